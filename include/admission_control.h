@@ -0,0 +1,151 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file admission_control.h
+/// Priority and admission control for new sessions.
+/// ----------------------------------------------------------
+/// $Id: admission_control.h 2558 2016-03-23 16:05:00 amarentes $
+/// $HeadURL: https://./include/admission_control.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_ADMISSION_CONTROL_H
+#define ANSLP_ADMISSION_CONTROL_H
+
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+class event;
+
+
+/**
+ * Counters describing the admission of new sessions.
+ */
+struct admission_stats {
+	uint64_t admitted;			///< session setups processed right away
+	uint64_t deferred;			///< session setups put aside
+	uint64_t resumed;			///< deferred session setups processed later
+	uint64_t shed;				///< session setups rejected on arrival
+	uint64_t expired;			///< deferred session setups rejected later
+};
+
+std::ostream &operator<<(std::ostream &out, const admission_stats &s);
+
+
+/**
+ * Admission control for session setups.
+ *
+ * Events setting up a new session (a CREATE for an unknown session or a
+ * create request from the API) are the only events that may be put off 
+ * when we are overloaded. Everything else keeps existing sessions alive
+ * and is processed first. 
+ *
+ * The load is judged from the depth of the input queue and the queueing
+ * delay estimated from it and the mean time spent processing an event.
+ * Above the defer thresholds, session setups are kept aside until the 
+ * load goes down again. Above the shed thresholds, when too many setups
+ * are kept aside or when one waited longer than max_delay_ms, they are 
+ * rejected.
+ *
+ * Instances of this class are thread-safe and shared among dispatchers.
+ */
+class admission_control {
+
+  public:
+	enum decision_t {
+		ADMIT	= 0,
+		DEFER	= 1,
+		SHED	= 2
+	};
+
+	admission_control(uint32 defer_depth, uint32 shed_depth, 
+					  uint32 max_delay_ms, uint32 max_deferred,
+					  uint32 num_threads);
+	
+	~admission_control();
+
+	bool is_overloaded(size_t depth) const;
+
+	decision_t admit(size_t depth);
+	
+	bool defer(event *evt);
+	
+	event *resume(size_t depth, std::vector<event *> &expired);
+	
+	void record_service(uint32 usecs);
+	
+	uint32 get_estimated_delay(size_t depth) const;
+	
+	void set_num_threads(uint32 num);
+
+	size_t get_num_deferred() const;
+	
+	inline bool has_deferred() const { return num_deferred != 0; }
+
+	bool begin_triage();
+	
+	void end_triage();
+
+	admission_stats get_stats() const;
+
+	static uint64_t now_ms();
+
+	/// Weight of a new sample in the mean service time, as a power of 2.
+	static const uint32 SERVICE_TIME_SHIFT = 3;
+
+  private:
+	struct deferred_t {
+		event *evt;
+		uint64_t since_ms;
+	};
+	
+	uint32 defer_depth;
+	uint32 shed_depth;
+	uint32 max_delay_ms;
+	uint32 max_deferred;
+	volatile uint32 num_threads;
+
+	volatile uint32 service_time_us;
+	
+	volatile size_t num_deferred;
+	
+	volatile int triage_running;
+	
+	mutable pthread_mutex_t mutex;
+	
+	std::deque<deferred_t> deferred;
+
+	admission_stats stats;
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_ADMISSION_CONTROL_H
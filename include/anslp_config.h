@@ -35,6 +35,10 @@
 #include "configpar.h"
 #include "configpar_repository.h"
 
+#include <signal.h>
+#include <pthread.h>
+#include <deque>
+
 // since we re-use some GIST parameter, we need to define them here
 #include "gist_conf.h"
 
@@ -81,17 +85,112 @@ namespace anslp {
     anslpconf_nr_max_session_lifetime,
     anslpconf_nr_max_retries,
     anslpconf_nr_response_timeout,
+    
+    /* Summary refresh */
+    anslpconf_summary_refresh,
+    anslpconf_summary_refresh_max_sessions,
+    anslpconf_summary_refresh_delay,
+    
+    /* Refresh scheduling */
+    anslpconf_refresh_jitter,
+    anslpconf_refresh_peer_rate,
+    anslpconf_refresh_peer_burst,
+    anslpconf_refresh_queue_threshold,
+    
+    /* Admission control */
+    anslpconf_admission_defer_depth,
+    anslpconf_admission_shed_depth,
+    anslpconf_admission_max_delay,
+    anslpconf_admission_max_deferred,
+    anslpconf_nf_cut_through,
+    anslpconf_lazy_decoding,
+    anslpconf_check_cache_ttl,
+    anslpconf_check_cache_size,
+    anslpconf_session_store_file,
+    anslpconf_session_store_slots,
+    anslpconf_create_max_hop_count,
+    anslpconf_create_source_rate,
+    anslpconf_create_source_burst,
+    anslpconf_create_source_sessions,
+    anslpconf_create_max_sources,
+    anslpconf_lock_profiling,
+    anslpconf_session_lock,
+    anslpconf_session_lock_spins,
+    anslpconf_dispatcher_cpus,
+    anslpconf_dispatcher_pin_each,
+    anslpconf_ntlp_cpus,
+    anslpconf_dispatcher_threads_max,
+    anslpconf_dispatcher_queue_delay,
+    anslpconf_dispatcher_idle_time,
+    anslpconf_dispatcher_work_stealing,
+    anslpconf_install_queue_size,
+    anslpconf_install_queue_high,
+    anslpconf_install_queue_low,
     anslpconf_maxparno
   };
 
 
+/**
+ * An immutable copy of the parameters read on hot paths.
+ *
+ * Reading a parameter from the configpar_repository means a lookup and,
+ * for strings, a copy. A snapshot is built once whenever the parameters
+ * change and then read without locking. Snapshots are never modified
+ * after they are published. The getters return copies of the members,
+ * so a reader only uses a snapshot during one call. A replaced snapshot
+ * is deleted after MAX_RETIRED_SNAPSHOTS newer ones replaced it.
+ */
+struct anslp_config_snapshot {
+	bool is_auctioneer;
+	bool install_auction_rules;
+
+	string auctioneer_application;
+	string auctioneer_user;
+	string auctioneer_password;
+	string auctioneer_server;
+	string auctioneer_xsl;
+	uint32 auctioneer_port;
+
+	string bid_user;
+	string bid_password;
+	string bid_server;
+	uint32 bid_port;
+
+	uint32 ni_max_session_lifetime;
+	uint32 ni_response_timeout;
+	uint32 ni_max_retries;
+	uint32 ni_msg_hop_count;
+
+	uint32 nf_max_session_lifetime;
+	uint32 nf_response_timeout;
+	bool nf_is_edge;
+
+	uint32 nr_max_session_lifetime;
+	uint32 nr_max_retries;
+	uint32 nr_response_timeout;
+
+	bool summary_refresh;
+	bool nf_cut_through;
+	bool lazy_decoding;
+};
+
+
 /**
  * The central configuration point for a ANSLP instance.
+ *
+ * The parameters used on hot paths are read from the current snapshot.
+ * Each instance has a snapshot of its own, which is published again 
+ * whenever the parameters change through this instance, and on reload().
+ * Copies publish their own snapshot of the shared repository.
  */
 class anslp_config {
 
   public:
-	anslp_config(configpar_repository *cfpgar_rep= NULL) : cfgpar_rep(cfpgar_rep) {};
+	anslp_config(configpar_repository *cfpgar_rep= NULL);
+
+	anslp_config(const anslp_config &other);
+
+	~anslp_config();
 	
 	void repository_init();
 
@@ -112,6 +211,25 @@ class anslp_config {
 	
 	string getparname(anslp_configpar_id_t configparid);
 
+	void publish_snapshot();
+
+	anslp_config_snapshot *build_snapshot() const;
+	
+	bool reload();
+
+	/// Return the current snapshot, without locking.
+	const anslp_config_snapshot *get_snapshot() const { return snapshot; }
+
+	/// Return the number of replaced snapshots still kept.
+	size_t get_num_retired_snapshots() const { return retired_snapshots.size(); }
+
+	/// Maximum number of replaced snapshots kept for readers still using them.
+	static const size_t MAX_RETIRED_SNAPSHOTS = 16;
+
+	static void request_reload();
+
+	static bool claim_reload();
+
     bool has_ipv4_address() const { 
 		return ntlp::gconf.getparref<hostaddresslist_t>(ntlp::gistconf_localaddrv4).size() > 0; }
     
@@ -136,70 +254,180 @@ class anslp_config {
 	uint32 get_num_dispatcher_threads() const {
 		return getpar<uint32>(anslpconf_dispatcher_threads); }
 
-	bool is_auctioneer() const { return getpar<bool>(anslpconf_is_auctioneer); }
+	bool is_auctioneer() const { return get_snapshot()->is_auctioneer; }
 	
-	string get_auctioning_application() const { 
-		return getpar<string>(anslpconf_auctioneer_application); }
+	string get_auctioning_application() const {
+		return get_snapshot()->auctioneer_application; }
 			
 	string get_user() const {
-		return getpar<string>(anslpconf_auctioneer_user); }
+		return get_snapshot()->auctioneer_user; }
 	
 	string get_password() const {
-		return getpar<string>(anslpconf_auctioneer_password); }
+		return get_snapshot()->auctioneer_password; }
 
 	string get_auctioneer_server() const {
-		return getpar<string>(anslpconf_auctioneer_server); }
+		return get_snapshot()->auctioneer_server; }
 
 	string get_auctioneer_xsl() const {
-		return getpar<string>(anslpconf_auctioneer_def_xsl); }
+		return get_snapshot()->auctioneer_xsl; }
 
 	uint32 get_auctioneer_port() const {
-		return getpar<uint32>(anslpconf_auctioneer_port); }
+		return get_snapshot()->auctioneer_port; }
 
 	string get_bid_user() const {
-		return getpar<string>(anslpconf_ni_user); }
+		return get_snapshot()->bid_user; }
 	
 	string get_bid_password() const {
-		return getpar<string>(anslpconf_ni_password); }
+		return get_snapshot()->bid_password; }
 
 	string get_bid_server() const {
-		return getpar<string>(anslpconf_ni_server); }
+		return get_snapshot()->bid_server; }
 
 	uint32 get_bid_port() const {
-		return getpar<uint32>(anslpconf_ni_port); }
+		return get_snapshot()->bid_port; }
 
-    uint32 get_ni_session_lifetime() const { 
-		return getpar<uint32>(anslpconf_ni_max_session_lifetime); }
+    uint32 get_ni_session_lifetime() const {
+		return get_snapshot()->ni_max_session_lifetime; }
         
-	uint32 get_ni_max_retries() const { 
-		return getpar<uint32>(anslpconf_ni_max_retries); }
+	uint32 get_ni_max_retries() const {
+		return get_snapshot()->ni_max_retries; }
     
     uint32 get_ni_msg_hop_count() const {
-		return getpar<uint32>(anslpconf_ni_msg_hop_count); }
+		return get_snapshot()->ni_msg_hop_count; }
     
-    uint32 get_ni_response_timeout() const { 
-		return getpar<uint32>(anslpconf_ni_response_timeout); }
+    uint32 get_ni_response_timeout() const {
+		return get_snapshot()->ni_response_timeout; }
 
-	uint32 get_nf_max_session_lifetime() const { 
-	  return getpar<uint32>(anslpconf_nf_max_session_lifetime); }
+	uint32 get_nf_max_session_lifetime() const {
+		return get_snapshot()->nf_max_session_lifetime; }
 	  
-	uint32 get_nf_response_timeout() const { 
-	  return getpar<uint32>(anslpconf_nf_response_timeout); }
+	uint32 get_nf_response_timeout() const {
+		return get_snapshot()->nf_response_timeout; }
 
 	bool is_nf_edge() const {
-	  return getpar<bool>(anslpconf_nf_is_edge); }
+		return get_snapshot()->nf_is_edge; }
 	
 	bool get_install_auction_rules() const {
-		return getpar<bool>(anslpconf_install_auction_rules); }
+		return get_snapshot()->install_auction_rules; }
 
 	uint32 get_nr_max_session_lifetime() const {
-		return getpar<uint32>(anslpconf_nr_max_session_lifetime); }
+		return get_snapshot()->nr_max_session_lifetime; }
+
+	uint32 get_nr_max_retries() const {
+		return get_snapshot()->nr_max_retries; }
+
+	uint32 get_nr_response_timeout() const {
+		return get_snapshot()->nr_response_timeout; }
+
+	bool use_summary_refresh() const {
+		return get_snapshot()->summary_refresh; }
+
+	uint32 get_summary_refresh_max_sessions() const {
+		return getpar<uint32>(anslpconf_summary_refresh_max_sessions); }
+
+	uint32 get_summary_refresh_delay() const {
+		return getpar<uint32>(anslpconf_summary_refresh_delay); }
+
+	uint32 get_refresh_jitter() const {
+		return getpar<uint32>(anslpconf_refresh_jitter); }
+
+	uint32 get_refresh_peer_rate() const {
+		return getpar<uint32>(anslpconf_refresh_peer_rate); }
+
+	uint32 get_refresh_peer_burst() const {
+		return getpar<uint32>(anslpconf_refresh_peer_burst); }
+
+	uint32 get_refresh_queue_threshold() const {
+		return getpar<uint32>(anslpconf_refresh_queue_threshold); }
+
+	uint32 get_admission_defer_depth() const {
+		return getpar<uint32>(anslpconf_admission_defer_depth); }
+
+	uint32 get_admission_shed_depth() const {
+		return getpar<uint32>(anslpconf_admission_shed_depth); }
+
+	uint32 get_admission_max_delay() const {
+		return getpar<uint32>(anslpconf_admission_max_delay); }
 
-	uint32 get_nr_max_retries() const { 
-		return getpar<uint32>(anslpconf_nr_max_retries); }
+	uint32 get_admission_max_deferred() const {
+		return getpar<uint32>(anslpconf_admission_max_deferred); }
 
-	uint32 get_nr_response_timeout() const { 
-	  return getpar<uint32>(anslpconf_nr_response_timeout); }
+	bool get_nf_cut_through() const {
+		return get_snapshot()->nf_cut_through; }
+
+	// Cut-through needs a node that never looks inside the mspec objects.
+	bool use_nf_cut_through() const {
+		return get_nf_cut_through()
+				&& !get_install_auction_rules() && !is_auctioneer(); }
+
+	bool use_lazy_decoding() const {
+		return get_snapshot()->lazy_decoding; }
+
+	uint32 get_check_cache_ttl() const {
+		return getpar<uint32>(anslpconf_check_cache_ttl); }
+
+	uint32 get_check_cache_size() const {
+		return getpar<uint32>(anslpconf_check_cache_size); }
+
+	string get_session_store_file() const {
+		return getpar<string>(anslpconf_session_store_file); }
+
+	uint32 get_session_store_slots() const {
+		return getpar<uint32>(anslpconf_session_store_slots); }
+
+	uint32 get_create_max_hop_count() const {
+		return getpar<uint32>(anslpconf_create_max_hop_count); }
+
+	uint32 get_create_source_rate() const {
+		return getpar<uint32>(anslpconf_create_source_rate); }
+
+	uint32 get_create_source_burst() const {
+		return getpar<uint32>(anslpconf_create_source_burst); }
+
+	uint32 get_create_source_sessions() const {
+		return getpar<uint32>(anslpconf_create_source_sessions); }
+
+	uint32 get_create_max_sources() const {
+		return getpar<uint32>(anslpconf_create_max_sources); }
+
+	bool get_lock_profiling() const {
+		return getpar<bool>(anslpconf_lock_profiling); }
+
+	string get_session_lock() const {
+		return getpar<string>(anslpconf_session_lock); }
+
+	uint32 get_session_lock_spins() const {
+		return getpar<uint32>(anslpconf_session_lock_spins); }
+
+	string get_dispatcher_cpus() const {
+		return getpar<string>(anslpconf_dispatcher_cpus); }
+
+	bool get_dispatcher_pin_each() const {
+		return getpar<bool>(anslpconf_dispatcher_pin_each); }
+
+	string get_ntlp_cpus() const {
+		return getpar<string>(anslpconf_ntlp_cpus); }
+
+	uint32 get_max_dispatcher_threads() const {
+		return getpar<uint32>(anslpconf_dispatcher_threads_max); }
+
+	uint32 get_dispatcher_queue_delay() const {
+		return getpar<uint32>(anslpconf_dispatcher_queue_delay); }
+
+	uint32 get_dispatcher_idle_time() const {
+		return getpar<uint32>(anslpconf_dispatcher_idle_time); }
+
+	bool use_work_stealing() const {
+		return getpar<bool>(anslpconf_dispatcher_work_stealing); }
+
+	uint32 get_install_queue_size() const {
+		return getpar<uint32>(anslpconf_install_queue_size); }
+
+	uint32 get_install_queue_high() const {
+		return getpar<uint32>(anslpconf_install_queue_high); }
+
+	uint32 get_install_queue_low() const {
+		return getpar<uint32>(anslpconf_install_queue_low); }
 
 		
 	/// The ID of the queue that receives messages from the NTLP.
@@ -231,6 +459,22 @@ class anslp_config {
 	hostaddress get_hostaddress(const std::string &key);
 
 	void registerAllPars();
+
+  private:
+	const anslp_config_snapshot *volatile snapshot;
+
+	// Snapshots replaced by newer ones, oldest first.
+	std::deque<const anslp_config_snapshot *> retired_snapshots;
+
+	// Serializes publishing snapshots.
+	pthread_mutex_t snapshot_mutex;
+	
+	static volatile sig_atomic_t reload_pending;
+
+	void publish_snapshot(anslp_config_snapshot *s);
+
+	// Not implemented, the snapshots can't be shared.
+	anslp_config &operator=(const anslp_config &other);
 };
 
 
@@ -240,6 +484,7 @@ void
 anslp_config::setpar(anslp_configpar_id_t configparid, const T& value)
 {
 	cfgpar_rep->setPar(anslp_realm, configparid, value);
+	publish_snapshot();
 }
 
 
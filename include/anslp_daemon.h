@@ -35,7 +35,17 @@
 #include "gist_conf.h"
 #include "anslp_config.h"
 #include "session_manager.h"
+#include "session_store.h"
 #include "auction_rule_installer.h"
+#include "summary_refresh_collector.h"
+#include "refresh_scheduler.h"
+#include "check_cache.h"
+#include "create_filter.h"
+#include "install_backlog.h"
+#include "cpu_placement.h"
+#include "admission_control.h"
+#include "elastic_pool.h"
+#include "work_scheduler.h"
 
 
 namespace anslp 
@@ -45,6 +55,10 @@ namespace anslp
   using ntlp::NTLPStarterParam;
   using ntlp::NTLPStarter;
 
+class dispatcher;
+class gistka_mapper;
+class event;
+
 
 /**
  * Encapsulated parameters for a anslp_daemon thread.
@@ -86,7 +100,25 @@ class anslp_daemon : public Thread {
   
 	anslp_config config;
 
+	session_store saved_sessions;
+
 	session_manager session_mgr;
+	
+	summary_refresh_collector refresh_collector;
+	
+	refresh_scheduler refresh_sched;
+	
+	check_cache checks;
+	
+	create_filter filter;
+	
+	install_backlog backlog;
+	
+	admission_control admission;
+	
+	elastic_pool pool;
+	
+	work_scheduler *scheduler;
 		
 	auction_rule_installer *rule_installer;
 	
@@ -94,6 +126,37 @@ class anslp_daemon : public Thread {
 
 	ThreadStarter<NTLPStarter, NTLPStarterParam> *ntlp_starter;
 	
+	/// Maximum number of queued messages looked at in one triage run.
+	static const uint32 TRIAGE_BATCH = 64;
+	
+	/// Maximum number of messages handed to the scheduler at once.
+	static const uint32 INGRESS_BATCH = 64;
+	
+	/// Delays between attempts to register with the NTLP.
+	static const uint32 REGISTER_MIN_DELAY_US = 1000;
+	static const uint32 REGISTER_MAX_DELAY_US = 50000;
+	
+	/// How often a parked dispatcher thread checks whether it has to stop.
+	static const uint32 PARK_TIMEOUT_MS = 1000;
+	
+	void triage(dispatcher &disp, const gistka_mapper &mapper);
+	
+	void process_event(dispatcher &disp, event *evt);
+	
+	bool run_scheduled(dispatcher &disp, const gistka_mapper &mapper,
+					   uint32 worker);
+	
+	size_t get_queue_depth();
+	
+	void log_lock_profiles();
+	
+	void update_backlog();
+	
+	void place_dispatcher_thread(uint32 thread_id);
+	
+	void admit_session_setup(dispatcher &disp, event *evt);
+	
+	void resume_session_setups(dispatcher &disp);
 };
 
 
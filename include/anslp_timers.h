@@ -70,14 +70,24 @@ class timer {
 	inline id_t get_id() const { return id; }
 	void start(dispatcher *d, int seconds);
 	void restart(dispatcher *d, int seconds);
+	void start_ms(dispatcher *d, uint32 msecs);
+	void start_refresh(dispatcher *d, uint32 interval, uint32 deadline);
 	void stop();
 
+	uint32 get_remaining_ms() const;
+
+	/// When the timer goes off, 0 if it is stopped.
+	inline uint64 get_expires_ms() const { return expires_ms; }
+
 	// needed for the test suite
 	inline void set_id(id_t new_id) { id = new_id; }
 	
   private:
 	id_t id;
 	session *owning_session;
+
+	/// When the timer goes off, as refresh_scheduler::now_ms(), 0 if stopped.
+	uint64 expires_ms;
 };
 
 
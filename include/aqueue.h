@@ -108,13 +108,11 @@ class AnslpEvent{
 		if ( obj == NULL )
 		return;
 
-		msg::anslp_mspec_object *old = objects[key];
+		msg::anslp_mspec_object *old = objects.exchange(key, obj);
 
 		if ( old )
 			delete old;
 
-		objects[key] = obj;
-
 	}
 
 	objectList_t * getObjects()
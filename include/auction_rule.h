@@ -32,6 +32,7 @@
 #include "protlib_types.h"
 #include "address.h"
 #include "mspec_rule_key.h"
+#include "mspec_object_list.h"
 #include "msg/anslp_mspec_object.h"
 #include <map>
 #include <vector>
@@ -55,10 +56,10 @@ namespace anslp
  * auction rule, which is vendor-dependent.
  */
 
-typedef std::map<mspec_rule_key, msg::anslp_mspec_object *> objectList_t;
-typedef std::map<mspec_rule_key, msg::anslp_mspec_object *>::iterator objectListIter_t;
-typedef std::map<mspec_rule_key, msg::anslp_mspec_object *>::reverse_iterator objectListRevIter_t;
-typedef std::map<mspec_rule_key, msg::anslp_mspec_object *>::const_iterator objectListConstIter_t;
+typedef mspec_object_list objectList_t;
+typedef mspec_object_list::iterator objectListIter_t;
+typedef mspec_object_list::reverse_iterator objectListRevIter_t;
+typedef mspec_object_list::const_iterator objectListConstIter_t;
 
 
 class auction_rule 
@@ -115,6 +116,8 @@ class auction_rule
 	const objectList_t *  get_request_objects(void) const { return &object_requests; }
 
 	objectList_t * get_response_objects(void) { return &object_responses; }
+
+	const objectList_t * get_response_objects(void) const { return &object_responses; }
 	
 
   protected:
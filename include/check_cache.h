@@ -0,0 +1,162 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file check_cache.h
+/// Shared cache of auction applicability check results.
+/// ----------------------------------------------------------
+/// $Id: check_cache.h 2558 2016-04-13 10:20:00 amarentes $
+/// $HeadURL: https://./include/check_cache.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_CHECK_CACHE_H
+#define ANSLP_CHECK_CACHE_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "protlib_types.h"
+#include "auction_rule.h"
+#include "msg/content_digest.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Counters describing how well the check cache works.
+ */
+struct check_cache_stats {
+	uint64_t hits;				///< checks answered from the cache
+	uint64_t misses;			///< checks sent to the auction application
+	uint64_t stored;			///< answers of the application remembered
+	uint64_t expired;			///< entries found too old or invalidated
+	uint64_t invalidations;		///< changes pushed by the application
+};
+
+std::ostream &operator<<(std::ostream &out, const check_cache_stats &s);
+
+
+/**
+ * Cache for the answers of the auction application to check requests.
+ *
+ * Every new session asks the auction application which of its mspec 
+ * objects are applicable at this node, but most sessions ask about the
+ * same filter and auction specifications. The cache remembers, keyed by
+ * a digest of the requested objects, which of them were applicable, so
+ * a repeated request can be answered without a round trip.
+ *
+ * A request sent to the application is registered with expect(). When 
+ * the answer comes back, learn() stores it for the time to live. All
+ * entries are dropped when the application reports that its auctions
+ * changed, answers to requests sent before that are not stored.
+ *
+ * The cache is split into shards, each with its own lock, so dispatcher
+ * threads rarely wait for each other. Instances of this class are 
+ * thread-safe and shared among dispatchers.
+ */
+class check_cache {
+
+  public:
+  
+	check_cache(uint32 ttl_ms, uint32 max_entries);
+	
+	~check_cache();
+
+	inline bool is_enabled() const { return ttl_ms > 0; }
+
+	bool lookup(const objectList_t *objects, std::vector<bool> &applicable,
+				uint64_t now);
+
+	void expect(const std::string &session_id, const objectList_t *objects,
+				uint64_t now);
+
+	bool learn(const std::string &session_id, const objectList_t *result,
+			   uint64_t now);
+
+	void invalidate();
+
+	check_cache_stats get_stats() const;
+
+	static msg::content_digest digest(const objectList_t *objects);
+
+	static uint64_t now_ms();
+	
+	/// Number of independently locked parts of the cache.
+	static const uint32 NUM_SHARDS = 16;
+	
+	/// Time after which we no longer wait for the application's answer.
+	static const uint32 MAX_ANSWER_MS = 10000;
+
+  private:
+  
+	typedef std::pair<protlib::uint64, protlib::uint64> digest_key_t;
+	
+	struct entry_t {
+		uint64_t expires;
+		uint32 generation;
+		std::vector<bool> applicable;
+	};
+
+	struct pending_t {
+		msg::content_digest digest;
+		uint64_t since;
+		uint32 generation;
+		std::vector<mspec_rule_key> keys;
+	};
+
+	struct shard_t {
+		pthread_mutex_t mutex;
+		std::map<digest_key_t, entry_t> entries;
+		std::map<std::string, pending_t> pending;
+		check_cache_stats stats;
+	};
+
+	uint32 ttl_ms;
+	uint32 max_shard_entries;
+	
+	volatile uint32 generation;
+
+	shard_t *shards;
+	
+	shard_t &get_shard(const msg::content_digest &digest) const;
+
+	shard_t &get_shard(const std::string &session_id) const;
+	
+	void store(const pending_t &request, const objectList_t *result, 
+			   uint64_t now);
+	
+	void purge(shard_t &shard, uint64_t now);
+
+	// Disallow copying, shards own their mutexes.
+	check_cache(const check_cache &other);
+	check_cache &operator=(const check_cache &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_CHECK_CACHE_H
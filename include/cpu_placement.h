@@ -0,0 +1,79 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file cpu_placement.h
+/// Placement of threads on CPUs.
+/// ----------------------------------------------------------
+/// $Id: cpu_placement.h 2558 2016-04-21 10:00:00 amarentes $
+/// $HeadURL: https://./include/cpu_placement.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_CPU_PLACEMENT_H
+#define ANSLP_CPU_PLACEMENT_H
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <sched.h>
+#include <string>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Helpers for placing threads on CPUs.
+ *
+ * CPU sets are written like the Linux cpusets, for example "0-3,8,10".
+ * A thread that is pinned before it allocates its own state gets that 
+ * memory from its NUMA node, since Linux places pages on the node of the
+ * thread touching them first. Threads inherit the placement of the 
+ * thread creating them.
+ */
+class cpu_placement {
+
+  public:
+	static bool parse(const std::string &spec, cpu_set_t &set);
+
+	static std::string to_string(const cpu_set_t &set);
+
+	static bool select(const cpu_set_t &set, uint32 index, cpu_set_t &cpu);
+
+	static bool get_affinity(cpu_set_t &set);
+
+	static bool set_affinity(const cpu_set_t &set);
+
+	static std::string describe_current_thread();
+
+  private:
+	// Only static methods.
+	cpu_placement();
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_CPU_PLACEMENT_H
@@ -0,0 +1,192 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file create_filter.h
+/// Stateless screening of CREATE messages before sessions are set up.
+/// ----------------------------------------------------------
+/// $Id: create_filter.h 2558 2016-04-18 10:10:00 amarentes $
+/// $HeadURL: https://./include/create_filter.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_CREATE_FILTER_H
+#define ANSLP_CREATE_FILTER_H
+
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+#include <ext/hash_map>
+
+#include "protlib_types.h"
+#include "session_id.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Counters describing which CREATE messages were screened out.
+ */
+struct create_filter_stats {
+	uint64_t passed;			///< CREATEs handed to a new session
+	uint64_t malformed;			///< CREATEs missing mandatory objects
+	uint64_t bad_mri;			///< CREATEs without a downstream path-coupled MRI
+	uint64_t bad_lifetime;		///< CREATEs with an unusable session lifetime
+	uint64_t hop_limit;			///< CREATEs beyond the hop count limit
+	uint64_t bad_sme;			///< CREATEs with an unknown SME value
+	uint64_t rate_limited;		///< CREATEs above the rate of their source
+	uint64_t over_quota;		///< CREATEs of sources with too many sessions
+	uint64_t overflowed;		///< CREATEs of sources beyond the table size
+};
+
+std::ostream &operator<<(std::ostream &out, const create_filter_stats &s);
+
+
+/**
+ * The values of a received CREATE that decide whether it is screened out.
+ *
+ * The dispatcher extracts them from the message, so the filter doesn't
+ * have to deal with message objects.
+ */
+struct create_request {
+	uint64_t source;			///< key of the node the CREATE came from
+	bool well_formed;			///< all mandatory objects are present
+	bool path_coupled;			///< the MRI is path-coupled and downstream
+	uint32 lifetime;			///< the requested session lifetime in ms
+	uint32 hop_count;			///< the message hop count
+	uint32 sme;					///< the selection auctioning entities value
+};
+
+
+/**
+ * Stateless screening of CREATE messages for unknown sessions.
+ *
+ * Every CREATE that doesn't belong to an existing session would make the
+ * session manager allocate and register a new session, even if that 
+ * session rejects the message right away. The filter catches the CREATEs
+ * a session would refuse anyway, and those of sources sending too fast or
+ * holding too many sessions, before any session state is allocated.
+ *
+ * Only the per-source counters are kept: a token bucket limiting the rate 
+ * of new sessions and the number of sessions set up by each source. The
+ * table of sources is bounded, sources not fitting in share one entry.
+ *
+ * The tables are split into shards, each with its own lock, so dispatcher
+ * threads rarely wait for each other. Instances of this class are 
+ * thread-safe and shared among dispatchers.
+ */
+class create_filter {
+
+  public:
+	enum verdict_t {
+		PASS			= 0,
+		MALFORMED		= 1,
+		BAD_MRI			= 2,
+		BAD_LIFETIME	= 3,
+		HOP_LIMIT		= 4,
+		BAD_SME			= 5,
+		RATE_LIMITED	= 6,
+		OVER_QUOTA		= 7,
+		NUM_VERDICTS	= 8
+	};
+
+	create_filter(uint32 max_hop_count, uint32 source_rate, 
+				  uint32 source_burst, uint32 max_source_sessions,
+				  uint32 max_sources);
+	
+	~create_filter();
+
+	verdict_t check(const create_request &request, uint64_t now);
+
+	void add_session(const session_id &sid, uint64_t source, uint64_t now);
+
+	void remove_session(const session_id &sid);
+	
+	uint32 get_num_sessions(uint64_t source) const;
+
+	create_filter_stats get_stats() const;
+
+	static uint64_t now_ms();
+
+	static const char *to_string(verdict_t v);
+	
+	/// Number of independently locked parts of the tables.
+	static const uint32 NUM_SHARDS = 16;
+	
+	/// Key of the entry shared by sources not fitting into the table.
+	static const uint64_t OVERFLOW_SOURCE = 0;
+
+  private:
+  
+	struct source_t {
+		double tokens;
+		uint64_t last_ms;
+		uint32 sessions;
+	};
+	
+	struct uint64_hash {
+		size_t operator()(uint64_t key) const {
+			return (size_t) (key ^ (key >> 32));
+		}
+	};
+
+	typedef __gnu_cxx::hash_map<uint64_t, source_t, uint64_hash> 
+		source_table_t;
+	typedef __gnu_cxx::hash_map<session_id, uint64_t> session_table_t;
+
+	struct shard_t {
+		pthread_mutex_t mutex;
+		source_table_t sources;
+		session_table_t sessions;
+	};
+
+	uint32 max_hop_count;
+	uint32 source_rate;
+	uint32 source_burst;
+	uint32 max_source_sessions;
+	uint32 max_shard_sources;
+
+	shard_t *shards;
+	
+	mutable create_filter_stats stats;
+	
+	verdict_t admit(uint64_t source, uint64_t now);
+
+	source_t *lookup(shard_t &shard, uint64_t source, uint64_t now);
+	
+	void purge(shard_t &shard, uint64_t now);
+	
+	shard_t &get_shard(uint64_t source) const;
+	
+	shard_t &get_shard(const session_id &sid) const;
+
+	void count(verdict_t v);
+
+	// Disallow copying, shards own their mutexes.
+	create_filter(const create_filter &other);
+	create_filter &operator=(const create_filter &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_CREATE_FILTER_H
@@ -39,6 +39,12 @@
 #include "events.h"
 #include "msg/ntlp_msg.h"
 #include "gistka_mapper.h"
+#include "summary_refresh_collector.h"
+#include "refresh_scheduler.h"
+#include "check_cache.h"
+#include "create_filter.h"
+#include "install_backlog.h"
+#include "msg/wire_image.h"
 
 
 namespace anslp {
@@ -65,19 +71,43 @@ class dispatcher {
   public:
 	dispatcher(session_manager *m, 
 			   auction_rule_installer *p, 
-			   anslp_config *conf);
+			   anslp_config *conf,
+			   summary_refresh_collector *c = NULL,
+			   refresh_scheduler *r = NULL,
+			   check_cache *k = NULL,
+			   create_filter *f = NULL,
+			   install_backlog *b = NULL);
 			
 	virtual ~dispatcher();
 
 	virtual void process(event *evt) throw ();
 
+	virtual bool is_session_setup(const event *evt) throw ();
+	
+	virtual void reject_session_setup(event *evt) throw ();
+
 	/*
 	 * Services which are used by the event handlers.
 	 */
 	virtual void send_message(msg::ntlp_msg *msg) throw ();
 	
+	void set_reply_filter(duplicate_filter *filter) throw ();
+	
+	virtual void send_wire_message(const msg::ntlp_msg *msg, 
+								   msg::wire_image &image) throw ();
+	
+	virtual void flush_summary_refreshes(bool all = false) throw ();
+	
 	virtual id_t start_timer(const session *s, int secs) throw ();
 	
+	virtual id_t start_timer_ms(const session *s, uint32 msecs) throw ();
+	
+	virtual id_t start_refresh_timer(const session *s, uint32 interval,
+									 uint32 deadline) throw ();
+	
+	virtual uint32 admit_refresh(const ntlp::mri *mri, uint64_t due_ms,
+								 uint64_t deadline_ms) throw ();
+	
 	virtual void report_async_event(std::string msg) throw ();
 	
 	virtual bool check(const string session_id, 
@@ -100,17 +130,42 @@ class dispatcher {
 
   private:
 	/*
-	 * The targets of these four pointers are shared among dispatchers.
+	 * The targets of these pointers are shared among dispatchers.
 	 * They may not be deleted by the destructor!
 	 */
 	session_manager *session_mgr;
 	auction_rule_installer *rule_installer;
 	anslp_config *config;
+	summary_refresh_collector *refresh_collector;
+	refresh_scheduler *scheduler;
+	check_cache *checks;
+	create_filter *filter;
+	install_backlog *backlog;
+
+	/// Filter of the session being processed, not owned.
+	duplicate_filter *reply_filter;
 
 	gistka_mapper mapper;
 
+	/// Responses to screened out CREATEs, serialized once per verdict.
+	msg::wire_image reject_images[create_filter::NUM_VERDICTS];
+
 	session *create_session(event *evt) const throw ();
 	
+	create_filter::verdict_t screen_create(const msg_event *evt,
+										   uint64_t &source) const throw ();
+	
+	void reject_create(const msg_event *evt, 
+					   create_filter::verdict_t verdict) throw ();
+	
+	void reject_bidding(const msg_event *evt) throw ();
+	
+	void process_summary_refresh(msg_event *evt) throw ();
+	
+	void send_to_ntlp(msg::ntlp_msg *msg) throw ();
+	
+	bool answer_check(const string sid, const objectList_t *objects) throw ();
+	
 	void send_receive_answer(const routing_state_check_event *evt) const;
 };
 
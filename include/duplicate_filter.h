@@ -0,0 +1,99 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file duplicate_filter.h
+/// Per-session filter for retransmitted messages.
+/// ----------------------------------------------------------
+/// $Id: duplicate_filter.h 2558 2016-04-11 09:30:00 amarentes $
+/// $HeadURL: https://./include/duplicate_filter.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_DUPLICATE_FILTER_H
+#define ANSLP_DUPLICATE_FILTER_H
+
+#include "protlib_types.h"
+#include "msg/content_digest.h"
+
+
+namespace anslp 
+{
+    using protlib::uint8;
+    using protlib::uint32;
+
+namespace msg {
+	class ntlp_msg;
+}
+
+
+/**
+ * Remembers the last few CREATE, BIDDING and RESPONSE messages a session
+ * received, keyed by message type, MSN and content digest.
+ *
+ * A message that matches an entry is a retransmission. If we already
+ * answered a CREATE, the RESPONSE we sent is kept with its entry, so a
+ * retransmitted CREATE can be answered from here without running the
+ * state machine again.
+ *
+ * The filter belongs to a session and is only used while the session is
+ * locked, so it needs no locking of its own.
+ */
+class duplicate_filter {
+
+  public:
+	static const uint32 CAPACITY = 4;
+
+	duplicate_filter();
+	~duplicate_filter();
+
+	static bool is_filtered(const msg::ntlp_msg *msg);
+
+	bool lookup(const msg::ntlp_msg *msg, const msg::content_digest &digest,
+				const msg::ntlp_msg *&reply) const;
+
+	void record(const msg::ntlp_msg *msg, const msg::content_digest &digest);
+
+	void record_reply(const msg::ntlp_msg *reply);
+
+	void clear();
+
+  private:
+	struct entry {
+		uint8 msg_type;
+		uint32 msn;
+		msg::content_digest digest;
+		msg::ntlp_msg *reply;
+	};
+
+	entry entries[CAPACITY];
+	uint32 num_entries;
+	uint32 next;
+
+	// Disallow copying, entries own their replies.
+	duplicate_filter(const duplicate_filter &other);
+	duplicate_filter &operator=(const duplicate_filter &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_DUPLICATE_FILTER_H
@@ -0,0 +1,121 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file elastic_pool.h
+/// Sizing of the dispatcher thread pool by queueing delay.
+/// ----------------------------------------------------------
+/// $Id: elastic_pool.h 2558 2016-04-22 10:00:00 amarentes $
+/// $HeadURL: https://./include/elastic_pool.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_ELASTIC_POOL_H
+#define ANSLP_ELASTIC_POOL_H
+
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * The state of the dispatcher thread pool.
+ */
+struct elastic_pool_stats {
+	uint32 size;				///< dispatcher threads currently working
+	uint32 queue_delay_ms;		///< the last queueing delay reported
+	uint64_t grown;				///< threads put to work because of delay
+	uint64_t shrunk;			///< threads parked because they were idle
+};
+
+std::ostream &operator<<(std::ostream &out, const elastic_pool_stats &s);
+
+
+/**
+ * Decides how many dispatcher threads work on the input queue.
+ *
+ * All max_workers threads are started, but only min_workers of them 
+ * work at first, the others are parked. A thread is put to work when 
+ * the queueing delay reported by the working threads stays above 
+ * target_delay_ms, at most one per target_delay_ms. A working thread 
+ * that found the queue empty for idle_ms is parked again, as long as 
+ * more than min_workers threads work.
+ *
+ * Parked threads wait on a condition variable instead of polling the
+ * input queue. Instances of this class are thread-safe and shared 
+ * among dispatchers.
+ */
+class elastic_pool {
+
+  public:
+	elastic_pool(uint32 min_workers, uint32 max_workers, 
+				 uint32 target_delay_ms, uint32 idle_ms);
+
+	~elastic_pool();
+
+	inline bool is_elastic() const { return min_workers < max_workers; }
+
+	bool start_worker();
+
+	bool park(uint32 timeout_ms);
+
+	bool report_delay(uint32 delay_ms, uint64_t now);
+
+	bool retire(uint64_t idle_since, uint64_t now);
+
+	inline uint32 get_size() const { return size; }
+
+	elastic_pool_stats get_stats() const;
+
+	static uint64_t now_ms();
+
+  private:
+	uint32 min_workers;
+	uint32 max_workers;
+	uint32 target_delay_ms;
+	uint32 idle_ms;
+
+	/// Working threads, including those woken but not yet running.
+	volatile uint32 size;
+
+	/// Wakeups not yet picked up by a parked thread.
+	uint32 pending;
+
+	uint32 num_started;
+
+	uint64_t last_grown;
+
+	mutable pthread_mutex_t mutex;
+
+	pthread_cond_t wakeup;
+
+	elastic_pool_stats stats;
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_ELASTIC_POOL_H
@@ -0,0 +1,142 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file epoch_manager.h
+/// Epoch based reclamation of removed sessions.
+/// ----------------------------------------------------------
+/// $Id: epoch_manager.h 2558 2016-03-15 09:40:00 amarentes $
+/// $HeadURL: https://./include/epoch_manager.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_EPOCH_MANAGER_H
+#define ANSLP_EPOCH_MANAGER_H
+
+#include <list>
+#include <cstddef>
+#include <pthread.h>
+
+
+namespace anslp 
+{
+
+class session;
+
+
+/**
+ * Safe memory reclamation for sessions removed from the session table.
+ *
+ * A dispatcher thread may still hold a pointer returned by 
+ * session_manager::get_session() when another thread removes that session.
+ * Threads announce that they may hold such pointers by entering a critical
+ * section (enter()/leave(), normally through an epoch_guard around
+ * dispatcher::process()). Removed sessions are retired with the current
+ * global epoch and deleted once the epoch advanced twice, that is when
+ * every thread that could have seen the session left its critical section.
+ *
+ * The global epoch only advances if all threads inside a critical section
+ * observed the current one. Threads outside a critical section never block
+ * reclamation.
+ *
+ * Instances of this class are thread-safe.
+ */
+class epoch_manager {
+
+  public:
+  
+	epoch_manager();
+	
+	~epoch_manager();
+
+	void enter();
+
+	void leave();
+
+	void retire(session *s);
+
+	void unregister_thread();
+
+	inline unsigned long get_epoch() const { return global_epoch; }
+
+	inline size_t get_num_retired() const { return num_retired; }
+
+	// Maximum number of threads using a manager at the same time.
+	static const int MAX_THREADS = 128;
+
+  private:
+  
+	/*
+	 * Per-thread state. Only the owning thread writes epoch and depth, 
+	 * other threads just read them while trying to advance the epoch.
+	 */
+	struct thread_record {
+		volatile int in_use;
+		volatile int depth;
+		volatile unsigned long epoch;
+	};
+	
+	struct retired_session {
+		session *s;
+		unsigned long epoch;
+	};
+	
+	volatile unsigned long global_epoch;
+	
+	volatile size_t num_retired;
+	
+	unsigned long instance;
+
+	thread_record records[MAX_THREADS];
+	
+	// Protects the retired list.
+	pthread_mutex_t mutex;
+	
+	std::list<retired_session> retired;
+	
+	thread_record *get_record();
+	
+	bool try_advance();
+	
+	void collect();
+};
+
+
+/**
+ * Scoped critical section on an epoch_manager.
+ */
+class epoch_guard {
+
+  public:
+	explicit epoch_guard(epoch_manager &m) : mgr(m) { mgr.enter(); }
+	
+	~epoch_guard() { mgr.leave(); }
+
+  private:
+	epoch_manager &mgr;
+	
+	// Not copyable.
+	epoch_guard(const epoch_guard &);
+	epoch_guard &operator=(const epoch_guard &);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_EPOCH_MANAGER_H
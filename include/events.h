@@ -64,16 +64,23 @@ class event
 	virtual ~event();
 	
 	session_id *get_session_id() const { return sid; }
+
+	/// True once admission control let this session setup through.
+	bool is_admitted() const { return admitted; }
+
+	void set_admitted() { admitted = true; }
 	
 	virtual ostream &print(ostream &out) const { return out << "[event]"; }
 
   protected:
   
-	event(session_id *sid=NULL) : sid(sid) { };
+	event(session_id *sid=NULL) : sid(sid), admitted(false) { };
 
   private:
   
 	session_id *sid;
+
+	bool admitted;
 };
 
 inline event::~event() 
@@ -352,13 +359,11 @@ inline void api_create_event::setObject(mspec_rule_key key, msg::anslp_mspec_obj
 	if ( obj == NULL )
 	return;
 	
-	msg::anslp_mspec_object *old = mspec_objects[key];
+	msg::anslp_mspec_object *old = mspec_objects.exchange(key, obj);
 
 	if ( old )
 		delete old;
 
-	mspec_objects[key] = obj;
-
 }
 
 /**
@@ -408,13 +413,11 @@ inline void api_check_event::setObject(mspec_rule_key key, msg::anslp_mspec_obje
 	if ( obj == NULL )
 	return;
 	
-	msg::anslp_mspec_object *old = mspec_objects[key];
+	msg::anslp_mspec_object *old = mspec_objects.exchange(key, obj);
 
 	if ( old )
 		delete old;
 
-	mspec_objects[key] = obj;
-
 }
 
 /**
@@ -465,13 +468,11 @@ inline void api_install_event::setObject(mspec_rule_key key, msg::anslp_mspec_ob
 	if ( obj == NULL )
 	return;
 	
-	msg::anslp_mspec_object *old = mspec_objects[key];
+	msg::anslp_mspec_object *old = mspec_objects.exchange(key, obj);
 
 	if ( old )
 		delete old;
 
-	mspec_objects[key] = obj;
-
 }
 
 /**
@@ -640,13 +641,11 @@ inline void api_bidding_event::setObject(mspec_rule_key key, msg::anslp_mspec_ob
 	if ( obj == NULL )
 	return;
 	
-	msg::anslp_mspec_object *old = mspec_objects[key];
+	msg::anslp_mspec_object *old = mspec_objects.exchange(key, obj);
 
 	if ( old )
 		delete old;
 
-	mspec_objects[key] = obj;
-
 }
 
 /**
@@ -774,16 +773,31 @@ inline void api_remove_event::setObject(mspec_rule_key key, msg::anslp_mspec_obj
 	if ( obj == NULL )
 	return;
 	
-	msg::anslp_mspec_object *old = mspec_objects[key];
+	msg::anslp_mspec_object *old = mspec_objects.exchange(key, obj);
 
 	if ( old )
 		delete old;
 
-	mspec_objects[key] = obj;
-
 }
 
 
+/**
+ * An API notification that auctions were created or removed.
+ *
+ * Answers to earlier check requests may be wrong now, so they must not 
+ * be reused. The event doesn't belong to a session.
+ */
+class api_auctions_changed_event : public api_event {
+  public:
+	api_auctions_changed_event() : api_event() { }
+	virtual ~api_auctions_changed_event() { }
+
+	virtual ostream &print(ostream &out) const {
+		return out << "[api_auctions_changed_event]"; }
+
+};
+
+
 
 /**
  * Check if the event is a timer event with the given timer ID.
@@ -850,6 +864,11 @@ inline bool is_api_remove(const event *evt)
 	return dynamic_cast<const api_remove_event *>(evt) != NULL;
 }
 
+inline bool is_api_auctions_changed(const event *evt) 
+{
+	return dynamic_cast<const api_auctions_changed_event *>(evt) != NULL;
+}
+
 
 inline bool is_routing_state_check(const event *evt) 
 {
@@ -932,6 +951,17 @@ inline bool is_anslp_refresh(const event *evt)
 		return e->get_refresh() != NULL;
 }
 
+inline bool is_anslp_summary_refresh(const event *evt) 
+{
+	const msg_event *e = dynamic_cast<const msg_event *>(evt);
+
+	if ( e == NULL )
+		return false;
+	else
+		return dynamic_cast<anslp_summary_refresh *>(
+					e->get_anslp_msg()) != NULL;
+}
+
 inline bool is_anslp_notify(const event *evt) 
 {
 	const msg_event *e = dynamic_cast<const msg_event *>(evt);
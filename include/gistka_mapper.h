@@ -36,6 +36,7 @@
 #include "events.h"
 #include "anslp_timers.h"
 #include "msg/ntlp_msg.h"
+#include "msg/wire_image.h"
 
 
 namespace anslp {
@@ -54,12 +55,20 @@ class gistka_mapper {
   public:
 	event *map_to_event(const protlib::message *msg) const;
 
+	bool is_session_setup(const protlib::message *msg) const;
+
 	ntlp::APIMsg *create_api_msg(msg::ntlp_msg *msg) const throw ();
+	
+	ntlp::APIMsg *create_api_msg(const msg::ntlp_msg *msg,
+		const msg::wire_image &image) const throw ();
 
 	ntlp::sessionid *create_ntlp_session_id(const session_id &sid) const;
 	session_id *create_anslp_session_id(ntlp::sessionid *sid) const;
 
   private:
+	ntlp::APIMsg *create_api_msg(ntlp::nslpdata *data, 
+		const msg::ntlp_msg *msg) const throw ();
+	
 	event *map_api_message(const ntlp::APIMsg *msg) const;
 	event *map_api_receive_message(const ntlp::APIMsg *msg) const;
 	event *map_api_network_notification(const ntlp::APIMsg *msg) const;
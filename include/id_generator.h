@@ -0,0 +1,101 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file id_generator.h
+/// Per-thread generator for random 128 bit identifiers.
+/// ----------------------------------------------------------
+/// $Id: id_generator.h 2558 2016-03-14 10:12:00 amarentes $
+/// $HeadURL: https://./include/id_generator.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_ID_GENERATOR_H
+#define ANSLP_ID_GENERATOR_H
+
+#include <cstddef>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint128;
+
+/**
+ * \class id_generator
+ *
+ * \brief Fast source of random identifiers for session ids and mspec keys.
+ *
+ * Every thread owns a pool of cryptographically strong random bytes that
+ * is refilled from OpenSSL in one call whenever it runs dry. Identifiers
+ * are cut from the pool, so the common case neither enters the kernel nor
+ * takes any lock, while each identifier still carries 128 random bits.
+ *
+ * Bytes handed out are never reused, two threads never share a pool.
+ * A failed refill is fatal: the process aborts rather than hand out
+ * bytes that were already used.
+ *
+ * \author Andres Marentes
+ *
+ * \version 0.1 
+ *
+ * \date 2016/03/14 10:12:00
+ *
+ * Contact: la.marentes455@uniandes.edu.co
+ *  
+ */
+class id_generator {
+
+  public:
+  
+	/// Size in bytes of the per-thread random pool.
+	static const size_t POOL_SIZE = 4096;
+
+	/**
+	 * Fill the given buffer with random bytes taken from the pool of 
+	 * the calling thread.
+	 * 
+	 * @param buf	 buffer to fill
+	 * @param length number of bytes to write into buf
+	 */
+	static void generate(unsigned char *buf, size_t length);
+
+	/**
+	 * Return a random 128 bit value.
+	 */
+	static void generate(uint128 &id);
+	
+	/**
+	 * Number of times the calling thread refilled its pool. 
+	 * Used by tests and benchmarks.
+	 */
+	static unsigned long get_refill_count();
+
+  private:
+  
+	// Only static methods, no instances.
+	id_generator();
+	
+	static void refill();
+};
+
+} // namespace anslp
+
+#endif // ANSLP_ID_GENERATOR_H
@@ -0,0 +1,103 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file install_backlog.h
+/// Watermarks and bound of the queue to the auction application.
+/// ----------------------------------------------------------
+/// $Id: install_backlog.h 2558 2016-04-24 10:00:00 amarentes $
+/// $HeadURL: https://./include/install_backlog.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_INSTALL_BACKLOG_H
+#define ANSLP_INSTALL_BACKLOG_H
+
+#include <iostream>
+#include <stdint.h>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Counters describing the queue to the auction application.
+ */
+struct install_backlog_stats {
+	uint32 occupancy;			///< events queued when last looked at
+	uint32 max_occupancy;		///< the most events queued at once
+	uint64_t filled;			///< times the high watermark was reached
+	uint64_t refused;			///< events not queued because it was full
+	uint64_t throttled;			///< CREATEs and BIDDINGs rejected meanwhile
+};
+
+std::ostream &operator<<(std::ostream &out, const install_backlog_stats &s);
+
+
+/**
+ * Keeps track of the events waiting for the auction application.
+ *
+ * When the number of queued events reaches the high watermark, the 
+ * backlog is full: the dispatchers reject new sessions and biddings 
+ * until it drops to the low watermark. Events beyond the capacity are
+ * not queued at all, except essential ones like session removals which
+ * the application must see to release its state.
+ *
+ * The dispatcher threads report the occupancy regularly using update(),
+ * so the backlog drains while nothing is queued. Threads queueing events
+ * ask admit() first; concurrent threads may exceed the capacity by one
+ * event each.
+ *
+ * A watermark or capacity of 0 disables the respective check. Instances
+ * of this class are thread-safe and shared among dispatchers.
+ */
+class install_backlog {
+
+  public:
+	install_backlog(uint32 capacity, uint32 high_watermark, 
+					uint32 low_watermark);
+
+	bool update(size_t occupancy);
+
+	bool admit(size_t occupancy, bool essential);
+
+	inline bool is_full() const { return full != 0; }
+
+	void count_throttled();
+
+	install_backlog_stats get_stats() const;
+
+  private:
+	uint32 capacity;
+	uint32 high_watermark;
+	uint32 low_watermark;
+
+	volatile int full;
+
+	mutable install_backlog_stats stats;
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_INSTALL_BACKLOG_H
@@ -52,6 +52,12 @@ class lock
 		// Release the lock by forwarding to the
 		// polymorphic release() method.
 		int release (void) { return lock_->release (); }
+		
+		// Acquire the lock for reading only.
+		int acquire_shared (void) { return lock_->acquire_shared (); }
+		
+		// Release a lock acquired for reading.
+		int release_shared (void) { return lock_->release_shared (); }
 
 	private:
 
@@ -0,0 +1,115 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file lock_profile.h
+/// Wait and hold time histograms of a lock.
+/// ----------------------------------------------------------
+/// $Id: lock_profile.h 2558 2016-04-19 09:30:00 amarentes $
+/// $HeadURL: https://./include/lock_profile.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_LOCK_PROFILE_H
+#define ANSLP_LOCK_PROFILE_H
+
+#include <string>
+#include <iostream>
+#include <stdint.h>
+#include <signal.h>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * A snapshot of the counters of a lock_profile.
+ *
+ * Bucket i of a histogram counts the times in [2^i, 2^(i+1)) nanoseconds,
+ * bucket 0 also counts zero.
+ */
+struct lock_profile_stats {
+	static const uint32 NUM_BUCKETS = 40;
+
+	std::string name;
+	uint64_t acquisitions;		///< times the lock was acquired
+	uint64_t contended;			///< acquisitions that had to wait
+	uint64_t total_wait_ns;		///< sum of all waiting times
+	uint64_t max_wait_ns;		///< longest wait for the lock
+	uint64_t total_hold_ns;		///< sum of all holding times
+	uint64_t max_hold_ns;		///< longest time the lock was held
+	uint64_t wait[NUM_BUCKETS];	///< histogram of the waiting times
+	uint64_t hold[NUM_BUCKETS];	///< histogram of the holding times
+
+	uint64_t get_percentile(const uint64_t *histogram, uint32 percent) const;
+};
+
+std::ostream &operator<<(std::ostream &out, const lock_profile_stats &s);
+
+
+/**
+ * Wait and hold time histograms of a lock, or of a group of locks.
+ *
+ * A profiled lock reports, for each acquisition, how long it waited and
+ * whether the lock was taken by another thread, and on release, how long
+ * it held the lock. Many locks may share a profile, for example all the
+ * locks of one session type.
+ *
+ * Recording uses atomic operations only, so instances of this class are
+ * thread-safe and add no lock of their own.
+ */
+class lock_profile {
+
+  public:
+	explicit lock_profile(const std::string &name);
+
+	void record_acquire(uint64_t wait_ns, bool contended);
+
+	void record_release(uint64_t hold_ns);
+
+	lock_profile_stats get_stats() const;
+
+	static uint64_t now_ns();
+
+	static uint32 get_bucket(uint64_t ns);
+
+	static void request_dump();
+
+	static bool claim_dump();
+
+  private:
+	lock_profile_stats stats;
+
+	static volatile sig_atomic_t dump_pending;
+
+	static void update_max(uint64_t *max, uint64_t value);
+
+	// Disallow copying, the counters are updated in place.
+	lock_profile(const lock_profile &other);
+	lock_profile &operator=(const lock_profile &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_LOCK_PROFILE_H
@@ -46,6 +46,13 @@ class lockable
 		
 		// Release the lock.
 		virtual int release (void) = 0;
+		
+		// Acquire the lock for reading only. Unless overridden, this 
+		// is the same as acquire().
+		virtual int acquire_shared (void) { return acquire(); }
+		
+		// Release a lock acquired by acquire_shared().
+		virtual int release_shared (void) { return release(); }
 
 };
 
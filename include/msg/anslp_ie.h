@@ -49,6 +49,8 @@ enum category_t {
 	cat_default_anslp_object	= 3
 };
 
+class anslp_object;
+
 /**
  * An Interface for reading/writing ANSLP Messages.
  *
@@ -63,6 +65,9 @@ enum category_t {
  *
  * The only way to get an ANSLP_IEManager object is through the static
  * instance() method.
+ *
+ * With lazy decoding enabled, mspec objects are read as anslp_raw_object
+ * placeholders; decode_object() turns them into the registered IE later.
  */
 class ANSLP_IEManager : public IEManager {
 
@@ -70,7 +75,12 @@ class ANSLP_IEManager : public IEManager {
 	static ANSLP_IEManager *instance();
 	static void clear();
 
-	static void register_known_ies();
+	static void register_known_ies(bool opaque_mspec = false);
+
+	static void set_lazy_decoding(bool lazy);
+	static bool is_lazy_decoding();
+
+	anslp_object *decode_object(NetMsg &msg, IEErrorList &errorlist);
 
 	virtual IE *deserialize(NetMsg &msg, uint16 category,
 			IE::coding_t coding, IEErrorList &errorlist,
@@ -85,6 +95,9 @@ class ANSLP_IEManager : public IEManager {
   private:
   
 	static ANSLP_IEManager *anslp_inst;
+	static bool lazy_decoding;
+
+	bool is_deferrable(uint16 object_type);
 
 	IE *deserialize_msg(NetMsg &msg,
 		IE::coding_t coding, IEErrorList &errorlist,
@@ -92,7 +105,7 @@ class ANSLP_IEManager : public IEManager {
 
 	IE *deserialize_object(NetMsg &msg,
 		IE::coding_t coding, IEErrorList &errorlist,
-		uint32 &bytes_read, bool skip);
+		uint32 &bytes_read, bool skip, bool defer);
 };
 
 
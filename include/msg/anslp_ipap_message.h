@@ -129,6 +129,12 @@ public:
 	 */
 	virtual size_t get_serialized_size(coding_t coding) const;
 	
+	/**
+	 * The IPAP message is public and may change behind our back, so its
+	 * size is not cached. Computing it only reads the export offset.
+	 */
+	virtual bool has_stable_size() const { return false; }
+	
 	/**
 	 * We say that a IPAP message is ok whenever executing the output 
 	 * method, the character representing the message has a length greater 
@@ -162,6 +168,11 @@ public:
 	 */
 	virtual void serialize_body(NetMsg &msg) const;
 	
+	/**
+	 * Digest of the exported message plus padding, null if the message
+	 * has not been exported since it last changed.
+	 */
+	virtual content_digest compute_digest() const;
 	
 };
 
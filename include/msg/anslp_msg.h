@@ -86,11 +86,14 @@ class anslp_msg : public IE {
 	virtual bool has_msg_sequence_number() const;
 	virtual uint32 get_msg_sequence_number() const;
 
+	content_digest get_digest() const;
+
 	static uint8 extract_msg_type(uint32 header_raw) throw ();
 
-  protected:
 	static const uint16 HEADER_LENGTH;
 
+  protected:
+
 	// protected constructors to prevent instantiation
 	explicit anslp_msg();
 	explicit anslp_msg(uint8 msg_type);
@@ -98,15 +101,19 @@ class anslp_msg : public IE {
 
 	virtual size_t get_num_objects() const;
 	virtual anslp_object *get_object(ie_object_key &object_type) const;
+	virtual anslp_object *peek_object(ie_object_key &object_type) const;
 	virtual void set_object(anslp_object *obj);
 	virtual anslp_object *remove_object(ie_object_key &object_type);
 
+	void decode_all() const;
+
 	virtual void set_msg_type(uint8 mt);
 
 	/**
-	 * Map ANSLP Object Type to anslp_object.
+	 * Map ANSLP Object Type to anslp_object. Objects received with lazy
+	 * decoding are replaced on first access, even through const methods.
 	 */
-	ie_store objects;
+	mutable ie_store objects;
 	typedef ie_store::const_iterator obj_iter;
 
 
@@ -118,6 +125,13 @@ class anslp_msg : public IE {
 	 */
 	uint8 msg_type;
 
+	/**
+	 * True while some object may still be an anslp_raw_object.
+	 */
+	mutable bool has_pending;
+
+	anslp_object *decode_pending(ie_object_key &key, IE *ie) const;
+
 };
 
   } // namespace msg
@@ -130,6 +144,7 @@ class anslp_msg : public IE {
 #include "anslp_create.h"
 #include "anslp_bidding.h"
 #include "anslp_refresh.h"
+#include "anslp_summary_refresh.h"
 #include "anslp_notify.h"
 
 #endif // ANSLP_MSG_ANSLP_MSG_H
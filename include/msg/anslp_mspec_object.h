@@ -75,6 +75,14 @@ class anslp_mspec_object : public anslp_object
 	
 	virtual bool notEqual(const anslp_mspec_object &object) const = 0;
 
+	/**
+	 * Return the digest of the serialized body, padding included. It is
+	 * computed on first use and kept as long as the body can't change.
+	 */
+	const content_digest &get_digest() const;
+
+	virtual void update_digest(digest_builder &builder) const;
+
 
   protected:
 
@@ -89,6 +97,11 @@ class anslp_mspec_object : public anslp_object
 			IEErrorList &err, bool skip) = 0;
 
 	virtual void serialize_body(NetMsg &msg) const = 0;
+
+	virtual content_digest compute_digest() const = 0;
+
+  private:
+	mutable content_digest digest;	///< Cached digest, null if not known yet
 	
 };
 
@@ -32,6 +32,8 @@
 
 #include "ie.h"
 
+#include "content_digest.h"
+
 namespace anslp 
 {
   namespace msg {
@@ -92,6 +94,10 @@ class anslp_object : public IE {
 
 	static uint16 extract_object_type(uint32 header_raw) throw ();
 
+	size_t get_cached_size(coding_t coding) const;
+
+	virtual void update_digest(digest_builder &builder) const;
+
   protected:
 	/**
 	 * Length of a anslp Object header in bytes.
@@ -124,7 +130,20 @@ class anslp_object : public IE {
 
 	virtual void serialize_body(NetMsg &msg) const = 0;
 
+	/**
+	 * Return false if the body may change without this object noticing,
+	 * so its serialized size can't be cached.
+	 */
+	virtual bool has_stable_size() const { return true; }
+
+	/**
+	 * Forget the cached serialized size, called whenever the size changes.
+	 */
+	inline void invalidate_size() const { serialized_size = 0; }
+
   private:
+	mutable uint32 serialized_size;	///< Cached size, 0 if not known yet
+	
 	uint16 object_type;
 	bool unique;				///< This value identifies if the object must be unique within the message.
 	treatment_t treatment;
@@ -145,6 +164,7 @@ class anslp_object : public IE {
 #include "selection_auctioning_entities.h"
 #include "msg_sequence_number.h"
 #include "message_hop_count.h"
+#include "session_refresh_list.h"
 
 
 
@@ -0,0 +1,120 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file anslp_opaque_mspec.h
+/// An mspec object carried as uninterpreted bytes.
+/// ----------------------------------------------------------
+/// $Id: anslp_opaque_mspec.h 2558 2016-04-01 10:15:00 amarentes $
+/// $HeadURL: https://./include/msg/anslp_opaque_mspec.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_MSG_OPAQUE_MSPEC_H
+#define ANSLP_MSG_OPAQUE_MSPEC_H
+
+#include "anslp_mspec_object.h"
+#include "anslp_ipap_message.h"
+#include "shared_bytes.h"
+
+
+namespace anslp {
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * \class anslp_opaque_mspec
+ *
+ * \brief An mspec object whose body is never decoded.
+ *
+ * Forwarders that neither install auction rules nor act as auctioneers 
+ * never look inside the IPAP messages they pass on. For them this class 
+ * is registered instead of anslp_ipap_message: the body is kept as the 
+ * received byte range and written back unchanged when the object is 
+ * serialized again.
+ *
+ * The bytes are immutable and shared between copies, so copying an object 
+ * into a rule or into the forwarded message costs the same whatever the 
+ * size of the mspec.
+ *
+ * \author Andres Marentes
+ *
+ * \version 0.1 
+ *
+ * \date 2016/04/01 10:15:00
+ *
+ * Contact: la.marentes455@uniandes.edu.co
+ *  
+ */
+class anslp_opaque_mspec : public anslp_mspec_object
+{
+
+  public:
+	static const uint16 OBJECT_TYPE = anslp_ipap_message::OBJECT_TYPE;
+
+	explicit anslp_opaque_mspec();
+	
+	explicit anslp_opaque_mspec(const uchar *data, uint16 length, 
+								treatment_t t = tr_mandatory);
+
+	virtual ~anslp_opaque_mspec();
+
+	virtual anslp_opaque_mspec *new_instance() const;
+	virtual anslp_opaque_mspec *copy() const;
+
+	virtual size_t get_serialized_size(coding_t coding) const;
+	virtual bool check_body() const;
+	virtual bool equals_body(const anslp_object &other) const;
+	virtual const char *get_ie_name() const;
+	virtual ostream &print_attributes(ostream &os) const;
+
+	virtual bool isEqual(const anslp_mspec_object &object) const;
+	virtual bool notEqual(const anslp_mspec_object &object) const;
+
+	virtual bool deserialize_body(NetMsg &msg, uint16 body_length,
+			IEErrorList &err, bool skip);
+
+	virtual void serialize_body(NetMsg &msg) const;
+
+	virtual content_digest compute_digest() const;
+
+	/*
+	 * New methods
+	 */
+	const uchar *get_body() const;
+	uint16 get_body_length() const;
+
+  private:
+	// Disallow assignment for now.
+	anslp_opaque_mspec &operator=(const anslp_opaque_mspec &other);
+
+	static const char *const ie_name;
+
+	shared_bytes body;
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_OPAQUE_MSPEC_H
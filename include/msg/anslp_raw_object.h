@@ -0,0 +1,107 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file anslp_raw_object.h
+/// An ANSLP object whose body has not been decoded yet.
+/// ----------------------------------------------------------
+/// $Id: anslp_raw_object.h 2558 2016-04-04 16:40:00 amarentes $
+/// $HeadURL: https://./include/msg/anslp_raw_object.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_MSG_RAW_OBJECT_H
+#define ANSLP_MSG_RAW_OBJECT_H
+
+#include "anslp_object.h"
+#include "shared_bytes.h"
+
+
+namespace anslp {
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * \class anslp_raw_object
+ *
+ * \brief An ANSLP object whose body has not been decoded yet.
+ *
+ * With lazy decoding enabled, ANSLP_IEManager stores the mspec objects of a
+ * received message in this form: only the header is parsed, the body is 
+ * kept as received. anslp_msg replaces the placeholder by the real object
+ * the first time it is accessed. A message that is rejected before that, 
+ * or forwarded as it is, never pays for decoding its mspec objects.
+ *
+ * This class is never registered with ANSLP_IEManager.
+ *
+ * \author Andres Marentes
+ *
+ * \version 0.1 
+ *
+ * \date 2016/04/04 16:40:00
+ *
+ * Contact: la.marentes455@uniandes.edu.co
+ *  
+ */
+class anslp_raw_object : public anslp_object {
+
+  public:
+	explicit anslp_raw_object();
+
+	virtual ~anslp_raw_object();
+
+	virtual anslp_raw_object *new_instance() const;
+	virtual anslp_raw_object *copy() const;
+
+	virtual size_t get_serialized_size(coding_t coding) const;
+	virtual bool check_body() const;
+	virtual bool equals_body(const anslp_object &other) const;
+	virtual const char *get_ie_name() const;
+	virtual ostream &print_attributes(ostream &os) const;
+
+	virtual bool deserialize_body(NetMsg &msg, uint16 body_length,
+			IEErrorList &err, bool skip);
+
+	virtual void serialize_body(NetMsg &msg) const;
+
+	virtual void update_digest(digest_builder &builder) const;
+
+	/*
+	 * New methods
+	 */
+	anslp_object *decode(IEErrorList &errorlist) const;
+
+  private:
+	// Disallow assignment for now.
+	anslp_raw_object &operator=(const anslp_raw_object &other);
+
+	static const char *const ie_name;
+
+	shared_bytes body;
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_RAW_OBJECT_H
@@ -0,0 +1,64 @@
+/*
+ * A ANSLP SUMMARY REFRESH Message.
+ *
+ * $Id: anslp_summary_refresh.h 2016-03-17  $
+ * $HeadURL: https://./include/msg/anslp_summary_refresh.h $
+ */
+#ifndef ANSLP_SUMMARY_REFRESH_H
+#define ANSLP_SUMMARY_REFRESH_H
+
+#include "ie.h"
+
+#include "anslp_msg.h"
+#include "session_refresh_list.h"
+
+
+namespace anslp {
+  namespace msg {
+
+
+/**
+ * A ANSLP Summary Refresh Message.
+ *
+ * Refreshes several sessions established through the same peer at once. 
+ * The message carries one session_refresh_list object, the receiver 
+ * handles every entry as if a single REFRESH message with that session id,
+ * message sequence number and lifetime had arrived.
+ */
+class anslp_summary_refresh : public anslp_msg {
+
+  public:
+	static const uint16 MSG_TYPE = 0x7;
+
+	explicit anslp_summary_refresh();
+	explicit anslp_summary_refresh(const anslp_summary_refresh &other);
+	virtual ~anslp_summary_refresh();
+
+	/*
+	 * Inherited methods:
+	 */
+	anslp_summary_refresh *new_instance() const;
+	anslp_summary_refresh *copy() const;
+	void register_ie(IEManager *iem) const;
+	virtual void serialize(NetMsg &msg, coding_t coding, uint32 &bytes_written) const throw (IEError);
+	virtual bool check() const;
+
+	/*
+	 * New methods:
+	 */
+	bool add_session(const uint128 &sid, uint32 msn, uint32 lifetime);
+
+	size_t get_num_sessions() const;
+	
+	const session_refresh_list::entry &get_session(size_t i) const;
+
+  protected:
+	session_refresh_list *get_session_refresh_list() const;
+
+};
+
+
+  } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_SUMMARY_REFRESH_H
@@ -0,0 +1,118 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file content_digest.h
+/// A 128 bit digest of an object's contents.
+/// ----------------------------------------------------------
+/// $Id: content_digest.h 2558 2016-04-11 09:30:00 amarentes $
+/// $HeadURL: https://./include/msg/content_digest.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_MSG_CONTENT_DIGEST_H
+#define ANSLP_MSG_CONTENT_DIGEST_H
+
+#include <cstddef>
+
+#include "protlib_types.h"
+
+
+namespace anslp {
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * A 128 bit digest of the contents of an object or message.
+ *
+ * Digests let us tell a retransmitted message from a new one without
+ * comparing the objects field by field. The hash is not cryptographic:
+ * equal digests are only trusted where the sender could as well have
+ * sent the original message again.
+ *
+ * A default constructed digest is null, meaning that no contents were 
+ * hashed. Computed digests are never null.
+ */
+class content_digest {
+
+  public:
+	content_digest() : high(0), low(0) { }
+	content_digest(uint64 high, uint64 low) : high(high), low(low) { }
+
+	static content_digest compute(const uchar *data, size_t length);
+
+	inline bool is_null() const { return high == 0 && low == 0; }
+
+	inline uint64 get_high() const { return high; }
+	inline uint64 get_low() const { return low; }
+
+	inline bool operator==(const content_digest &other) const {
+		return high == other.high && low == other.low;
+	}
+
+	inline bool operator!=(const content_digest &other) const {
+		return ! (*this == other);
+	}
+
+  private:
+	uint64 high;
+	uint64 low;
+};
+
+
+/**
+ * Builds a content_digest from a sequence of byte ranges.
+ *
+ * This is MurmurHash3 (x64, 128 bit) fed incrementally, so the result 
+ * only depends on the concatenated bytes, not on how they were split 
+ * into update() calls.
+ */
+class digest_builder {
+
+  public:
+	digest_builder();
+
+	void update(const uchar *data, size_t length);
+	void update(uint32 value);
+	void update(const content_digest &digest);
+
+	content_digest finish() const;
+
+  private:
+	static const size_t BLOCK_SIZE = 16;
+
+	uint64 h1;
+	uint64 h2;
+	uint64 total;
+
+	uchar tail[BLOCK_SIZE];
+	size_t tail_length;
+
+	void mix_block(const uchar *block);
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_CONTENT_DIGEST_H
@@ -79,13 +79,13 @@ public:
 		return ((object_type == rhs.object_type) && (seq_nbr == rhs.seq_nbr)); 
 	}
 
-	/** less operator. a key field is less than other when the sum of its 
-	*    attributes is less that the same sum for the key field given as 
-	*    parameter.
+	/** less operator. Keys are ordered by object type first and by 
+	*    sequence number within the same object type.
 	*/ 
 	inline bool operator< (const ie_object_key& rhs) const
 	{
-		return (object_type + seq_nbr) < (rhs.object_type + rhs.seq_nbr ); 
+		return (object_type < rhs.object_type) 
+			|| ((object_type == rhs.object_type) && (seq_nbr < rhs.seq_nbr)); 
 	}
 
 	/** 
@@ -30,7 +30,8 @@
 #ifndef PROTLIB__IE_STORE_H
 #define PROTLIB__IE_STORE_H
 
-#include <map>
+#include <utility>
+#include <vector>
 
 #include "ie.h"
 #include "ie_object_key.h"
@@ -43,8 +44,13 @@ namespace protlib
 /**
  * Stores (ID, IE) mappings.
  *
- * This is a helper class intented for internal use. It mainly specializes
- * std::map and takes care of memory management issues.
+ * This is a helper class intented for internal use. It keeps the entries
+ * in a vector sorted by ID and takes care of memory management issues.
+ *
+ * A message holds only a handful of objects, so the whole store fits in
+ * one or two cache lines: a lookup is a short binary search over 
+ * contiguous memory and building or copying a message allocates once 
+ * instead of once per tree node.
  */
 class ie_store 
 {
@@ -62,26 +68,36 @@ class ie_store
 	bool operator==(const ie_store &other) const throw();
 	uint32 getMaxSequence(uint32 id) const;
 
-	typedef std::map<ie_object_key, IE *>::const_iterator const_iterator;
+	typedef std::pair<ie_object_key, IE *> entry_t;
+	typedef std::vector<entry_t>::const_iterator const_iterator;
 
 	const_iterator begin() const throw() { return entries.begin(); }
 	const_iterator end() const throw() { return entries.end(); }
 
   private:
 	/**
-	 * Maps IDs to IEs.
+	 * Enough for the objects of any message without mspec objects.
+	 */
+	static const size_t INITIAL_CAPACITY = 8;
+
+	/**
+	 * The entries, sorted by ID.
 	 *
 	 * Note: Don't use __gnu_cxx::hash_map here. It is vector-based and
 	 *       *extremely* expensive to initialize. The constructor eats
 	 *       up much more processing time than we can ever gain by the
 	 *       cheaper lookup method.
 	 */
-	std::map<ie_object_key, IE *> entries;
+	std::vector<entry_t> entries;
 
 	/**
-	 * Shortcut.
+	 * Shortcuts.
 	 */
 	typedef const_iterator c_iter;
+	typedef std::vector<entry_t>::iterator iter;
+
+	iter find(const ie_object_key &id) throw();
+	c_iter find(const ie_object_key &id) const throw();
 };
 
 
@@ -0,0 +1,123 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file session_refresh_list.h
+/// The Session Refresh List Object.
+/// ----------------------------------------------------------
+/// $Id: session_refresh_list.h 2558 2016-03-17 11:05:00 amarentes $
+/// $HeadURL: https://./include/msg/session_refresh_list.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_MSG_SESSION_REFRESH_LIST_H
+#define ANSLP_MSG_SESSION_REFRESH_LIST_H
+
+#include <vector>
+
+#include "protlib_types.h"
+#include "anslp_object.h"
+
+
+namespace anslp 
+{
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * \class session_refresh_list
+ *
+ * \brief List of sessions refreshed by a summary refresh message.
+ *
+ * Each entry carries the session id together with the message sequence 
+ * number and the session lifetime the single REFRESH message for that 
+ * session would have carried.
+ *
+ * \author Andres Marentes
+ *
+ * \version 0.1 
+ *
+ * \date 2016/03/17 11:05:00
+ *
+ * Contact: la.marentes455@uniandes.edu.co
+ *  
+ */
+class session_refresh_list : public anslp_object {
+
+  public:
+	static const uint16 OBJECT_TYPE = 0x00FA;
+	
+	/// Size of a serialized entry in bytes.
+	static const uint16 ENTRY_LENGTH = 24;
+	
+	/// Maximum number of entries fitting into one object.
+	static const uint32 MAX_ENTRIES = (0xFFF * 4) / ENTRY_LENGTH;
+
+	struct entry {
+		uint128 sid;
+		uint32 msn;
+		uint32 lifetime;
+	};
+
+	explicit session_refresh_list();
+	explicit session_refresh_list(treatment_t t, bool _unique = true);
+
+	virtual ~session_refresh_list();
+
+	virtual session_refresh_list *new_instance() const;
+	virtual session_refresh_list *copy() const;
+
+	virtual size_t get_serialized_size(coding_t coding) const;
+	virtual bool check_body() const;
+	virtual bool equals_body(const anslp_object &other) const;
+	virtual const char *get_ie_name() const;
+	virtual ostream &print_attributes(ostream &os) const;
+
+
+	virtual bool deserialize_body(NetMsg &msg, uint16 body_length,
+			IEErrorList &err, bool skip);
+
+	virtual void serialize_body(NetMsg &msg) const;
+
+
+	/*
+	 * New methods
+	 */
+	bool add_entry(const uint128 &sid, uint32 msn, uint32 lifetime);
+	
+	size_t get_num_entries() const;
+	
+	const entry &get_entry(size_t i) const;
+
+  private:
+	// Disallow assignment for now.
+	session_refresh_list &operator=(const session_refresh_list &other);
+
+	static const char *const ie_name;
+
+	std::vector<entry> entries;
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_SESSION_REFRESH_LIST_H
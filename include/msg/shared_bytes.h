@@ -0,0 +1,81 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file shared_bytes.h
+/// An immutable byte range shared between copies.
+/// ----------------------------------------------------------
+/// $Id: shared_bytes.h 2558 2016-04-04 16:40:00 amarentes $
+/// $HeadURL: https://./include/msg/shared_bytes.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_MSG_SHARED_BYTES_H
+#define ANSLP_MSG_SHARED_BYTES_H
+
+#include "protlib_types.h"
+
+
+namespace anslp {
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * An immutable byte range shared between copies.
+ *
+ * Objects that carry bytes exactly as they were received use this to make
+ * their copies cheap: copying only takes another reference, and the last
+ * owner frees the storage. The reference count is atomic, so copies may 
+ * be released by different threads.
+ */
+class shared_bytes {
+
+  public:
+	shared_bytes();
+	shared_bytes(const uchar *data, uint16 length);
+	shared_bytes(const shared_bytes &other);
+	~shared_bytes();
+
+	shared_bytes &operator=(const shared_bytes &other);
+	bool operator==(const shared_bytes &other) const;
+
+	const uchar *get_data() const;
+	uint16 get_length() const;
+
+  private:
+	struct block {
+		volatile uint32 refs;
+		uint16 length;
+		uchar data[1];
+	};
+
+	void release();
+
+	block *blk;
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_SHARED_BYTES_H
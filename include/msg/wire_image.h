@@ -0,0 +1,97 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file wire_image.h
+/// The serialized form of an outbound A-NSLP message.
+/// ----------------------------------------------------------
+/// $Id: wire_image.h 2558 2016-03-30 09:20:00 amarentes $
+/// $HeadURL: https://./include/msg/wire_image.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_MSG_WIRE_IMAGE_H
+#define ANSLP_MSG_WIRE_IMAGE_H
+
+#include "protlib_types.h"
+#include "network_message.h"
+
+#include "anslp_msg.h"
+
+
+namespace anslp 
+{
+ namespace msg {
+
+    using namespace protlib;
+
+
+/**
+ * \class wire_image
+ *
+ * \brief The serialized form of a message that may be sent again.
+ *
+ * Sessions keep the wire image of their last CREATE or REFRESH message, 
+ * so retransmissions don't copy and serialize the whole message again.
+ * The message sequence number is the only field that changes between 
+ * sends of an otherwise unchanged message, it is patched in place.
+ *
+ * \author Andres Marentes
+ *
+ * \version 0.1 
+ *
+ * \date 2016/03/30 09:20:00
+ *
+ * Contact: la.marentes455@uniandes.edu.co
+ */
+class wire_image {
+
+  public:
+	wire_image();
+	
+	~wire_image();
+
+	void assign(const anslp_msg *msg);
+	
+	void clear();
+
+	inline bool is_empty() const { return image == NULL; }
+
+	bool set_msg_sequence_number(uint32 msn);
+	
+	uchar *get_buffer() const;
+	
+	uint32 get_size() const;
+
+  private:
+	NetMsg *image;
+	
+	/// Position of the MSN value in the image, 0 if there is none.
+	uint32 msn_offset;
+
+	// Not copyable, images may be large.
+	wire_image(const wire_image &other);
+	wire_image &operator=(const wire_image &other);
+};
+
+
+ } // namespace msg
+} // namespace anslp
+
+#endif // ANSLP_MSG_WIRE_IMAGE_H
@@ -0,0 +1,143 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file mspec_object_list.h
+/// Flat container of mspec objects keyed by rule key.
+/// ----------------------------------------------------------
+/// $Id: mspec_object_list.h 2558 2016-04-08 10:20:00 amarentes $
+/// $HeadURL: https://./include/mspec_object_list.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#ifndef ANSLP_MSPEC_OBJECT_LIST_H
+#define ANSLP_MSPEC_OBJECT_LIST_H
+
+#include <vector>
+#include <utility>
+
+#include "mspec_rule_key.h"
+#include "msg/anslp_mspec_object.h"
+
+
+namespace anslp 
+{
+
+/**
+ * A list of mspec objects keyed by their mspec_rule_key.
+ *
+ * Most auction rules and events carry just a few objects, so entries are
+ * kept in a single vector in insertion order and lookups scan the keys,
+ * which are compared as plain 16 byte blocks. The first insert reserves
+ * room for INLINE_CAPACITY entries, so a small list costs one allocation
+ * instead of one per object. Once a list grows beyond INDEX_THRESHOLD
+ * entries an open addressing hash index on the keys is kept as well.
+ *
+ * The interface follows the std::map subset used by the sessions: the
+ * elements are pairs whose first member is the key and whose second is
+ * the object. Like std::map, operator[] inserts a NULL object for an
+ * unknown key. Unlike std::map, inserting or erasing invalidates the
+ * iterators, so erasing while iterating has to use erase(iterator).
+ *
+ * The list doesn't own the objects.
+ */
+class mspec_object_list {
+
+  public:
+	typedef mspec_rule_key key_type;
+	typedef msg::anslp_mspec_object *mapped_type;
+	typedef std::pair<mspec_rule_key, msg::anslp_mspec_object *> value_type;
+	typedef std::vector<value_type>::size_type size_type;
+	typedef std::vector<value_type>::iterator iterator;
+	typedef std::vector<value_type>::const_iterator const_iterator;
+	typedef std::vector<value_type>::reverse_iterator reverse_iterator;
+	typedef std::vector<value_type>::const_reverse_iterator 
+													const_reverse_iterator;
+
+	static const size_type INLINE_CAPACITY = 4;
+	static const size_type INDEX_THRESHOLD = 16;
+
+	mspec_object_list();
+
+	mspec_object_list(const mspec_object_list &other);
+
+	~mspec_object_list();
+
+	mspec_object_list &operator=(const mspec_object_list &other);
+
+	inline iterator begin() { return entries.begin(); }
+	inline const_iterator begin() const { return entries.begin(); }
+	inline iterator end() { return entries.end(); }
+	inline const_iterator end() const { return entries.end(); }
+
+	inline reverse_iterator rbegin() { return entries.rbegin(); }
+	inline const_reverse_iterator rbegin() const { return entries.rbegin(); }
+	inline reverse_iterator rend() { return entries.rend(); }
+	inline const_reverse_iterator rend() const { return entries.rend(); }
+
+	inline size_type size() const { return entries.size(); }
+	inline bool empty() const { return entries.empty(); }
+
+	iterator find(const mspec_rule_key &key);
+
+	const_iterator find(const mspec_rule_key &key) const;
+
+	msg::anslp_mspec_object *&operator[](const mspec_rule_key &key);
+
+	/**
+	 * Store obj under key and return the object stored before, or NULL
+	 * if the key was not in the list.
+	 */
+	msg::anslp_mspec_object *exchange(const mspec_rule_key &key,
+									  msg::anslp_mspec_object *obj);
+
+	size_type erase(const mspec_rule_key &key);
+
+	/**
+	 * Remove the entry at pos and return an iterator to the entry that
+	 * followed it.
+	 */
+	iterator erase(iterator pos);
+
+	void clear();
+
+	/// Return true if the list keeps a hash index, mainly for tests.
+	inline bool is_indexed() const { return ! index.empty(); }
+
+  private:
+	std::vector<value_type> entries;
+
+	/// Open addressing table of positions in entries plus one, 0 is free.
+	std::vector<size_type> index;
+
+	size_type lookup(const mspec_rule_key &key) const;
+
+	iterator append(const mspec_rule_key &key, msg::anslp_mspec_object *obj);
+
+	void insert_index(size_type pos);
+
+	void rebuild_index();
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_MSPEC_OBJECT_LIST_H
@@ -31,6 +31,9 @@
 #define MSPEC_RULE_KEY_H
 
 #include <uuid/uuid.h>
+#include <cstring>
+#include <cstddef>
+#include <string>
 
 namespace anslp 
 {
@@ -68,14 +71,22 @@ public:
 	
 	/// Copy contructor - Constructs a copy of mspec_rule_key.
 	mspec_rule_key(const mspec_rule_key &rul_key);
+
+	/// Constructs the key with the given SIZE bytes, see get_bytes().
+	explicit mspec_rule_key(const unsigned char *bytes);
 	
 	/// Destructor of the field key
 	~mspec_rule_key();
 		
 	/**
 	 *  Equals to operator. It is equal when they have the same uuids.
+	 *  Object lists compare keys on every lookup, so this is a plain
+	 *  16 byte compare.
 	 */
-	bool operator ==(const mspec_rule_key &rhs) const;
+	inline bool operator ==(const mspec_rule_key &rhs) const
+	{
+		return memcmp(uuid, rhs.uuid, sizeof(uuid)) == 0;
+	}
 
 	/** 
 	 * less operator. 
@@ -95,6 +106,25 @@ public:
 	 * Return the key represented as string. 
 	 */
 	std::string to_string() const;
+
+	/**
+	 * Return the SIZE bytes of the key, to store it in binary form.
+	 */
+	inline const unsigned char *get_bytes() const { return uuid; }
+
+	/// Length of a key in bytes.
+	static const std::size_t SIZE = sizeof(uuid_t);
+
+	/**
+	 * Return a hash value for the key. Keys are random (version 4)
+	 * uuids, so the first bytes are already well distributed.
+	 */
+	inline std::size_t hash() const
+	{
+		std::size_t val;
+		memcpy(&val, uuid, sizeof(val));
+		return val;
+	}
 	
 	/** 
 	 * Not equal to operator. 
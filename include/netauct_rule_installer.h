@@ -32,6 +32,7 @@
 
 #include "auction_rule_installer.h"
 #include "aqueue.h"
+#include "install_backlog.h"
 
 namespace anslp 
 {
@@ -54,7 +55,8 @@ class netauct_rule_installer : public auction_rule_installer
 	
   public:
 
-	netauct_rule_installer(anslp_config *conf, FastQueue *installQueue, bool test=false) throw ();
+	netauct_rule_installer(anslp_config *conf, FastQueue *installQueue, bool test=false,
+						   install_backlog *backlog=NULL) throw ();
 
 	virtual ~netauct_rule_installer() throw ();
 
@@ -97,6 +99,10 @@ class netauct_rule_installer : public auction_rule_installer
   
   private:
 	
+	//! Throws an exception if the install queue has no room for the event.
+	void admit_event(AnslpEvent *evt, bool essential)
+			throw (auction_rule_installer_error);
+	
 	//! Cast the object to the ipap_message.
 	const msg::anslp_ipap_message * get_ipap_message(const msg::anslp_mspec_object *object);
 	
@@ -115,6 +121,9 @@ class netauct_rule_installer : public auction_rule_installer
 	
 	FastQueue *installQueue;
 	
+	//! Bound of the install queue, shared among installers, not owned.
+	install_backlog *backlog;
+	
 	bool test;
 };
 
@@ -0,0 +1,82 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file netmsg_pool.h
+/// Per-thread pool of serialization buffers.
+/// ----------------------------------------------------------
+/// $Id: netmsg_pool.h 2558 2016-03-28 11:30:00 amarentes $
+/// $HeadURL: https://./include/netmsg_pool.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_NETMSG_POOL_H
+#define ANSLP_NETMSG_POOL_H
+
+#include "protlib_types.h"
+#include "network_message.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+    using protlib::NetMsg;
+
+
+/**
+ * A per-thread pool of NetMsg buffers used for serializing messages.
+ *
+ * Buffers come in a few size classes. A buffer is taken from the smallest
+ * class that fits and goes back to the pool of the calling thread, so a
+ * dispatcher thread sending messages doesn't allocate a buffer for each
+ * of them. Sizes beyond the largest class are allocated and freed as
+ * usual.
+ *
+ * A thread using the pool has to call clear() before it exits.
+ */
+class netmsg_pool {
+
+  public:
+	static NetMsg *acquire(uint32 size);
+	
+	static void release(NetMsg *msg);
+
+	static void clear();
+
+	static uint32 get_num_allocated();
+
+	/// Number of size classes.
+	static const uint32 NUM_CLASSES = 5;
+	
+	/// Size of the smallest class, each class is four times the previous.
+	static const uint32 MIN_CLASS_SIZE = 256;
+	
+	/// Maximum number of idle buffers kept per class and thread.
+	static const uint32 MAX_IDLE = 4;
+
+  private:
+	static int get_class(uint32 size);
+
+	static uint32 get_class_size(int c);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_NETMSG_POOL_H
@@ -53,12 +53,22 @@ class nf_session : public session {
 	
   public:
   
-	nf_session(const session_id &id, const anslp_config *conf);
+	nf_session(const session_id &id, const anslp_config *conf, lock *l = NULL);
 	
 	~nf_session();
 
 	bool is_final() const; // inherited from session
 
+	bool is_outdated_timer(const event *evt) const; // inherited from session
+
+	const ntlp::mri *get_refresh_mri() const; // inherited from session
+
+	bool save_state(NetMsg &msg) const; // inherited from session
+
+	bool restore_state(dispatcher *d, NetMsg &msg); // inherited from session
+
+	void get_state_mark(state_mark &mark) const; // inherited from session
+
   protected:
 	/**
 	 * States of a session.
@@ -198,6 +208,15 @@ inline bool nf_session::is_final() const {
 	return get_state() == STATE_ANSLP_CLOSE;
 }
 
+inline bool nf_session::is_outdated_timer(const event *evt) const {
+	return is_timer(evt) && ! is_timer(evt, state_timer) 
+		&& ! is_timer(evt, response_timer);
+}
+
+inline const ntlp::mri *nf_session::get_refresh_mri() const {
+	return nr_mri; // the MRI of the CREATE, headed downstream
+}
+
 inline void nf_session::set_last_create_message(msg::ntlp_msg *msg) {
 	delete(create_message);
 	create_message = msg;
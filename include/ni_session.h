@@ -36,6 +36,7 @@
 #include "events.h"
 #include "anslp_timers.h"
 #include "msg/ntlp_msg.h"
+#include "msg/wire_image.h"
 #include <stdexcept>
 
 
@@ -68,12 +69,20 @@ class ni_session : public session {
 	
   public:
   
-	ni_session(const session_id &id, const anslp_config *conf);
+	ni_session(const session_id &id, const anslp_config *conf, lock *l = NULL);
 	
 	~ni_session();
 
 	bool is_final() const; // inherited from session
 
+	bool is_outdated_timer(const event *evt) const; // inherited from session
+
+	bool save_state(NetMsg &msg) const; // inherited from session
+
+	bool restore_state(dispatcher *d, NetMsg &msg); // inherited from session
+
+	void get_state_mark(state_mark &mark) const; // inherited from session
+
   protected:
 	/**
 	 * States of a session.
@@ -113,13 +122,16 @@ class ni_session : public session {
 	inline uint32 get_refresh_interval() const { return refresh_interval; }
 	inline void set_refresh_interval(uint32 sec) { refresh_interval = sec; }
 	inline void cal_refresh_interval() { refresh_interval = (uint32) lifetime * 2/3; }
+	uint32 get_refresh_deadline() const;
 
 	inline uint32 get_lifetime() const { return lifetime; }
-	inline void set_lifetime(uint32 seconds) { lifetime = seconds; }
+	void set_lifetime(uint32 seconds);
 
 	inline ntlp::mri *get_mri() const { return routing_info; }
 	void set_mri(ntlp::mri *m);
 
+	inline uint32 get_peer_sii_handle() const { return peer_sii_handle; }
+
 	inline bool is_proxy_mode() const { return proxy_mode; }
 	
 	inline void set_proxy_mode(bool value) { proxy_mode = value; }
@@ -157,6 +169,14 @@ class ni_session : public session {
 	 */
 	msg::ntlp_msg *last_refresh_msg;
 
+	/*
+	 * The serialized form of the two messages above, used to send them 
+	 * again without copying and serializing them. Empty until they are
+	 * sent the first time.
+	 */
+	msg::wire_image last_create_image;
+	msg::wire_image last_refresh_image;
+
 
 	/*
 	 * The AUCTION RULE to install. We keep it because we need it for
@@ -184,6 +204,27 @@ class ni_session : public session {
 	timer response_timer;
 	timer refresh_timer;
 
+	/*
+	 * Nominal time and deadline of the pending refresh, as timestamps of
+	 * refresh_scheduler::now_ms(). The refresh scheduler may defer a due
+	 * refresh, but not beyond its deadline.
+	 */
+	uint64_t refresh_due_ms;
+	uint64_t refresh_deadline_ms;
+
+	/*
+	 * The SII handle of the GIST peer that confirmed the session, 0 if 
+	 * unknown. REFRESH messages carry it, so the summary refresh collector
+	 * can group them by next hop.
+	 */
+	uint32 peer_sii_handle;
+
+	/*
+	 * Set if the MRI or lifetime changed after the last REFRESH was built,
+	 * so the next REFRESH has to be built from scratch.
+	 */
+	bool refresh_outdated;
+
 	/*
 	 * State machine methods:
 	 */
@@ -196,6 +237,8 @@ class ni_session : public session {
 	/*
 	 * Utility methods:
 	 */
+	void start_refresh_timer(dispatcher *d);
+	void prepare_refresh_message();
 	void setup_session(dispatcher *d, 
 					   api_create_event *evt,
 					   std::vector<msg::anslp_mspec_object *> &missing_objects);
@@ -225,6 +268,12 @@ inline bool ni_session::is_final() const
 	return get_state() == STATE_ANSLP_CLOSE;
 }
 
+inline bool ni_session::is_outdated_timer(const event *evt) const 
+{
+	return is_timer(evt) && ! is_timer(evt, response_timer) 
+		&& ! is_timer(evt, refresh_timer);
+}
+
 inline void ni_session::inc_create_counter() 
 {
 	create_counter++;
@@ -250,12 +299,15 @@ inline void ni_session::set_last_create_message(msg::ntlp_msg *msg)
 {
 	delete last_create_msg;
 	last_create_msg = msg;
+	last_create_image.clear();
 }
 
 inline void ni_session::set_last_refresh_message(msg::ntlp_msg *msg) 
 {
 	delete last_refresh_msg;
 	last_refresh_msg = msg;
+	last_refresh_image.clear();
+	refresh_outdated = false;
 }
 
 inline void ni_session::set_last_auction_install_rule(auction_rule *act) 
@@ -275,6 +327,15 @@ inline void ni_session::set_mri(ntlp::mri *m)
 {
 	delete routing_info;
 	routing_info = m;
+	refresh_outdated = true;
+}
+
+inline void ni_session::set_lifetime(uint32 seconds) 
+{
+	if ( seconds != lifetime )
+		refresh_outdated = true;
+
+	lifetime = seconds;
 }
 
 
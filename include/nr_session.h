@@ -53,11 +53,21 @@ class nr_session : public session {
 	
   public:
   
-	nr_session(const session_id &id, anslp_config *conf);
+	nr_session(const session_id &id, anslp_config *conf, lock *l = NULL);
 	
 	~nr_session();
 
 	bool is_final() const; // inherited from session
+
+	bool is_outdated_timer(const event *evt) const; // inherited from session
+
+	const ntlp::mri *get_refresh_mri() const; // inherited from session
+
+	bool save_state(NetMsg &msg) const; // inherited from session
+
+	bool restore_state(dispatcher *d, NetMsg &msg); // inherited from session
+
+	void get_state_mark(state_mark &mark) const; // inherited from session
 	
 	uint32 get_msg_bidding_sequence_number() const { return msn_bidding; }		
 	
@@ -188,6 +198,17 @@ inline bool nr_session::is_final() const
 	return get_state() == STATE_ANSLP_CLOSE;
 }
 
+inline bool nr_session::is_outdated_timer(const event *evt) const 
+{
+	return is_timer(evt) && ! is_timer(evt, state_timer) 
+		&& ! is_timer(evt, response_timer);
+}
+
+inline const ntlp::mri *nr_session::get_refresh_mri() const 
+{
+	return routing_info;
+}
+
 
 inline void nr_session::set_auction_rule(auction_rule *r) 
 {
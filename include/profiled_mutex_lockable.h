@@ -0,0 +1,75 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file profiled_mutex_lockable.h
+/// A mutex lockable recording its wait and hold times.
+/// ----------------------------------------------------------
+/// $Id: profiled_mutex_lockable.h 2558 2016-04-19 09:30:00 amarentes $
+/// $HeadURL: https://./include/profiled_mutex_lockable.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_PROFILED_MUTEX_LOCKABLE_H
+#define ANSLP_PROFILED_MUTEX_LOCKABLE_H
+
+#include "lockable.h"
+#include "lock_profile.h"
+#include <pthread.h>
+#include <assert.h>
+
+namespace anslp 
+{
+
+/**
+ * A mutex that records its wait and hold times in a lock_profile.
+ *
+ * The mutex is first tried without blocking. Only if that fails, the
+ * acquisition counts as contended and the waiting time is measured, so
+ * uncontended locking costs one extra clock read for the hold time.
+ */
+class profiled_mutex_lockable: public lockable
+{
+	public:
+		// The profile is shared, it isn't deleted by the destructor.
+		profiled_mutex_lockable (lock_profile *profile);
+
+		// Destructor for the class.
+		~profiled_mutex_lockable();
+		
+		// Acquire the lock.
+		virtual int acquire (void);
+
+		// Release the lock.
+		virtual int release (void);
+	
+	private:
+		
+		// Concrete lock type.
+		pthread_mutex_t	mutex;
+		
+		lock_profile *profile;
+		
+		// The time the lock was acquired, only valid while it is held.
+		uint64_t acquired_ns;
+};
+
+} // namespace anslp
+
+#endif // ANSLP_PROFILED_MUTEX_LOCKABLE_H
@@ -0,0 +1,148 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file refresh_scheduler.h
+/// Spreads session refreshes over time and toward peers.
+/// ----------------------------------------------------------
+/// $Id: refresh_scheduler.h 2558 2016-03-21 10:15:00 amarentes $
+/// $HeadURL: https://./include/refresh_scheduler.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_REFRESH_SCHEDULER_H
+#define ANSLP_REFRESH_SCHEDULER_H
+
+#include <map>
+#include <string>
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "protlib_types.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Counters describing how refreshes were scheduled.
+ *
+ * Delays are measured between the nominal refresh time and the time the
+ * refresh was actually sent, margins between sending and the deadline.
+ */
+struct refresh_scheduler_stats {
+	uint64_t scheduled;			///< refresh timers started
+	uint64_t sent;				///< refreshes admitted for sending
+	uint64_t deferred_queue;	///< deferrals because of a deep input queue
+	uint64_t deferred_peer;		///< deferrals because of the peer's rate
+	uint64_t late;				///< refreshes sent after their deadline
+	uint64_t total_delay_ms;	///< sum of delays of all sent refreshes
+	uint64_t max_delay_ms;		///< largest delay of a sent refresh
+	uint64_t min_margin_ms;		///< smallest margin to the deadline
+};
+
+std::ostream &operator<<(std::ostream &out, const refresh_scheduler_stats &s);
+
+
+/**
+ * Central scheduler for session refreshes.
+ *
+ * Sessions created in a burst would refresh in a burst forever if each 
+ * one refreshed exactly after its refresh interval. The scheduler instead
+ * picks, within a jitter window ending at the nominal interval, the least
+ * loaded time slot, so refreshes spread evenly over time.
+ *
+ * When a refresh is due, admit() decides whether it may be sent now. A 
+ * refresh is deferred, as long as its deadline allows, if the dispatcher 
+ * input queue is deeper than the configured threshold or if the outbound
+ * token bucket of its peer is empty. Refreshes reaching their deadline
+ * are always sent.
+ *
+ * Instances of this class are thread-safe and shared among dispatchers.
+ */
+class refresh_scheduler {
+
+  public:
+  
+	refresh_scheduler(uint32 jitter_percent, uint32 peer_rate, 
+					  uint32 peer_burst, uint32 queue_threshold);
+	
+	~refresh_scheduler();
+
+	uint32 schedule(uint32 interval_ms, uint32 deadline_ms);
+
+	uint32 admit(const std::string &peer, uint64_t due_ms, 
+				 uint64_t deadline_ms);
+
+	inline void set_queue_depth(size_t depth) { queue_depth = depth; }
+
+	refresh_scheduler_stats get_stats() const;
+
+	static uint64_t now_ms();
+
+	/// Granularity of the schedule in milliseconds.
+	static const uint32 SLOT_MS = 100;
+	
+	/// Number of slots tracked, this limits the horizon of the schedule.
+	static const uint32 NUM_SLOTS = 8192;
+	
+	/// Maximum number of slots compared when scheduling a refresh.
+	/// They are spread across the whole jitter window.
+	static const uint32 MAX_CANDIDATES = 32;
+	
+	/// Maximum time a refresh is deferred at once.
+	static const uint32 MAX_DEFER_MS = 1000;
+
+  private:
+  
+	struct bucket_t {
+		double tokens;
+		uint64_t last_ms;
+	};
+
+	struct slot_t {
+		uint64_t number;
+		uint32 count;
+	};
+
+	uint32 jitter_percent;
+	uint32 peer_rate;
+	uint32 peer_burst;
+	uint32 queue_threshold;
+	
+	volatile size_t queue_depth;
+
+	mutable pthread_mutex_t mutex;
+	
+	slot_t *slots;
+	
+	std::map<std::string, bucket_t> buckets;
+	
+	refresh_scheduler_stats stats;
+	
+	bool take_token(const std::string &peer, uint64_t now, uint32 &wait_ms);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_REFRESH_SCHEDULER_H
@@ -0,0 +1,75 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file rw_lockable.h
+/// A lockable that lets readers share the lock.
+/// ----------------------------------------------------------
+/// $Id: rw_lockable.h 2558 2016-04-20 11:00:00 amarentes $
+/// $HeadURL: https://./include/rw_lockable.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_RW_LOCKABLE_H
+#define ANSLP_RW_LOCKABLE_H
+
+#include "lockable.h"
+#include <pthread.h>
+#include <assert.h>
+
+namespace anslp 
+{
+
+/**
+ * A reader/writer lock.
+ *
+ * acquire() takes the lock exclusively, acquire_shared() together with
+ * other readers. Waiting writers are preferred, if the platform allows,
+ * so a steady stream of readers can't starve the state machine.
+ */
+class rw_lockable: public lockable
+{
+	public:
+		// Constructor for the class.
+		rw_lockable ();
+
+		// Destructor for the class.
+		~rw_lockable();
+		
+		// Acquire the lock exclusively.
+		virtual int acquire (void);
+
+		// Release the lock.
+		virtual int release (void);
+		
+		// Acquire the lock for reading only.
+		virtual int acquire_shared (void);
+		
+		// Release a lock acquired for reading.
+		virtual int release_shared (void);
+	
+	private:
+		
+		// Concrete lock type.
+		pthread_rwlock_t rwlock;
+};
+
+} // namespace anslp
+
+#endif // ANSLP_RW_LOCKABLE_H
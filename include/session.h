@@ -29,24 +29,40 @@
 #ifndef ANSLP_SESSION_H
 #define ANSLP_SESSION_H
 
+#include <assert.h>
+
 #include "protlib_types.h"
 #include "session_id.h"
 #include "address.h"
 #include "auction_rule.h"
 #include "lock.h"
+#include "duplicate_filter.h"
 #include <vector>
 
 
+namespace ntlp 
+{
+	class mri;
+	class mri_pathcoupled;
+}
+
 namespace anslp 
 {
     using protlib::uint8;
     using protlib::uint32;
     using protlib::hostaddress;
+    using protlib::NetMsg;
 
 class dispatcher;
 class event;
 class msg_event;
 class api_install_event;
+class timer;
+
+namespace msg 
+{
+	class ntlp_msg;
+}
 
 
 /**
@@ -111,6 +127,41 @@ inline std::ostream &operator<<(std::ostream &os, const request_error &err) {
 	return os << err.get_msg();
 }
 
+/**
+ * The values of a session that change whenever its saved state changes.
+ *
+ * Comparing two marks is much cheaper than serializing the session, so
+ * the session manager writes a session to the store only if its mark
+ * differs from the one of the last save.
+ */
+class state_mark {
+
+  public:
+	state_mark() : num_values(0) { }
+
+	inline void add(protlib::uint64 value) {
+		assert( num_values < MAX_VALUES );
+		values[num_values++] = value;
+	}
+
+	inline void add(const void *ptr) { add((protlib::uint64) (size_t) ptr); }
+
+	void add(const timer &t);
+
+	bool operator==(const state_mark &other) const;
+
+	inline bool operator!=(const state_mark &other) const { 
+		return ! (*this == other);
+	}
+
+  private:
+	static const int MAX_VALUES = 16;
+
+	protlib::uint64 values[MAX_VALUES];
+	int num_values;
+};
+
+
 /**
  * The abstract session class.
  *
@@ -155,6 +206,55 @@ class session {
 	int acquire();
 	
 	int release();
+
+	int acquire_shared();
+	
+	int release_shared();
+
+	/**
+	 * Check whether the event is a timer the session no longer waits for.
+	 *
+	 * Every state discards outdated timers without a change, so the 
+	 * dispatcher checks this holding the lock shared only. The default 
+	 * implementation treats all timers as current.
+	 */
+	virtual bool is_outdated_timer(const event *evt) const;
+
+	/**
+	 * Return the MRI a REFRESH for this session arrives with.
+	 *
+	 * Summary refreshes carry a single MRI for many sessions, so the
+	 * dispatcher uses this one for each session they list. The caller 
+	 * holds the lock at least shared. The default returns NULL (unknown).
+	 */
+	virtual const ntlp::mri *get_refresh_mri() const;
+
+	/**
+	 * Write what is needed to resume the session after a restart to msg.
+	 *
+	 * Only sessions in a stable state are written, the others return
+	 * false and are set up again by signaling. Subclasses call this
+	 * method first, it writes the state common to all sessions.
+	 */
+	virtual bool save_state(NetMsg &msg) const;
+
+	/**
+	 * Read a state written by save_state() and restart the timers.
+	 *
+	 * Returns false if the state can't be used.
+	 */
+	virtual bool restore_state(dispatcher *d, NetMsg &msg);
+
+	/**
+	 * Add the values to the mark that change whenever the state written
+	 * by save_state() changes: the state, the MSNs, the lifetime, the 
+	 * timers and the objects owned. Subclasses call this method first.
+	 */
+	virtual void get_state_mark(state_mark &mark) const;
+
+	bool has_unsaved_changes() const;
+
+	void set_saved(bool saved) const;
 		
   protected:
   
@@ -183,6 +283,25 @@ class session {
 
 	void set_reponse_objects(anslp::api_install_event *install, auction_rule *act_rule);
 
+	/*
+	 * Helpers for save_state() and restore_state(). The restore methods
+	 * return NULL or false if the saved data is damaged.
+	 */
+	static void save_timer(NetMsg &msg, const timer &t);
+	static void restore_timer(dispatcher *d, NetMsg &msg, timer &t);
+
+	static void save_time(NetMsg &msg, protlib::uint64 ms);
+	static protlib::uint64 restore_time(NetMsg &msg);
+
+	static bool save_mri(NetMsg &msg, const ntlp::mri *m);
+	static ntlp::mri_pathcoupled *restore_mri(NetMsg &msg);
+
+	static void save_rule(NetMsg &msg, const auction_rule *r);
+	static auction_rule *restore_rule(NetMsg &msg);
+
+	static bool save_message(NetMsg &msg, const msg::ntlp_msg *m);
+	static bool restore_message(NetMsg &msg, msg::ntlp_msg *&m);
+
 	auction_rule *rule;
 
   private:
@@ -195,6 +314,16 @@ class session {
 	
 	uint32 msg_hop_count;
 
+	/// Recently received messages, to answer retransmissions.
+	duplicate_filter duplicates;
+
+	/*
+	 * The mark at the last time the session manager saved the session.
+	 * Only the session manager uses them, holding the session's lock.
+	 */
+	mutable state_mark saved_mark;
+	mutable bool saved;
+
 	// The locking object, it can be giving for implementing Strategized Locking Pattern
 	// if nothing is given, it creates a locking by default. 
 	// In any case the session object is the owner of this memory and delete it. 
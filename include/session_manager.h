@@ -29,6 +29,7 @@
 #ifndef ANSLP_SESSION_MANAGER_H
 #define ANSLP_SESSION_MANAGER_H
 
+#include <vector>
 #include <ext/hash_map>
 
 #include "protlib_types.h"
@@ -37,16 +38,14 @@
 #include "ni_session.h"
 #include "nf_session.h"
 #include "nr_session.h"
+#include "epoch_manager.h"
+#include "session_store.h"
+#include "lock_profile.h"
 
 
 namespace anslp 
 {
 
-	//! list of done auctions
-	typedef list<session*>            sessionDone_t;
-	typedef list<session*>::iterator  sessionDoneIter_t;
-
-
 /**
  * The session manager.
  *
@@ -55,6 +54,15 @@ namespace anslp
  * session factory, because it can verify that a created session_id is really
  * unique on this node.
  *
+ * Removed sessions are not deleted right away, because other threads may
+ * still use a pointer returned by get_session(). Threads using sessions
+ * have to do so inside a critical section (see epoch_guard), removed
+ * sessions are deleted once all those critical sections ended.
+ *
+ * With a session store, the dispatcher saves each session after it has
+ * processed an event, and restore_sessions() brings the saved sessions
+ * back after a restart.
+ *
  * Instances of this class are thread-safe.
  */
 class session_manager 
@@ -62,7 +70,7 @@ class session_manager
 
   public:
   
-	session_manager(anslp_config *conf);
+	session_manager(anslp_config *conf, session_store *store=NULL);
 	
 	~session_manager();
 
@@ -76,30 +84,60 @@ class session_manager
 	
 	session *remove_session(const session_id &sid);
 
+	void save_session(const session *s);
+
+	uint32 restore_sessions(dispatcher *d);
+
+	inline epoch_manager &get_epoch_manager() { return epochs; }
+
+	inline bool has_store() const { return store != NULL && store->is_open(); }
+
+	std::vector<lock_profile_stats> get_lock_profiles() const;
+
   private:
   
 	pthread_mutex_t mutex;
 	
 	anslp_config *config; // shared by many objects, don't delete
+	session_store *store; // may be NULL, don't delete
 	
 	hash_map<session_id, session *> session_table;
 	
-	sessionDone_t sessionDone;
+	epoch_manager epochs;
 	
 	typedef hash_map<session_id, session *>::const_iterator c_iter;
 
-	session_id create_unique_id() const;
+	enum lock_type_t {
+		lt_mutex,
+		lt_spin,
+		lt_rwlock
+	};
 
-	// Large initial size to avoid resizing of the session table.
-	static const int SESSION_TABLE_SIZE = 500000;
+	/// The lock strategy of new sessions.
+	lock_type_t lock_type;
+	uint32 lock_spins;
+
+	/// Record wait and hold times of the table and the session locks.
+	bool profiling;
 	
-	static const int DONE_SESSION_LIST_SIZE = 300; 
+	lock_profile table_profile;
+	lock_profile ni_profile;
+	lock_profile nf_profile;
+	lock_profile nr_profile;
+	
+	/// The time the table was locked, only valid while it is locked.
+	uint64_t table_locked_ns;
+
+	session_id create_unique_id() const;
+
+	void lock_table();
 	
-	/*! \short add the session to the list of finished sessions
+	void unlock_table();
+
+	lock *create_lock(lock_profile &profile);
 
-       \arg \c session - session to be set as done
-    */
-    void store_session_asdone(session *s);
+	// Large initial size to avoid resizing of the session table.
+	static const int SESSION_TABLE_SIZE = 500000;
 };
 
 
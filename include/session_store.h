@@ -0,0 +1,165 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file session_store.h
+/// Memory-mapped store of session snapshots.
+/// ----------------------------------------------------------
+/// $Id: session_store.h 2558 2016-04-15 09:40:00 amarentes $
+/// $HeadURL: https://./include/session_store.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_SESSION_STORE_H
+#define ANSLP_SESSION_STORE_H
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+#include <ext/hash_map>
+
+#include "protlib_types.h"
+#include "session_id.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Counters describing the work of the session store.
+ */
+struct session_store_stats {
+	uint64_t writes;			///< snapshots written to a slot
+	uint64_t unchanged;			///< snapshots equal to the stored one
+	uint64_t erased;			///< snapshots removed
+	uint64_t rejected;			///< snapshots too large or without a slot
+};
+
+std::ostream &operator<<(std::ostream &out, const session_store_stats &s);
+
+
+/**
+ * A file of session snapshots, mapped into memory.
+ *
+ * The file consists of a header and a fixed number of slots of SLOT_SIZE
+ * bytes. Each slot holds the snapshot of one session: a slot header with
+ * the session ID, the snapshot's length, a sequence number and a checksum,
+ * followed by the snapshot itself. The store doesn't interpret snapshots,
+ * they are written and read by the sessions (see session::save_state()).
+ *
+ * A changed snapshot is written to a free slot first and the old slot is
+ * released afterwards, so the file always contains a complete snapshot
+ * of every session, even if the daemon dies while writing. Should both
+ * slots survive, the one with the higher sequence number wins. Only if 
+ * the store is full, the old slot is overwritten. Writes go
+ * to the mapped pages only; the kernel writes them back, so the file 
+ * survives a restart of the daemon, but not necessarily of the host.
+ *
+ * Instances of this class are thread-safe.
+ */
+class session_store {
+
+  public:
+	typedef std::vector< std::pair<session_id, std::string> > record_list_t;
+
+	session_store();
+
+	~session_store();
+
+	bool open(const std::string &filename, uint32 num_slots);
+
+	void close();
+
+	inline bool is_open() const { return base != NULL; }
+
+	bool put(const session_id &sid, const uchar *data, uint32 length);
+
+	bool erase(const session_id &sid);
+
+	void reject(const session_id &sid);
+
+	void get_records(record_list_t &records) const;
+
+	uint32 size() const;
+
+	session_store_stats get_stats() const;
+
+	/// Size of a slot in the file, including its header.
+	static const uint32 SLOT_SIZE = 4096;
+
+	/// Maximum length of a session's snapshot.
+	static const uint32 MAX_RECORD_SIZE = SLOT_SIZE - 32;
+
+	static const uint32 FILE_MAGIC = 0x414E5353;	// "ANSS"
+	static const uint32 SLOT_MAGIC = 0x534C4F54;	// "SLOT"
+	static const uint32 VERSION = 1;
+
+  private:
+	struct file_header_t {
+		uint32 magic;
+		uint32 version;
+		uint32 slot_size;
+		uint32 num_slots;
+	};
+
+	struct slot_header_t {
+		uint32 magic;				// SLOT_MAGIC if in use, 0 otherwise
+		uint32 length;
+		uint32 sequence;
+		uint32 checksum;
+		uint32 sid[4];
+	};
+
+	mutable pthread_mutex_t mutex;
+
+	int fd;
+	uchar *base;
+	size_t mapped_size;
+	uint32 num_slots;
+	uint32 sequence;
+
+	/// The slot of each stored session.
+	hash_map<session_id, uint32> slots;
+
+	std::vector<uint32> free_slots;
+
+	session_store_stats stats;
+
+	slot_header_t *get_slot(uint32 slot) const;
+
+	bool is_valid(const slot_header_t *h) const;
+
+	void recover();
+
+	static uint32 checksum(const slot_header_t *h, const uchar *data);
+
+	// Disallow copying, the store owns its mapping.
+	session_store(const session_store &other);
+	session_store &operator=(const session_store &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_SESSION_STORE_H
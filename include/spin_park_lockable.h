@@ -0,0 +1,80 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file spin_park_lockable.h
+/// A lockable that spins briefly before it blocks.
+/// ----------------------------------------------------------
+/// $Id: spin_park_lockable.h 2558 2016-04-20 11:00:00 amarentes $
+/// $HeadURL: https://./include/spin_park_lockable.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_SPIN_PARK_LOCKABLE_H
+#define ANSLP_SPIN_PARK_LOCKABLE_H
+
+#include "lockable.h"
+#include "protlib_types.h"
+#include <pthread.h>
+#include <assert.h>
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+/**
+ * A mutex that spins for a while before the thread is put to sleep.
+ *
+ * Most session critical sections are only a few microseconds long, so a
+ * thread finding the lock taken often gets it soon after. Spinning avoids
+ * the cost of sleeping and waking up in that case. The number of spins is
+ * adapted to how many were needed recently, but never exceeds the given
+ * maximum, after which the thread blocks on the mutex.
+ */
+class spin_park_lockable: public lockable
+{
+	public:
+		spin_park_lockable (uint32 max_spins = DEFAULT_MAX_SPINS);
+
+		// Destructor for the class.
+		~spin_park_lockable();
+		
+		// Acquire the lock.
+		virtual int acquire (void);
+
+		// Release the lock.
+		virtual int release (void);
+
+		static const uint32 DEFAULT_MAX_SPINS = 100;
+	
+	private:
+		
+		// Concrete lock type.
+		pthread_mutex_t	mutex;
+		
+		uint32 max_spins;
+		
+		// Moving average of the spins that were needed, only written 
+		// while the lock is held.
+		volatile uint32 spin_estimate;
+};
+
+} // namespace anslp
+
+#endif // ANSLP_SPIN_PARK_LOCKABLE_H
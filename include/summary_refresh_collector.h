@@ -0,0 +1,108 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file summary_refresh_collector.h
+/// Collects REFRESH messages to send them as summary refreshes.
+/// ----------------------------------------------------------
+/// $Id: summary_refresh_collector.h 2558 2016-03-17 15:20:00 amarentes $
+/// $HeadURL: https://./include/summary_refresh_collector.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_SUMMARY_REFRESH_COLLECTOR_H
+#define ANSLP_SUMMARY_REFRESH_COLLECTOR_H
+
+#include <map>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <pthread.h>
+
+#include "protlib_types.h"
+#include "msg/ntlp_msg.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+
+/**
+ * Groups outgoing REFRESH messages by peer into summary refreshes.
+ *
+ * Instead of sending one REFRESH per session, the dispatcher hands each
+ * REFRESH to this collector. REFRESH messages toward the same peer are 
+ * merged into one anslp_summary_refresh that lists session id, MSN and
+ * lifetime of every session. A batch is released when it is full or when
+ * its oldest refresh waited for the configured delay. A batch holding a
+ * single refresh is released as the original REFRESH message.
+ *
+ * The peer is the SII handle if GIST already told us one, otherwise the
+ * destination address and direction of the path-coupled MRI, since all
+ * flows toward it take the same next hop.
+ *
+ * Instances of this class are thread-safe and shared among dispatchers.
+ */
+class summary_refresh_collector {
+
+  public:
+  
+	summary_refresh_collector(uint32 max_sessions, uint32 max_delay_ms);
+	
+	~summary_refresh_collector();
+
+	bool collects(const msg::ntlp_msg *msg) const;
+
+	bool add(msg::ntlp_msg *msg, std::vector<msg::ntlp_msg *> &ready);
+
+	void flush(bool all, std::vector<msg::ntlp_msg *> &ready);
+	
+	size_t get_num_pending() const;
+
+	static bool get_peer_key(const ntlp::mri *mri, uint32 sii_handle,
+							 std::string &key);
+
+  private:
+  
+	struct batch_t {
+		msg::ntlp_msg *first;
+		msg::anslp_summary_refresh *summary;
+		struct timespec started;
+	};
+	
+	typedef std::map<std::string, batch_t> batch_map_t;
+	
+	uint32 max_sessions;
+	
+	uint32 max_delay_ms;
+
+	mutable pthread_mutex_t mutex;
+	
+	batch_map_t batches;
+	
+	static bool get_peer_key(const msg::ntlp_msg *msg, std::string &key);
+	
+	static msg::ntlp_msg *release(batch_t &batch);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_SUMMARY_REFRESH_COLLECTOR_H
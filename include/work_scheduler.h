@@ -0,0 +1,161 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file work_scheduler.h
+/// Per-worker deques of session batches with work stealing.
+/// ----------------------------------------------------------
+/// $Id: work_scheduler.h 2558 2016-04-23 10:00:00 amarentes $
+/// $HeadURL: https://./include/work_scheduler.h $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#ifndef ANSLP_WORK_SCHEDULER_H
+#define ANSLP_WORK_SCHEDULER_H
+
+#include <deque>
+#include <vector>
+#include <iostream>
+#include <stdint.h>
+#include <pthread.h>
+#include <ext/hash_map>
+
+#include "protlib_types.h"
+#include "session_id.h"
+
+
+namespace anslp 
+{
+    using protlib::uint32;
+
+class event;
+
+
+/**
+ * Counters describing the work of the scheduler.
+ */
+struct work_scheduler_stats {
+	uint64_t pushed;			///< events handed to the scheduler
+	uint64_t batches;			///< batches taken by dispatcher threads
+	uint64_t stolen;			///< batches taken from another thread's deque
+};
+
+std::ostream &operator<<(std::ostream &out, const work_scheduler_stats &s);
+
+
+/**
+ * Distributes events among dispatcher threads.
+ *
+ * Each dispatcher thread has a deque of batches. A batch holds the 
+ * queued events of one session, in order. An event for a session that 
+ * has a batch already is appended to it, otherwise a new batch is put
+ * on the deque of the session's home thread. A thread takes batches 
+ * from its own deque first. If it is empty, it steals the oldest batch
+ * of another thread.
+ *
+ * A session has at most one batch, which is queued on one deque or 
+ * processed by one thread, so the events of a session are processed 
+ * one after another, in order. Events arriving while their batch is 
+ * processed are put on the deque of the processing thread afterwards. 
+ * Events without a session get a batch of their own.
+ *
+ * Sessions are looked up in shards, each with its own lock, and each 
+ * deque has its own lock, so dispatcher threads rarely contend.
+ * Instances of this class are thread-safe and shared among dispatchers.
+ */
+class work_scheduler {
+
+  public:
+	struct batch;
+
+	work_scheduler(uint32 num_workers);
+
+	~work_scheduler();
+
+	uint32 register_worker();
+
+	void push(event *evt);
+
+	batch *pop(uint32 worker, std::vector<event *> &events);
+
+	void done(uint32 worker, batch *b);
+
+	bool wait(uint32 timeout_ms);
+
+	bool begin_ingress();
+
+	void end_ingress();
+
+	inline size_t size() const { return num_queued; }
+
+	work_scheduler_stats get_stats() const;
+
+	static const uint32 NUM_SHARDS = 16;
+
+  private:
+	typedef __gnu_cxx::hash_map<session_id, batch *> batch_table_t;
+
+	struct shard_t {
+		pthread_mutex_t mutex;
+		batch_table_t batches;
+	};
+
+	struct worker_t {
+		pthread_mutex_t mutex;
+		std::deque<batch *> batches;
+		volatile size_t size;
+	};
+
+	uint32 num_workers;
+
+	shard_t *shards;
+
+	worker_t *workers;
+
+	volatile uint32 num_registered;
+
+	volatile uint32 next_worker;
+
+	volatile size_t num_queued;
+
+	volatile uint32 num_waiting;
+
+	volatile int ingress_running;
+
+	pthread_mutex_t wait_mutex;
+
+	pthread_cond_t wakeup;
+
+	mutable work_scheduler_stats stats;
+
+	void enqueue(uint32 worker, batch *b);
+
+	batch *dequeue(uint32 worker, bool steal);
+
+	shard_t &get_shard(const session_id &sid) const;
+
+	// Disallow copying, shards and workers own their mutexes.
+	work_scheduler(const work_scheduler &other);
+	work_scheduler &operator=(const work_scheduler &other);
+};
+
+
+} // namespace anslp
+
+#endif // ANSLP_WORK_SCHEDULER_H
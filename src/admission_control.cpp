@@ -0,0 +1,340 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file admission_control.cpp
+/// The admission_control class.
+/// ----------------------------------------------------------
+/// $Id: admission_control.cpp 2558 2016-03-23 16:05:00 amarentes $
+/// $HeadURL: https://./src/admission_control.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <time.h>
+
+#include "events.h"
+#include "admission_control.h"
+
+
+using namespace anslp;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * A threshold of 0 disables the respective check.
+ *
+ * @param defer_depth queue depth from which session setups are deferred
+ * @param shed_depth queue depth from which session setups are rejected
+ * @param max_delay_ms the maximum time a session setup may wait
+ * @param max_deferred the maximum number of deferred session setups
+ * @param num_threads the number of dispatcher threads serving the queue
+ */
+admission_control::admission_control(uint32 defer_depth, uint32 shed_depth,
+					uint32 max_delay_ms, uint32 max_deferred, 
+					uint32 num_threads)
+		: defer_depth(defer_depth), shed_depth(shed_depth),
+		  max_delay_ms(max_delay_ms), max_deferred(max_deferred),
+		  num_threads(num_threads), service_time_us(0),
+		  num_deferred(0), triage_running(0) 
+{
+	if ( this->num_threads == 0 )
+		this->num_threads = 1;
+
+	stats.admitted = 0;
+	stats.deferred = 0;
+	stats.resumed = 0;
+	stats.shed = 0;
+	stats.expired = 0;
+
+	pthread_mutex_init(&mutex, NULL);
+}
+
+
+/**
+ * Destructor.
+ *
+ * Deletes all deferred events.
+ */
+admission_control::~admission_control() 
+{
+	for ( std::deque<deferred_t>::iterator i = deferred.begin();
+			i != deferred.end(); i++ )
+		delete i->evt;
+
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+uint64_t admission_control::now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * Add the time spent processing one event to the mean service time.
+ *
+ * Concurrent updates may lose a sample, which doesn't matter for a mean.
+ */
+void admission_control::record_service(uint32 usecs) 
+{
+	uint32 old_mean = service_time_us;
+
+	if ( old_mean == 0 )
+		service_time_us = usecs;
+	else
+		service_time_us = old_mean 
+			- ( old_mean >> SERVICE_TIME_SHIFT )
+			+ ( usecs >> SERVICE_TIME_SHIFT );
+}
+
+
+/**
+ * Estimate how long an event entering the queue now will wait.
+ *
+ * @param depth the number of events in the input queue
+ * @return the estimated delay in milliseconds
+ */
+uint32 admission_control::get_estimated_delay(size_t depth) const 
+{
+	return (uint32) ( (uint64_t) depth * service_time_us 
+						/ num_threads / 1000 );
+}
+
+
+/**
+ * Set the number of dispatcher threads serving the queue.
+ *
+ * Used when the dispatcher pool grows or shrinks.
+ */
+void admission_control::set_num_threads(uint32 num) 
+{
+	num_threads = ( num > 0 ) ? num : 1;
+}
+
+
+/**
+ * Check whether session setups have to wait.
+ *
+ * @param depth the number of events in the input queue
+ */
+bool admission_control::is_overloaded(size_t depth) const 
+{
+	if ( defer_depth > 0 && depth >= defer_depth )
+		return true;
+
+	if ( max_delay_ms > 0 && get_estimated_delay(depth) >= max_delay_ms / 2 )
+		return true;
+
+	return false;
+}
+
+
+/**
+ * Decide what to do with a new session setup.
+ *
+ * Session setups arriving while others are deferred are deferred, too,
+ * to keep them in order.
+ *
+ * @param depth the number of events in the input queue
+ * @return the decision
+ */
+admission_control::decision_t admission_control::admit(size_t depth) 
+{
+	decision_t ret = ADMIT;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	if ( ( shed_depth > 0 && depth >= shed_depth ) || ( max_delay_ms > 0 
+			&& get_estimated_delay(depth) >= max_delay_ms ) ) {
+		ret = SHED;
+		stats.shed++;
+	}
+	else if ( ! deferred.empty() || is_overloaded(depth) ) {
+		ret = DEFER;
+	}
+	else {
+		stats.admitted++;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Keep a session setup aside until the load goes down.
+ *
+ * @param evt the event, it is owned by this object on success
+ * @return false if too many session setups wait already
+ */
+bool admission_control::defer(event *evt) 
+{
+	assert( evt != NULL );
+
+	bool ret = true;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	if ( max_deferred > 0 && deferred.size() >= max_deferred ) {
+		ret = false;
+		stats.shed++;
+	}
+	else {
+		deferred_t d;
+		d.evt = evt;
+		d.since_ms = now_ms();
+
+		deferred.push_back(d);
+		num_deferred = deferred.size();
+		stats.deferred++;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Return the oldest deferred session setup, if the load allows it.
+ *
+ * Deferred session setups that waited longer than max_delay_ms are added
+ * to expired, the caller has to reject and delete them.
+ *
+ * @param depth the number of events in the input queue
+ * @param expired receives the session setups that waited too long
+ * @return the event or NULL if there is none or we are still overloaded
+ */
+event *admission_control::resume(size_t depth, std::vector<event *> &expired) 
+{
+	event *ret = NULL;
+	uint64_t now = now_ms();
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	while ( max_delay_ms > 0 && ! deferred.empty() 
+			&& deferred.front().since_ms + max_delay_ms <= now ) {
+		expired.push_back(deferred.front().evt);
+		deferred.pop_front();
+		stats.expired++;
+	}
+
+	if ( ! deferred.empty() && ! is_overloaded(depth) ) {
+		ret = deferred.front().evt;
+		deferred.pop_front();
+		stats.resumed++;
+	}
+
+	num_deferred = deferred.size();
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+size_t admission_control::get_num_deferred() const 
+{
+	size_t ret;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	ret = deferred.size();
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Start a triage run.
+ *
+ * Only one dispatcher thread sorts the input queue at a time, the others
+ * keep processing events meanwhile.
+ *
+ * @return false if another thread is running a triage already
+ */
+bool admission_control::begin_triage() 
+{
+	return __sync_bool_compare_and_swap(&triage_running, 0, 1);
+}
+
+
+/**
+ * End a triage run started using begin_triage().
+ */
+void admission_control::end_triage() 
+{
+	__sync_lock_release(&triage_running);
+}
+
+
+/**
+ * Return a copy of the current counters.
+ */
+admission_stats admission_control::get_stats() const
+{
+	admission_stats s;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	s = stats;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return s;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, const admission_stats &s)
+{
+	return out << "admitted=" << s.admitted << " deferred=" << s.deferred
+		<< " resumed=" << s.resumed << " shed=" << s.shed 
+		<< " expired=" << s.expired;
+}
+
+
+// EOF
@@ -28,9 +28,49 @@
 // ===========================================================
 
 #include "anslp_config.h"
+#include "configfile.h"
 
 using namespace anslp;
 
+
+volatile sig_atomic_t anslp_config::reload_pending = 0;
+
+
+anslp_config::anslp_config(configpar_repository *cfpgar_rep) 
+	: cfgpar_rep(cfpgar_rep), snapshot(NULL)
+{
+	pthread_mutex_init(&snapshot_mutex, NULL);
+}
+
+
+/**
+ * Copy the configuration. The copy reads the same repository, but
+ * publishes a snapshot of its own.
+ */
+anslp_config::anslp_config(const anslp_config &other) 
+	: cfgpar_rep(other.cfgpar_rep), snapshot(NULL)
+{
+	pthread_mutex_init(&snapshot_mutex, NULL);
+
+	if ( other.snapshot != NULL )
+		publish_snapshot();
+}
+
+
+/**
+ * Delete all snapshots. No thread may read a snapshot afterwards.
+ */
+anslp_config::~anslp_config()
+{
+	for ( size_t i = 0; i < retired_snapshots.size(); i++ )
+		delete retired_snapshots[i];
+
+	delete snapshot;
+
+	pthread_mutex_destroy(&snapshot_mutex);
+}
+
+
 void
 anslp_config::repository_init() 
 {
@@ -57,6 +97,8 @@ anslp_config::setRepository(configpar_repository* newcfp_rep)
 	
 	// now register all parameters
 	registerAllPars();
+	
+	publish_snapshot();
 }
 
 
@@ -96,6 +138,187 @@ anslp_config::registerAllPars()
   registerPar( new configpar<uint32>(anslp_realm, anslpconf_nr_max_session_lifetime, "nr-max-session-lifetime", "NR max session lifetime in seconds", true, 60, "s") );
   registerPar( new configpar<uint32>(anslp_realm, anslpconf_nr_response_timeout, "nr-response-timeout", "NR response timeout", true, 2, "s") );
   registerPar( new configpar<uint32>(anslp_realm, anslpconf_nr_max_retries, "nr-max-retries", "NR max retries", true, 3) );
+
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_summary_refresh, "summary-refresh", "send refreshes toward the same peer in one message", true, false) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_summary_refresh_max_sessions, "summary-refresh-max-sessions", "maximum number of sessions in a summary refresh", true, 256) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_summary_refresh_delay, "summary-refresh-delay", "maximum delay of a refresh waiting for others", true, 100, "ms") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_refresh_jitter, "refresh-jitter", "size of the window refreshes are spread over", true, 25, "%") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_refresh_peer_rate, "refresh-peer-rate", "maximum refreshes per second toward one peer, 0 is unlimited", true, 0) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_refresh_peer_burst, "refresh-peer-burst", "number of refreshes sent toward one peer at once", true, 100) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_refresh_queue_threshold, "refresh-queue-threshold", "input queue depth above which refreshes are deferred, 0 is never", true, 1000) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_admission_defer_depth, "admission-defer-depth", "input queue depth from which session setups are deferred, 0 is never", true, 200) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_admission_shed_depth, "admission-shed-depth", "input queue depth from which session setups are rejected, 0 is never", true, 1000) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_admission_max_delay, "admission-max-delay", "maximum queueing delay of a session setup, 0 is unlimited", true, 2000, "ms") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_admission_max_deferred, "admission-max-deferred", "maximum number of deferred session setups, 0 is unlimited", true, 1000) );
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_nf_cut_through, "nf-cut-through", "forward mspec objects without decoding them", true, false) );
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_lazy_decoding, "lazy-decoding", "decode mspec objects on first access only", true, false) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_check_cache_ttl, "check-cache-ttl", "time the answers of the auction application to check requests are cached, 0 disables the cache", true, 0, "ms") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_check_cache_size, "check-cache-size", "maximum number of cached check answers", true, 4096) );
+  registerPar( new configpar<string>(anslp_realm, anslpconf_session_store_file, "session-store-file", "file the sessions are saved to for a warm restart, empty disables saving", true, "") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_session_store_slots, "session-store-slots", "maximum number of sessions saved", true, 16384) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_create_max_hop_count, "create-max-hop-count", "highest message hop count accepted in a CREATE, 0 is any", true, 0) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_create_source_rate, "create-source-rate", "maximum sessions per second set up by one source, 0 is unlimited", true, 0) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_create_source_burst, "create-source-burst", "number of sessions a source may set up at once", true, 32) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_create_source_sessions, "create-source-sessions", "maximum number of sessions of one source, 0 is unlimited", true, 0) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_create_max_sources, "create-max-sources", "number of sources tracked by the CREATE filter", true, 65536) );
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_lock_profiling, "lock-profiling", "record wait and hold times of the session locks, written to the log on SIGUSR1", true, false) );
+  registerPar( new configpar<string>(anslp_realm, anslpconf_session_lock, "session-lock", "lock of each session: mutex, spin or rwlock", true, "mutex") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_session_lock_spins, "session-lock-spins", "maximum spins of a spin session lock before it blocks", true, 100) );
+  registerPar( new configpar<string>(anslp_realm, anslpconf_dispatcher_cpus, "dispatcher-cpus", "CPUs the dispatcher threads run on, like 0-3,8, empty is any", true, "") );
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_dispatcher_pin_each, "dispatcher-pin-each", "pin each dispatcher thread to one of the dispatcher CPUs", true, false) );
+  registerPar( new configpar<string>(anslp_realm, anslpconf_ntlp_cpus, "ntlp-cpus", "CPUs the GIST threads run on, like 4-7, empty is any", true, "") );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_dispatcher_threads_max, "dispatcher-threads-max", "maximum number of dispatcher threads under load, 0 is dispatcher-threads", true, 0) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_dispatcher_queue_delay, "dispatcher-queue-delay", "queueing delay in ms above which dispatcher threads are added", true, 10) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_dispatcher_idle_time, "dispatcher-idle-time", "time in ms a dispatcher thread is idle before it is parked", true, 5000) );
+  registerPar( new configpar<bool>(anslp_realm, anslpconf_dispatcher_work_stealing, "dispatcher-work-stealing", "give each dispatcher thread a deque of session batches and let idle threads steal", true, false) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_install_queue_size, "install-queue-size", "maximum number of events queued for the auction application, 0 is unlimited", true, 10000) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_install_queue_high, "install-queue-high", "queued events from which new sessions and biddings are rejected, 0 is never", true, 8000) );
+  registerPar( new configpar<uint32>(anslp_realm, anslpconf_install_queue_low, "install-queue-low", "queued events at which new sessions and biddings are accepted again", true, 4000) );
   
   DLog("anslp_config::registerAllPars", "finished registering anslp parameters.");
 }
+
+
+/**
+ * Build a snapshot from the repository and make it the current one.
+ */
+void
+anslp_config::publish_snapshot()
+{
+	publish_snapshot(build_snapshot());
+}
+
+
+/**
+ * Return a new snapshot of the parameters in the repository.
+ */
+anslp_config_snapshot *
+anslp_config::build_snapshot() const
+{
+	anslp_config_snapshot *s = new anslp_config_snapshot();
+
+	s->is_auctioneer = getpar<bool>(anslpconf_is_auctioneer);
+	s->install_auction_rules = getpar<bool>(anslpconf_install_auction_rules);
+
+	s->auctioneer_application = getpar<string>(anslpconf_auctioneer_application);
+	s->auctioneer_user = getpar<string>(anslpconf_auctioneer_user);
+	s->auctioneer_password = getpar<string>(anslpconf_auctioneer_password);
+	s->auctioneer_server = getpar<string>(anslpconf_auctioneer_server);
+	s->auctioneer_xsl = getpar<string>(anslpconf_auctioneer_def_xsl);
+	s->auctioneer_port = getpar<uint32>(anslpconf_auctioneer_port);
+
+	s->bid_user = getpar<string>(anslpconf_ni_user);
+	s->bid_password = getpar<string>(anslpconf_ni_password);
+	s->bid_server = getpar<string>(anslpconf_ni_server);
+	s->bid_port = getpar<uint32>(anslpconf_ni_port);
+
+	s->ni_max_session_lifetime = getpar<uint32>(anslpconf_ni_max_session_lifetime);
+	s->ni_response_timeout = getpar<uint32>(anslpconf_ni_response_timeout);
+	s->ni_max_retries = getpar<uint32>(anslpconf_ni_max_retries);
+	s->ni_msg_hop_count = getpar<uint32>(anslpconf_ni_msg_hop_count);
+
+	s->nf_max_session_lifetime = getpar<uint32>(anslpconf_nf_max_session_lifetime);
+	s->nf_response_timeout = getpar<uint32>(anslpconf_nf_response_timeout);
+	s->nf_is_edge = getpar<bool>(anslpconf_nf_is_edge);
+
+	s->nr_max_session_lifetime = getpar<uint32>(anslpconf_nr_max_session_lifetime);
+	s->nr_max_retries = getpar<uint32>(anslpconf_nr_max_retries);
+	s->nr_response_timeout = getpar<uint32>(anslpconf_nr_response_timeout);
+
+	s->summary_refresh = getpar<bool>(anslpconf_summary_refresh);
+	s->nf_cut_through = getpar<bool>(anslpconf_nf_cut_through);
+	s->lazy_decoding = getpar<bool>(anslpconf_lazy_decoding);
+
+	return s;
+}
+
+
+/**
+ * Make the snapshot the current one.
+ *
+ * Readers that still use the previous snapshot are not disturbed, it is
+ * kept until MAX_RETIRED_SNAPSHOTS newer ones replaced it. The getters
+ * return copies, so a reader only uses a snapshot for one call.
+ *
+ * @param s the new snapshot, it is owned by this object
+ */
+void
+anslp_config::publish_snapshot(anslp_config_snapshot *s)
+{
+	pthread_mutex_lock(&snapshot_mutex);
+
+	// The swap is a full barrier, readers see the snapshot complete.
+	const anslp_config_snapshot *old = __sync_lock_test_and_set(&snapshot, s);
+	
+	if ( old != NULL )
+		retired_snapshots.push_back(old);
+
+	if ( retired_snapshots.size() > MAX_RETIRED_SNAPSHOTS ) {
+		delete retired_snapshots.front();
+		retired_snapshots.pop_front();
+	}
+
+	pthread_mutex_unlock(&snapshot_mutex);
+}
+
+
+/**
+ * Read the configuration file again and publish the new parameters.
+ *
+ * Other threads read the shared repository without locking, so the file
+ * is parsed into a private repository and only the new snapshot is 
+ * taken from it. Only parameters in the snapshot change, all others keep
+ * the values they had at startup.
+ *
+ * @return false if the file could not be read, the old snapshot stays
+ */
+bool
+anslp_config::reload()
+{
+	const string filename = getpar<string>(anslpconf_conffilename);
+
+	ILog("anslp_config", "reloading configuration file " << filename);
+
+	// The file has GIST parameters, too.
+	configpar_repository fresh(anslp_realm + 1);
+	ntlp::gistconf gist;
+	anslp_config parsed;
+
+	try {
+		gist.setRepository(&fresh);
+		parsed.setRepository(&fresh);
+
+		configfile cfgfile(&fresh);
+		cfgfile.load(filename);
+	}
+	catch ( configParException &e ) {
+		ERRLog("anslp_config", "reloading the configuration file failed: " 
+				<< e.what());
+		return false;
+	}
+
+	publish_snapshot(parsed.build_snapshot());
+
+	return true;
+}
+
+
+/**
+ * Ask for a reload of the configuration file. Safe in signal handlers.
+ */
+void
+anslp_config::request_reload()
+{
+	reload_pending = 1;
+}
+
+
+/**
+ * Return true exactly once for each requested reload.
+ */
+bool
+anslp_config::claim_reload()
+{
+	return reload_pending != 0 
+		&& __sync_bool_compare_and_swap(&reload_pending, 1, 0);
+}
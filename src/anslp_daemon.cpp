@@ -37,11 +37,16 @@
 #include "msg/anslp_msg.h"
 #include "dispatcher.h"
 #include "anslp_daemon.h"
+#include "netmsg_pool.h"
 #include "benchmark_journal.h"
 #include <openssl/ssl.h>
 #include "gist_conf.h"
 #include <pthread.h>
 #include <sys/syscall.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
 
 
 using namespace protlib;
@@ -66,7 +71,38 @@ using namespace anslp::msg;
  */
 anslp_daemon::anslp_daemon(const anslp_daemon_param &param)
 		: Thread(param), config(param.config),
-		  session_mgr(&config), rule_installer(NULL), installQueue(param.installQueue), ntlp_starter(NULL) {
+		  session_mgr(&config, &saved_sessions), 
+		  refresh_collector(config.get_summary_refresh_max_sessions(),
+							config.get_summary_refresh_delay()),
+		  refresh_sched(config.get_refresh_jitter(), 
+						config.get_refresh_peer_rate(),
+						config.get_refresh_peer_burst(),
+						config.get_refresh_queue_threshold()),
+		  checks(config.get_check_cache_ttl(), config.get_check_cache_size()),
+		  filter(config.get_create_max_hop_count(),
+				 config.get_create_source_rate(),
+				 config.get_create_source_burst(),
+				 config.get_create_source_sessions(),
+				 config.get_create_max_sources()),
+		  backlog(config.get_install_queue_size(),
+				  config.get_install_queue_high(),
+				  config.get_install_queue_low()),
+		  admission(config.get_admission_defer_depth(),
+					config.get_admission_shed_depth(),
+					config.get_admission_max_delay(),
+					config.get_admission_max_deferred(),
+					config.get_num_dispatcher_threads()),
+		  pool(config.get_num_dispatcher_threads(),
+			   config.get_max_dispatcher_threads(),
+			   config.get_dispatcher_queue_delay(),
+			   config.get_dispatcher_idle_time()),
+		  scheduler(NULL), rule_installer(NULL), 
+		  installQueue(param.installQueue), ntlp_starter(NULL) {
+
+	if ( config.use_work_stealing() )
+		scheduler = new work_scheduler(
+			std::max(config.get_num_dispatcher_threads(),
+					 config.get_max_dispatcher_threads()));
 
 	startup();
 }
@@ -76,7 +112,20 @@ anslp_daemon::anslp_daemon(const anslp_daemon_param &param)
  * Destructor.
  */
 anslp_daemon::~anslp_daemon() {
+	LogInfo("refresh scheduler: " << refresh_sched.get_stats());
+	LogInfo("check cache: " << checks.get_stats());
+	LogInfo("create filter: " << filter.get_stats());
+	LogInfo("install queue: " << backlog.get_stats());
+	LogInfo("admission control: " << admission.get_stats());
+	LogInfo("dispatcher pool: " << pool.get_stats());
+	if ( scheduler != NULL )
+		LogInfo("work scheduler: " << scheduler->get_stats());
+	LogInfo("session store: " << saved_sessions.get_stats());
+	log_lock_profiles();
+	
 	shutdown();
+
+	delete scheduler;
 }
 
 
@@ -96,7 +145,8 @@ void anslp_daemon::startup() {
 	
 	if (installQueue != NULL){
 		if ((config.is_auctioneer() == true) || (config.get_install_auction_rules() == true)){
-			rule_installer = new netauct_rule_installer(&config, installQueue);
+			rule_installer = new netauct_rule_installer(&config, installQueue,
+														false, &backlog);
 		} else {
 			rule_installer = new nop_auction_rule_installer(&config);
 		}	
@@ -111,6 +161,22 @@ void anslp_daemon::startup() {
 		LogError("unable to setup the auction rule installer: " << e);
 	}
 
+	/*
+	 * A pure forwarder never looks inside the mspec objects, so they are
+	 * kept as received and forwarded without being decoded. No message
+	 * has been read yet, so the IEs can still be registered again.
+	 */
+	if ( config.use_nf_cut_through() ) {
+		LogInfo("A-NSLP forwarding mspec objects without decoding them");
+		ANSLP_IEManager::register_known_ies(true);
+	}
+	else if ( config.get_nf_cut_through() ) {
+		LogWarn("nf-cut-through ignored, this node installs rules or "
+				"is an auctioneer");
+	}
+
+	ANSLP_IEManager::set_lazy_decoding(config.use_lazy_decoding());
+
     AddressList *addresses = new AddressList();
 	
 	hostaddresslist_t& ntlpv4addr= ntlp::gconf.getparref< protlib::hostaddresslist_t >(ntlp::gistconf_localaddrv4);
@@ -192,13 +258,36 @@ void anslp_daemon::startup() {
     }
 	
 	/*
-	 * Start the GIST thread.
+	 * Start the GIST thread. It and the threads it starts inherit the 
+	 * CPUs of this thread, so this thread moves to the configured CPUs
+	 * while starting it and back afterwards.
 	 */
+	const std::string ntlp_spec = config.get_ntlp_cpus();
+	cpu_set_t own_cpus, ntlp_cpus;
+	bool ntlp_placed = false;
+
+	if ( ntlp_spec.empty() )
+		; // no placement
+	else if ( ! cpu_placement::parse(ntlp_spec, ntlp_cpus) )
+		LogError("invalid ntlp-cpus " << ntlp_spec);
+	else if ( cpu_placement::get_affinity(own_cpus) 
+			&& cpu_placement::set_affinity(ntlp_cpus) )
+		ntlp_placed = true;
+	else
+		LogError("unable to place the GIST thread on cpus " << ntlp_spec 
+				 << ": " << strerror(errno));
+
 	NTLPStarterParam ntlpparam;
 	ntlpparam.addresses = addresses;	
 	ntlp_starter= new ThreadStarter<NTLPStarter, NTLPStarterParam>(1, ntlpparam);
 	ntlp_starter->start_processing();
 
+	if ( ntlp_placed ) {
+		cpu_placement::set_affinity(own_cpus);
+		LogInfo("GIST thread placed on cpus " 
+				<< cpu_placement::to_string(ntlp_cpus));
+	}
+
 
 	/*
 	 * Register our input queue with the queue manager.
@@ -217,17 +306,47 @@ void anslp_daemon::startup() {
 	LogInfo("starting it is going to read parameters 5");
 	
 	/*
-	 * TODO: We have no way to find out if the NTLP thread is up and has
-	 * already registered an input queue. Because of this, we try to send
-	 * our registration message until there is a queue to accept it.
+	 * The NTLP thread registers its input queue as soon as it is up, but
+	 * it can't tell us. So we retry sending our registration message, 
+	 * with a delay starting at a millisecond, until there is a queue to 
+	 * accept it. The message isn't deleted if sending fails.
 	 */
-	bool success;
-	do {
-		success = api_msg->send_to(anslp_config::OUTPUT_QUEUE_ADDRESS);
-		sleep(1);
+	uint32 delay_us = REGISTER_MIN_DELAY_US;
+	uint32 num_retries = 0;
+	
+	while ( ! api_msg->send_to(anslp_config::OUTPUT_QUEUE_ADDRESS) ) {
+		usleep(delay_us);
+		num_retries++;
+		
+		delay_us *= 2;
+		if ( delay_us > REGISTER_MAX_DELAY_US )
+			delay_us = REGISTER_MAX_DELAY_US;
+	}
+
+	LogInfo("registered with the NTLP after " << num_retries << " retries");
+
+
+	/*
+	 * Resume the sessions saved before a restart. Their timers are started
+	 * with the time they had left, so refreshes and expirations happen as
+	 * if the daemon had never stopped.
+	 */
+	const std::string filename = config.get_session_store_file();
+
+	if ( ! filename.empty() ) {
+		if ( saved_sessions.open(filename, config.get_session_store_slots()) ) {
+			dispatcher disp(&session_mgr, rule_installer, &config, 
+							&refresh_collector, &refresh_sched, &checks,
+							&filter, &backlog);
+
+			uint32 num = session_mgr.restore_sessions(&disp);
+
+			LogInfo("restored " << num << " sessions from " << filename);
+		}
+		else
+			LogError("unable to open the session store " << filename
+					 << ": " << strerror(errno));
 	}
-	while ( ! success );
-	assert( success );
 
 
 	LogDebug("ANSLP daemon startup complete");
@@ -242,12 +361,22 @@ void anslp_daemon::startup() {
 void anslp_daemon::shutdown() {
 	LogDebug("ANSLP daemon shutting down ...");
 
-	try {
-		rule_installer->remove_all();
+	/*
+	 * The rules of saved sessions stay installed, the sessions are 
+	 * resumed when the daemon starts again.
+	 */
+	if ( saved_sessions.is_open() ) {
+		LogInfo("keeping the auction rules of " << saved_sessions.size() 
+				<< " saved sessions");
 	}
-	catch ( auction_rule_installer_error &e ) {
-		LogError("unable to remove the installed auction rules: " << e);
-		LogError("You have to remove them manually!");
+	else {
+		try {
+			rule_installer->remove_all();
+		}
+		catch ( auction_rule_installer_error &e ) {
+			LogError("unable to remove the installed auction rules: " << e);
+			LogError("You have to remove them manually!");
+		}
 	}
 
 	// Shut down the NTLP threads.
@@ -270,41 +399,118 @@ void anslp_daemon::shutdown() {
  */
 void anslp_daemon::main_loop(uint32 thread_id) {
 
+	// Before allocating anything, so the thread's state is NUMA-local.
+	place_dispatcher_thread(thread_id);
+
 	/* 
 	 * The dispatcher handles incoming messages. It is the top-level state
 	 * machine which delegates work to the state machines on session level.
 	 *
 	 * For each main_loop, and thus POSIX thread, there is a dispatcher.
 	 */
-	dispatcher disp(&session_mgr, rule_installer, &config);
+	dispatcher disp(&session_mgr, rule_installer, &config, 
+					&refresh_collector, &refresh_sched, &checks,
+					&filter, &backlog);
 	gistka_mapper mapper;
 
 
 	/*
-	 * Wait for messages in the input queue and process them.
+	 * Wait for messages in the input queue and process them. Threads
+	 * beyond the size of the pool are parked until the load goes up.
 	 */
-	LogInfo("dispatcher thread #"
-			<< thread_id << " waiting for incoming messages ...");
+	bool working = pool.start_worker();
+	uint64_t idle_since = elastic_pool::now_ms();
+	uint32 worker = ( scheduler != NULL ) ? scheduler->register_worker() : 0;
+
+	LogInfo("dispatcher thread #" << thread_id << ( working 
+			? " waiting for incoming messages ..." : " parked ..." ));
 
 	while ( get_state() == Thread::STATE_RUN ) {
 
+		if ( ! working ) {
+			if ( pool.park(PARK_TIMEOUT_MS) ) {
+				working = true;
+				idle_since = elastic_pool::now_ms();
+				LogInfo("dispatcher thread #" << thread_id 
+						<< " put to work: " << pool.get_stats());
+			}
+			continue;
+		}
 
-		// A timeout makes sure the loop condition is checked regularly.
-		message *msg = get_fqueue()->dequeue_timedwait(100);
+		message *msg = NULL;
+		bool busy = false;
+
+		if ( scheduler != NULL )
+			busy = run_scheduled(disp, mapper, worker);
+		else
+			// A timeout makes sure the loop condition is checked regularly.
+			msg = get_fqueue()->dequeue_timedwait(100);
+		
+		uint64_t now = elastic_pool::now_ms();
+		
+		// Let the refresh scheduler back off while we are busy.
+		refresh_sched.set_queue_depth(get_queue_depth());
+		
+		// Notice when the auction application falls behind or catches up.
+		update_backlog();
 		
-		if ( msg == NULL ){
+		// Send the summary refreshes that waited long enough.
+		if ( config.use_summary_refresh() )
+			disp.flush_summary_refreshes();
+		
+		// One thread reloads the configuration after a SIGHUP.
+		if ( anslp_config::claim_reload() )
+			config.reload();
+		
+		// One thread writes the lock profiles after a SIGUSR1.
+		if ( lock_profile::claim_dump() )
+			log_lock_profiles();
+		
+		// Deferred session setups go on when the load allows it.
+		if ( admission.has_deferred() )
+			resume_session_setups(disp);
+		
+		if ( msg == NULL && ! busy ){
+			// Park this thread if it has been idle for a while.
+			if ( pool.retire(idle_since, now) ) {
+				working = false;
+				admission.set_num_threads(pool.get_size());
+				LogInfo("dispatcher thread #" << thread_id 
+						<< " parked: " << pool.get_stats());
+			}
 			continue;	// no message in the queue
 			LogInfo("dispatcher thread #" << thread_id
 					<< " no message in queue" );
 			
 		}
 
+		idle_since = now;
+
+		// Put another thread to work if messages wait too long.
+		if ( pool.report_delay(admission.get_estimated_delay(
+						get_queue_depth()), now) ) {
+			admission.set_num_threads(pool.get_size());
+			LogInfo("dispatcher pool grown: " << pool.get_stats());
+		}
+
+		// The scheduler processed a batch of events already.
+		if ( msg == NULL )
+			continue;
+
 		LogInfo("dispatcher thread #" << thread_id
 			<< " processing received message #" << msg->get_id()
 			<< " number of messages #"<< get_fqueue()->size() 
 			<< "- procid:" <<  getpid() 
 			<< " - getthread_self:" << pthread_self() 
 			<< " tid:" << syscall(SYS_gettid));
+		
+		// Under overload, let everything but session setups skip ahead.
+		// There is no triage with the work scheduler, see triage().
+		if ( admission.is_overloaded(get_fqueue()->size()) 
+				&& admission.begin_triage() ) {
+			triage(disp, mapper);
+			admission.end_triage();
+		}
 						
 		MP(benchmark_journal::PRE_PROCESSING);
 
@@ -313,16 +519,309 @@ void anslp_daemon::main_loop(uint32 thread_id) {
 
 		// Then feed the event to the dispatcher.
 		if ( evt != NULL ) {
-			MP(benchmark_journal::PRE_DISPATCHER);
-			disp.process(evt);
-			MP(benchmark_journal::POST_DISPATCHER);
-			delete evt;
+			if ( disp.is_session_setup(evt) )
+				admit_session_setup(disp, evt);
+			else
+				process_event(disp, evt);
 		}
 
 		delete msg;
 
 		MP(benchmark_journal::POST_PROCESSING);
 	}
+
+	disp.flush_summary_refreshes(true);
+
+	// This thread won't observe any session anymore.
+	session_mgr.get_epoch_manager().unregister_thread();
+	
+	netmsg_pool::clear();
+}
+
+
+/**
+ * Write the lock profiles of the session manager to the log, if lock
+ * profiling is configured.
+ */
+void anslp_daemon::log_lock_profiles() {
+	std::vector<lock_profile_stats> profiles = session_mgr.get_lock_profiles();
+
+	for ( size_t i = 0; i < profiles.size(); i++ )
+		LogInfo("lock profile " << profiles[i]);
+}
+
+
+/**
+ * Report the occupancy of the install queue to the backlog.
+ *
+ * Changes between rejecting and accepting new sessions are logged.
+ */
+void anslp_daemon::update_backlog() {
+	if ( installQueue == NULL || ! backlog.update(installQueue->size()) )
+		return;
+
+	if ( backlog.is_full() )
+		LogWarn("auction application behind, rejecting new sessions and "
+				"biddings: " << backlog.get_stats());
+	else
+		LogInfo("auction application caught up: " << backlog.get_stats());
+}
+
+
+/**
+ * Restrict the calling dispatcher thread to the configured CPUs.
+ *
+ * The thread's placement is logged, even if it isn't restricted.
+ */
+void anslp_daemon::place_dispatcher_thread(uint32 thread_id) {
+	const std::string spec = config.get_dispatcher_cpus();
+	cpu_set_t cpus, cpu;
+
+	if ( spec.empty() )
+		; // no placement
+	else if ( ! cpu_placement::parse(spec, cpus) )
+		LogError("invalid dispatcher-cpus " << spec);
+	else {
+		if ( config.get_dispatcher_pin_each() 
+				&& cpu_placement::select(cpus, thread_id, cpu) )
+			cpus = cpu;
+
+		if ( ! cpu_placement::set_affinity(cpus) )
+			LogError("unable to place dispatcher thread #" << thread_id 
+					 << " on cpus " << cpu_placement::to_string(cpus) 
+					 << ": " << strerror(errno));
+	}
+
+	LogInfo("dispatcher thread #" << thread_id << " placed: " 
+			<< cpu_placement::describe_current_thread());
+}
+
+
+/**
+ * Sort the head of the input queue while we are overloaded.
+ *
+ * Messages that don't set up a session are moved to the expedited part
+ * of the queue, keeping their order, so they are processed before all 
+ * other messages. Session setups are handed to the admission control.
+ *
+ * The messages to expedite are only put back after the scan, otherwise
+ * the next dequeue() would return them again right away. At most the
+ * messages queued when the scan starts are looked at.
+ *
+ * With the work scheduler, messages are moved to the scheduler as they
+ * arrive and this is never called.
+ */
+void anslp_daemon::triage(dispatcher &disp, const gistka_mapper &mapper) {
+
+	uint32 num_setups = 0;
+	std::vector<message *> expedite;
+
+	uint32 limit = get_fqueue()->size();
+	if ( limit > TRIAGE_BATCH )
+		limit = TRIAGE_BATCH;
+	
+	for ( uint32 i = 0; i < limit; i++ ) {
+		message *msg = get_fqueue()->dequeue(false);
+
+		if ( msg == NULL )
+			break;
+
+		if ( ! mapper.is_session_setup(msg) ) {
+			expedite.push_back(msg);
+			continue;
+		}
+
+		event *evt = mapper.map_to_event(msg);
+		delete msg;
+
+		if ( evt == NULL )
+			continue;
+		
+		num_setups++;
+
+		// A retransmitted CREATE belongs to an existing session.
+		if ( disp.is_session_setup(evt) )
+			admit_session_setup(disp, evt);
+		else
+			process_event(disp, evt);
+	}
+
+	for ( size_t i = 0; i < expedite.size(); i++ )
+		get_fqueue()->enqueue(expedite[i], true);
+
+	LogDebug("triage: expedited " << expedite.size() << " messages, found "
+			<< num_setups << " session setups");
+}
+
+
+/**
+ * Process an event and update the mean service time.
+ *
+ * The event is deleted.
+ */
+void anslp_daemon::process_event(dispatcher &disp, event *evt) {
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	MP(benchmark_journal::PRE_DISPATCHER);
+	disp.process(evt);
+	MP(benchmark_journal::POST_DISPATCHER);
+	
+	delete evt;
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	admission.record_service( (end.tv_sec - start.tv_sec) * 1000000 
+							 + (end.tv_nsec - start.tv_nsec) / 1000 );
+}
+
+
+/**
+ * Move messages from the input queue to the work scheduler and process
+ * one batch of events.
+ *
+ * Only one thread at a time reads the input queue. It waits for messages
+ * if nothing is queued, the other threads wait for the scheduler. All
+ * messages still come through the single input queue and this one 
+ * ingress thread, which maps them to events; the scheduler spreads only
+ * the processing of the events.
+ *
+ * @return true if a batch was processed
+ */
+bool anslp_daemon::run_scheduled(dispatcher &disp, 
+		const gistka_mapper &mapper, uint32 worker) {
+
+	bool waited = false;
+
+	if ( scheduler->begin_ingress() ) {
+		message *msg;
+
+		// A timeout makes sure the loop condition is checked regularly.
+		if ( scheduler->size() == 0 ) {
+			msg = get_fqueue()->dequeue_timedwait(100);
+			waited = true;
+		}
+		else
+			msg = get_fqueue()->dequeue(false);
+
+		for ( uint32 i = 1; msg != NULL; i++ ) {
+			event *evt = mapper.map_to_event(msg);
+			delete msg;
+
+			if ( evt != NULL )
+				scheduler->push(evt);
+
+			if ( i == INGRESS_BATCH )
+				break;
+
+			msg = get_fqueue()->dequeue(false);
+		}
+
+		scheduler->end_ingress();
+	}
+
+	std::vector<event *> events;
+	work_scheduler::batch *b = scheduler->pop(worker, events);
+
+	if ( b == NULL ) {
+		if ( ! waited )
+			scheduler->wait(100);
+
+		return false;
+	}
+
+	MP(benchmark_journal::PRE_PROCESSING);
+
+	for ( size_t i = 0; i < events.size(); i++ ) {
+		if ( disp.is_session_setup(events[i]) )
+			admit_session_setup(disp, events[i]);
+		else
+			process_event(disp, events[i]);
+	}
+
+	MP(benchmark_journal::POST_PROCESSING);
+
+	// Other threads may take the session's next events now.
+	scheduler->done(worker, b);
+
+	return true;
+}
+
+
+/**
+ * Return the number of messages and events waiting to be processed.
+ */
+size_t anslp_daemon::get_queue_depth() {
+	size_t depth = get_fqueue()->size();
+
+	if ( scheduler != NULL )
+		depth += scheduler->size();
+
+	return depth;
+}
+
+
+/**
+ * Process, defer or reject a session setup, depending on the load.
+ *
+ * The event is deleted or handed to the admission control.
+ */
+void anslp_daemon::admit_session_setup(dispatcher &disp, event *evt) {
+
+	// A resumed session setup was admitted already.
+	if ( evt->is_admitted() ) {
+		process_event(disp, evt);
+		return;
+	}
+
+	switch ( admission.admit(get_queue_depth()) ) {
+		case admission_control::ADMIT:
+			process_event(disp, evt);
+			return;
+
+		case admission_control::DEFER:
+			if ( admission.defer(evt) )
+				return;
+			break;	// too many deferred already
+
+		case admission_control::SHED:
+			break;
+	}
+
+	disp.reject_session_setup(evt);
+	delete evt;
+}
+
+
+/**
+ * Process the oldest deferred session setup if the load allows it.
+ *
+ * With the work scheduler, the session setup is pushed back to it, so it
+ * isn't processed concurrently with other events of its session. Events
+ * of the session that arrived while it was deferred are still processed 
+ * before it. Session setups that were deferred for too long are rejected.
+ */
+void anslp_daemon::resume_session_setups(dispatcher &disp) {
+
+	std::vector<event *> expired;
+
+	event *evt = admission.resume(get_queue_depth(), expired);
+
+	for ( size_t i = 0; i < expired.size(); i++ ) {
+		disp.reject_session_setup(expired[i]);
+		delete expired[i];
+	}
+
+	if ( evt == NULL )
+		return;
+
+	evt->set_admitted();
+
+	if ( scheduler != NULL )
+		scheduler->push(evt);
+	else
+		process_event(disp, evt);
 }
 
 
@@ -28,6 +28,7 @@
 // ===========================================================
 #include "anslp_timers.h"
 #include "dispatcher.h"
+#include "refresh_scheduler.h"
 #include <iostream>
 
 
@@ -37,7 +38,7 @@ using namespace anslp;
 /**
  * Constructor.
  */
-timer::timer(session *s) : id(0), owning_session(s) 
+timer::timer(session *s) : id(0), owning_session(s), expires_ms(0) 
 {
 	// nothing to do
 }
@@ -47,15 +48,48 @@ void timer::start(dispatcher *d, int seconds)
 {
 
 	id = d->start_timer(owning_session, seconds);
+	expires_ms = refresh_scheduler::now_ms() + (uint64) seconds * 1000;
 
 }
 
 void timer::restart(dispatcher *d, int seconds) 
 {
 	id = d->start_timer(owning_session, seconds);
+	expires_ms = refresh_scheduler::now_ms() + (uint64) seconds * 1000;
+}
+
+void timer::start_ms(dispatcher *d, uint32 msecs) 
+{
+	id = d->start_timer_ms(owning_session, msecs);
+	expires_ms = refresh_scheduler::now_ms() + msecs;
+}
+
+void timer::start_refresh(dispatcher *d, uint32 interval, uint32 deadline) 
+{
+	id = d->start_refresh_timer(owning_session, interval, deadline);
+	expires_ms = refresh_scheduler::now_ms() + (uint64) interval * 1000;
 }
 
 void timer::stop() 
 {
 	id = 0;
+	expires_ms = 0;
+}
+
+
+/**
+ * Return the milliseconds left until the timer goes off.
+ *
+ * This is 0 for a stopped timer and at least 1 for a running one, even 
+ * if it is overdue. A timer is still running after it went off, unless
+ * the session stopped or restarted it.
+ */
+uint32 timer::get_remaining_ms() const 
+{
+	if ( expires_ms == 0 )
+		return 0;
+
+	uint64 now = refresh_scheduler::now_ms();
+
+	return ( expires_ms > now ) ? (uint32) (expires_ms - now) : 1;
 }
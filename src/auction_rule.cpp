@@ -98,7 +98,7 @@ auction_rule::auction_rule(const auction_rule &rhs)
 	LogDebug("Starting constructor from another instance");
 	
 	// Copy object request
-	std::map<mspec_rule_key, msg::anslp_mspec_object *>::const_iterator it;
+	objectListConstIter_t it;
 	for ( it = rhs.object_requests.begin(); it != rhs.object_requests.end(); it++ )
 	{
 		const mspec_rule_key id = it->first;
@@ -142,12 +142,10 @@ auction_rule::set_request_object(mspec_rule_key key, msg::anslp_mspec_object *ob
 	if ( obj == NULL )
 		return;
 
-	msg::anslp_mspec_object *old = object_requests[key];
+	msg::anslp_mspec_object *old = object_requests.exchange(key, obj);
 
 	if ( old )
 		delete old;
-
-	object_requests[key] = obj;
 }
 
 void 
@@ -159,12 +157,10 @@ auction_rule::set_response_object(mspec_rule_key key, msg::anslp_mspec_object *o
 	if ( obj == NULL )
 		return;
 
-	msg::anslp_mspec_object *old = object_responses[key];
+	msg::anslp_mspec_object *old = object_responses.exchange(key, obj);
 
 	if ( old )
 		delete old;
-
-	object_responses[key] = obj;
 	
 	LogDebug("Ending set_response_object");
 }
@@ -176,7 +172,7 @@ auction_rule::set_request_object(msg::anslp_mspec_object *obj)
 	
 	if (obj != NULL){
 		mspec_rule_key key;
-		object_requests[key] = obj;
+		object_requests.exchange(key, obj);
 		return key;
 	}
 	else{
@@ -191,7 +187,7 @@ auction_rule::set_response_object(msg::anslp_mspec_object *obj)
 	
 	if (obj != NULL){
 		mspec_rule_key key;
-		object_responses[key] = obj;
+		object_responses.exchange(key, obj);
 		return key;
 	}
 	else{
@@ -281,7 +277,7 @@ operator<<(std::ostream &out, const auction_rule &r)
 auction_rule & 
 auction_rule::operator=(const auction_rule &rhs)
 {
-	std::map<mspec_rule_key, msg::anslp_mspec_object *>::const_iterator it;
+	objectListConstIter_t it;
 	for ( it = rhs.object_requests.begin(); it != rhs.object_requests.end(); it++ )
 	{
 		const mspec_rule_key id = it->first;
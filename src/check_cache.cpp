@@ -0,0 +1,386 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file check_cache.cpp
+/// Shared cache of auction applicability check results.
+/// ----------------------------------------------------------
+/// $Id: check_cache.cpp 2558 2016-04-13 10:20:00 amarentes $
+/// $HeadURL: https://./src/check_cache.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <time.h>
+
+#include "check_cache.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * @param ttl_ms the time an answer is kept in milliseconds (0 = disabled)
+ * @param max_entries the maximum number of answers kept
+ */
+check_cache::check_cache(uint32 ttl_ms, uint32 max_entries)
+		: ttl_ms(ttl_ms), max_shard_entries(max_entries / NUM_SHARDS), 
+		  generation(0)
+{
+	if ( max_shard_entries == 0 )
+		max_shard_entries = 1;
+
+	shards = new shard_t[NUM_SHARDS];
+
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ ) {
+		pthread_mutex_init(&shards[i].mutex, NULL);
+
+		shards[i].stats.hits = 0;
+		shards[i].stats.misses = 0;
+		shards[i].stats.stored = 0;
+		shards[i].stats.expired = 0;
+		shards[i].stats.invalidations = 0;
+	}
+}
+
+
+/**
+ * Destructor.
+ */
+check_cache::~check_cache() 
+{
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ )
+		pthread_mutex_destroy(&shards[i].mutex);
+
+	delete[] shards;
+}
+
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+uint64_t check_cache::now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * Return the digest of a check request.
+ *
+ * The digest covers the contents of all objects in their order, but not
+ * the keys, which are different for every session.
+ */
+content_digest check_cache::digest(const objectList_t *objects)
+{
+	assert( objects != NULL );
+
+	digest_builder builder;
+	builder.update( (uint32) objects->size() );
+
+	objectListConstIter_t it;
+	for ( it = objects->begin(); it != objects->end(); it++ ) {
+		if ( it->second != NULL )
+			builder.update( it->second->get_digest() );
+		else
+			builder.update( content_digest() );
+	}
+
+	return builder.finish();
+}
+
+
+/**
+ * Look up the answer to a check request.
+ *
+ * @param objects the objects to check
+ * @param applicable set to one flag per object, in the list's order
+ * @param now the current time in milliseconds
+ * @return true if the answer was found
+ */
+bool check_cache::lookup(const objectList_t *objects, 
+						 std::vector<bool> &applicable, uint64_t now)
+{
+	assert( objects != NULL );
+
+	if ( ! is_enabled() || objects->empty() )
+		return false;
+
+	content_digest d = digest(objects);
+	shard_t &shard = get_shard(d);
+	bool found = false;
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	std::map<digest_key_t, entry_t>::iterator it 
+		= shard.entries.find( digest_key_t(d.get_high(), d.get_low()) );
+
+	if ( it != shard.entries.end() ) {
+		if ( it->second.expires <= now 
+				|| it->second.generation != generation ) {
+			shard.entries.erase(it);
+			shard.stats.expired++;
+		}
+		else if ( it->second.applicable.size() == objects->size() ) {
+			applicable = it->second.applicable;
+			found = true;
+		}
+	}
+
+	if ( found )
+		shard.stats.hits++;
+	else
+		shard.stats.misses++;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+
+	return found;
+}
+
+
+/**
+ * Register a check request sent to the auction application.
+ *
+ * The answer is stored when it is passed to learn().
+ *
+ * @param session_id the session that sent the request
+ * @param objects the objects to check
+ * @param now the current time in milliseconds
+ */
+void check_cache::expect(const std::string &session_id, 
+						 const objectList_t *objects, uint64_t now)
+{
+	assert( objects != NULL );
+
+	if ( ! is_enabled() || objects->empty() )
+		return;
+
+	pending_t request;
+	request.digest = digest(objects);
+	request.since = now;
+	request.generation = generation;
+	
+	objectListConstIter_t it;
+	for ( it = objects->begin(); it != objects->end(); it++ )
+		request.keys.push_back(it->first);
+
+	shard_t &shard = get_shard(session_id);
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	if ( shard.pending.size() >= max_shard_entries )
+		purge(shard, now);
+
+	// If the application doesn't answer at all, we don't cache anything.
+	if ( shard.pending.size() < max_shard_entries )
+		shard.pending[session_id] = request;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+}
+
+
+/**
+ * Store the auction application's answer to a check request.
+ *
+ * An object of the request is applicable if the result contains an
+ * object with the same key.
+ *
+ * @param session_id the session that sent the request
+ * @param result the applicable objects
+ * @param now the current time in milliseconds
+ * @return true if the answer was stored
+ */
+bool check_cache::learn(const std::string &session_id, 
+						const objectList_t *result, uint64_t now)
+{
+	assert( result != NULL );
+
+	if ( ! is_enabled() )
+		return false;
+
+	shard_t &shard = get_shard(session_id);
+	pending_t request;
+	bool found = false;
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	std::map<std::string, pending_t>::iterator it 
+		= shard.pending.find(session_id);
+
+	if ( it != shard.pending.end() ) {
+		request = it->second;
+		shard.pending.erase(it);
+		found = true;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+
+	// Answers given before the auctions changed may be wrong now.
+	if ( ! found || request.generation != generation )
+		return false;
+	
+	store(request, result, now);
+
+	return true;
+}
+
+
+/**
+ * Drop all answers, because the auction application's auctions changed.
+ */
+void check_cache::invalidate()
+{
+	__sync_add_and_fetch(&generation, 1);
+}
+
+
+/**
+ * Return the statistics of all shards.
+ */
+check_cache_stats check_cache::get_stats() const
+{
+	check_cache_stats s;
+	s.hits = 0;
+	s.misses = 0;
+	s.stored = 0;
+	s.expired = 0;
+	s.invalidations = generation;
+
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ ) {
+		pthread_mutex_lock(&shards[i].mutex);
+		install_cleanup_handler(&shards[i].mutex);
+
+		s.hits += shards[i].stats.hits;
+		s.misses += shards[i].stats.misses;
+		s.stored += shards[i].stats.stored;
+		s.expired += shards[i].stats.expired;
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shards[i].mutex);
+	}
+
+	return s;
+}
+
+
+check_cache::shard_t &check_cache::get_shard(const content_digest &d) const
+{
+	return shards[d.get_low() % NUM_SHARDS];
+}
+
+
+check_cache::shard_t &check_cache::get_shard(
+		const std::string &session_id) const
+{
+	content_digest d = content_digest::compute(
+		(const uchar *) session_id.data(), session_id.size());
+
+	return get_shard(d);
+}
+
+
+/**
+ * Store the answer to a request in the shard of the request's digest.
+ */
+void check_cache::store(const pending_t &request, 
+						const objectList_t *result, uint64_t now)
+{
+	entry_t entry;
+	entry.expires = now + ttl_ms;
+	entry.generation = request.generation;
+
+	std::vector<mspec_rule_key>::const_iterator it;
+	for ( it = request.keys.begin(); it != request.keys.end(); it++ )
+		entry.applicable.push_back( result->find(*it) != result->end() );
+
+	shard_t &shard = get_shard(request.digest);
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	if ( shard.entries.size() >= max_shard_entries )
+		purge(shard, now);
+
+	// Still full, make room for the newer answer.
+	if ( shard.entries.size() >= max_shard_entries )
+		shard.entries.erase(shard.entries.begin());
+	
+	shard.entries[ digest_key_t(request.digest.get_high(), 
+								request.digest.get_low()) ] = entry;
+	shard.stats.stored++;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+}
+
+
+/**
+ * Remove old answers and requests we no longer expect an answer for.
+ *
+ * The shard has to be locked by the caller.
+ */
+void check_cache::purge(shard_t &shard, uint64_t now)
+{
+	std::map<digest_key_t, entry_t>::iterator i = shard.entries.begin();
+	while ( i != shard.entries.end() ) {
+		if ( i->second.expires <= now || i->second.generation != generation ) {
+			shard.entries.erase(i++);
+			shard.stats.expired++;
+		}
+		else
+			i++;
+	}
+
+	std::map<std::string, pending_t>::iterator j = shard.pending.begin();
+	while ( j != shard.pending.end() ) {
+		if ( j->second.since + MAX_ANSWER_MS <= now )
+			shard.pending.erase(j++);
+		else
+			j++;
+	}
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, const check_cache_stats &s)
+{
+	return out << "hits=" << s.hits << " misses=" << s.misses
+			   << " stored=" << s.stored << " expired=" << s.expired
+			   << " invalidations=" << s.invalidations;
+}
+
+
+// EOF
@@ -0,0 +1,209 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file cpu_placement.cpp
+/// Placement of threads on CPUs.
+/// ----------------------------------------------------------
+/// $Id: cpu_placement.cpp 2558 2016-04-21 10:00:00 amarentes $
+/// $HeadURL: https://./src/cpu_placement.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <stdlib.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <sstream>
+
+#include "cpu_placement.h"
+
+
+using namespace anslp;
+
+
+/**
+ * Parse a list of CPUs and CPU ranges, like "0-3,8,10".
+ *
+ * @param spec the list, may contain blanks
+ * @param set the resulting CPU set
+ * @return false if the list is malformed or empty
+ */
+bool cpu_placement::parse(const std::string &spec, cpu_set_t &set)
+{
+	CPU_ZERO(&set);
+
+	const char *p = spec.c_str();
+	bool any = false;
+
+	while ( *p != '\0' ) {
+		while ( *p == ' ' || *p == '\t' )
+			p++;
+
+		char *end;
+		long first = strtol(p, &end, 10);
+		if ( end == p || first < 0 )
+			return false;
+
+		long last = first;
+		p = end;
+
+		if ( *p == '-' ) {
+			p++;
+			last = strtol(p, &end, 10);
+			if ( end == p || last < first )
+				return false;
+			p = end;
+		}
+
+		if ( last >= CPU_SETSIZE )
+			return false;
+
+		for ( long cpu = first; cpu <= last; cpu++ )
+			CPU_SET(cpu, &set);
+		any = true;
+
+		while ( *p == ' ' || *p == '\t' )
+			p++;
+
+		if ( *p == ',' )
+			p++;
+		else if ( *p != '\0' )
+			return false;
+	}
+
+	return any;
+}
+
+
+/**
+ * Write a CPU set in the format read by parse(), using ranges.
+ */
+std::string cpu_placement::to_string(const cpu_set_t &set)
+{
+	std::ostringstream out;
+	bool first = true;
+
+	for ( int cpu = 0; cpu < CPU_SETSIZE; cpu++ ) {
+		if ( ! CPU_ISSET(cpu, &set) )
+			continue;
+
+		int last = cpu;
+		while ( last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &set) )
+			last++;
+
+		if ( ! first )
+			out << ",";
+		out << cpu;
+		if ( last > cpu )
+			out << "-" << last;
+
+		first = false;
+		cpu = last;
+	}
+
+	return out.str();
+}
+
+
+/**
+ * Select a single CPU of a set, going round robin.
+ *
+ * @param set the CPUs to choose from
+ * @param index the number of the thread, it wraps around
+ * @param cpu the set containing the selected CPU only
+ * @return false if the set is empty
+ */
+bool cpu_placement::select(const cpu_set_t &set, uint32 index, cpu_set_t &cpu)
+{
+	CPU_ZERO(&cpu);
+
+	int count = CPU_COUNT(&set);
+	if ( count == 0 )
+		return false;
+
+	int n = (int) ( index % count );
+
+	for ( int i = 0; i < CPU_SETSIZE; i++ ) {
+		if ( CPU_ISSET(i, &set) && n-- == 0 ) {
+			CPU_SET(i, &cpu);
+			break;
+		}
+	}
+
+	return true;
+}
+
+
+/**
+ * Get the CPUs the calling thread may run on.
+ *
+ * On failure, errno is set.
+ */
+bool cpu_placement::get_affinity(cpu_set_t &set)
+{
+	int ret = pthread_getaffinity_np(pthread_self(), sizeof(set), &set);
+
+	if ( ret != 0 )
+		errno = ret;
+
+	return ret == 0;
+}
+
+
+/**
+ * Restrict the calling thread to the given CPUs.
+ *
+ * Threads created by the calling thread afterwards inherit the setting.
+ * On failure, errno is set.
+ */
+bool cpu_placement::set_affinity(const cpu_set_t &set)
+{
+	int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+
+	if ( ret != 0 )
+		errno = ret;
+
+	return ret == 0;
+}
+
+
+/**
+ * Describe where the calling thread is placed, for logging.
+ */
+std::string cpu_placement::describe_current_thread()
+{
+	std::ostringstream out;
+
+	out << "tid " << syscall(SYS_gettid);
+
+	cpu_set_t set;
+	if ( get_affinity(set) )
+		out << " cpus " << to_string(set);
+
+	unsigned cpu = 0, node = 0;
+	if ( syscall(SYS_getcpu, &cpu, &node, NULL) == 0 )
+		out << " running on cpu " << cpu << " node " << node;
+
+	return out.str();
+}
+
+
+// EOF
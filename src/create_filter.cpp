@@ -0,0 +1,466 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file create_filter.cpp
+/// Stateless screening of CREATE messages before sessions are set up.
+/// ----------------------------------------------------------
+/// $Id: create_filter.cpp 2558 2016-04-18 10:10:00 amarentes $
+/// $HeadURL: https://./src/create_filter.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <time.h>
+
+#include "create_filter.h"
+#include "msg/selection_auctioning_entities.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * @param max_hop_count the highest message hop count accepted (0 = any)
+ * @param source_rate new sessions per second a source may set up 
+ *        (0 = unlimited)
+ * @param source_burst number of sessions a source may set up at once
+ * @param max_source_sessions the number of sessions a source may hold
+ *        (0 = unlimited)
+ * @param max_sources the number of sources tracked individually
+ */
+create_filter::create_filter(uint32 max_hop_count, uint32 source_rate,
+							 uint32 source_burst, uint32 max_source_sessions,
+							 uint32 max_sources)
+		: max_hop_count(max_hop_count), source_rate(source_rate), 
+		  source_burst(source_burst), 
+		  max_source_sessions(max_source_sessions),
+		  max_shard_sources(max_sources / NUM_SHARDS)
+{
+	if ( this->source_burst == 0 )
+		this->source_burst = 1;
+
+	if ( max_shard_sources == 0 )
+		max_shard_sources = 1;
+
+	shards = new shard_t[NUM_SHARDS];
+
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ )
+		pthread_mutex_init(&shards[i].mutex, NULL);
+
+	stats.passed = 0;
+	stats.malformed = 0;
+	stats.bad_mri = 0;
+	stats.bad_lifetime = 0;
+	stats.hop_limit = 0;
+	stats.bad_sme = 0;
+	stats.rate_limited = 0;
+	stats.over_quota = 0;
+	stats.overflowed = 0;
+}
+
+
+/**
+ * Destructor.
+ */
+create_filter::~create_filter() 
+{
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ )
+		pthread_mutex_destroy(&shards[i].mutex);
+
+	delete[] shards;
+}
+
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+uint64_t create_filter::now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * Decide whether a CREATE for an unknown session may set up a session.
+ *
+ * The values of the message are checked first, they need no state at 
+ * all. Only a CREATE passing them is charged to its source.
+ *
+ * @param request the values extracted from the CREATE
+ * @param now the current time (see now_ms())
+ * @return PASS or the reason to reject the CREATE
+ */
+create_filter::verdict_t create_filter::check(const create_request &request,
+											  uint64_t now)
+{
+	verdict_t v = PASS;
+
+	if ( ! request.well_formed )
+		v = MALFORMED;
+	else if ( ! request.path_coupled )
+		v = BAD_MRI;
+	else if ( request.lifetime == 0 )
+		v = BAD_LIFETIME;
+	else if ( request.hop_count == 0 
+			|| ( max_hop_count > 0 && request.hop_count > max_hop_count ) )
+		v = HOP_LIMIT;
+	else {
+		switch ( request.sme ) {
+			case selection_auctioning_entities::sme_all:
+			case selection_auctioning_entities::sme_any:
+			case selection_auctioning_entities::sme_first:
+			case selection_auctioning_entities::sme_last:
+			case selection_auctioning_entities::sme_first_last:
+			case selection_auctioning_entities::sme_enterprise_specific:
+				break;
+			default:
+				v = BAD_SME;
+		}
+	}
+
+	if ( v == PASS && ( source_rate > 0 || max_source_sessions > 0 ) )
+		v = admit(request.source, now);
+
+	count(v);
+
+	return v;
+}
+
+
+/**
+ * Charge a new session to its source.
+ *
+ * The source's entry is created if there is room, sources not fitting in
+ * share the overflow entry.
+ */
+create_filter::verdict_t create_filter::admit(uint64_t source, uint64_t now)
+{
+	verdict_t v = PASS;
+	source_t *s = NULL;
+
+	while ( s == NULL ) {
+		shard_t &shard = get_shard(source);
+
+		pthread_mutex_lock(&shard.mutex);
+		install_cleanup_handler(&shard.mutex);
+
+		s = lookup(shard, source, now);
+
+		if ( s == NULL )
+			; // no room left for this source
+		else if ( max_source_sessions > 0 
+				&& s->sessions >= max_source_sessions )
+			v = OVER_QUOTA;
+		else if ( source_rate > 0 && s->tokens < 1.0 )
+			v = RATE_LIMITED;
+		else if ( source_rate > 0 )
+			s->tokens -= 1.0;
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shard.mutex);
+
+		if ( s == NULL ) {
+			__sync_fetch_and_add(&stats.overflowed, 1);
+			source = OVERFLOW_SOURCE;
+		}
+	}
+
+	return v;
+}
+
+
+/**
+ * Count a new session for the given source.
+ *
+ * The session is counted until remove_session() is called for it.
+ *
+ * @param sid the ID of the new session
+ * @param source the source the CREATE came from
+ * @param now the current time (see now_ms())
+ */
+void create_filter::add_session(const session_id &sid, uint64_t source,
+								uint64_t now)
+{
+	if ( max_source_sessions == 0 )
+		return;
+
+	source_t *s = NULL;
+
+	while ( s == NULL ) {
+		shard_t &shard = get_shard(source);
+
+		pthread_mutex_lock(&shard.mutex);
+		install_cleanup_handler(&shard.mutex);
+
+		s = lookup(shard, source, now);
+		if ( s != NULL )
+			s->sessions++;
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shard.mutex);
+
+		if ( s == NULL )
+			source = OVERFLOW_SOURCE;
+	}
+
+	shard_t &shard = get_shard(sid);
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	shard.sessions[sid] = source;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+}
+
+
+/**
+ * Stop counting a session.
+ *
+ * Sessions that were never added are ignored.
+ *
+ * @param sid the ID of the removed session
+ */
+void create_filter::remove_session(const session_id &sid)
+{
+	if ( max_source_sessions == 0 )
+		return;
+
+	bool found = false;
+	uint64_t source = OVERFLOW_SOURCE;
+
+	shard_t &shard = get_shard(sid);
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	session_table_t::iterator i = shard.sessions.find(sid);
+	if ( i != shard.sessions.end() ) {
+		found = true;
+		source = i->second;
+		shard.sessions.erase(i);
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+
+	if ( ! found )
+		return;
+
+	shard_t &src_shard = get_shard(source);
+
+	pthread_mutex_lock(&src_shard.mutex);
+	install_cleanup_handler(&src_shard.mutex);
+
+	source_table_t::iterator j = src_shard.sources.find(source);
+	if ( j != src_shard.sources.end() && j->second.sessions > 0 )
+		j->second.sessions--;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&src_shard.mutex);
+}
+
+
+/**
+ * Return the number of sessions counted for the given source.
+ */
+uint32 create_filter::get_num_sessions(uint64_t source) const
+{
+	uint32 num = 0;
+	shard_t &shard = get_shard(source);
+
+	pthread_mutex_lock(&shard.mutex);
+	install_cleanup_handler(&shard.mutex);
+
+	source_table_t::const_iterator i = shard.sources.find(source);
+	if ( i != shard.sources.end() )
+		num = i->second.sessions;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&shard.mutex);
+
+	return num;
+}
+
+
+/**
+ * Return a snapshot of the filter's counters.
+ */
+create_filter_stats create_filter::get_stats() const
+{
+	create_filter_stats s;
+
+	s.passed = __sync_fetch_and_add(&stats.passed, 0);
+	s.malformed = __sync_fetch_and_add(&stats.malformed, 0);
+	s.bad_mri = __sync_fetch_and_add(&stats.bad_mri, 0);
+	s.bad_lifetime = __sync_fetch_and_add(&stats.bad_lifetime, 0);
+	s.hop_limit = __sync_fetch_and_add(&stats.hop_limit, 0);
+	s.bad_sme = __sync_fetch_and_add(&stats.bad_sme, 0);
+	s.rate_limited = __sync_fetch_and_add(&stats.rate_limited, 0);
+	s.over_quota = __sync_fetch_and_add(&stats.over_quota, 0);
+	s.overflowed = __sync_fetch_and_add(&stats.overflowed, 0);
+
+	return s;
+}
+
+
+/**
+ * Return a short name of the given verdict for logging.
+ */
+const char *create_filter::to_string(verdict_t v)
+{
+	static const char *names[NUM_VERDICTS] = {
+		"pass", "malformed", "bad MRI", "bad lifetime", "hop limit", 
+		"bad SME", "rate limited", "over quota"
+	};
+
+	return ( v < NUM_VERDICTS ) ? names[v] : "unknown";
+}
+
+
+/**
+ * Find the entry of a source, creating it if there is room.
+ *
+ * Must be called with the mutex of the shard held. The token bucket of
+ * the entry is refilled up to the current time. The overflow entry is
+ * always created.
+ *
+ * @return the entry or NULL if the shard is full
+ */
+create_filter::source_t *create_filter::lookup(shard_t &shard, 
+		uint64_t source, uint64_t now)
+{
+	source_table_t::iterator i = shard.sources.find(source);
+
+	if ( i == shard.sources.end() ) {
+		if ( shard.sources.size() >= max_shard_sources )
+			purge(shard, now);
+
+		if ( shard.sources.size() >= max_shard_sources 
+				&& source != OVERFLOW_SOURCE )
+			return NULL;
+
+		source_t s;
+		s.tokens = source_burst;
+		s.last_ms = now;
+		s.sessions = 0;
+		
+		i = shard.sources.insert(std::make_pair(source, s)).first;
+	}
+
+	source_t &s = i->second;
+
+	if ( now > s.last_ms ) {
+		s.tokens += (double) (now - s.last_ms) * source_rate / 1000.0;
+		if ( s.tokens > source_burst )
+			s.tokens = source_burst;
+		s.last_ms = now;
+	}
+
+	return &s;
+}
+
+
+/**
+ * Drop the entries of sources that hold no session and whose bucket
+ * would be full by now, they are no different from new sources.
+ *
+ * Must be called with the mutex of the shard held.
+ */
+void create_filter::purge(shard_t &shard, uint64_t now)
+{
+	uint64_t refill_ms = ( source_rate > 0 ) 
+		? (uint64_t) source_burst * 1000 / source_rate + 1 : 0;
+
+	source_table_t::iterator i = shard.sources.begin();
+
+	while ( i != shard.sources.end() ) {
+		const source_t &s = i->second;
+
+		if ( s.sessions == 0 && now >= s.last_ms + refill_ms )
+			shard.sources.erase(i++);
+		else
+			++i;
+	}
+}
+
+
+create_filter::shard_t &create_filter::get_shard(uint64_t source) const
+{
+	return shards[(source ^ (source >> 32)) % NUM_SHARDS];
+}
+
+
+create_filter::shard_t &create_filter::get_shard(const session_id &sid) const
+{
+	return shards[__gnu_cxx::hash<session_id>()(sid) % NUM_SHARDS];
+}
+
+
+/**
+ * Count a verdict in the statistics.
+ */
+void create_filter::count(verdict_t v)
+{
+	uint64_t *counter = NULL;
+
+	switch ( v ) {
+		case PASS:			counter = &stats.passed; break;
+		case MALFORMED:		counter = &stats.malformed; break;
+		case BAD_MRI:		counter = &stats.bad_mri; break;
+		case BAD_LIFETIME:	counter = &stats.bad_lifetime; break;
+		case HOP_LIMIT:		counter = &stats.hop_limit; break;
+		case BAD_SME:		counter = &stats.bad_sme; break;
+		case RATE_LIMITED:	counter = &stats.rate_limited; break;
+		case OVER_QUOTA:	counter = &stats.over_quota; break;
+		default:			return;
+	}
+
+	__sync_fetch_and_add(counter, 1);
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, 
+								const create_filter_stats &s)
+{
+	return out << "passed=" << s.passed << " malformed=" << s.malformed
+			   << " bad_mri=" << s.bad_mri 
+			   << " bad_lifetime=" << s.bad_lifetime
+			   << " hop_limit=" << s.hop_limit << " bad_sme=" << s.bad_sme
+			   << " rate_limited=" << s.rate_limited
+			   << " over_quota=" << s.over_quota
+			   << " overflowed=" << s.overflowed;
+}
+
+
+// EOF
@@ -30,6 +30,7 @@
 #include "logfile.h"
 
 #include "apimessage.h"		// from NTLP
+#include "mri_pc.h"			// from NTLP
 
 #include "anslp_config.h"
 #include "msg/anslp_ie.h"
@@ -71,10 +72,20 @@ using namespace protlib::log;
  * @param m the session manager to use for all session lookups
  * @param p the policy rule installer for interfacing with the operating system
  * @param conf a configuration for this node
+ * @param c the collector for summary refreshes, NULL to send them one by one
+ * @param k the cache for check answers, NULL to always ask the application
+ * @param f the filter screening CREATEs for unknown sessions, NULL to set
+ *        up a session for every CREATE
+ * @param b the backlog of the auction application, NULL to accept new 
+ *        sessions and biddings however long it is
  */
 dispatcher::dispatcher(session_manager *m, auction_rule_installer *p, 
-					   anslp_config *conf)
-		: session_mgr(m), rule_installer(p), config(conf) {
+					   anslp_config *conf, summary_refresh_collector *c,
+					   refresh_scheduler *r, check_cache *k, create_filter *f,
+					   install_backlog *b)
+		: session_mgr(m), rule_installer(p), config(conf), 
+		  refresh_collector(c), scheduler(r), checks(k), filter(f),
+		  backlog(b), reply_filter(NULL) {
 
 	// nothing to do
 }
@@ -146,17 +157,43 @@ void dispatcher::process(event *evt) throw () {
 		send_message( resp );
 		return;
 	}
-
+	
+	/*
+	 * A summary refresh is split into the single refreshes it stands for.
+	 */
+	else if ( is_anslp_summary_refresh(evt) ) {
+		process_summary_refresh(dynamic_cast<msg_event *>(evt));
+		return;
+	}
 
 	/*
-	 * TODO: At this point, we could do some basic error checking on the
-	 *       message to avoid creating state for obviously dubious messages.
+	 * The auction application created or removed auctions, so answers
+	 * to earlier check requests can't be reused anymore.
 	 */
+	else if ( is_api_auctions_changed(evt) ) {
+		if ( checks != NULL )
+			checks->invalidate();
+		return;
+	}
+
+	// Remember the application's answer for sessions asking the same.
+	if ( checks != NULL && is_api_check(evt) 
+			&& evt->get_session_id() != NULL ) {
+		api_check_event *e = dynamic_cast<api_check_event *>(evt);
+
+		checks->learn(evt->get_session_id()->to_string(), e->getObjects(),
+					  check_cache::now_ms());
+	}
+
+
 	MP(benchmark_journal::PRE_SESSION_MANAGER);
 
 	session *s = NULL;
 	session_id *id = evt->get_session_id();
 
+	// Sessions looked up below stay valid until the guard goes out of 
+	// scope, even if another thread removes them meanwhile.
+	epoch_guard guard(session_mgr->get_epoch_manager());
 	
 	// If the event has a session ID, try to lookup the session.
 	if ( id != NULL ){
@@ -167,11 +204,71 @@ void dispatcher::process(event *evt) throw () {
 	 * There can be several reasons if we don't find the session.
 	 * In some cases (tg_CREATE, rx_CREATE, etc.), we create a new
 	 * session.
+	 *
+	 * A received CREATE is screened first, so obviously dubious messages
+	 * and floods from a single source don't create any state. No session
+	 * is set up while the auction application is behind.
 	 */
-	if ( s == NULL )
+	if ( s == NULL ) {
+		uint64_t source = 0;
+		bool screened = false;
+
+		if ( backlog != NULL && backlog->is_full() 
+				&& ( is_anslp_create(evt) || is_api_create(evt) ) ) {
+			backlog->count_throttled();
+			reject_session_setup(evt);
+			return;
+		}
+
+		if ( filter != NULL && is_anslp_create(evt) ) {
+			msg_event *e = dynamic_cast<msg_event *>(evt);
+
+			create_filter::verdict_t v = screen_create(e, source);
+			if ( v != create_filter::PASS ) {
+				reject_create(e, v);
+				return;
+			}
+
+			screened = true;
+		}
+
 		s = create_session(evt);
 
+		if ( s != NULL && screened )
+			filter->add_session(*id, source, create_filter::now_ms());
+	}
+
 	MP(benchmark_journal::POST_SESSION_MANAGER);
+
+	/*
+	 * BIDDINGs for this node go to the auction application, they are 
+	 * rejected while it is behind. The sender may retry them later.
+	 */
+	if ( s != NULL && backlog != NULL && backlog->is_full() 
+			&& is_anslp_bidding(evt) ) {
+		msg_event *e = dynamic_cast<msg_event *>(evt);
+
+		if ( e->is_for_this_node() ) {
+			backlog->count_throttled();
+			reject_bidding(e);
+			return;
+		}
+	}
+
+	/*
+	 * Timers the session no longer waits for are discarded by every 
+	 * state. Recognize them holding the lock shared, so they don't wait
+	 * for each other with a reader/writer session lock.
+	 */
+	if ( s != NULL && is_timer(evt) ) {
+		s->acquire_shared();
+		bool outdated = s->is_outdated_timer(evt);
+		s->release_shared();
+
+		if ( outdated )
+			s = NULL;
+	}
+
 	/*
 	 * If we have a session now, process the event. Otherwise simply
 	 * discard it. Top candidates for discarding are obsolete timers.
@@ -182,11 +279,18 @@ void dispatcher::process(event *evt) throw () {
 			MP(benchmark_journal::PRE_SESSION);
 			s->acquire();
 			s->process(this, evt);
+
+			// Save the new state for a warm restart, if enabled.
+			if ( ! s->is_final() )
+				session_mgr->save_session(s);
+
 			s->release();
 			MP(benchmark_journal::POST_SESSION);
 		}
 		catch ( ... ) {
 			LogError("process() threw exception, aborting session");
+			if ( filter != NULL )
+				filter->remove_session(s->get_id());
 			session_mgr->remove_session(s->get_id());
 			return;
 		}
@@ -195,6 +299,8 @@ void dispatcher::process(event *evt) throw () {
 		 * If a session is in state FINAL after processing, delete it. 
 		*/
 		if (s->is_final()){
+			if ( filter != NULL )
+				filter->remove_session(s->get_id());
 			session_mgr->remove_session(s->get_id());
 		}	
 	}
@@ -206,6 +312,81 @@ void dispatcher::process(event *evt) throw () {
 }
 
 
+/**
+ * Check whether processing the event would set up a new session.
+ *
+ * Retransmitted CREATE messages for sessions we already have are not
+ * session setups.
+ */
+bool dispatcher::is_session_setup(const event *evt) throw () {
+	assert( evt != NULL );
+
+	if ( is_api_create(evt) )
+		return true;
+
+	if ( ! is_anslp_create(evt) || evt->get_session_id() == NULL )
+		return false;
+
+	epoch_guard guard(session_mgr->get_epoch_manager());
+
+	return session_mgr->get_session(*evt->get_session_id()) == NULL;
+}
+
+
+/**
+ * Reject a session setup because we are overloaded.
+ *
+ * A CREATE received from the network gets a transient failure response,
+ * so the sender may retry later. A create request from the API is 
+ * reported to the user.
+ */
+void dispatcher::reject_session_setup(event *evt) throw () {
+	assert( evt != NULL );
+
+	msg_event *e = dynamic_cast<msg_event *>(evt);
+
+	if ( e != NULL && e->get_ntlp_msg() != NULL ) {
+		LogWarn("overloaded, rejecting CREATE for session " 
+				<< e->get_session_id()->to_string());
+
+		send_message( e->get_ntlp_msg()->create_response(
+			information_code::sc_transient_failure,
+			information_code::tfail_resources_unavailable) );
+	}
+	else {
+		report_async_event("overloaded, rejecting session setup");
+	}
+}
+
+
+/**
+ * Reject a BIDDING because the auction application is behind.
+ *
+ * The sender gets a transient failure response, so it may retry later.
+ */
+void dispatcher::reject_bidding(const msg_event *evt) throw () {
+	assert( evt != NULL && evt->get_ntlp_msg() != NULL );
+
+	LogWarn("auction application behind, rejecting BIDDING for session " 
+			<< evt->get_session_id()->to_string());
+
+	send_message( evt->get_ntlp_msg()->create_response(
+		information_code::sc_transient_failure,
+		information_code::tfail_resources_unavailable) );
+}
+
+
+/**
+ * Set the duplicate filter that keeps the replies sent from now on.
+ *
+ * The session processing an event sets its filter for the duration of
+ * the call, NULL stops recording.
+ */
+void dispatcher::set_reply_filter(duplicate_filter *filter) throw () {
+	reply_filter = filter;
+}
+
+
 /**
  * Analyzes the given event and creates a session, if appropriate.
  *
@@ -237,14 +418,275 @@ session *dispatcher::create_session(event *evt) const throw () {
 }
 
 
+/**
+ * Screen a received CREATE for which there is no session yet.
+ *
+ * Only the values of the message and the counters of its source are 
+ * looked at, no session state is allocated.
+ *
+ * @param evt the event carrying the CREATE
+ * @param source returns the key of the node the CREATE came from
+ * @return PASS if a session may be set up for the CREATE
+ */
+create_filter::verdict_t dispatcher::screen_create(const msg_event *evt,
+		uint64_t &source) const throw () {
+	assert( filter != NULL );
+
+	const ntlp_msg *msg = evt->get_ntlp_msg();
+	const anslp_create *create = msg->get_anslp_create();
+	const ntlp::mri_pathcoupled *pc_mri
+		= dynamic_cast<const ntlp::mri_pathcoupled *>(msg->get_mri());
+
+	// Use the GIST peer, if known, or else the flow's source address.
+	if ( msg->get_sii_handle() != 0 )
+		source = ( (uint64_t) 1 << 32 ) | msg->get_sii_handle();
+	else if ( pc_mri != NULL )
+		source = ( (uint64_t) 2 << 32 ) 
+			| (uint32) pc_mri->get_sourceaddress().get_hash();
+	else
+		source = create_filter::OVERFLOW_SOURCE;
+
+	create_request request;
+	request.source = source;
+	request.well_formed = ( create != NULL && create->check() );
+	request.path_coupled = ( pc_mri != NULL && pc_mri->get_downstream() );
+	request.lifetime = 0;
+	request.hop_count = 0;
+	request.sme = 0;
+
+	if ( request.well_formed ) {
+		request.lifetime = create->get_session_lifetime();
+		request.hop_count = create->get_message_hop_count();
+		request.sme = create->get_selection_auctioning_entities();
+	}
+
+	return filter->check(request, create_filter::now_ms());
+}
+
+
+/**
+ * Send the response to a CREATE that was screened out.
+ *
+ * The responses differ only in their MSN, so each one is serialized the
+ * first time it is needed and its MSN is patched afterwards.
+ */
+void dispatcher::reject_create(const msg_event *evt, 
+							   create_filter::verdict_t verdict) throw () {
+	assert( verdict > create_filter::PASS 
+			&& verdict < create_filter::NUM_VERDICTS );
+
+	const ntlp_msg *msg = evt->get_ntlp_msg();
+	const anslp_create *create = msg->get_anslp_create();
+
+	LogDebug("rejecting CREATE for session " << msg->get_session_id()
+			<< ": " << create_filter::to_string(verdict));
+
+	wire_image &image = reject_images[verdict];
+
+	if ( image.is_empty() ) {
+		uint8 severity = information_code::sc_protocol_error;
+		uint8 code = information_code::perr_unknown_object_field_value;
+		uint16 object_type = 0;
+
+		switch ( verdict ) {
+			case create_filter::MALFORMED:
+				code = 0;
+				break;
+			case create_filter::BAD_MRI:
+				severity = information_code::sc_permanent_failure;
+				code = information_code::fail_configuration_failed;
+				break;
+			case create_filter::BAD_LIFETIME:
+				object_type = information_code::obj_session_lifetime;
+				break;
+			case create_filter::HOP_LIMIT:
+				object_type = information_code::obj_message_hop_count;
+				break;
+			case create_filter::BAD_SME:
+				object_type = information_code::obj_selection_met_entities;
+				break;
+			default: // RATE_LIMITED, OVER_QUOTA
+				severity = information_code::sc_transient_failure;
+				code = information_code::tfail_resources_unavailable;
+		}
+
+		anslp_response resp;
+		resp.set_information_code(severity, code, object_type);
+		resp.set_msg_sequence_number(0);
+
+		image.assign(&resp);
+	}
+
+	// A malformed CREATE may lack the MSN; answer those with MSN 0.
+	image.set_msg_sequence_number( 
+		( create != NULL && create->has_msg_sequence_number() )
+			? create->get_msg_sequence_number() : 0 );
+
+	// Like create_response(), the response takes the reverse path.
+	ntlp::mri *mri = msg->get_mri()->copy();
+	mri->invertDirection();
+
+	ntlp_msg reverse(msg->get_session_id(), NULL, mri, 0);
+
+	send_wire_message(&reverse, image);
+}
+
+
+/**
+ * Process a summary refresh.
+ *
+ * Every session listed is processed as if a REFRESH message carrying its
+ * MSN and lifetime had arrived from the same peer. The summary's MRI is
+ * that of one session only, so each REFRESH gets the MRI of its own
+ * session, if known.
+ */
+void dispatcher::process_summary_refresh(msg_event *evt) throw () {
+	assert( evt != NULL );
+	
+	anslp_summary_refresh *summary = 
+		dynamic_cast<anslp_summary_refresh *>(evt->get_anslp_msg());
+	
+	LogDebug("processing summary refresh for " 
+				<< summary->get_num_sessions() << " sessions");
+
+	epoch_guard guard(session_mgr->get_epoch_manager());
+
+	for ( size_t i = 0; i < summary->get_num_sessions(); i++ ) {
+		const session_refresh_list::entry &entry = summary->get_session(i);
+		
+		anslp_refresh *refresh = new anslp_refresh();
+		refresh->set_msg_sequence_number(entry.msn);
+		refresh->set_session_lifetime(entry.lifetime);
+		
+		session_id *sid = new session_id(entry.sid);
+
+		ntlp::mri *mri = NULL;
+		session *s = session_mgr->get_session(*sid);
+
+		if ( s != NULL ) {
+			s->acquire_shared();
+			if ( s->get_refresh_mri() != NULL )
+				mri = s->get_refresh_mri()->copy();
+			s->release_shared();
+		}
+
+		// Unknown sessions are rejected, any MRI does for the response.
+		if ( mri == NULL )
+			mri = evt->get_mri()->copy();
+		
+		ntlp_msg *msg = new ntlp_msg(*sid, refresh, 
+			mri, evt->get_sii_handle());
+
+		msg_event single(sid, msg, evt->is_for_this_node());
+		
+		process(&single);
+	}
+}
+
+
 /**
  * Send a A-NSLP message.
  *
+ * If summary refreshes are enabled, REFRESH messages are handed to the 
+ * collector and sent later together with other refreshes to the same peer.
+ *
  * This method will delete the msg object after it is done with it.
  *
  * @param msg the message to send
  */
 void dispatcher::send_message(msg::ntlp_msg *msg) throw () {
+
+	if ( reply_filter != NULL )
+		reply_filter->record_reply(msg);
+
+	if ( refresh_collector != NULL && config->use_summary_refresh() ) {
+		std::vector<msg::ntlp_msg *> ready;
+		
+		if ( refresh_collector->add(msg, ready) ) {
+			for ( size_t i = 0; i < ready.size(); i++ )
+				send_to_ntlp(ready[i]);
+			return;
+		}
+	}
+	
+	send_to_ntlp(msg);
+}
+
+
+/**
+ * Send a message the session keeps for retransmission.
+ *
+ * The message is serialized into the session's wire image the first time
+ * and the image is sent as it is afterwards. The session has to clear the
+ * image whenever it changes the message, except for the MSN, which it may
+ * patch into the image.
+ *
+ * When summary refreshes are enabled, REFRESH messages the collector takes
+ * are copied and the image is not used; the collector needs the message
+ * itself. Other messages, including REFRESH messages the collector can't
+ * group, are still sent from the image.
+ *
+ * @param msg the message, it is not deleted
+ * @param image the wire image of the message, may be empty
+ */
+void dispatcher::send_wire_message(const msg::ntlp_msg *msg, 
+								   msg::wire_image &image) throw () {
+	assert( msg != NULL );
+
+	if ( reply_filter != NULL )
+		reply_filter->record_reply(msg);
+
+	// The collector owns what it takes, it gets a copy.
+	if ( refresh_collector != NULL && config->use_summary_refresh()
+			&& refresh_collector->collects(msg) ) {
+		std::vector<msg::ntlp_msg *> ready;
+
+		msg::ntlp_msg *copy = msg->copy();
+
+		if ( ! refresh_collector->add(copy, ready) )
+			ready.push_back(copy);
+
+		for ( size_t i = 0; i < ready.size(); i++ )
+			send_to_ntlp(ready[i]);
+
+		return;
+	}
+
+	if ( image.is_empty() )
+		image.assign(msg->get_anslp_msg());
+
+	LogDebug("sending wire image of " << image.get_size() 
+			<< " bytes for session " << msg->get_session_id());
+
+	ntlp::APIMsg *apimsg = mapper.create_api_msg(msg, image);
+
+	bool success = apimsg->send_to(anslp_config::OUTPUT_QUEUE_ADDRESS);
+	assert( success );
+}
+
+
+/**
+ * Send the summary refreshes that waited long enough.
+ *
+ * @param all send all pending refreshes, no matter how long they waited
+ */
+void dispatcher::flush_summary_refreshes(bool all) throw () {
+
+	if ( refresh_collector == NULL )
+		return;
+	
+	std::vector<msg::ntlp_msg *> ready;
+	refresh_collector->flush(all, ready);
+	
+	for ( size_t i = 0; i < ready.size(); i++ )
+		send_to_ntlp(ready[i]);
+}
+
+
+/**
+ * Pass a message to the NTLP and delete it.
+ */
+void dispatcher::send_to_ntlp(msg::ntlp_msg *msg) throw () {
 	LogDebug("sending message for session "
 			<< msg->get_session_id() << " " << *msg);
 
@@ -307,6 +749,81 @@ id_t dispatcher::start_timer(const session *s, int seconds) throw () {
 }
 
 
+/**
+ * Start a timer with millisecond resolution.
+ *
+ * @param s the session this timer is for
+ * @param msecs the number of milliseconds from now
+ * @return a timer ID which can be used to recognize this timer
+ */
+id_t dispatcher::start_timer_ms(const session *s, uint32 msecs) throw () {
+
+	anslp_timer_msg *msg = new anslp_timer_msg(
+		s->get_id(), anslp_config::INPUT_QUEUE_ADDRESS, false);
+
+	id_t ret = msg->get_id(); // save it now to avoid a race condition
+
+	msg->start_relative(msecs / 1000, msecs % 1000);
+	msg->send_to(anslp_config::TIMER_MODULE_QUEUE_ADDRESS);
+
+	LogDebug("started timer " << ret << " for session " << s->get_id()
+		<< " (" << msecs << " ms)");
+
+	return ret;
+}
+
+
+/**
+ * Start a refresh timer.
+ *
+ * The refresh scheduler, if any, picks the exact delay so that refreshes
+ * of many sessions don't fire at the same time. Without a scheduler, the
+ * timer fires after the nominal interval.
+ *
+ * @param s the session this timer is for
+ * @param interval the nominal refresh interval in seconds
+ * @param deadline the number of seconds after which the refresh is too late
+ * @return a timer ID which can be used to recognize this timer
+ */
+id_t dispatcher::start_refresh_timer(const session *s, uint32 interval,
+									 uint32 deadline) throw () {
+
+	if ( scheduler == NULL )
+		return start_timer(s, interval);
+
+	return start_timer_ms(s, 
+		scheduler->schedule(interval * 1000, deadline * 1000));
+}
+
+
+/**
+ * Ask the refresh scheduler whether a due refresh may be sent now.
+ *
+ * @param mri the MRI the refresh is sent with
+ * @param due_ms the nominal time of the refresh (see refresh_scheduler)
+ * @param deadline_ms the time after which the refresh is too late
+ * @return 0 to send it now, otherwise the number of ms to defer it
+ */
+uint32 dispatcher::admit_refresh(const ntlp::mri *mri, uint64_t due_ms,
+								 uint64_t deadline_ms) throw () {
+
+	if ( scheduler == NULL )
+		return 0;
+
+	std::string peer;
+	if ( ! summary_refresh_collector::get_peer_key(mri, 0, peer) )
+		peer = "";
+
+	uint32 defer = scheduler->admit(peer, due_ms, deadline_ms);
+	
+	if ( defer > 0 )
+		LogDebug("deferring refresh toward " << peer 
+			<< " by " << defer << " ms");
+
+	return defer;
+}
+
+
 /**
  * Report an asynchronous event to the user.
  *
@@ -396,6 +913,13 @@ bool dispatcher::check(const string session_id,
 	
 	if (config->get_install_auction_rules())
 	{	
+		if ( checks != NULL && answer_check(session_id, missing_objects) )
+			return true;
+		
+		// Register first, the answer may arrive on another thread.
+		if ( checks != NULL )
+			checks->expect(session_id, missing_objects, check_cache::now_ms());
+		
 		rule_installer->check(session_id, missing_objects);
 		return true;
 	}
@@ -405,6 +929,45 @@ bool dispatcher::check(const string session_id,
 	}
 }
 
+
+/**
+ * Answer a check request from the check cache, if possible.
+ *
+ * The answer is queued like one from the auction application, so the
+ * session can't tell them apart.
+ *
+ * @return true if an answer was queued
+ */
+bool dispatcher::answer_check(const string sid, 
+							  const objectList_t *objects) throw () {
+	
+	std::vector<bool> applicable;
+	
+	if ( ! checks->lookup(objects, applicable, check_cache::now_ms()) )
+		return false;
+
+	api_check_event *evt = new api_check_event(new anslp::session_id(sid));
+
+	uint32 i = 0;
+	objectListConstIter_t it;
+	for ( it = objects->begin(); it != objects->end(); it++, i++ ) {
+		if ( applicable[i] )
+			evt->setObject(mspec_rule_key(it->first), it->second->copy());
+	}
+
+	anslp_event_msg *msg = new anslp_event_msg(anslp::session_id(sid), evt);
+
+	if ( ! msg->send_to(anslp_config::INPUT_QUEUE_ADDRESS) ) {
+		delete msg;
+		delete evt;
+		return false;
+	}
+
+	LogDebug("check for session " << sid << " answered from the cache");
+
+	return true;
+}
+
 bool dispatcher::is_authorized(const msg_event *evt) const throw () {
 	LogUnimp("implement dispatcher::is_authorized()!");
 	return true;
@@ -0,0 +1,174 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file duplicate_filter.cpp
+/// Per-session filter for retransmitted messages.
+/// ----------------------------------------------------------
+/// $Id: duplicate_filter.cpp 2558 2016-04-11 09:30:00 amarentes $
+/// $HeadURL: https://./src/duplicate_filter.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include "duplicate_filter.h"
+#include "msg/ntlp_msg.h"
+#include "msg/anslp_msg.h"
+
+
+namespace anslp 
+{
+
+using namespace msg;
+
+
+duplicate_filter::duplicate_filter() : num_entries(0), next(0) 
+{
+	for ( uint32 i = 0; i < CAPACITY; i++ )
+		entries[i].reply = NULL;
+}
+
+
+duplicate_filter::~duplicate_filter() 
+{
+	clear();
+}
+
+
+/**
+ * Check whether the filter looks at the given message at all.
+ *
+ * Only CREATE, BIDDING and RESPONSE messages carrying an MSN are filtered.
+ */
+bool 
+duplicate_filter::is_filtered(const ntlp_msg *msg) 
+{
+	if ( msg == NULL || msg->get_anslp_msg() == NULL )
+		return false;
+
+	const anslp_msg *body = msg->get_anslp_msg();
+	uint8 type = body->get_msg_type();
+
+	if ( type != anslp_create::MSG_TYPE && type != anslp_bidding::MSG_TYPE
+			&& type != anslp_response::MSG_TYPE )
+		return false;
+
+	return body->has_msg_sequence_number();
+}
+
+
+/**
+ * Check whether the given message was received before.
+ *
+ * @param msg the received message, see is_filtered()
+ * @param digest the digest of msg's body
+ * @param reply returns the reply sent to the earlier message, or NULL
+ * @return true if msg repeats a message recorded earlier
+ */
+bool 
+duplicate_filter::lookup(const ntlp_msg *msg, const content_digest &digest,
+						 const ntlp_msg *&reply) const 
+{
+	const anslp_msg *body = msg->get_anslp_msg();
+	uint8 type = body->get_msg_type();
+	uint32 msn = body->get_msg_sequence_number();
+
+	reply = NULL;
+
+	for ( uint32 i = 0; i < num_entries; i++ ) {
+		const entry &e = entries[i];
+
+		if ( e.msg_type == type && e.msn == msn && e.digest == digest ) {
+			reply = e.reply;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/**
+ * Record a received message, replacing the oldest entry when full.
+ */
+void 
+duplicate_filter::record(const ntlp_msg *msg, const content_digest &digest) 
+{
+	const anslp_msg *body = msg->get_anslp_msg();
+	entry &e = entries[next];
+
+	delete e.reply;
+
+	e.msg_type = body->get_msg_type();
+	e.msn = body->get_msg_sequence_number();
+	e.digest = digest;
+	e.reply = NULL;
+
+	next = (next + 1) % CAPACITY;
+
+	if ( num_entries < CAPACITY )
+		num_entries++;
+}
+
+
+/**
+ * Keep a copy of a RESPONSE sent by the session.
+ *
+ * The copy goes with the CREATE recorded for the response's MSN. Replies
+ * to messages that are not recorded, e.g. to REFRESH messages, are 
+ * ignored.
+ */
+void 
+duplicate_filter::record_reply(const ntlp_msg *reply) 
+{
+	const anslp_response *resp = reply->get_anslp_response();
+
+	if ( resp == NULL || ! resp->has_msg_sequence_number() )
+		return;
+
+	uint32 msn = resp->get_msg_sequence_number();
+
+	for ( uint32 i = 0; i < num_entries; i++ ) {
+		entry &e = entries[i];
+
+		if ( e.msg_type == anslp_create::MSG_TYPE && e.msn == msn ) {
+			delete e.reply;
+			e.reply = reply->copy();
+		}
+	}
+}
+
+
+void 
+duplicate_filter::clear() 
+{
+	for ( uint32 i = 0; i < num_entries; i++ ) {
+		delete entries[i].reply;
+		entries[i].reply = NULL;
+	}
+
+	num_entries = 0;
+	next = 0;
+}
+
+
+} // namespace anslp
+
+// EOF
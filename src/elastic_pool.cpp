@@ -0,0 +1,272 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file elastic_pool.cpp
+/// Sizing of the dispatcher thread pool by queueing delay.
+/// ----------------------------------------------------------
+/// $Id: elastic_pool.cpp 2558 2016-04-22 10:00:00 amarentes $
+/// $HeadURL: https://./src/elastic_pool.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <time.h>
+#include <errno.h>
+
+#include "elastic_pool.h"
+
+
+using namespace anslp;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * If max_workers isn't larger than min_workers or target_delay_ms is 0,
+ * the pool has a fixed size of min_workers.
+ *
+ * @param min_workers the number of threads that always work
+ * @param max_workers the number of threads started
+ * @param target_delay_ms the queueing delay above which threads are added
+ * @param idle_ms the time a thread has to be idle before it is parked
+ */
+elastic_pool::elastic_pool(uint32 min_workers, uint32 max_workers,
+			uint32 target_delay_ms, uint32 idle_ms)
+		: min_workers(min_workers), max_workers(max_workers),
+		  target_delay_ms(target_delay_ms), idle_ms(idle_ms),
+		  size(0), pending(0), num_started(0), last_grown(0)
+{
+	if ( this->min_workers == 0 )
+		this->min_workers = 1;
+
+	if ( this->max_workers < this->min_workers || target_delay_ms == 0 )
+		this->max_workers = this->min_workers;
+
+	stats.size = 0;
+	stats.queue_delay_ms = 0;
+	stats.grown = 0;
+	stats.shrunk = 0;
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+	pthread_mutex_init(&mutex, NULL);
+	pthread_cond_init(&wakeup, &attr);
+
+	pthread_condattr_destroy(&attr);
+}
+
+
+/**
+ * Destructor.
+ */
+elastic_pool::~elastic_pool() 
+{
+	pthread_cond_destroy(&wakeup);
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+uint64_t elastic_pool::now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * Register a newly started thread.
+ *
+ * @return true if the thread works, false if it starts parked
+ */
+bool elastic_pool::start_worker() 
+{
+	bool ret = false;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	num_started++;
+
+	if ( size < min_workers ) {
+		size++;
+		ret = true;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Wait until a parked thread is put to work.
+ *
+ * The timeout lets the caller check regularly whether it has to stop.
+ *
+ * @param timeout_ms the maximum time to wait
+ * @return true if the thread works now, false on timeout
+ */
+bool elastic_pool::park(uint32 timeout_ms) 
+{
+	bool ret = false;
+
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long) ( timeout_ms % 1000 ) * 1000000;
+
+	if ( deadline.tv_nsec >= 1000000000 ) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	int err = 0;
+
+	while ( pending == 0 && err != ETIMEDOUT )
+		err = pthread_cond_timedwait(&wakeup, &mutex, &deadline);
+
+	if ( pending > 0 ) {
+		pending--;
+		ret = true;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Report the queueing delay seen by a working thread.
+ *
+ * If the delay is above the target, a parked thread is put to work.
+ *
+ * @param delay_ms the queueing delay in milliseconds
+ * @param now the current time as returned by now_ms()
+ * @return true if a thread was put to work
+ */
+bool elastic_pool::report_delay(uint32 delay_ms, uint64_t now) 
+{
+	stats.queue_delay_ms = delay_ms;
+
+	if ( ! is_elastic() || delay_ms <= target_delay_ms 
+			|| size >= max_workers )
+		return false;
+
+	bool ret = false;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	// The last thread added needs some time to show an effect.
+	if ( size < max_workers && size < num_started 
+			&& now >= last_grown + target_delay_ms ) {
+		size++;
+		pending++;
+		last_grown = now;
+		stats.grown++;
+
+		pthread_cond_signal(&wakeup);
+		ret = true;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Decide whether an idle working thread is parked.
+ *
+ * @param idle_since the time since which the thread found no work
+ * @param now the current time as returned by now_ms()
+ * @return true if the thread has to call park()
+ */
+bool elastic_pool::retire(uint64_t idle_since, uint64_t now) 
+{
+	if ( ! is_elastic() || now < idle_since + idle_ms || size <= min_workers )
+		return false;
+
+	bool ret = false;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	if ( size > min_workers ) {
+		size--;
+		stats.shrunk++;
+		ret = true;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+
+/**
+ * Return a copy of the current state.
+ */
+elastic_pool_stats elastic_pool::get_stats() const
+{
+	elastic_pool_stats s;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	s = stats;
+	s.size = size;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return s;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, const elastic_pool_stats &s)
+{
+	return out << "size=" << s.size << " queue_delay=" << s.queue_delay_ms
+		<< "ms grown=" << s.grown << " shrunk=" << s.shrunk;
+}
+
+
+// EOF
@@ -0,0 +1,260 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file epoch_manager.cpp
+/// The epoch_manager class.
+/// ----------------------------------------------------------
+/// $Id: epoch_manager.cpp 2558 2016-03-15 09:40:00 amarentes $
+/// $HeadURL: https://./src/epoch_manager.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <string.h>
+
+#include "logfile.h"
+
+#include "session.h"
+#include "epoch_manager.h"
+
+
+using namespace anslp;
+using namespace protlib::log;
+
+
+#define LogError(msg) ERRLog("epoch_manager", msg)
+#define LogWarn(msg) WLog("epoch_manager", msg)
+#define LogInfo(msg) ILog("epoch_manager", msg)
+#define LogDebug(msg) DLog("epoch_manager", msg)
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/*
+ * Every manager gets a distinct instance number, so a record cached by a 
+ * thread can never be confused with one of a newer manager that happens 
+ * to live at the same address.
+ */
+static volatile unsigned long next_instance = 0;
+
+static __thread unsigned long cached_instance = 0;
+static __thread int cached_record = -1;
+
+
+/**
+ * Constructor.
+ */
+epoch_manager::epoch_manager()
+		: global_epoch(0), num_retired(0)
+{
+	instance = __sync_add_and_fetch(&next_instance, 1);
+	
+	memset((void *) records, 0, sizeof(records));
+	
+	pthread_mutex_init(&mutex, NULL);
+}
+
+
+/**
+ * Destructor.
+ *
+ * Deletes all retired sessions. No thread may be inside a critical 
+ * section anymore.
+ */
+epoch_manager::~epoch_manager()
+{
+	std::list<retired_session>::iterator i;
+	for ( i = retired.begin(); i != retired.end(); i++ )
+		delete i->s;
+
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Return the record of the calling thread, claim a free one if the thread
+ * has none yet.
+ */
+epoch_manager::thread_record *epoch_manager::get_record()
+{
+	if ( cached_instance == instance )
+		return &records[cached_record];
+
+	for ( int i = 0; i < MAX_THREADS; i++ ) {
+		if ( records[i].in_use == 0 
+			 && __sync_bool_compare_and_swap(&records[i].in_use, 0, 1) ) {
+			cached_instance = instance;
+			cached_record = i;
+			return &records[i];
+		}
+	}
+
+	LogError("more than " << MAX_THREADS << " threads use the epoch manager");
+	assert( false );
+	return NULL;
+}
+
+
+/**
+ * Enter a critical section.
+ *
+ * Session pointers obtained after this call remain valid until the 
+ * matching leave(). Critical sections may be nested.
+ */
+void epoch_manager::enter()
+{
+	thread_record *r = get_record();
+	
+	if ( r->depth++ > 0 )
+		return;
+
+	// Publish that we are active before reading the epoch, so a thread 
+	// advancing the epoch either sees us or we see its new epoch.
+	__sync_synchronize();
+	r->epoch = global_epoch;
+	__sync_synchronize();
+}
+
+
+/**
+ * Leave a critical section.
+ *
+ * Session pointers obtained inside the critical section must not be used
+ * anymore.
+ */
+void epoch_manager::leave()
+{
+	thread_record *r = get_record();
+	
+	assert( r->depth > 0 );
+	
+	__sync_synchronize();
+	
+	if ( --r->depth > 0 )
+		return;
+
+	// Help reclaiming, but never wait for other threads doing it.
+	if ( num_retired > 0 && pthread_mutex_trylock(&mutex) == 0 ) {
+		collect();
+		pthread_mutex_unlock(&mutex);
+	}
+}
+
+
+/**
+ * Release the record of the calling thread.
+ *
+ * Called by threads that stop using this manager, for example when a 
+ * dispatcher thread leaves its main loop.
+ */
+void epoch_manager::unregister_thread()
+{
+	if ( cached_instance != instance )
+		return;
+
+	thread_record *r = &records[cached_record];
+	
+	assert( r->depth == 0 );
+
+	cached_instance = 0;
+	cached_record = -1;
+	
+	__sync_lock_release(&r->in_use);
+}
+
+
+/**
+ * Retire a session that was already removed from the session table.
+ *
+ * The session is deleted as soon as no thread can observe it anymore,
+ * which may happen right away.
+ *
+ * @param s the session to retire (may be NULL)
+ */
+void epoch_manager::retire(session *s)
+{
+	if ( s == NULL )
+		return;
+		
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	retired_session entry = { s, global_epoch };
+	retired.push_back(entry);
+	__sync_add_and_fetch(&num_retired, 1);
+
+	collect();
+	
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+}
+
+
+/**
+ * Advance the global epoch if every thread inside a critical section 
+ * has observed the current one.
+ */
+bool epoch_manager::try_advance()
+{
+	unsigned long epoch = global_epoch;
+	
+	for ( int i = 0; i < MAX_THREADS; i++ ) {
+		if ( records[i].in_use && records[i].depth > 0 
+			 && records[i].epoch != epoch )
+			return false;
+	}
+
+	return __sync_bool_compare_and_swap(&global_epoch, epoch, epoch + 1);
+}
+
+
+/**
+ * Delete retired sessions that no thread can observe anymore.
+ *
+ * Sessions retired in epoch e are safe once the global epoch reached e+2.
+ * The caller has to hold the mutex.
+ */
+void epoch_manager::collect()
+{
+	if ( retired.empty() )
+		return;
+	
+	// Without active threads the epoch may advance twice right away.
+	if ( try_advance() )
+		try_advance();
+
+	unsigned long epoch = global_epoch;
+
+	// The list is ordered by retirement epoch.
+	while ( ! retired.empty() && retired.front().epoch + 2 <= epoch ) {
+	
+		LogDebug("deleting session " << retired.front().s->get_id());
+		
+		delete retired.front().s;
+		retired.pop_front();
+		__sync_sub_and_fetch(&num_retired, 1);
+	}
+}
+
+// EOF
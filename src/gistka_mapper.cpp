@@ -35,6 +35,7 @@
 #include "msg/anslp_ie.h"
 #include "events.h"
 #include "gistka_mapper.h"
+#include "netmsg_pool.h"
 #include "benchmark_journal.h"
 
 
@@ -69,21 +70,61 @@ ntlp::APIMsg *gistka_mapper::create_api_msg(msg::ntlp_msg *msg) const throw ()
 	 * Construct the NSLP payload (the NTLP's body).
 	 */
 	const anslp_msg *m = msg->get_anslp_msg();
-	NetMsg payload( m->get_serialized_size(IE::protocol_v1) );
+	
+	/*
+	 * Object sizes are cached, except for IPAP objects. Those are asked
+	 * every time, but their size is only the export offset plus padding.
+	 */
+	NetMsg *payload = netmsg_pool::acquire(
+		m->get_serialized_size(IE::protocol_v1) );
+	
+	uint32 bytes_written = 0;
 
 	try {
-		uint32 bytes_written;
-		m->serialize(payload, IE::protocol_v1, bytes_written);
+		m->serialize(*payload, IE::protocol_v1, bytes_written);
 	}
 	catch ( IEError &e ) {
 		LogError("serializing M-NSLP message failed");
 		assert( false ); // this would be a programming error
 	}
 
+	/*
+	 * Note: The nslpdata constructor copies the buffer. The NTLP owns its
+	 * payload, so every message still costs one allocation and copy here;
+	 * the pool only saves the serialization buffer.
+	 */
+	nslpdata *data = new nslpdata(payload->get_buffer(), bytes_written);
+
+	netmsg_pool::release(payload);
+
+	return create_api_msg(data, msg);
+}
+
+
+/*
+ * Create an NTLP APIMsg from the wire image of our ntlp_msg.
+ *
+ * Only the routing data is taken from the ntlp_msg, the payload is the
+ * image.
+ */
+ntlp::APIMsg *gistka_mapper::create_api_msg(const msg::ntlp_msg *msg,
+		const msg::wire_image &image) const throw () 
+{
+	using ntlp::nslpdata;
+
 	// Note: The nslpdata constructor copies the buffer.
-	nslpdata *data = new nslpdata(payload.get_buffer(), payload.get_size());
+	nslpdata *data = new nslpdata(image.get_buffer(), image.get_size());
+
+	return create_api_msg(data, msg);
+}
 
 
+/*
+ * Create an NTLP APIMsg carrying the given payload.
+ */
+ntlp::APIMsg *gistka_mapper::create_api_msg(ntlp::nslpdata *data, 
+		const msg::ntlp_msg *msg) const throw () 
+{
 	/*
 	 * Gather all data the NTLP needs for sending our message.
 	 */
@@ -167,6 +208,39 @@ event *gistka_mapper::map_to_event(const protlib::message *msg) const
 }
 
 
+/**
+ * Check whether a message may set up a new session, without mapping it.
+ *
+ * This is true for create requests from the API and for received CREATE
+ * messages. Only the message type in the A-NSLP header is looked at, so
+ * this is cheap enough to be used for triage when we are overloaded.
+ */
+bool gistka_mapper::is_session_setup(const protlib::message *msg) const 
+{
+	using ntlp::APIMsg;
+	using ntlp::nslpdata;
+
+	assert( msg != NULL );
+
+	const APIMsg *apimsg = dynamic_cast<const APIMsg *>(msg);
+
+	if ( apimsg != NULL ) {
+		if ( apimsg->get_subtype() != APIMsg::RecvMessage )
+			return false;
+
+		nslpdata *data = apimsg->get_data();
+		
+		// The message type is the first byte of the A-NSLP header.
+		return data != NULL && data->get_size() >= anslp_msg::HEADER_LENGTH
+			&& data->get_buffer()[0] == anslp_create::MSG_TYPE;
+	}
+
+	const anslp_event_msg *em = dynamic_cast<const anslp_event_msg *>(msg);
+	
+	return em != NULL && is_api_create(em->get_event());
+}
+
+
 event *gistka_mapper::map_api_message(const ntlp::APIMsg *msg) const 
 {
 	using ntlp::APIMsg;
@@ -245,6 +319,7 @@ event *gistka_mapper::map_api_receive_message(
 	 * Parse the NSLP payload (the NTLP's body).
 	 */
 	MP(benchmark_journal::PRE_DESERIALIZE);
+	// This is the only copy of the payload, objects are decoded from it.
 	NetMsg payload(data->get_buffer(), data->get_size()); // copies the data
 	ANSLP_IEManager *mgr = ANSLP_IEManager::instance();
 
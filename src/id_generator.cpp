@@ -0,0 +1,109 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file id_generator.cpp
+/// Per-thread generator for random 128 bit identifiers.
+/// ----------------------------------------------------------
+/// $Id: id_generator.cpp 2558 2016-03-14 10:12:00 amarentes $
+/// $HeadURL: https://./src/id_generator.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/err.h>
+#include <openssl/rand.h>
+
+#include "logfile.h"
+
+#include "id_generator.h"
+
+
+using namespace anslp;
+using namespace protlib::log;
+
+
+#define LogError(msg) ERRLog("id_generator", msg)
+
+
+/*
+ * Pool state of the calling thread. The pool starts empty, so the first
+ * request of every thread fills it.
+ */
+static __thread unsigned char pool[id_generator::POOL_SIZE];
+static __thread size_t pool_pos = id_generator::POOL_SIZE;
+static __thread unsigned long refills = 0;
+
+
+/**
+ * Refill the pool of the calling thread using OpenSSL's 
+ * cryptographically strong random numbers.
+ *
+ * If OpenSSL can't deliver, the pool still holds used (zeroed) bytes.
+ * Handing those out would give every caller the same identifier, so the
+ * process is terminated instead.
+ */
+void id_generator::refill()
+{
+	if ( RAND_bytes(pool, sizeof(pool)) != 1 ) {
+		LogError("refilling the random pool failed: "
+			<< ERR_error_string(ERR_get_error(), NULL));
+		abort();
+	}
+	
+	pool_pos = 0;
+	refills++;
+}
+
+
+void id_generator::generate(unsigned char *buf, size_t length)
+{
+	while ( length > 0 ) {
+		
+		if ( pool_pos == POOL_SIZE )
+			refill();
+
+		size_t avail = POOL_SIZE - pool_pos;
+		size_t n = ( length < avail ) ? length : avail;
+
+		memcpy(buf, pool + pool_pos, n);
+		
+		// Never hand out the same bytes twice.
+		memset(pool + pool_pos, 0, n);
+
+		pool_pos += n;
+		buf += n;
+		length -= n;
+	}
+}
+
+
+void id_generator::generate(uint128 &id)
+{
+	generate((unsigned char *) &id, sizeof(id));
+}
+
+
+unsigned long id_generator::get_refill_count()
+{
+	return refills;
+}
+
+// EOF
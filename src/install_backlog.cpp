@@ -0,0 +1,148 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file install_backlog.cpp
+/// Watermarks and bound of the queue to the auction application.
+/// ----------------------------------------------------------
+/// $Id: install_backlog.cpp 2558 2016-04-24 10:00:00 amarentes $
+/// $HeadURL: https://./src/install_backlog.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include "install_backlog.h"
+
+
+using namespace anslp;
+
+
+/**
+ * Constructor.
+ *
+ * A low watermark above the high one is lowered to it.
+ *
+ * @param capacity the maximum number of queued events, 0 is unlimited
+ * @param high_watermark the occupancy from which the backlog is full
+ * @param low_watermark the occupancy at which a full backlog is drained
+ */
+install_backlog::install_backlog(uint32 capacity, uint32 high_watermark,
+			uint32 low_watermark)
+		: capacity(capacity), high_watermark(high_watermark),
+		  low_watermark(low_watermark), full(0)
+{
+	if ( this->low_watermark > this->high_watermark )
+		this->low_watermark = this->high_watermark;
+
+	stats.occupancy = 0;
+	stats.max_occupancy = 0;
+	stats.filled = 0;
+	stats.refused = 0;
+	stats.throttled = 0;
+}
+
+
+/**
+ * Report the number of queued events.
+ *
+ * @param occupancy the number of events in the queue
+ * @return true if the backlog became full or drained
+ */
+bool install_backlog::update(size_t occupancy) 
+{
+	stats.occupancy = occupancy;
+
+	if ( occupancy > stats.max_occupancy )
+		stats.max_occupancy = occupancy;
+
+	if ( high_watermark == 0 )
+		return false;
+
+	if ( full == 0 ) {
+		if ( occupancy < high_watermark 
+				|| ! __sync_bool_compare_and_swap(&full, 0, 1) )
+			return false;
+
+		__sync_fetch_and_add(&stats.filled, 1);
+		return true;
+	}
+	else {
+		return occupancy <= low_watermark 
+			&& __sync_bool_compare_and_swap(&full, 1, 0);
+	}
+}
+
+
+/**
+ * Decide whether an event may be queued.
+ *
+ * This doesn't change whether the backlog is full, see update().
+ *
+ * @param occupancy the number of events in the queue
+ * @param essential true if the event has to be queued anyway
+ * @return true if the event may be queued
+ */
+bool install_backlog::admit(size_t occupancy, bool essential) 
+{
+	if ( occupancy > stats.max_occupancy )
+		stats.max_occupancy = occupancy;
+
+	if ( essential || capacity == 0 || occupancy < capacity )
+		return true;
+
+	__sync_fetch_and_add(&stats.refused, 1);
+	return false;
+}
+
+
+/**
+ * Count a CREATE or BIDDING rejected because the backlog is full.
+ */
+void install_backlog::count_throttled() 
+{
+	__sync_fetch_and_add(&stats.throttled, 1);
+}
+
+
+/**
+ * Return a copy of the current counters.
+ */
+install_backlog_stats install_backlog::get_stats() const
+{
+	install_backlog_stats s;
+
+	s.occupancy = stats.occupancy;
+	s.max_occupancy = stats.max_occupancy;
+	s.filled = __sync_fetch_and_add(&stats.filled, 0);
+	s.refused = __sync_fetch_and_add(&stats.refused, 0);
+	s.throttled = __sync_fetch_and_add(&stats.throttled, 0);
+
+	return s;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, 
+		const install_backlog_stats &s)
+{
+	return out << "occupancy=" << s.occupancy 
+		<< " max_occupancy=" << s.max_occupancy << " filled=" << s.filled 
+		<< " refused=" << s.refused << " throttled=" << s.throttled;
+}
+
+
+// EOF
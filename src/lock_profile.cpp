@@ -0,0 +1,238 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file lock_profile.cpp
+/// Wait and hold time histograms of a lock.
+/// ----------------------------------------------------------
+/// $Id: lock_profile.cpp 2558 2016-04-19 09:30:00 amarentes $
+/// $HeadURL: https://./src/lock_profile.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <time.h>
+
+#include "lock_profile.h"
+
+
+using namespace anslp;
+
+
+volatile sig_atomic_t lock_profile::dump_pending = 0;
+
+
+/**
+ * Constructor.
+ *
+ * @param name the name the profile is reported under
+ */
+lock_profile::lock_profile(const std::string &name)
+{
+	stats.name = name;
+	stats.acquisitions = 0;
+	stats.contended = 0;
+	stats.total_wait_ns = 0;
+	stats.max_wait_ns = 0;
+	stats.total_hold_ns = 0;
+	stats.max_hold_ns = 0;
+
+	for ( uint32 i = 0; i < lock_profile_stats::NUM_BUCKETS; i++ ) {
+		stats.wait[i] = 0;
+		stats.hold[i] = 0;
+	}
+}
+
+
+/**
+ * Return a monotonic timestamp in nanoseconds.
+ */
+uint64_t lock_profile::now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+/**
+ * Return the histogram bucket counting the given time.
+ */
+uint32 lock_profile::get_bucket(uint64_t ns)
+{
+	uint32 bucket = 0;
+
+	while ( ns > 1 && bucket < lock_profile_stats::NUM_BUCKETS - 1 ) {
+		ns >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+
+/**
+ * Record an acquisition of the lock.
+ *
+ * @param wait_ns the time spent waiting for the lock
+ * @param contended true if the lock was held by another thread
+ */
+void lock_profile::record_acquire(uint64_t wait_ns, bool contended)
+{
+	__sync_fetch_and_add(&stats.acquisitions, 1);
+	__sync_fetch_and_add(&stats.wait[get_bucket(wait_ns)], 1);
+
+	if ( contended ) {
+		__sync_fetch_and_add(&stats.contended, 1);
+		__sync_fetch_and_add(&stats.total_wait_ns, wait_ns);
+		update_max(&stats.max_wait_ns, wait_ns);
+	}
+}
+
+
+/**
+ * Record a release of the lock.
+ *
+ * @param hold_ns the time the lock was held
+ */
+void lock_profile::record_release(uint64_t hold_ns)
+{
+	__sync_fetch_and_add(&stats.hold[get_bucket(hold_ns)], 1);
+	__sync_fetch_and_add(&stats.total_hold_ns, hold_ns);
+	update_max(&stats.max_hold_ns, hold_ns);
+}
+
+
+/**
+ * Return a snapshot of the counters.
+ *
+ * The counters are read one by one while other threads may update them,
+ * so the snapshot isn't exactly consistent.
+ */
+lock_profile_stats lock_profile::get_stats() const
+{
+	return stats;
+}
+
+
+/**
+ * Ask for the lock profiles to be written to the log. Safe in signal 
+ * handlers.
+ */
+void lock_profile::request_dump()
+{
+	dump_pending = 1;
+}
+
+
+/**
+ * Check whether a dump was requested.
+ *
+ * Only one of the threads calling this gets true for each request.
+ */
+bool lock_profile::claim_dump()
+{
+	return dump_pending != 0 
+		&& __sync_bool_compare_and_swap(&dump_pending, 1, 0);
+}
+
+
+void lock_profile::update_max(uint64_t *max, uint64_t value)
+{
+	uint64_t current = *max;
+
+	while ( value > current ) {
+		uint64_t seen = __sync_val_compare_and_swap(max, current, value);
+		if ( seen == current )
+			break;
+		current = seen;
+	}
+}
+
+
+/**
+ * Return an upper bound of the given percentile of a histogram.
+ *
+ * @param histogram the wait or hold histogram of this snapshot
+ * @param percent the percentile, between 1 and 100
+ * @return the upper limit of the bucket the percentile falls in
+ */
+uint64_t lock_profile_stats::get_percentile(const uint64_t *histogram, 
+											uint32 percent) const
+{
+	uint64_t total = 0;
+	for ( uint32 i = 0; i < NUM_BUCKETS; i++ )
+		total += histogram[i];
+
+	if ( total == 0 )
+		return 0;
+
+	uint64_t rank = ( total * percent + 99 ) / 100;
+	uint64_t seen = 0;
+
+	for ( uint32 i = 0; i < NUM_BUCKETS; i++ ) {
+		seen += histogram[i];
+		if ( seen >= rank )
+			return ( (uint64_t) 2 << i ) - 1;
+	}
+
+	return (uint64_t) -1;
+}
+
+
+static void write_histogram(std::ostream &out, const char *label, 
+							const uint64_t *histogram)
+{
+	out << " " << label << "={";
+
+	bool first = true;
+	for ( uint32 i = 0; i < lock_profile_stats::NUM_BUCKETS; i++ ) {
+		if ( histogram[i] == 0 )
+			continue;
+
+		if ( ! first )
+			out << ",";
+		out << ( (uint64_t) 1 << i ) << ":" << histogram[i];
+		first = false;
+	}
+
+	out << "}";
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, const lock_profile_stats &s)
+{
+	out << s.name << ": acquisitions=" << s.acquisitions 
+		<< " contended=" << s.contended
+		<< " total_wait_ns=" << s.total_wait_ns
+		<< " max_wait_ns=" << s.max_wait_ns
+		<< " p99_wait_ns=" << s.get_percentile(s.wait, 99)
+		<< " total_hold_ns=" << s.total_hold_ns
+		<< " max_hold_ns=" << s.max_hold_ns
+		<< " p50_hold_ns=" << s.get_percentile(s.hold, 50)
+		<< " p99_hold_ns=" << s.get_percentile(s.hold, 99);
+
+	write_histogram(out, "wait", s.wait);
+	write_histogram(out, "hold", s.hold);
+
+	return out;
+}
+
+
+// EOF
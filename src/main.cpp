@@ -27,7 +27,9 @@
 //
 // ===========================================================
 #include <unistd.h>	// for getopt
+#include <signal.h>
 #include <openssl/ssl.h>
+#include <algorithm>
 
 #include "logfile.h"
 #include "threads.h"
@@ -37,6 +39,7 @@
 
 #include "anslp_config.h"
 #include "anslp_daemon.h"
+#include "lock_profile.h"
 
 
 using namespace protlib;
@@ -58,6 +61,21 @@ logfile &protlib::log::DefaultLog(commonlog);
 
 std::string config_filename;
 
+
+/**
+ * SIGHUP makes the dispatcher threads reload the configuration file.
+ */
+void reload_handler(int signum) {
+	anslp_config::request_reload();
+}
+
+/**
+ * SIGUSR1 makes a dispatcher thread write the lock profiles to the log.
+ */
+void dump_handler(int signum) {
+	lock_profile::request_dump();
+}
+
 void parse_commandline(int argc, char *argv[]) {
 	std::string usage("usage: anslp -c config_file\n");
 
@@ -133,13 +151,19 @@ int main(int argc, char *argv[]) {
 		return 1;
 	}
 
+	conf->publish_snapshot();
+
+	signal(SIGHUP, reload_handler);
+	signal(SIGUSR1, dump_handler);
+
 	/*
 	 * Start the A-NSLP daemon thread. It will in turn start the other
 	 * threads it requires.
 	 */
 	anslp_daemon_param param("anslp", *conf);
 	ThreadStarter<anslp_daemon, anslp_daemon_param> anslp_thread(
-		conf->get_num_dispatcher_threads(), param);
+		std::max(conf->get_num_dispatcher_threads(), 
+				 conf->get_max_dispatcher_threads()), param);
 	
 	anslp_thread.start_processing();
 
@@ -157,7 +157,7 @@ anslp_bidding::serialize_object(ie_object_key &key, NetMsg &msg, coding_t coding
 	LogDebug("Starting serialize object");
 	
 	uint32 obj_bytes_written = 0;
-	anslp_object *obj = get_object(key);
+	anslp_object *obj = peek_object(key);
 	if (obj != NULL) {
 		obj->serialize(msg, coding, obj_bytes_written);
 		LogDebug("Ending serialize object" << obj_bytes_written);
@@ -246,6 +246,8 @@ void anslp_bidding::get_mspec_objects(vector<anslp_mspec_object *> &list_return)
 {
 	
 	LogDebug("Starting get_mspec_objects");	
+
+	decode_all();
 	
 	for ( obj_iter i = objects.begin(); i != objects.end(); i++ ) {
 		const ie_object_key key = i->first;
@@ -31,6 +31,8 @@
 #include "msg/anslp_ie.h"
 #include "msg/anslp_msg.h"
 #include "msg/anslp_response.h"
+#include "msg/anslp_opaque_mspec.h"
+#include "msg/anslp_raw_object.h"
 #include <bitset>
 
 
@@ -48,6 +50,11 @@ using namespace protlib::log;
  */
 ANSLP_IEManager *ANSLP_IEManager::anslp_inst = NULL;
 
+/**
+ * Whether mspec objects are decoded on first access only.
+ */
+bool ANSLP_IEManager::lazy_decoding = false;
+
 
 /**
  * Constructor for child classes.
@@ -114,8 +121,11 @@ void ANSLP_IEManager::clear() {
  *
  * This method clears the registry and then registers all IEs known to this
  * implementation. It solely exists for convenience.
+ *
+ * @param opaque_mspec register anslp_opaque_mspec in place of
+ *        anslp_ipap_message, so mspec objects are never decoded
  */
-void ANSLP_IEManager::register_known_ies() 
+void ANSLP_IEManager::register_known_ies(bool opaque_mspec) 
 {
 	clear();
 	LogDebug("Starting register_known_ies");
@@ -127,13 +137,18 @@ void ANSLP_IEManager::register_known_ies()
 	inst->register_ie(new anslp_response());
 	inst->register_ie(new anslp_notify());
 	inst->register_ie(new anslp_bidding());	
+	inst->register_ie(new anslp_summary_refresh());
 		
 	inst->register_ie(new session_lifetime());
 	inst->register_ie(new information_code());
 	inst->register_ie(new message_hop_count());
 	inst->register_ie(new selection_auctioning_entities());
 	inst->register_ie(new msg_sequence_number());
-	inst->register_ie(new anslp_ipap_message());
+	if ( opaque_mspec )
+		inst->register_ie(new anslp_opaque_mspec());
+	else
+		inst->register_ie(new anslp_ipap_message());
+	inst->register_ie(new session_refresh_list());
 	
 	// TODO: implement catch-all
 
@@ -198,7 +213,7 @@ IE *ANSLP_IEManager::deserialize(NetMsg &msg, uint16 category,
 
 		case cat_anslp_object:
 			return deserialize_object(msg, coding,
-					errorlist, bytes_read, skip);
+					errorlist, bytes_read, skip, lazy_decoding);
 
 		default:
 			LogError("category " << category << " not supported");
@@ -276,7 +291,7 @@ IE *ANSLP_IEManager::deserialize_msg(NetMsg &msg,
  */
 IE *ANSLP_IEManager::deserialize_object(NetMsg &msg,
 		IE::coding_t coding, IEErrorList &errorlist,
-		uint32 &bytes_read, bool skip) {
+		uint32 &bytes_read, bool skip, bool defer) {
 
 	/*
 	 * Peek ahead to find out the MNSLP Object Type.
@@ -292,7 +307,12 @@ IE *ANSLP_IEManager::deserialize_object(NetMsg &msg,
 		return NULL; // fatal error
 	}
 
-	IE *ie = new_instance(cat_anslp_object, object_type, 0);
+	IE *ie = NULL;
+
+	if ( defer && is_deferrable(object_type) )
+		catch_bad_alloc( ie = new anslp_raw_object() );
+	else
+		ie = new_instance(cat_anslp_object, object_type, 0);
 
 	if ( ie == NULL ) {
 		LogError("no anslp_object registered for ID " << object_type);
@@ -308,3 +328,54 @@ IE *ANSLP_IEManager::deserialize_object(NetMsg &msg,
 
 	return ret;	// the deserialized object on success, NULL on error
 }
+
+
+/**
+ * Only mspec objects are worth deferring, they are the only large ones.
+ * They can never be unique, so their key doesn't depend on the body.
+ */
+bool ANSLP_IEManager::is_deferrable(uint16 object_type) {
+	const anslp_mspec_object *proto = dynamic_cast<const anslp_mspec_object *>(
+				lookup_ie(cat_anslp_object, object_type, 0));
+
+	return proto != NULL && ! proto->is_unique();
+}
+
+
+/**
+ * Decode mspec objects only when a message accesses them.
+ *
+ * @param lazy true to keep the bodies of mspec objects until first access
+ */
+void ANSLP_IEManager::set_lazy_decoding(bool lazy) {
+	lazy_decoding = lazy;
+}
+
+
+bool ANSLP_IEManager::is_lazy_decoding() {
+	return lazy_decoding;
+}
+
+
+/**
+ * Deserialize one object right now, even with lazy decoding enabled.
+ *
+ * @param msg a buffer positioned at the object header
+ * @param errorlist returns the exceptions caught while parsing the object
+ * @return the newly created object, or NULL on error
+ */
+anslp_object *ANSLP_IEManager::decode_object(NetMsg &msg, 
+		IEErrorList &errorlist) {
+
+	uint32 bytes_read;
+
+	IE *ie = deserialize_object(msg, IE::protocol_v1, errorlist, 
+						bytes_read, false, false);
+
+	anslp_object *obj = dynamic_cast<anslp_object *>(ie);
+
+	if ( ie != NULL && obj == NULL )
+		delete ie;
+
+	return obj;
+}
@@ -149,6 +149,12 @@ anslp_ipap_message::isEqual (const anslp_mspec_object &rhs) const
 	
 	if (obj != NULL)
 	{
+		// Equal digests mean equal exported bytes. Different digests 
+		// don't prove much, equal contents may be exported differently.
+		const content_digest digest = get_digest();
+		if ( ! digest.is_null() && digest == obj->get_digest() )
+			return true;
+		
 		val_return = ip_message.operator ==(obj->ip_message);
 	}
 	return val_return;
@@ -280,15 +286,14 @@ anslp_ipap_message::deserialize_body(NetMsg &msg, uint16 body_length,
     log->dlog(ch, "starting deserialize_body: %d", body_length );
 #endif
 
-	uchar *messdef;
 	int num_read=0;
-	uchar *padding = new uchar[4];
 	int num_padding = 0;
-
-	messdef = (uchar *) malloc(sizeof(uchar) * body_length);
 	uint32 start_pos = msg.get_pos();
+
+	// The IPAP message is imported right from the received buffer, 
+	// ipap_import() keeps its own copy of what it needs.
+	uchar *messdef = msg.get_buffer() + start_pos;
 	
-	msg.copy_to(messdef, start_pos, body_length);
 	ip_message.close();
 	
 	try{ 
@@ -309,8 +314,6 @@ anslp_ipap_message::deserialize_body(NetMsg &msg, uint16 body_length,
 	}	
 	msg.set_pos(start_pos + body_length);
 	
-	free(messdef);
-	
 #ifdef DEBUG
     log->dlog(ch, "ending deserialize_body" );
 #endif	
@@ -325,7 +328,6 @@ anslp_ipap_message::serialize_body(NetMsg &msg) const
     log->dlog(ch, "starting serialize_body" );
 #endif
 
-	uchar *padding;
 	int num_padding = 0;
 	int offset = 0;
 	uint32 start_pos = msg.get_pos();
@@ -356,13 +358,9 @@ anslp_ipap_message::serialize_body(NetMsg &msg) const
 
 	if ( num_padding != 0 ){
 		num_padding = 4 - num_padding; // How many additional bytes are required.
-		padding = new uchar[4];
 		for (int i = 0 ; i < num_padding; i++ ){
-			padding[i] = 0;
+			msg.encode8(0);
 		}
-		uint32 start_pos2 = msg.get_pos();
-		msg.copy_from(padding,start_pos2, num_padding);
-		msg.set_pos(start_pos2 + num_padding);
 	}
 
 #ifdef DEBUG
@@ -370,3 +368,24 @@ anslp_ipap_message::serialize_body(NetMsg &msg) const
 #endif
 }
 
+content_digest 
+anslp_ipap_message::compute_digest() const
+{
+	const uchar *message = get_message();
+	
+	if ( message == NULL )
+		return content_digest();
+
+	digest_builder builder;
+	int offset = ip_message.get_offset();
+	
+	builder.update(message, offset);
+	
+	// Hash the padding too, so the digest equals the one of the same
+	// body kept as received.
+	static const uchar zeros[4] = { 0, 0, 0, 0 };
+	if ( offset % 4 != 0 )
+		builder.update(zeros, 4 - offset % 4);
+	
+	return builder.finish();
+}
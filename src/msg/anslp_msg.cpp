@@ -27,6 +27,7 @@
 //
 // ===========================================================
 #include <iomanip>	// for setw()
+#include <vector>
 
 #include "logfile.h"
 
@@ -34,6 +35,7 @@
 #include "msg/anslp_ie.h"
 #include "msg/ie_object_key.h"
 #include "msg/anslp_msg.h"
+#include "msg/anslp_raw_object.h"
 
 
 using namespace anslp::msg;
@@ -60,7 +62,7 @@ const char *const anslp_msg::ie_name = "anslp_msg";
  * Creates an empty ANSLP Message.
  */
 anslp_msg::anslp_msg()
-		: IE(cat_anslp_msg), msg_type(0) {
+		: IE(cat_anslp_msg), msg_type(0), has_pending(false) {
 
 	// nothing to do
 }
@@ -76,7 +78,7 @@ anslp_msg::anslp_msg()
  * @param type the ANSLP Message Type (8 bit)
  */
 anslp_msg::anslp_msg(uint8 type)
-		: IE(cat_anslp_msg), msg_type(type) 
+		: IE(cat_anslp_msg), msg_type(type), has_pending(false) 
 {
 
 	// nothing to do
@@ -92,7 +94,7 @@ anslp_msg::anslp_msg(uint8 type)
  */
 anslp_msg::anslp_msg(const anslp_msg &other)
 		: IE(other.category), msg_type(other.get_msg_type()),
-		  objects(other.objects) 
+		  objects(other.objects), has_pending(other.has_pending) 
 {
 	
 	// nothing else to do
@@ -258,7 +260,7 @@ anslp_msg::deserialize(NetMsg &msg, coding_t coding,
 		if (obj->is_unique())
 		{			
 			ie_object_key key(obj->get_object_type(),1);
-			if ( get_object( key ) != NULL ) {
+			if ( peek_object( key ) != NULL ) {
 				catch_bad_alloc( errorlist.put(
 					new PDUSyntaxError(coding, get_category(),
 						obj->get_object_type(), 1,
@@ -270,6 +272,9 @@ anslp_msg::deserialize(NetMsg &msg, coding_t coding,
 		}			
 		bytes_read += obj_bytes_read;
 		set_object(obj);
+
+		if ( dynamic_cast<anslp_raw_object *>(obj) != NULL )
+			has_pending = true;
 	}
 
 	// empty messages are not allowed
@@ -380,13 +385,12 @@ size_t anslp_msg::get_serialized_size(coding_t coding) const
 	LogDebug("Start get_serialized_size");
 
 	for ( obj_iter i = objects.begin(); i != objects.end(); i++ ) {
-		LogDebug("Start get_serialized_size");
-		const IE *obj = i->second;
+		const anslp_object *obj = dynamic_cast<const anslp_object *>(i->second);
 
-		
-		
-		size += obj->get_serialized_size(coding);
-		
+		if ( obj != NULL )
+			size += obj->get_cached_size(coding);
+		else
+			size += i->second->get_serialized_size(coding);
 	}
 	
 	LogDebug("Ending get_serialized_size:" << size);
@@ -403,6 +407,9 @@ bool anslp_msg::operator==(const IE &ie) const
 		return false;
 	}
 
+	decode_all();
+	p->decode_all();
+
 	// Return true iff all objects are equal, too.
 	return ( objects == p->objects );
 }
@@ -456,6 +463,32 @@ uint8 anslp_msg::get_msg_type() const
 }
 
 
+/**
+ * Return a digest of the message type and all objects.
+ *
+ * Objects that were not decoded yet are hashed as received, which gives
+ * the same digest as their decoded form. A retransmitted message has the
+ * same digest as the original.
+ *
+ * @return the message digest
+ */
+content_digest anslp_msg::get_digest() const 
+{
+	digest_builder builder;
+
+	builder.update(uint32(get_msg_type()));
+
+	for ( obj_iter i = objects.begin(); i != objects.end(); i++ ) {
+		const anslp_object *obj = dynamic_cast<const anslp_object *>(i->second);
+
+		if ( obj != NULL )
+			obj->update_digest(builder);
+	}
+
+	return builder.finish();
+}
+
+
 /**
  * Set the Message Type.
  *
@@ -487,11 +520,89 @@ size_t anslp_msg::get_num_objects() const
  * @return the ANSLP object or NULL, if none is registered for that type
  */
 anslp_object *anslp_msg::get_object(ie_object_key &object_type) const 
+{
+	IE *ie = objects.get(object_type);
+
+	if ( has_pending )
+		return decode_pending(object_type, ie);
+
+	return dynamic_cast<anslp_object *>( ie );
+}
+
+
+/**
+ * Returns the message object without decoding a pending body.
+ *
+ * Meant for serializing: an object that was never decoded is written back
+ * exactly as it was received.
+ *
+ * @param the object type (12 bit)
+ * @return the ANSLP object or NULL, if none is registered for that type
+ */
+anslp_object *anslp_msg::peek_object(ie_object_key &object_type) const 
 {
 	return dynamic_cast<anslp_object *>( objects.get(object_type) );
 }
 
 
+/**
+ * Replace a placeholder left by lazy decoding with the decoded object.
+ *
+ * If the body turns out to be invalid the object is dropped from the
+ * message, as if it had never been received.
+ *
+ * @param key the object's key
+ * @param ie the stored object, a placeholder or not
+ * @return the decoded object, or NULL on error
+ */
+anslp_object *anslp_msg::decode_pending(ie_object_key &key, IE *ie) const 
+{
+	anslp_raw_object *raw = dynamic_cast<anslp_raw_object *>(ie);
+
+	if ( raw == NULL )
+		return dynamic_cast<anslp_object *>( ie );
+
+	IEErrorList errlist;
+	anslp_object *obj = raw->decode(errlist);
+
+	if ( obj == NULL || ! errlist.is_empty() ) {
+		LogError("dropping object " << key.get_object_type() 
+				<< " that could not be decoded");
+
+		delete obj;
+		delete objects.remove(key);
+		return NULL;
+	}
+
+	objects.set(key, obj); // deletes the placeholder
+	return obj;
+}
+
+
+/**
+ * Decode every object still pending from lazy decoding.
+ *
+ * Called before the objects are iterated directly.
+ */
+void anslp_msg::decode_all() const 
+{
+	if ( ! has_pending )
+		return;
+
+	std::vector<ie_object_key> keys;
+
+	for ( obj_iter i = objects.begin(); i != objects.end(); i++ ) {
+		if ( dynamic_cast<anslp_raw_object *>(i->second) != NULL )
+			keys.push_back(i->first);
+	}
+
+	for ( size_t k = 0; k < keys.size(); k++ )
+		decode_pending(keys[k], objects.get(keys[k]));
+
+	has_pending = false;
+}
+
+
 /**
  * Add an object to this message.
  *
@@ -532,5 +643,8 @@ void anslp_msg::set_object(anslp_object *obj)
  */
 anslp_object *anslp_msg::remove_object(ie_object_key &object_type) 
 {
+	if ( has_pending )
+		get_object(object_type); // hand out the decoded object
+
 	return dynamic_cast<anslp_object *>( objects.remove(object_type) );
 }
@@ -74,3 +74,26 @@ anslp_mspec_object::~anslp_mspec_object()
 {
 	// nothing to do
 }
+
+
+const content_digest &anslp_mspec_object::get_digest() const 
+{
+	// Objects whose size can't be cached may change their body as well.
+	if ( digest.is_null() || ! has_stable_size() )
+		digest = compute_digest();
+
+	return digest;
+}
+
+
+/**
+ * Feed the object type and the body digest into a message digest. 
+ *
+ * The same bytes give the same digest whether they were decoded or kept
+ * as received (see anslp_raw_object and anslp_opaque_mspec).
+ */
+void anslp_mspec_object::update_digest(digest_builder &builder) const 
+{
+	builder.update(uint32(get_object_type()));
+	builder.update(get_digest());
+}
@@ -123,7 +123,7 @@ uint32
 anslp_notify::serialize_object(ie_object_key &key, NetMsg &msg, coding_t coding) const
 {
 	uint32 obj_bytes_written = 0;
-	anslp_object *obj = get_object(key);
+	anslp_object *obj = peek_object(key);
 	if (obj != NULL){
 		obj->serialize(msg, coding, obj_bytes_written);
 		return obj_bytes_written;
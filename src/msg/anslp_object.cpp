@@ -54,7 +54,8 @@ using namespace protlib::log;
  * The treatment is set to mandatory.
  */
 anslp_object::anslp_object()
-		: IE(cat_anslp_object), treatment(tr_mandatory), unique(true) {
+		: IE(cat_anslp_object), serialized_size(0), treatment(tr_mandatory), 
+		  unique(true) {
 
 	// nothing to do									
 	
@@ -70,7 +71,8 @@ anslp_object::anslp_object()
  * @param object_type the ANSLP Object Type (12 bit)
  */
 anslp_object::anslp_object(uint16 obj_type, treatment_t tr, bool _unique)
-		: IE(cat_anslp_object), object_type(obj_type), treatment(tr), unique(_unique) 
+		: IE(cat_anslp_object), serialized_size(0), object_type(obj_type), 
+		  treatment(tr), unique(_unique) 
 {
 
 	// nothing to do
@@ -129,6 +131,47 @@ uint16 anslp_object::extract_object_type(uint32 header_raw) throw ()
 }
 
 
+/**
+ * Return the serialized size, computing it only once.
+ *
+ * The size is cached until the object changes its size or is deserialized
+ * again. Objects without a stable size are asked every time.
+ *
+ * @param coding the encoding
+ * @return the size in bytes, including the header
+ */
+size_t anslp_object::get_cached_size(coding_t coding) const 
+{
+	if ( serialized_size != 0 )
+		return serialized_size;
+
+	size_t size = get_serialized_size(coding);
+	
+	if ( has_stable_size() )
+		serialized_size = size;
+
+	return size;
+}
+
+
+/**
+ * Feed this object's contents into a message digest.
+ *
+ * This implementation hashes the serialized object. Objects that keep a
+ * digest of their own override it.
+ *
+ * @param builder the digest of the enclosing message
+ */
+void anslp_object::update_digest(digest_builder &builder) const 
+{
+	NetMsg msg(get_cached_size(CODING));
+	uint32 bytes_written = 0;
+
+	serialize(msg, CODING, bytes_written);
+	builder.update(msg.get_buffer(), bytes_written);
+}
+
+
 /**
  * Parse a ANSLP object header.
  *
@@ -200,6 +243,8 @@ IE *anslp_object::deserialize(NetMsg &msg, coding_t coding,
 
 	LogDebug("deserialize start_post:" << start_pos);
 
+	invalidate_size();
+
 	// check if coding is supported
 	uint32 tmp;
 	if ( ! check_deser_args(CODING, err, tmp) )
@@ -262,7 +307,7 @@ void anslp_object::serialize(NetMsg &msg, coding_t coding,
 	/*
 	 * Write header
 	 */
-	uint16 body_length = get_serialized_size(CODING) - HEADER_LENGTH;
+	uint16 body_length = get_cached_size(CODING) - HEADER_LENGTH;
 
 	try {
 		serialize_header(msg, body_length);
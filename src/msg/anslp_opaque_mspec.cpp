@@ -0,0 +1,192 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file anslp_opaque_mspec.cpp
+/// An mspec object carried as uninterpreted bytes.
+/// ----------------------------------------------------------
+/// $Id: anslp_opaque_mspec.cpp 2558 2016-04-01 10:15:00 amarentes $
+/// $HeadURL: https://./src/msg/anslp_opaque_mspec.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include "logfile.h"
+
+#include "msg/anslp_opaque_mspec.h"
+
+
+using namespace anslp::msg;
+
+
+const char *const anslp_opaque_mspec::ie_name = "anslp_opaque_mspec";
+
+
+/**
+ * Default constructor.
+ */
+anslp_opaque_mspec::anslp_opaque_mspec()
+		: anslp_mspec_object(OBJECT_TYPE, tr_mandatory, false), body() 
+{
+
+	// nothing to do
+}
+
+
+/**
+ * Constructor for manual use.
+ *
+ * @param data the body, already padded to a multiple of 4 bytes
+ * @param length the length of the body in bytes
+ */
+anslp_opaque_mspec::anslp_opaque_mspec(const uchar *data, uint16 length, 
+									   treatment_t t)
+		: anslp_mspec_object(OBJECT_TYPE, t, false), 
+		  body(data, length) 
+{
+
+	// nothing to do
+}
+
+
+anslp_opaque_mspec::~anslp_opaque_mspec() 
+{
+	// nothing to do, the body is released by shared_bytes
+}
+
+
+anslp_opaque_mspec *anslp_opaque_mspec::new_instance() const 
+{
+	anslp_opaque_mspec *q = NULL;
+	catch_bad_alloc( q = new anslp_opaque_mspec() );
+	return q;
+}
+
+
+anslp_opaque_mspec *anslp_opaque_mspec::copy() const 
+{
+	anslp_opaque_mspec *q = NULL;
+	catch_bad_alloc( q = new anslp_opaque_mspec(*this) );
+	return q;
+}
+
+
+/**
+ * Take the body as it is on the wire, padding included.
+ */
+bool anslp_opaque_mspec::deserialize_body(NetMsg &msg, uint16 body_length,
+		IEErrorList &err, bool skip) 
+{
+	uint32 start_pos = msg.get_pos();
+
+	body = shared_bytes(msg.get_buffer() + start_pos, body_length);
+
+	msg.set_pos(start_pos + body_length);
+
+	return true;
+}
+
+
+void anslp_opaque_mspec::serialize_body(NetMsg &msg) const 
+{
+	uint32 start_pos = msg.get_pos();
+	uint16 length = get_body_length();
+
+	if ( length > 0 )
+		msg.copy_from(body.get_data(), start_pos, length);
+
+	msg.set_pos(start_pos + length);
+}
+
+
+size_t anslp_opaque_mspec::get_serialized_size(coding_t coding) const 
+{
+	return HEADER_LENGTH + get_body_length();
+}
+
+
+bool anslp_opaque_mspec::check_body() const 
+{
+	return get_body_length() > 0 && get_body_length() % 4 == 0;
+}
+
+
+bool anslp_opaque_mspec::equals_body(const anslp_object &obj) const 
+{
+	const anslp_opaque_mspec *other
+		= dynamic_cast<const anslp_opaque_mspec *>(&obj);
+
+	return other != NULL && body == other->body;
+}
+
+
+bool anslp_opaque_mspec::isEqual(const anslp_mspec_object &obj) const 
+{
+	// Different digests mean different bytes, and a digest is cheaper
+	// to compare than the bodies.
+	if ( get_digest() != obj.get_digest() )
+		return false;
+
+	return equals_body(obj);
+}
+
+
+bool anslp_opaque_mspec::notEqual(const anslp_mspec_object &obj) const 
+{
+	return !isEqual(obj);
+}
+
+
+content_digest anslp_opaque_mspec::compute_digest() const 
+{
+	return content_digest::compute(body.get_data(), body.get_length());
+}
+
+
+const char *anslp_opaque_mspec::get_ie_name() const 
+{
+	return ie_name;
+}
+
+
+ostream &anslp_opaque_mspec::print_attributes(ostream &os) const 
+{
+	return os << ", length=" << get_body_length();
+}
+
+
+/**
+ * Returns the body as received, or NULL if there is none.
+ */
+const uchar *anslp_opaque_mspec::get_body() const 
+{
+	return body.get_data();
+}
+
+
+/**
+ * Returns the length of the body in bytes.
+ */
+uint16 anslp_opaque_mspec::get_body_length() const 
+{
+	return body.get_length();
+}
+
+// EOF
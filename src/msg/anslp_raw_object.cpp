@@ -0,0 +1,164 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file anslp_raw_object.cpp
+/// An ANSLP object whose body has not been decoded yet.
+/// ----------------------------------------------------------
+/// $Id: anslp_raw_object.cpp 2558 2016-04-04 16:40:00 amarentes $
+/// $HeadURL: https://./src/msg/anslp_raw_object.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include "logfile.h"
+
+#include "msg/anslp_ie.h"
+#include "msg/anslp_raw_object.h"
+
+
+using namespace anslp::msg;
+
+
+const char *const anslp_raw_object::ie_name = "anslp_raw_object";
+
+
+/**
+ * Default constructor. Type and treatment are taken from the header when
+ * the object is deserialized.
+ */
+anslp_raw_object::anslp_raw_object()
+		: anslp_object(0, tr_mandatory, false), body() 
+{
+
+	// nothing to do
+}
+
+
+anslp_raw_object::~anslp_raw_object() 
+{
+	// nothing to do
+}
+
+
+anslp_raw_object *anslp_raw_object::new_instance() const 
+{
+	anslp_raw_object *q = NULL;
+	catch_bad_alloc( q = new anslp_raw_object() );
+	return q;
+}
+
+
+anslp_raw_object *anslp_raw_object::copy() const 
+{
+	anslp_raw_object *q = NULL;
+	catch_bad_alloc( q = new anslp_raw_object(*this) );
+	return q;
+}
+
+
+bool anslp_raw_object::deserialize_body(NetMsg &msg, uint16 body_length,
+		IEErrorList &err, bool skip) 
+{
+	uint32 start_pos = msg.get_pos();
+
+	body = shared_bytes(msg.get_buffer() + start_pos, body_length);
+
+	msg.set_pos(start_pos + body_length);
+
+	return true;
+}
+
+
+void anslp_raw_object::serialize_body(NetMsg &msg) const 
+{
+	uint32 start_pos = msg.get_pos();
+
+	if ( body.get_length() > 0 )
+		msg.copy_from(body.get_data(), start_pos, body.get_length());
+
+	msg.set_pos(start_pos + body.get_length());
+}
+
+
+size_t anslp_raw_object::get_serialized_size(coding_t coding) const 
+{
+	return HEADER_LENGTH + body.get_length();
+}
+
+
+// The body is checked when it is decoded.
+bool anslp_raw_object::check_body() const 
+{
+	return true;
+}
+
+
+bool anslp_raw_object::equals_body(const anslp_object &obj) const 
+{
+	const anslp_raw_object *other
+		= dynamic_cast<const anslp_raw_object *>(&obj);
+
+	return other != NULL && body == other->body;
+}
+
+
+const char *anslp_raw_object::get_ie_name() const 
+{
+	return ie_name;
+}
+
+
+ostream &anslp_raw_object::print_attributes(ostream &os) const 
+{
+	return os << ", length=" << body.get_length();
+}
+
+
+/**
+ * Feed the object into a message digest the way the decoded mspec object
+ * would, so the digest doesn't depend on whether it was decoded.
+ */
+void anslp_raw_object::update_digest(digest_builder &builder) const 
+{
+	builder.update(uint32(get_object_type()));
+	builder.update(content_digest::compute(body.get_data(), 
+										   body.get_length()));
+}
+
+
+/**
+ * Decode the object this placeholder stands for.
+ *
+ * @param errorlist returns the errors found while decoding
+ * @return the decoded object, or NULL on error
+ */
+anslp_object *anslp_raw_object::decode(IEErrorList &errorlist) const 
+{
+	NetMsg msg(get_serialized_size(CODING));
+	uint32 bytes;
+
+	serialize(msg, CODING, bytes);
+	msg.set_pos(0);
+
+	return ANSLP_IEManager::instance()->decode_object(msg, errorlist);
+}
+
+// EOF
@@ -150,7 +150,7 @@ anslp_response::serialize_object(ie_object_key &key,
 								 coding_t coding) const
 {
 	uint32 obj_bytes_written = 0;
-	anslp_object * obj = get_object(key);
+	anslp_object * obj = peek_object(key);
 	if (obj != NULL){
 		obj->serialize(msg, coding, obj_bytes_written);
 		return obj_bytes_written;
@@ -393,6 +393,8 @@ void anslp_response::get_mspec_objects(vector<anslp_mspec_object *> &list_return
 {
 	
 	LogDebug("Starting get_mspec_objects");	
+
+	decode_all();
 	
 	for ( obj_iter i = objects.begin(); i != objects.end(); i++ ) {
 		const ie_object_key key = i->first;
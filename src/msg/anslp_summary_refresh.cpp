@@ -0,0 +1,195 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file anslp_summary_refresh.cpp
+/// Implementation of the ANSLP SUMMARY REFRESH Message.
+/// ----------------------------------------------------------
+/// $Id: anslp_summary_refresh.cpp 2558 2016-03-17 11:40:00 amarentes $
+/// $HeadURL: https://./src/msg/anslp_summary_refresh.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include "logfile.h"
+
+#include "msg/anslp_ie.h"
+#include "msg/ie_object_key.h"
+#include "msg/anslp_summary_refresh.h"
+#include "msg/anslp_object.h"
+
+
+using namespace anslp::msg;
+using namespace protlib::log;
+
+
+/**
+ * Constructor.
+ *
+ * Only basic initialization is done. The session list is empty.
+ */
+anslp_summary_refresh::anslp_summary_refresh()
+		: anslp_msg(MSG_TYPE) 
+{
+
+	// nothing to do
+}
+
+
+/**
+ * Copy constructor.
+ *
+ * Makes a deep copy of the object passed as an argument.
+ *
+ * @param other the object to copy
+ */
+anslp_summary_refresh::anslp_summary_refresh(const anslp_summary_refresh &other)
+		: anslp_msg(other) 
+{
+	
+	// nothing else to do
+}
+
+
+/**
+ * Destructor.
+ *
+ * Deletes all objects this message contains.
+ */
+anslp_summary_refresh::~anslp_summary_refresh() 
+{
+	// Nothing to do, parent class handles this.
+}
+
+
+anslp_summary_refresh *anslp_summary_refresh::new_instance() const 
+{
+	anslp_summary_refresh *inst = NULL;
+	catch_bad_alloc(inst = new anslp_summary_refresh());
+	return inst;
+}
+
+
+anslp_summary_refresh *anslp_summary_refresh::copy() const 
+{
+	anslp_summary_refresh *copy = NULL;
+	catch_bad_alloc(copy = new anslp_summary_refresh(*this));
+	return copy;
+}
+
+
+void anslp_summary_refresh::serialize(NetMsg &msg, coding_t coding,
+		uint32 &bytes_written) const throw (IEError) 
+{
+	uint32 start_pos = msg.get_pos();
+	
+	/* 
+	 * Write the header.
+	 */
+	anslp_msg::serialize(msg, coding, bytes_written);
+	
+	/*
+	 * Write the body: the session list.
+	 */
+	session_refresh_list *list = get_session_refresh_list();
+	if ( list != NULL ) {
+		uint32 obj_bytes_written = 0;
+		list->serialize(msg, coding, obj_bytes_written);
+		bytes_written += obj_bytes_written;
+	}
+	
+	// this would be an implementation error
+	if ( bytes_written != msg.get_pos() - start_pos )
+		Log(ERROR_LOG, LOG_CRIT, "anslp_msg",
+				"serialize(): byte count mismatch");
+}
+
+
+bool anslp_summary_refresh::check() const 
+{
+	// Error: only the session list is allowed
+	if ( get_num_objects() != 1 )
+		return false;
+
+	session_refresh_list *list = get_session_refresh_list();
+	
+	return ( list != NULL && list->check() );
+}
+
+
+void anslp_summary_refresh::register_ie(IEManager *iem) const 
+{
+	iem->register_ie(cat_anslp_msg, get_msg_type(), 0, this);
+}
+
+
+session_refresh_list *anslp_summary_refresh::get_session_refresh_list() const
+{
+	ie_object_key key(session_refresh_list::OBJECT_TYPE, 1);
+	
+	return dynamic_cast<session_refresh_list *>(get_object(key));
+}
+
+
+/**
+ * Add a session to refresh.
+ *
+ * @param sid the id of the refreshed session
+ * @param msn the message sequence number the session's REFRESH would carry
+ * @param lifetime the requested session lifetime
+ * @return false if the message is full, true otherwise
+ */
+bool anslp_summary_refresh::add_session(const uint128 &sid, uint32 msn, 
+										uint32 lifetime) 
+{
+	session_refresh_list *list = get_session_refresh_list();
+	
+	if ( list == NULL ) {
+		list = new session_refresh_list(anslp_object::tr_mandatory, true);
+		set_object(list);
+	}
+	
+	return list->add_entry(sid, msn, lifetime);
+}
+
+
+/**
+ * Return the number of sessions refreshed by this message.
+ */
+size_t anslp_summary_refresh::get_num_sessions() const 
+{
+	session_refresh_list *list = get_session_refresh_list();
+	
+	return ( list == NULL ) ? 0 : list->get_num_entries();
+}
+
+
+/**
+ * Return the refresh data of a session.
+ *
+ * @param i a position lower than get_num_sessions()
+ */
+const session_refresh_list::entry &
+anslp_summary_refresh::get_session(size_t i) const 
+{
+	session_refresh_list *list = get_session_refresh_list();
+	
+	assert( list != NULL );
+	
+	return list->get_entry(i);
+}
@@ -0,0 +1,189 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file content_digest.cpp
+/// A 128 bit digest of an object's contents.
+/// ----------------------------------------------------------
+/// $Id: content_digest.cpp 2558 2016-04-11 09:30:00 amarentes $
+/// $HeadURL: https://./src/msg/content_digest.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include <cstring>
+
+#include "msg/content_digest.h"
+
+
+using namespace anslp::msg;
+
+
+namespace {
+
+	const uint64 C1 = 0x87c37b91114253d5ULL;
+	const uint64 C2 = 0x4cf5ad432745937fULL;
+
+	inline uint64 rotl64(uint64 x, int r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	inline uint64 fmix64(uint64 k) {
+		k ^= k >> 33;
+		k *= 0xff51afd7ed558ccdULL;
+		k ^= k >> 33;
+		k *= 0xc4ceb9fe1a85ec53ULL;
+		k ^= k >> 33;
+		return k;
+	}
+
+	// Bytes are read little endian, so digests don't depend on the host.
+	inline uint64 load64(const uchar *p, size_t n) {
+		uint64 val = 0;
+		for ( size_t i = 0; i < n; i++ )
+			val |= uint64(p[i]) << (8 * i);
+		return val;
+	}
+
+} // anonymous namespace
+
+
+/**
+ * Compute the digest of a single byte range.
+ */
+content_digest content_digest::compute(const uchar *data, size_t length) 
+{
+	digest_builder builder;
+	builder.update(data, length);
+	return builder.finish();
+}
+
+
+digest_builder::digest_builder() 
+		: h1(0), h2(0), total(0), tail_length(0) 
+{
+	// nothing to do
+}
+
+
+void digest_builder::mix_block(const uchar *block) 
+{
+	uint64 k1 = load64(block, 8);
+	uint64 k2 = load64(block + 8, 8);
+
+	k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; h1 ^= k1;
+	h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+	k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; h2 ^= k2;
+	h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+}
+
+
+void digest_builder::update(const uchar *data, size_t length) 
+{
+	total += length;
+
+	// Complete a block left over from the previous call first.
+	if ( tail_length > 0 ) {
+		size_t n = BLOCK_SIZE - tail_length;
+		if ( n > length )
+			n = length;
+
+		memcpy(tail + tail_length, data, n);
+		tail_length += n;
+		data += n;
+		length -= n;
+
+		if ( tail_length < BLOCK_SIZE )
+			return;
+
+		mix_block(tail);
+		tail_length = 0;
+	}
+
+	for ( ; length >= BLOCK_SIZE; data += BLOCK_SIZE, length -= BLOCK_SIZE )
+		mix_block(data);
+
+	memcpy(tail, data, length);
+	tail_length = length;
+}
+
+
+void digest_builder::update(uint32 value) 
+{
+	uchar buf[4];
+	for ( int i = 0; i < 4; i++ )
+		buf[i] = uchar(value >> (8 * i));
+
+	update(buf, sizeof(buf));
+}
+
+
+void digest_builder::update(const content_digest &digest) 
+{
+	uchar buf[16];
+	for ( int i = 0; i < 8; i++ ) {
+		buf[i] = uchar(digest.get_high() >> (8 * i));
+		buf[8 + i] = uchar(digest.get_low() >> (8 * i));
+	}
+
+	update(buf, sizeof(buf));
+}
+
+
+/**
+ * Return the digest of all bytes passed so far. The builder may still be
+ * updated afterwards.
+ */
+content_digest digest_builder::finish() const 
+{
+	uint64 f1 = h1;
+	uint64 f2 = h2;
+
+	if ( tail_length > 8 ) {
+		uint64 k2 = load64(tail + 8, tail_length - 8);
+		k2 *= C2; k2 = rotl64(k2, 33); k2 *= C1; f2 ^= k2;
+	}
+
+	if ( tail_length > 0 ) {
+		uint64 k1 = load64(tail, tail_length > 8 ? 8 : tail_length);
+		k1 *= C1; k1 = rotl64(k1, 31); k1 *= C2; f1 ^= k1;
+	}
+
+	f1 ^= total;
+	f2 ^= total;
+
+	f1 += f2;
+	f2 += f1;
+
+	f1 = fmix64(f1);
+	f2 = fmix64(f2);
+
+	f1 += f2;
+	f2 += f1;
+
+	// Null is reserved for "nothing hashed".
+	if ( f1 == 0 && f2 == 0 )
+		f2 = 1;
+
+	return content_digest(f1, f2);
+}
+
+// EOF
@@ -26,6 +26,8 @@
 // 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
 //
 // ===========================================================
+#include <algorithm>
+
 #include "logfile.h"
 
 #include "msg/ie_store.h"
@@ -35,13 +37,28 @@ using namespace protlib;
 using namespace protlib::log;
 
 
+namespace {
+
+/**
+ * Orders entries by ID, for the binary searches below.
+ */
+struct entry_less {
+	bool operator()(const ie_store::entry_t &a, 
+					const ie_object_key &b) const {
+		return a.first < b;
+	}
+};
+
+} // anonymous namespace
+
+
 /**
  * Standard constructor.
  *
  * Creates an empty ie_store.
  */
 ie_store::ie_store() : entries() {
-	// nothing to do
+	entries.reserve(INITIAL_CAPACITY);
 }
 
 
@@ -52,15 +69,19 @@ ie_store::ie_store() : entries() {
  *
  * @param other the object to copy
  */
-ie_store::ie_store(const ie_store &other) {
+ie_store::ie_store(const ie_store &other) : entries() {
 
-	// copy all entries
+	if ( other.entries.size() > INITIAL_CAPACITY )
+		entries.reserve(other.entries.size());
+	else
+		entries.reserve(INITIAL_CAPACITY);
+
+	// copy all entries, they are already in order
 	for (c_iter i = other.entries.begin(); i != other.entries.end(); i++) {
-		const ie_object_key id = i->first;
 		const IE *ie = i->second;
 
 		if ( ie )
-			set(id, ie->copy());
+			entries.push_back(entry_t(i->first, ie->copy()));
 		else
 			Log(ERROR_LOG, LOG_CRIT, "ie_store",
 				"copy constructor: the other IE is NULL");
@@ -77,30 +98,20 @@ ie_store::~ie_store() {
 	
 	for ( c_iter i = entries.begin(); i != entries.end(); i++ )
 		delete i->second;
-	
-	
 }
 
 
 bool ie_store::operator==(const ie_store &other) const throw() {
 
-	// The number of entries has to be equal, otherwise the check
-	// after this one doesn't work.
-		
 	if ( size() != other.size() )
 		return false;
 
-	// All entries have to be identical.
-	for ( c_iter i = entries.begin(); i != entries.end(); i++ ) {
-		const ie_object_key id = i->first;
-		const IE *obj = i->second;
-  
-		IE *other_obj = other.get(id);
-		
-		// Note: other_obj can't be NULL, set() takes care of that.
-		if ( other_obj == NULL || *obj != *other_obj ){
+	// Both are sorted, so equal stores have equal entries at each position.
+	for ( c_iter i = entries.begin(), j = other.entries.begin(); 
+			i != entries.end(); i++, j++ ) {
+
+		if ( i->first != j->first || *(i->second) != *(j->second) )
 			return false;
-		}
 	}
 		
 	return true;	// no difference found
@@ -117,6 +128,22 @@ size_t ie_store::size() const throw() {
 }
 
 
+ie_store::iter ie_store::find(const ie_object_key &id) throw() {
+	iter i = std::lower_bound(entries.begin(), entries.end(), id, 
+							  entry_less());
+
+	return ( i != entries.end() && i->first == id ) ? i : entries.end();
+}
+
+
+ie_store::c_iter ie_store::find(const ie_object_key &id) const throw() {
+	c_iter i = std::lower_bound(entries.begin(), entries.end(), id, 
+								entry_less());
+
+	return ( i != entries.end() && i->first == id ) ? i : entries.end();
+}
+
+
 /**
  * Returns the entry registered for a given ID.
  *
@@ -126,11 +153,7 @@ size_t ie_store::size() const throw() {
  */
 IE *ie_store::get(ie_object_key id) const throw() {
 
-	/*
-	 * Note: This is a true "const" implementation. Accessing the map
-	 *       via entries[id] would modify it, even if no entry is found!
-	 */
-	c_iter i = entries.find(id);
+	c_iter i = find(id);
 
 	if ( i != entries.end() )
 		return i->second;
@@ -158,12 +181,16 @@ void ie_store::set(ie_object_key id, IE *ie) throw () {
 		return;
 	}
 
-	IE *old = entries[id];
+	iter i = std::lower_bound(entries.begin(), entries.end(), id, 
+							  entry_less());
 
-	if ( old ){
-		delete old;
+	if ( i != entries.end() && i->first == id ) {
+		if ( i->second != ie )
+			delete i->second;
+		i->second = ie;
 	}
-	entries[id] = ie;
+	else
+		entries.insert(i, entry_t(id, ie));
 }
 
 
@@ -179,12 +206,15 @@ void ie_store::set(ie_object_key id, IE *ie) throw () {
  * @return the entry with that ID or NULL if there is none
  */
 IE *ie_store::remove(ie_object_key id) throw () {
-	IE *ie = entries[id];
+	iter i = find(id);
 
-	// Note: entries[id] created an entry, even if none existed before!
-	entries.erase(id);
+	if ( i == entries.end() )
+		return NULL;
+
+	IE *ie = i->second;
+	entries.erase(i);
 
-	return ie; // either the IE or NULL
+	return ie;
 }
 
 
@@ -197,18 +227,18 @@ IE *ie_store::remove(ie_object_key id) throw () {
 uint32 
 ie_store::getMaxSequence(uint32 id) const {
 
-	uint32 result = 0;
-	bool ingress = false;
-
-	// All entries have to be of the same type.
-	for ( c_iter i = entries.begin(); i != entries.end(); i++ ) {
-		const ie_object_key key = i->first;
-		if ( key.get_object_type() == id ){
-			if (result <= key.get_sequence_number())
-				result = key.get_sequence_number();
-				ingress = true;
-		}
-	}
-	
-	return result;
+	// The last entry of that type, if any, sits right before the first
+	// entry of the next type.
+	c_iter i = std::lower_bound(entries.begin(), entries.end(), 
+								ie_object_key(id + 1, 0), entry_less());
+
+	if ( i == entries.begin() )
+		return 0;
+
+	--i;
+
+	if ( i->first.get_object_type() != id )
+		return 0;
+
+	return i->first.get_sequence_number();
 }
@@ -0,0 +1,228 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file session_refresh_list.cpp
+/// The Session Refresh List Object.
+/// ----------------------------------------------------------
+/// $Id: session_refresh_list.cpp 2558 2016-03-17 11:05:00 amarentes $
+/// $HeadURL: https://./src/msg/session_refresh_list.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include "logfile.h"
+
+#include "msg/session_refresh_list.h"
+
+
+using namespace anslp::msg;
+
+
+const char *const session_refresh_list::ie_name = "session_refresh_list";
+
+
+/**
+ * Default constructor.
+ */
+session_refresh_list::session_refresh_list()
+		: anslp_object(OBJECT_TYPE, tr_mandatory, true), entries() 
+{
+
+	// nothing to do
+}
+
+
+/**
+ * Constructor for manual use.
+ *
+ * @param treatment the object treatment
+ */
+session_refresh_list::session_refresh_list(treatment_t treatment, bool _unique)
+		: anslp_object(OBJECT_TYPE, treatment, _unique), entries() 
+{
+
+	// nothing to do
+}
+
+
+session_refresh_list::~session_refresh_list() 
+{
+	// nothing to do
+}
+
+
+session_refresh_list *session_refresh_list::new_instance() const 
+{
+	session_refresh_list *q = NULL;
+	catch_bad_alloc( q = new session_refresh_list() );
+	return q;
+}
+
+
+session_refresh_list *session_refresh_list::copy() const 
+{
+	session_refresh_list *q = NULL;
+	catch_bad_alloc( q = new session_refresh_list(*this) );
+	return q;
+}
+
+
+bool session_refresh_list::deserialize_body(NetMsg &msg, uint16 body_length,
+		IEErrorList &err, bool skip) 
+{
+	
+	// The body has to consist of complete entries.
+	if ( body_length == 0 || (body_length % ENTRY_LENGTH) != 0 ) {
+		catch_bad_alloc( err.put( 
+			new PDUSyntaxError(CODING, get_category(),
+				get_object_type(), 0, msg.get_pos())) );
+
+		if ( ! skip )
+			return false;
+	}
+
+	uint16 num_entries = body_length / ENTRY_LENGTH;
+
+	entries.reserve(num_entries);
+
+	for ( uint16 i = 0; i < num_entries; i++ ) {
+		entry e;
+		e.sid.w1 = msg.decode32();
+		e.sid.w2 = msg.decode32();
+		e.sid.w3 = msg.decode32();
+		e.sid.w4 = msg.decode32();
+		e.msn = msg.decode32();
+		e.lifetime = msg.decode32();
+		entries.push_back(e);
+	}
+
+	// Skip the remaining bytes of an incomplete entry.
+	if ( body_length % ENTRY_LENGTH != 0 )
+		msg.set_pos_r(body_length % ENTRY_LENGTH);
+
+	return true; // success, all values are syntactically valid
+}
+
+
+void session_refresh_list::serialize_body(NetMsg &msg) const 
+{
+	std::vector<entry>::const_iterator i;
+	for ( i = entries.begin(); i != entries.end(); i++ ) {
+		msg.encode32(i->sid.w1);
+		msg.encode32(i->sid.w2);
+		msg.encode32(i->sid.w3);
+		msg.encode32(i->sid.w4);
+		msg.encode32(i->msn);
+		msg.encode32(i->lifetime);
+	}
+}
+
+
+size_t session_refresh_list::get_serialized_size(coding_t coding) const 
+{
+	return HEADER_LENGTH + entries.size() * ENTRY_LENGTH;
+}
+
+
+bool session_refresh_list::check_body() const 
+{
+	return entries.size() > 0 && entries.size() <= MAX_ENTRIES;
+}
+
+
+bool session_refresh_list::equals_body(const anslp_object &obj) const 
+{
+
+	const session_refresh_list *other
+		= dynamic_cast<const session_refresh_list *>(&obj);
+
+	if ( other == NULL || get_num_entries() != other->get_num_entries() )
+		return false;
+
+	for ( size_t i = 0; i < entries.size(); i++ ) {
+		const entry &a = entries[i];
+		const entry &b = other->entries[i];
+		
+		if ( a.sid.w1 != b.sid.w1 || a.sid.w2 != b.sid.w2 
+			 || a.sid.w3 != b.sid.w3 || a.sid.w4 != b.sid.w4 
+			 || a.msn != b.msn || a.lifetime != b.lifetime )
+			return false;
+	}
+
+	return true;
+}
+
+
+const char *session_refresh_list::get_ie_name() const 
+{
+	return ie_name;
+}
+
+
+ostream &session_refresh_list::print_attributes(ostream &os) const 
+{
+	return os << ", entries=" << get_num_entries();
+}
+
+
+/**
+ * Add a session to the list.
+ *
+ * @param sid the id of the refreshed session
+ * @param msn the message sequence number of the refresh
+ * @param lifetime the requested session lifetime
+ * @return false if the list is full, true otherwise
+ */
+bool session_refresh_list::add_entry(const uint128 &sid, uint32 msn, 
+									 uint32 lifetime) 
+{
+	if ( entries.size() >= MAX_ENTRIES )
+		return false;
+	
+	entry e;
+	e.sid = sid;
+	e.msn = msn;
+	e.lifetime = lifetime;
+	entries.push_back(e);
+	invalidate_size();
+	
+	return true;
+}
+
+
+/**
+ * Return the number of sessions in the list.
+ */
+size_t session_refresh_list::get_num_entries() const 
+{
+	return entries.size();
+}
+
+
+/**
+ * Return the entry at the given position.
+ *
+ * @param i a position lower than get_num_entries()
+ */
+const session_refresh_list::entry &
+session_refresh_list::get_entry(size_t i) const 
+{
+	assert( i < entries.size() );
+	return entries[i];
+}
@@ -0,0 +1,139 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file shared_bytes.cpp
+/// An immutable byte range shared between copies.
+/// ----------------------------------------------------------
+/// $Id: shared_bytes.cpp 2558 2016-04-04 16:40:00 amarentes $
+/// $HeadURL: https://./src/msg/shared_bytes.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include "msg/shared_bytes.h"
+
+
+using namespace anslp::msg;
+
+
+/**
+ * Creates an empty range.
+ */
+shared_bytes::shared_bytes() : blk(NULL) 
+{
+	// nothing to do
+}
+
+
+/**
+ * Copies the given bytes into a new block.
+ *
+ * @param data the bytes to copy
+ * @param length the number of bytes
+ */
+shared_bytes::shared_bytes(const uchar *data, uint16 length) : blk(NULL) 
+{
+	blk = static_cast<block *>(malloc(sizeof(block) + length));
+
+	if ( blk == NULL )
+		throw std::bad_alloc();
+
+	blk->refs = 1;
+	blk->length = length;
+
+	if ( length > 0 )
+		memcpy(blk->data, data, length);
+}
+
+
+/**
+ * Copy constructor. Shares the block with the other range.
+ */
+shared_bytes::shared_bytes(const shared_bytes &other) : blk(other.blk) 
+{
+	if ( blk != NULL )
+		__sync_add_and_fetch(&blk->refs, 1);
+}
+
+
+shared_bytes::~shared_bytes() 
+{
+	release();
+}
+
+
+shared_bytes &shared_bytes::operator=(const shared_bytes &other) 
+{
+	if ( blk != other.blk ) {
+		if ( other.blk != NULL )
+			__sync_add_and_fetch(&other.blk->refs, 1);
+
+		release();
+		blk = other.blk;
+	}
+
+	return *this;
+}
+
+
+/**
+ * Two ranges are equal if they hold the same bytes.
+ */
+bool shared_bytes::operator==(const shared_bytes &other) const 
+{
+	if ( get_length() != other.get_length() )
+		return false;
+
+	if ( blk == other.blk || get_length() == 0 )
+		return true;
+
+	return memcmp(blk->data, other.blk->data, get_length()) == 0;
+}
+
+
+void shared_bytes::release() 
+{
+	if ( blk != NULL && __sync_sub_and_fetch(&blk->refs, 1) == 0 )
+		free(blk);
+
+	blk = NULL;
+}
+
+
+/**
+ * Returns the bytes, or NULL if the range is empty.
+ */
+const uchar *shared_bytes::get_data() const 
+{
+	return ( blk != NULL ) ? blk->data : NULL;
+}
+
+
+uint16 shared_bytes::get_length() const 
+{
+	return ( blk != NULL ) ? blk->length : 0;
+}
+
+// EOF
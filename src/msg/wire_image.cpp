@@ -0,0 +1,144 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file wire_image.cpp
+/// The wire_image class.
+/// ----------------------------------------------------------
+/// $Id: wire_image.cpp 2558 2016-03-30 09:20:00 amarentes $
+/// $HeadURL: https://./src/msg/wire_image.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <cstring>
+#include <netinet/in.h>
+
+#include "logfile.h"
+
+#include "msg/anslp_ie.h"
+#include "msg/wire_image.h"
+
+
+using namespace anslp::msg;
+using namespace protlib::log;
+
+
+/**
+ * Constructor, creates an empty image.
+ */
+wire_image::wire_image() : image(NULL), msn_offset(0) 
+{
+	// nothing to do
+}
+
+
+wire_image::~wire_image() 
+{
+	delete image;
+}
+
+
+/**
+ * Serialize the given message into this image.
+ *
+ * @param msg the message, it is not modified and may be deleted afterwards
+ */
+void wire_image::assign(const anslp_msg *msg) 
+{
+	assert( msg != NULL );
+
+	clear();
+
+	image = new NetMsg( msg->get_serialized_size(IE::protocol_v1) );
+	
+	try {
+		uint32 bytes_written;
+		msg->serialize(*image, IE::protocol_v1, bytes_written);
+	}
+	catch ( IEError &e ) {
+		Log(ERROR_LOG, LOG_CRIT, "anslp_msg", 
+			"wire_image: serializing message failed");
+		assert( false ); // this would be a programming error
+	}
+
+	/*
+	 * Find the MSN object by walking the object headers.
+	 */
+	uchar *buf = image->get_buffer();
+	uint32 pos = anslp_msg::HEADER_LENGTH;
+
+	while ( pos + 4 <= image->get_size() ) {
+		uint32 header_raw;
+		memcpy(&header_raw, buf + pos, 4);
+		header_raw = ntohl(header_raw);
+
+		if ( anslp_object::extract_object_type(header_raw) 
+				== msg_sequence_number::OBJECT_TYPE ) {
+			msn_offset = pos + 4;
+			break;
+		}
+		
+		pos += 4 + (header_raw & 0xFFF) * 4;
+	}
+}
+
+
+/**
+ * Drop the image.
+ */
+void wire_image::clear() 
+{
+	delete image;
+	image = NULL;
+	msn_offset = 0;
+}
+
+
+/**
+ * Patch the message sequence number in the image.
+ *
+ * @return false if the image is empty or has no MSN object
+ */
+bool wire_image::set_msg_sequence_number(uint32 msn) 
+{
+	if ( image == NULL || msn_offset == 0 )
+		return false;
+
+	uint32 value = htonl(msn);
+	memcpy(image->get_buffer() + msn_offset, &value, 4);
+
+	return true;
+}
+
+
+uchar *wire_image::get_buffer() const 
+{
+	assert( image != NULL );
+	return image->get_buffer();
+}
+
+
+uint32 wire_image::get_size() const 
+{
+	assert( image != NULL );
+	return image->get_size();
+}
+
+
+// EOF
@@ -0,0 +1,245 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file mspec_object_list.cpp
+/// Flat container of mspec objects keyed by rule key.
+/// ----------------------------------------------------------
+/// $Id: mspec_object_list.cpp 2558 2016-04-08 10:20:00 amarentes $
+/// $HeadURL: https://./src/mspec_object_list.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+//
+// ===========================================================
+#include "mspec_object_list.h"
+
+
+namespace anslp 
+{
+
+const mspec_object_list::size_type mspec_object_list::INLINE_CAPACITY;
+const mspec_object_list::size_type mspec_object_list::INDEX_THRESHOLD;
+
+
+mspec_object_list::mspec_object_list()
+{
+	// nothing to do
+}
+
+
+mspec_object_list::mspec_object_list(const mspec_object_list &other)
+  : entries(other.entries), index(other.index)
+{
+	// nothing to do
+}
+
+
+mspec_object_list::~mspec_object_list()
+{
+	// nothing to do, the objects are owned by the user of the list.
+}
+
+
+mspec_object_list &
+mspec_object_list::operator=(const mspec_object_list &other)
+{
+	if ( this != &other )
+	{
+		entries = other.entries;
+		index = other.index;
+	}
+	return *this;
+}
+
+
+/**
+ * Return the position of key in entries, or entries.size() if the key is
+ * not in the list.
+ */
+mspec_object_list::size_type
+mspec_object_list::lookup(const mspec_rule_key &key) const
+{
+	if ( index.empty() )
+	{
+		for ( size_type i = 0; i < entries.size(); i++ )
+			if ( entries[i].first == key )
+				return i;
+		
+		return entries.size();
+	}
+
+	const size_type mask = index.size() - 1;
+	
+	for ( size_type slot = key.hash() & mask; index[slot] != 0; 
+			slot = (slot + 1) & mask )
+	{
+		if ( entries[index[slot] - 1].first == key )
+			return index[slot] - 1;
+	}
+	
+	return entries.size();
+}
+
+
+mspec_object_list::iterator 
+mspec_object_list::find(const mspec_rule_key &key)
+{
+	return entries.begin() + lookup(key);
+}
+
+
+mspec_object_list::const_iterator 
+mspec_object_list::find(const mspec_rule_key &key) const
+{
+	return entries.begin() + lookup(key);
+}
+
+
+msg::anslp_mspec_object *&
+mspec_object_list::operator[](const mspec_rule_key &key)
+{
+	size_type pos = lookup(key);
+	
+	if ( pos < entries.size() )
+		return entries[pos].second;
+	
+	return append(key, NULL)->second;
+}
+
+
+msg::anslp_mspec_object *
+mspec_object_list::exchange(const mspec_rule_key &key, 
+							msg::anslp_mspec_object *obj)
+{
+	size_type pos = lookup(key);
+	
+	if ( pos < entries.size() )
+	{
+		msg::anslp_mspec_object *old = entries[pos].second;
+		entries[pos].second = obj;
+		return old;
+	}
+	
+	append(key, obj);
+	return NULL;
+}
+
+
+mspec_object_list::size_type 
+mspec_object_list::erase(const mspec_rule_key &key)
+{
+	size_type pos = lookup(key);
+	
+	if ( pos == entries.size() )
+		return 0;
+	
+	erase(entries.begin() + pos);
+	return 1;
+}
+
+
+mspec_object_list::iterator 
+mspec_object_list::erase(iterator pos)
+{
+	size_type offset = pos - entries.begin();
+	
+	entries.erase(pos);
+	
+	// The entries behind pos moved, so the index has to be rebuilt.
+	if ( ! index.empty() )
+		rebuild_index();
+	
+	return entries.begin() + offset;
+}
+
+
+void 
+mspec_object_list::clear()
+{
+	entries.clear();
+	index.clear();
+}
+
+
+mspec_object_list::iterator 
+mspec_object_list::append(const mspec_rule_key &key, 
+						  msg::anslp_mspec_object *obj)
+{
+	if ( entries.capacity() == 0 )
+		entries.reserve(INLINE_CAPACITY);
+	
+	entries.push_back(value_type(key, obj));
+	
+	if ( entries.size() > INDEX_THRESHOLD )
+		insert_index(entries.size() - 1);
+	
+	return entries.end() - 1;
+}
+
+
+void 
+mspec_object_list::insert_index(size_type pos)
+{
+	// Keep the load factor at or below one half.
+	if ( 2 * entries.size() > index.size() )
+	{
+		rebuild_index();
+		return;
+	}
+
+	const size_type mask = index.size() - 1;
+	size_type slot = entries[pos].first.hash() & mask;
+	
+	while ( index[slot] != 0 )
+		slot = (slot + 1) & mask;
+	
+	index[slot] = pos + 1;
+}
+
+
+void 
+mspec_object_list::rebuild_index()
+{
+	index.clear();
+	
+	if ( entries.size() <= INDEX_THRESHOLD )
+		return;
+	
+	size_type capacity = 4 * INDEX_THRESHOLD;
+	while ( capacity < 2 * entries.size() )
+		capacity *= 2;
+	
+	index.resize(capacity, 0);
+	
+	const size_type mask = capacity - 1;
+	for ( size_type i = 0; i < entries.size(); i++ )
+	{
+		size_type slot = entries[i].first.hash() & mask;
+		while ( index[slot] != 0 )
+			slot = (slot + 1) & mask;
+		
+		index[slot] = i + 1;
+	}
+}
+
+
+} // namespace anslp
+
+// EOF
@@ -30,6 +30,7 @@
 #include <sstream>
 #include <iostream>
 #include "mspec_rule_key.h"
+#include "id_generator.h"
 
 
 namespace anslp 
@@ -38,7 +39,11 @@ namespace anslp
 /// Constructor of the field key
 mspec_rule_key::mspec_rule_key()
 {
-	uuid_generate_time_safe(uuid);
+	// Random (version 4) uuid built from the per-thread pool, this avoids 
+	// the clock read and the global lock of uuid_generate_time_safe.
+	id_generator::generate(uuid, sizeof(uuid));
+	uuid[6] = (uuid[6] & 0x0F) | 0x40;
+	uuid[8] = (uuid[8] & 0x3F) | 0x80;
 }
 
 /// Copy constructor of the field key
@@ -48,6 +53,12 @@ mspec_rule_key::mspec_rule_key(const mspec_rule_key &rhs)
 	uuid_copy(uuid, rhs.uuid);
 }
 
+/// Constructor of a key from its binary form
+mspec_rule_key::mspec_rule_key(const unsigned char *bytes)
+{
+	memcpy(uuid, bytes, sizeof(uuid));
+}
+
 	
 /// Destructor of the field key
 mspec_rule_key::~mspec_rule_key()
@@ -55,20 +66,6 @@ mspec_rule_key::~mspec_rule_key()
    uuid_clear(uuid);
 }
 		
-/**
- *  Equals to operator. It is equal when they have the same uuids.
- */
-bool 
-mspec_rule_key::operator ==(const mspec_rule_key &rhs) const
-{
-	int rv;
-	rv = uuid_compare(uuid, rhs.uuid);
-	if (rv == 0)
-		return true;
-	else
-		return false;
-}
-
 /** 
  * less operator. 
  */ 
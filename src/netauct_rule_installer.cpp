@@ -67,8 +67,10 @@ using namespace protlib::log;
 
 
 
-netauct_rule_installer::netauct_rule_installer(anslp_config *conf, FastQueue *installQueue, bool test) throw () 
-		: auction_rule_installer(conf), installQueue(installQueue) , test(test)
+netauct_rule_installer::netauct_rule_installer(anslp_config *conf, FastQueue *installQueue, 
+		bool test, install_backlog *backlog) throw () 
+		: auction_rule_installer(conf), installQueue(installQueue), 
+		  backlog(backlog), test(test)
 {
 
 	// nothing to do
@@ -185,6 +187,28 @@ void netauct_rule_installer::handle_response_check(anslp::FastQueue *waitqueue)
 	LogDebug("ending handle_response_check()");
 }
 
+/**
+ * Make sure the install queue has room for another event.
+ *
+ * Essential events, like session removals, are always queued. Others are
+ * deleted and an error with a transient failure is thrown if the queue is
+ * full.
+ */
+void
+netauct_rule_installer::admit_event(AnslpEvent *evt, bool essential)
+		throw (auction_rule_installer_error)
+{
+	if ( backlog == NULL || backlog->admit(getQueue()->size(), essential) )
+		return;
+
+	delete evt;
+
+	throw auction_rule_installer_error("The auction application is behind, event not queued",
+		msg::information_code::sc_transient_failure,
+		msg::information_code::tfail_resources_unavailable);
+}
+
+
 void 
 netauct_rule_installer::check(const string sessionId, 
 								objectList_t *missing_objects)
@@ -208,6 +232,8 @@ netauct_rule_installer::check(const string sessionId,
 									it_objects->second->copy());
 		}
 				
+		admit_event(evt, false);
+
 		bool queued = getQueue()->enqueue(evt);
 
 		if ( !queued ){
@@ -251,6 +277,8 @@ netauct_rule_installer::handle_create_session(const string sessionId, const auct
 				 << " - getthread_self:" << pthread_self() 
 				 << " tid:" << syscall(SYS_gettid) );
 		
+	admit_event(evt, false);
+
 	bool queued = getQueue()->enqueue(evt);
 	if ( !queued ){
 						
@@ -319,6 +347,9 @@ netauct_rule_installer::handle_remove_session(const string sessionId, const auct
 		evt->setObject(mspec_rule_key(i->first), i->second->copy());
 	}
 		
+	// The application has to release the session's state.
+	admit_event(evt, true);
+
 	bool queued = getQueue()->enqueue(evt);
 	if ( !queued ){
 						
@@ -384,6 +415,14 @@ netauct_rule_installer::auction_interaction(const bool server, const string sess
 		evt->setObject(i->first, i->second->copy());
 	}
 		
+	try {
+		admit_event(evt, false);
+	}
+	catch ( auction_rule_installer_error &e ) {
+		delete auc_return;
+		throw;
+	}
+
 	bool queued = getQueue()->enqueue(evt);
 
 	if ( queued ){
@@ -0,0 +1,147 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file netmsg_pool.cpp
+/// The netmsg_pool class.
+/// ----------------------------------------------------------
+/// $Id: netmsg_pool.cpp 2558 2016-03-28 11:30:00 amarentes $
+/// $HeadURL: https://./src/netmsg_pool.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+
+#include "netmsg_pool.h"
+
+
+using namespace anslp;
+
+
+/*
+ * The idle buffers of this thread, per size class.
+ */
+static __thread NetMsg *idle_buffers[netmsg_pool::NUM_CLASSES][netmsg_pool::MAX_IDLE];
+static __thread uint32 num_idle[netmsg_pool::NUM_CLASSES];
+
+/*
+ * The number of buffers allocated by this thread, for the test suite.
+ */
+static __thread uint32 num_allocated = 0;
+
+
+/**
+ * Return the index of the smallest class a buffer of the given size fits.
+ *
+ * @return the class or -1 if the size is larger than all classes
+ */
+int netmsg_pool::get_class(uint32 size) 
+{
+	uint32 class_size = MIN_CLASS_SIZE;
+
+	for ( uint32 c = 0; c < NUM_CLASSES; c++, class_size *= 4 ) {
+		if ( size <= class_size )
+			return c;
+	}
+
+	return -1;
+}
+
+
+uint32 netmsg_pool::get_class_size(int c) 
+{
+	return MIN_CLASS_SIZE << (2 * c);
+}
+
+
+/**
+ * Get a buffer of at least the given size.
+ *
+ * The buffer's position is at its start, its contents are undefined. 
+ * Use bytes written instead of get_size() to know how much of it is used.
+ *
+ * @param size the minimum size in bytes
+ * @return a buffer that has to be given back using release()
+ */
+NetMsg *netmsg_pool::acquire(uint32 size) 
+{
+	int c = get_class(size);
+
+	if ( c < 0 ) {
+		num_allocated++;
+		return new NetMsg(size);
+	}
+	
+	if ( num_idle[c] > 0 ) {
+		NetMsg *msg = idle_buffers[c][--num_idle[c]];
+		msg->set_pos(0);
+		return msg;
+	}
+
+	num_allocated++;
+	return new NetMsg(get_class_size(c));
+}
+
+
+/**
+ * Give a buffer back to the pool of the calling thread.
+ *
+ * Buffers may be released by another thread than the one that acquired
+ * them. Buffers not matching a size class or exceeding MAX_IDLE are freed.
+ *
+ * @param msg a buffer taken from acquire()
+ */
+void netmsg_pool::release(NetMsg *msg) 
+{
+	assert( msg != NULL );
+
+	int c = get_class(msg->get_size());
+
+	if ( c < 0 || get_class_size(c) != msg->get_size() 
+			|| num_idle[c] >= MAX_IDLE ) {
+		delete msg;
+		return;
+	}
+
+	idle_buffers[c][num_idle[c]++] = msg;
+}
+
+
+/**
+ * Free all idle buffers of the calling thread.
+ */
+void netmsg_pool::clear() 
+{
+	for ( uint32 c = 0; c < NUM_CLASSES; c++ ) {
+		while ( num_idle[c] > 0 )
+			delete idle_buffers[c][--num_idle[c]];
+	}
+}
+
+
+/**
+ * Return the number of buffers the calling thread had to allocate.
+ */
+uint32 netmsg_pool::get_num_allocated() 
+{
+	return num_allocated;
+}
+
+
+// EOF
@@ -57,9 +57,12 @@ using protlib::uint32;
  * Constructor.
  *
  * Use this if the session ID is known in advance.
+ *
+ * @param l the lock of the session, NULL for a plain mutex
  */
-nf_session::nf_session(const session_id &id, const anslp_config *conf)
-		: session(id), state(nf_session::STATE_ANSLP_CLOSE), config(conf),
+nf_session::nf_session(const session_id &id, const anslp_config *conf,
+					   lock *l)
+		: session(id, l), state(nf_session::STATE_ANSLP_CLOSE), config(conf),
 		  proxy_mode(false), msn_bidding(0), lifetime(0), max_lifetime(0),
 		  response_timeout(0), state_timer(this), response_timer(this),
 		  ni_mri(NULL), nr_mri(NULL), create_message(NULL), 
@@ -111,6 +114,88 @@ nf_session::~nf_session()
 	
 }
 
+
+/**
+ * Save the session if it is auctioning and not being torn down.
+ */
+bool nf_session::save_state(NetMsg &msg) const 
+{
+	if ( get_state() != STATE_ANSLP_AUCTIONING || get_lifetime() == 0 )
+		return false;
+
+	session::save_state(msg);
+
+	msg.encode32(proxy_mode);
+	msg.encode32(msn_bidding);
+	msg.encode32(lifetime);
+	msg.encode32(max_lifetime);
+	msg.encode32(response_timeout);
+
+	if ( ! save_mri(msg, ni_mri) || ! save_mri(msg, nr_mri)
+			|| ! save_message(msg, refresh_message) )
+		return false;
+
+	save_timer(msg, state_timer);
+	save_timer(msg, response_timer);
+
+	return true;
+}
+
+
+/**
+ * Resume an auctioning session saved by save_state().
+ */
+bool nf_session::restore_state(dispatcher *d, NetMsg &msg) 
+{
+	if ( ! session::restore_state(d, msg) )
+		return false;
+
+	proxy_mode = ( msg.decode32() != 0 );
+	msn_bidding = msg.decode32();
+	lifetime = msg.decode32();
+	max_lifetime = msg.decode32();
+	response_timeout = msg.decode32();
+
+	ntlp::mri_pathcoupled *m = restore_mri(msg);
+	if ( m == NULL )
+		return false;
+
+	set_ni_mri(m);
+
+	if ( (m = restore_mri(msg)) == NULL )
+		return false;
+
+	set_nr_mri(m);
+
+	msg::ntlp_msg *refresh;
+	if ( ! restore_message(msg, refresh) )
+		return false;
+
+	set_last_refresh_message(refresh);
+
+	restore_timer(d, msg, state_timer);
+	restore_timer(d, msg, response_timer);
+
+	state = STATE_ANSLP_AUCTIONING;
+
+	return true;
+}
+
+
+void nf_session::get_state_mark(state_mark &mark) const 
+{
+	session::get_state_mark(mark);
+
+	mark.add(state);
+	mark.add(msn_bidding);
+	mark.add(lifetime);
+	mark.add(ni_mri);
+	mark.add(nr_mri);
+	mark.add(refresh_message);
+	mark.add(state_timer);
+	mark.add(response_timer);
+}
+
 /**
  * Generate a 32 Bit random number.
  */
@@ -679,16 +764,15 @@ nf_session::handle_state_pending_check(dispatcher *d, event *evt) {
 		LogInfo("responder session checked. 1");
 		
 		// We loop through spec objects and remove those not included in the check message.
-		objectListRevIter_t itc_objects;
-		for ( itc_objects = rule->get_request_objects()->rbegin(); 
-				itc_objects != rule->get_request_objects()->rend(); itc_objects++)
+		objectListIter_t itc_objects = rule->get_request_objects()->begin();
+		while ( itc_objects != rule->get_request_objects()->end() )
 		{
-			mspec_rule_key key = itc_objects->first;
-			objectListIter_t itc_objects2;
-			if ( e->getObjects()->find(key) == e->getObjects()->end()){
+			if ( e->getObjects()->find(itc_objects->first) == e->getObjects()->end()){
 				delete itc_objects->second;
-				rule->get_request_objects()->erase (key);
+				itc_objects = rule->get_request_objects()->erase(itc_objects);
 			}
+			else
+				itc_objects++;
 		}
 		
 		// Create the new message to send foreward.
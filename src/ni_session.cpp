@@ -56,13 +56,18 @@ using protlib::uint32;
  * Constructor.
  *
  * Use this if the session ID is known in advance.
+ *
+ * @param l the lock of the session, NULL for a plain mutex
  */
-ni_session::ni_session(const session_id &id, const anslp_config *conf)
-		: session(id), state(STATE_ANSLP_CLOSE), routing_info(NULL),
+ni_session::ni_session(const session_id &id, const anslp_config *conf,
+					   lock *l)
+		: session(id, l), state(STATE_ANSLP_CLOSE), routing_info(NULL),
 		  last_create_msg(NULL), last_refresh_msg(NULL), last_auction_install_rule(NULL),
 		  lifetime(0),refresh_interval(20), response_timeout(0), create_counter(0),
 		  refresh_counter(0), max_retries(0), proxy_session(false),
-		  response_timer(this), refresh_timer(this) {
+		  response_timer(this), refresh_timer(this),
+		  refresh_due_ms(0), refresh_deadline_ms(0), peer_sii_handle(0),
+		  refresh_outdated(false) {
 
 	set_session_type(st_initiator);
 	set_msg_sequence_number(create_random_number());
@@ -86,7 +91,9 @@ ni_session::ni_session(state_t s)
 		  last_auction_install_rule(NULL), lifetime(30),
 		  refresh_interval(20), response_timeout(2), create_counter(0),
 		  refresh_counter(0), max_retries(3), proxy_session(false),
-		  response_timer(this), refresh_timer(this) {
+		  response_timer(this), refresh_timer(this),
+		  refresh_due_ms(0), refresh_deadline_ms(0), peer_sii_handle(0),
+		  refresh_outdated(false) {
 
 	set_session_type(st_initiator);
 	set_msg_sequence_number(create_random_number());
@@ -262,12 +269,43 @@ msg::ntlp_msg *ni_session::build_refresh_message()
 	/*
 	 * Wrap the Refresh inside an ntlp_msg and add session ID and MRI.
 	 */
-	ntlp_msg *msg = new ntlp_msg(get_id(), refresh, get_mri()->copy(), 0);
+	ntlp_msg *msg = new ntlp_msg(get_id(), refresh, get_mri()->copy(),
+								 peer_sii_handle);
 
 	return msg;
 }
 
 
+/**
+ * Prepare the REFRESH message to send next as the last REFRESH message.
+ *
+ * If neither the MRI nor the lifetime changed since the last REFRESH was
+ * built and it carries the current peer SII handle, only its MSN is 
+ * replaced, also in its wire image. Otherwise a new one is built.
+ */
+void ni_session::prepare_refresh_message() 
+{
+	using namespace anslp::msg;
+
+	anslp_refresh *refresh = NULL;
+	
+	if ( last_refresh_msg != NULL )
+		refresh = last_refresh_msg->get_anslp_refresh();
+
+	if ( refresh == NULL || refresh_outdated
+			|| last_refresh_msg->get_sii_handle() != peer_sii_handle ) {
+		set_last_refresh_message( build_refresh_message() );
+		return;
+	}
+
+	uint32 msn = next_msg_sequence_number();
+	refresh->set_msg_sequence_number(msn);
+
+	if ( ! last_refresh_image.set_msg_sequence_number(msn) )
+		last_refresh_image.clear();
+}
+
+
 /***
  * Create the auctioning rules (set of objects) to install 
 *
@@ -349,6 +387,132 @@ ni_session::setup_session(dispatcher *d, api_create_event *e,
 
 }
 
+/**
+ * Return the number of seconds after which a refresh is too late.
+ *
+ * The refresh has to leave enough time for all retransmissions before
+ * the session's lifetime expires at the responder.
+ */
+uint32 ni_session::get_refresh_deadline() const 
+{
+	uint32 reserve = get_response_timeout() * ( get_max_retries() + 1 );
+	
+	if ( get_lifetime() > reserve + get_refresh_interval() )
+		return get_lifetime() - reserve;
+	else
+		return get_refresh_interval();
+}
+
+
+/**
+ * Start the refresh timer and remember when the refresh is due.
+ */
+void ni_session::start_refresh_timer(dispatcher *d) 
+{
+	uint64_t now = refresh_scheduler::now_ms();
+	uint32 deadline = get_refresh_deadline();
+
+	refresh_due_ms = now + (uint64_t) get_refresh_interval() * 1000;
+	refresh_deadline_ms = now + (uint64_t) deadline * 1000;
+
+	refresh_timer.start_refresh(d, get_refresh_interval(), deadline);
+}
+
+
+/**
+ * Save the session if it is auctioning and not being torn down.
+ */
+bool ni_session::save_state(NetMsg &msg) const 
+{
+	if ( get_state() != STATE_ANSLP_AUCTIONING || get_lifetime() == 0 )
+		return false;
+
+	session::save_state(msg);
+
+	msg.encode32(lifetime);
+	msg.encode32(refresh_interval);
+	msg.encode32(response_timeout);
+	msg.encode32(max_retries);
+	msg.encode32(refresh_counter);
+	msg.encode32(proxy_mode);
+	msg.encode32(proxy_session);
+
+	if ( ! save_mri(msg, routing_info) 
+			|| ! save_message(msg, last_refresh_msg) )
+		return false;
+
+	save_time(msg, refresh_due_ms);
+	save_time(msg, refresh_deadline_ms);
+
+	// While we wait for a response, the refresh timer already went off.
+	timer stopped(NULL);
+	bool waiting = response_timer.get_remaining_ms() > 0;
+
+	save_timer(msg, waiting ? stopped : refresh_timer);
+	save_timer(msg, response_timer);
+
+	return true;
+}
+
+
+/**
+ * Resume an auctioning session saved by save_state().
+ */
+bool ni_session::restore_state(dispatcher *d, NetMsg &msg) 
+{
+	if ( ! session::restore_state(d, msg) )
+		return false;
+
+	lifetime = msg.decode32();
+	refresh_interval = msg.decode32();
+	response_timeout = msg.decode32();
+	max_retries = msg.decode32();
+	refresh_counter = msg.decode32();
+	proxy_mode = ( msg.decode32() != 0 );
+	proxy_session = ( msg.decode32() != 0 );
+
+	ntlp::mri_pathcoupled *m = restore_mri(msg);
+	if ( m == NULL )
+		return false;
+
+	set_mri(m);
+
+	msg::ntlp_msg *refresh;
+	if ( ! restore_message(msg, refresh) )
+		return false;
+
+	// No REFRESH was sent yet, the next one is built from scratch.
+	set_last_refresh_message( 
+		( refresh != NULL ) ? refresh : build_refresh_message() );
+
+	refresh_due_ms = restore_time(msg);
+	refresh_deadline_ms = restore_time(msg);
+
+	restore_timer(d, msg, refresh_timer);
+	restore_timer(d, msg, response_timer);
+
+	state = STATE_ANSLP_AUCTIONING;
+
+	return true;
+}
+
+
+void ni_session::get_state_mark(state_mark &mark) const 
+{
+	session::get_state_mark(mark);
+
+	mark.add(state);
+	mark.add(lifetime);
+	mark.add(refresh_counter);
+	mark.add(routing_info);
+	mark.add(last_refresh_msg);
+	mark.add(refresh_due_ms);
+	mark.add(refresh_deadline_ms);
+	mark.add(refresh_timer);
+	mark.add(response_timer);
+}
+
+
 /**
  * Create an auctioning rule from the given event and return it.
  *
@@ -421,7 +585,7 @@ ni_session::state_t ni_session::handle_state_close(dispatcher *d, event *evt)
 		// Build the new create message based on those objects not installed.
 		set_last_create_message( build_create_message(e, missing_objects) );
 
-		d->send_message( get_last_create_message()->copy() );
+		d->send_wire_message( get_last_create_message(), last_create_image );
 		
 		response_timer.start(d, get_response_timeout());
 						
@@ -488,7 +652,7 @@ ni_session::state_t ni_session::handle_state_pending(
 			
 			inc_create_counter();
 			
-			d->send_message( get_last_create_message()->copy() );
+			d->send_wire_message( get_last_create_message(), last_create_image );
 
 			response_timer.start(d, get_response_timeout());
 
@@ -552,6 +716,7 @@ ni_session::state_t ni_session::handle_state_pending(
 		if ( resp->is_success() ) {
 			
 			LogDebug("initiated session " << get_id());
+			peer_sii_handle = e->get_ntlp_msg()->get_sii_handle();
 			d->report_async_event("CREATE session initiated");
 			response_timer.start(d, get_response_timeout());
 			
@@ -691,7 +856,7 @@ ni_session::state_t ni_session::handle_state_pending_installing(
 						
 			set_create_counter(0);
 			response_timer.stop();
-			refresh_timer.start(d, get_refresh_interval());
+			start_refresh_timer(d);
 				
 			LogDebug("Ending state handle pending - New State AUCTIONING ");
 			return STATE_ANSLP_AUCTIONING;
@@ -762,11 +927,17 @@ ni_session::state_t ni_session::handle_state_auctioning(
 
 		LogDebug("received refresh timer");
 
-		// Build a new REFRESH message, it stores a copy for refreshing.
-		set_last_refresh_message( build_refresh_message() );
+		uint32 defer = d->admit_refresh(get_mri(), refresh_due_ms, 
+										refresh_deadline_ms);
+		if ( defer > 0 ) {
+			refresh_timer.start_ms(d, defer);
+			return STATE_ANSLP_AUCTIONING; // no change
+		}
 
-		// dispatcher will delete
-		d->send_message( get_last_refresh_message()->copy() );
+		// Reuse the last REFRESH message with a new MSN, if possible.
+		prepare_refresh_message();
+
+		d->send_wire_message( get_last_refresh_message(), last_refresh_image );
 
         // Set the refresh counter to zero
         set_refresh_counter(0);
@@ -788,7 +959,7 @@ ni_session::state_t ni_session::handle_state_auctioning(
 		if ( get_refresh_counter() < get_max_retries() ) {
 			inc_refresh_counter();
 
-			d->send_message( get_last_refresh_message()->copy() );
+			d->send_wire_message( get_last_refresh_message(), last_refresh_image );
 
 			response_timer.start(d, get_response_timeout());
 
@@ -836,8 +1007,7 @@ ni_session::state_t ni_session::handle_state_auctioning(
 		// Build a new REFRESH message, it stores a copy for refreshing.
 		set_last_refresh_message( build_refresh_message() );
 
-		// dispatcher will delete
-		d->send_message( get_last_refresh_message()->copy() );
+		d->send_wire_message( get_last_refresh_message(), last_refresh_image );
 
 		LogDebug("Ending state auctioning - api teardown");
 
@@ -924,6 +1094,9 @@ ni_session::state_t ni_session::handle_state_auctioning(
 
 		if ( resp->is_success() ) {
 			d->report_async_event("REFRESH successful");
+
+			// The next hop may have changed since the CREATE.
+			peer_sii_handle = e->get_ntlp_msg()->get_sii_handle();
 						
 			if ( get_lifetime() == 0 )
 			{
@@ -955,7 +1128,7 @@ ni_session::state_t ni_session::handle_state_auctioning(
 
 				response_timer.stop();
 				
-				refresh_timer.start(d, get_refresh_interval());
+				start_refresh_timer(d);
 
 				set_refresh_counter(0);
 
@@ -54,9 +54,12 @@ using protlib::uint32;
  * Constructor.
  *
  * Use this if the session ID is known in advance.
+ *
+ * @param l the lock of the session, NULL for a plain mutex
  */
-nr_session::nr_session(const session_id &id, anslp_config *conf)
-		: session(id), state(STATE_ANSLP_CLOSE),routing_info(NULL), config(conf),
+nr_session::nr_session(const session_id &id, anslp_config *conf,
+					   lock *l)
+		: session(id, l), state(STATE_ANSLP_CLOSE),routing_info(NULL), config(conf),
 		  msn_bidding(0), lifetime(0), max_lifetime(0), create_counter(0), state_timer(this), 
 		  response_timer(this), act_rule(NULL), create_message(NULL)
 {
@@ -109,6 +112,87 @@ nr_session::~nr_session()
 	
 }
 
+
+/**
+ * Save the session if it is auctioning.
+ */
+bool nr_session::save_state(NetMsg &msg) const 
+{
+	if ( get_state() != STATE_ANSLP_AUCTIONING )
+		return false;
+
+	session::save_state(msg);
+
+	msg.encode32(msn_bidding);
+	msg.encode32(lifetime);
+	msg.encode32(max_lifetime);
+	msg.encode32(response_timeout);
+	msg.encode32(max_retries);
+
+	if ( ! save_mri(msg, routing_info) )
+		return false;
+
+	msg.encode32( act_rule != NULL );
+	if ( act_rule != NULL )
+		save_rule(msg, act_rule);
+
+	save_timer(msg, state_timer);
+	save_timer(msg, response_timer);
+
+	return true;
+}
+
+
+/**
+ * Resume an auctioning session saved by save_state().
+ */
+bool nr_session::restore_state(dispatcher *d, NetMsg &msg) 
+{
+	if ( ! session::restore_state(d, msg) )
+		return false;
+
+	msn_bidding = msg.decode32();
+	lifetime = msg.decode32();
+	max_lifetime = msg.decode32();
+	response_timeout = msg.decode32();
+	max_retries = msg.decode32();
+
+	ntlp::mri_pathcoupled *m = restore_mri(msg);
+	if ( m == NULL )
+		return false;
+
+	set_mri(m);
+
+	if ( msg.decode32() != 0 ) {
+		auction_rule *r = restore_rule(msg);
+		if ( r == NULL )
+			return false;
+
+		set_auction_rule(r);
+	}
+
+	restore_timer(d, msg, state_timer);
+	restore_timer(d, msg, response_timer);
+
+	state = STATE_ANSLP_AUCTIONING;
+
+	return true;
+}
+
+
+void nr_session::get_state_mark(state_mark &mark) const 
+{
+	session::get_state_mark(mark);
+
+	mark.add(state);
+	mark.add(msn_bidding);
+	mark.add(lifetime);
+	mark.add(routing_info);
+	mark.add(act_rule);
+	mark.add(state_timer);
+	mark.add(response_timer);
+}
+
 /**
  * Generate a 32 Bit random number.
  */
@@ -487,16 +571,15 @@ nr_session::handle_state_pending(dispatcher *d, event *evt)
 		LogDebug("responder session installed.");
 		
 		// We loop through spec objects and remove those not included in the check message.
-		objectListRevIter_t itc_objects;
-		for ( itc_objects = rule->get_request_objects()->rbegin(); 
-				itc_objects != rule->get_request_objects()->rend(); itc_objects++)
+		objectListIter_t itc_objects = rule->get_request_objects()->begin();
+		while ( itc_objects != rule->get_request_objects()->end() )
 		{
-			mspec_rule_key key = itc_objects->first;
-			objectListIter_t itc_objects2;
-			if ( e->getObjects()->find(key) == e->getObjects()->end()){
+			if ( e->getObjects()->find(itc_objects->first) == e->getObjects()->end()){
 				delete itc_objects->second;
-				rule->get_request_objects()->erase (key);
+				itc_objects = rule->get_request_objects()->erase(itc_objects);
 			}
+			else
+				itc_objects++;
 		}
 
 		// reinitiate create counter.
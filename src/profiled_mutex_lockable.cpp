@@ -0,0 +1,95 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file profiled_mutex_lockable.cpp
+/// A mutex lockable recording its wait and hold times.
+/// ----------------------------------------------------------
+/// $Id: profiled_mutex_lockable.cpp 2558 2016-04-19 09:30:00 amarentes $
+/// $HeadURL: https://./src/profiled_mutex_lockable.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+
+#include "profiled_mutex_lockable.h"
+
+using namespace anslp;
+
+profiled_mutex_lockable::profiled_mutex_lockable (lock_profile *profile)
+		: profile(profile), acquired_ns(0)
+{
+	assert( profile != NULL );
+
+	pthread_mutexattr_t mutex_attr;
+
+	pthread_mutexattr_init(&mutex_attr);
+
+#ifdef _DEBUG
+	pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
+#else
+	pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_NORMAL);
+#endif
+
+	pthread_mutex_init(&mutex, &mutex_attr);
+
+	pthread_mutexattr_destroy(&mutex_attr); // valid, doesn't affect mutex
+
+}
+
+profiled_mutex_lockable::~profiled_mutex_lockable()
+{
+	pthread_mutex_destroy(&mutex);
+}
+
+
+int profiled_mutex_lockable::acquire(void)
+{
+	int ret = pthread_mutex_trylock(&mutex);
+
+	if ( ret == 0 ) {
+		acquired_ns = lock_profile::now_ns();
+		profile->record_acquire(0, false);
+		return ret;
+	}
+
+	uint64_t start = lock_profile::now_ns();
+
+	ret = pthread_mutex_lock(&mutex);
+	assert( ret == 0 );
+
+	acquired_ns = lock_profile::now_ns();
+	profile->record_acquire(acquired_ns - start, true);
+	
+	return ret;
+}
+
+
+int profiled_mutex_lockable::release(void)
+{
+	int ret;
+
+	uint64_t held = lock_profile::now_ns() - acquired_ns;
+
+	ret = pthread_mutex_unlock(&mutex);
+	assert( ret == 0 );
+
+	profile->record_release(held);
+	
+	return ret;
+}
@@ -0,0 +1,316 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file refresh_scheduler.cpp
+/// The refresh_scheduler class.
+/// ----------------------------------------------------------
+/// $Id: refresh_scheduler.cpp 2558 2016-03-21 10:15:00 amarentes $
+/// $HeadURL: https://./src/refresh_scheduler.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "refresh_scheduler.h"
+
+
+using namespace anslp;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * @param jitter_percent size of the jitter window in percent of the interval
+ * @param peer_rate refreshes per second sent to one peer (0 = unlimited)
+ * @param peer_burst number of refreshes a peer may receive at once
+ * @param queue_threshold input queue depth above which refreshes are
+ *        deferred (0 = never)
+ */
+refresh_scheduler::refresh_scheduler(uint32 jitter_percent, uint32 peer_rate,
+								uint32 peer_burst, uint32 queue_threshold)
+		: jitter_percent(jitter_percent), peer_rate(peer_rate), 
+		  peer_burst(peer_burst), queue_threshold(queue_threshold), 
+		  queue_depth(0) 
+{
+	if ( this->jitter_percent > 100 )
+		this->jitter_percent = 100;
+	
+	if ( this->peer_burst == 0 )
+		this->peer_burst = 1;
+
+	slots = new slot_t[NUM_SLOTS];
+	for ( uint32 i = 0; i < NUM_SLOTS; i++ ) {
+		slots[i].number = 0;
+		slots[i].count = 0;
+	}
+
+	stats.scheduled = 0;
+	stats.sent = 0;
+	stats.deferred_queue = 0;
+	stats.deferred_peer = 0;
+	stats.late = 0;
+	stats.total_delay_ms = 0;
+	stats.max_delay_ms = 0;
+	stats.min_margin_ms = (uint64_t) -1;
+
+	pthread_mutex_init(&mutex, NULL);
+}
+
+
+/**
+ * Destructor.
+ */
+refresh_scheduler::~refresh_scheduler() 
+{
+	delete[] slots;
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Return a monotonic timestamp in milliseconds.
+ */
+uint64_t refresh_scheduler::now_ms()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	
+	return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+
+/**
+ * Choose the delay of a refresh timer.
+ *
+ * The delay lies within the jitter window [interval - jitter, interval],
+ * but never beyond the deadline. At most MAX_CANDIDATES slots, spread
+ * evenly across the window, are compared and the one with the fewest
+ * refreshes is chosen, ties are broken randomly.
+ *
+ * @param interval_ms the nominal refresh interval
+ * @param deadline_ms the time after which a refresh is too late
+ * @return the delay in milliseconds
+ */
+uint32 refresh_scheduler::schedule(uint32 interval_ms, uint32 deadline_ms)
+{
+	if ( interval_ms > deadline_ms )
+		interval_ms = deadline_ms;
+
+	uint32 low = interval_ms - (uint32) 
+		( (uint64_t) interval_ms * jitter_percent / 100 );
+
+	uint64_t now = now_ms();
+	uint64_t first = (now + low) / SLOT_MS;
+	uint64_t last = (now + interval_ms) / SLOT_MS;
+	
+	// A window wider than the ring would count two slots in one entry.
+	if ( last - first >= NUM_SLOTS )
+		last = first + NUM_SLOTS - 1;
+
+	uint64_t window = last - first + 1;
+	uint64_t stride = (window + MAX_CANDIDATES - 1) / MAX_CANDIDATES;
+
+	uint64_t best = first;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	uint32 best_count = (uint32) -1;
+	uint32 num_best = 0;
+
+	// A random offset lets every slot of the window be chosen.
+	for ( uint64_t n = first + rand() % stride; n <= last; n += stride ) {
+		slot_t &slot = slots[n % NUM_SLOTS];
+		uint32 count = ( slot.number == n ) ? slot.count : 0;
+		
+		if ( count < best_count ) {
+			best = n;
+			best_count = count;
+			num_best = 1;
+		} else if ( count == best_count && rand() % ++num_best == 0 ) {
+			best = n;
+		}
+	}
+
+	slot_t &slot = slots[best % NUM_SLOTS];
+	if ( slot.number != best ) {
+		slot.number = best;
+		slot.count = 0;
+	}
+	slot.count++;
+	
+	stats.scheduled++;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	uint64_t delay = best * SLOT_MS + rand() % SLOT_MS;
+
+	if ( delay < now + low )
+		delay = now + low;
+	if ( delay > now + interval_ms )
+		delay = now + interval_ms;
+
+	return (uint32) (delay - now);
+}
+
+
+/**
+ * Take a token from the bucket of the given peer.
+ *
+ * Must be called with the mutex held.
+ *
+ * @param wait_ms the time until a token is available, if none is left
+ * @return true if a token was taken
+ */
+bool refresh_scheduler::take_token(const std::string &peer, uint64_t now,
+								   uint32 &wait_ms)
+{
+	std::map<std::string, bucket_t>::iterator i = buckets.find(peer);
+
+	if ( i == buckets.end() ) {
+		bucket_t b;
+		b.tokens = peer_burst;
+		b.last_ms = now;
+		i = buckets.insert(std::make_pair(peer, b)).first;
+	}
+
+	bucket_t &b = i->second;
+
+	b.tokens += (double) (now - b.last_ms) * peer_rate / 1000.0;
+	if ( b.tokens > peer_burst )
+		b.tokens = peer_burst;
+	b.last_ms = now;
+
+	if ( b.tokens >= 1.0 ) {
+		b.tokens -= 1.0;
+		return true;
+	}
+
+	wait_ms = (uint32) ( (1.0 - b.tokens) * 1000.0 / peer_rate ) + 1;
+	return false;
+}
+
+
+/**
+ * Decide whether a due refresh may be sent now.
+ *
+ * @param peer the key of the peer the refresh is sent to, may be empty
+ * @param due_ms the time the refresh was scheduled for (see now_ms())
+ * @param deadline_ms the time after which the refresh is too late
+ * @return 0 if the refresh is to be sent, otherwise the time to defer it 
+ */
+uint32 refresh_scheduler::admit(const std::string &peer, uint64_t due_ms,
+								uint64_t deadline_ms)
+{
+	uint64_t now = now_ms();
+	uint32 defer = 0;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	uint64_t slack = ( deadline_ms > now ) ? deadline_ms - now : 0;
+
+	if ( slack > 0 && queue_threshold > 0 && queue_depth > queue_threshold ) {
+		// Give the queue half of the remaining slack to drain.
+		defer = (uint32) ( slack / 2 < MAX_DEFER_MS ? slack / 2 : MAX_DEFER_MS );
+		
+		if ( defer >= SLOT_MS )
+			stats.deferred_queue++;
+		else
+			defer = 0;
+	}
+
+	uint32 wait_ms = 0;
+	if ( defer == 0 && peer_rate > 0 && ! peer.empty() 
+			&& ! take_token(peer, now, wait_ms) && wait_ms < slack ) {
+		defer = wait_ms;
+		stats.deferred_peer++;
+	}
+
+	if ( defer == 0 ) {
+		uint64_t delay = ( now > due_ms ) ? now - due_ms : 0;
+		
+		stats.sent++;
+		stats.total_delay_ms += delay;
+		if ( delay > stats.max_delay_ms )
+			stats.max_delay_ms = delay;
+		if ( slack < stats.min_margin_ms )
+			stats.min_margin_ms = slack;
+		if ( slack == 0 )
+			stats.late++;
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return defer;
+}
+
+
+/**
+ * Return a copy of the current counters.
+ */
+refresh_scheduler_stats refresh_scheduler::get_stats() const
+{
+	refresh_scheduler_stats s;
+
+	pthread_mutex_lock(&mutex);
+	install_cleanup_handler(&mutex);
+
+	s = stats;
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&mutex);
+
+	return s;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, 
+								const refresh_scheduler_stats &s)
+{
+	out << "scheduled=" << s.scheduled << " sent=" << s.sent
+		<< " deferred_queue=" << s.deferred_queue
+		<< " deferred_peer=" << s.deferred_peer
+		<< " late=" << s.late
+		<< " avg_delay_ms=" 
+		<< ( s.sent > 0 ? s.total_delay_ms / s.sent : 0 )
+		<< " max_delay_ms=" << s.max_delay_ms
+		<< " min_margin_ms=";
+	
+	if ( s.sent > 0 )
+		out << s.min_margin_ms;
+	else
+		out << "-";
+	
+	return out;
+}
+
+
+// EOF
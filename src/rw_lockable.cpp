@@ -0,0 +1,97 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file rw_lockable.cpp
+/// A lockable that lets readers share the lock.
+/// ----------------------------------------------------------
+/// $Id: rw_lockable.cpp 2558 2016-04-20 11:00:00 amarentes $
+/// $HeadURL: https://./src/rw_lockable.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+
+#include "rw_lockable.h"
+
+using namespace anslp;
+
+rw_lockable::rw_lockable ()
+{
+	pthread_rwlockattr_t rwlock_attr;
+
+	pthread_rwlockattr_init(&rwlock_attr);
+
+#ifdef __GLIBC__
+	pthread_rwlockattr_setkind_np(&rwlock_attr, 
+		PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+#endif
+
+	pthread_rwlock_init(&rwlock, &rwlock_attr);
+
+	pthread_rwlockattr_destroy(&rwlock_attr); // valid, doesn't affect lock
+}
+
+rw_lockable::~rw_lockable()
+{
+	pthread_rwlock_destroy(&rwlock);
+}
+
+
+int rw_lockable::acquire(void)
+{
+	int ret;
+
+	ret = pthread_rwlock_wrlock(&rwlock);
+	assert( ret == 0 );
+	
+	return ret;
+}
+
+
+int rw_lockable::release(void)
+{
+	int ret;
+
+	ret = pthread_rwlock_unlock(&rwlock);
+	assert( ret == 0 );
+	
+	return ret;
+}
+
+
+int rw_lockable::acquire_shared(void)
+{
+	int ret;
+
+	ret = pthread_rwlock_rdlock(&rwlock);
+	assert( ret == 0 );
+	
+	return ret;
+}
+
+
+int rw_lockable::release_shared(void)
+{
+	int ret;
+
+	ret = pthread_rwlock_unlock(&rwlock);
+	assert( ret == 0 );
+	
+	return ret;
+}
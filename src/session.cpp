@@ -27,19 +27,27 @@
 //
 // ===========================================================
 #include <assert.h>
+#include <sys/time.h>
 
 #include "logfile.h"
+#include "mri.h"	// from NTLP
 
 #include "session.h"
 #include "dispatcher.h"
+#include "anslp_timers.h"
+#include "refresh_scheduler.h"
+#include "msg/ntlp_msg.h"
+#include "msg/anslp_ie.h"
 #include "msg/selection_auctioning_entities.h"
 #include "thread_mutex_lockable.h"
 #include <iostream>
 
 
 using namespace anslp;
+using namespace anslp::msg;
 using namespace protlib::log;
 using protlib::uint32;
+using protlib::uint64;
 
 #define LogWarn(msg) Log(WARNING_LOG, LOG_NORMAL, "session", msg)
 #define LogInfo(msg) Log(INFO_LOG, LOG_NORMAL, "session", msg)
@@ -100,6 +108,7 @@ void session::init()
 {
 		
 	rule = new auction_rule();
+	saved = false;
 	
 	if (lock_ == NULL){
 		lock_ = new lock(new thread_mutex_lockable());
@@ -112,13 +121,46 @@ void session::init()
  *
  * This method calls the user-defined process_event method and takes care of
  * locking.
+ *
+ * Retransmitted CREATE, BIDDING and RESPONSE messages are caught before
+ * that. A retransmitted CREATE we already answered gets the same RESPONSE
+ * again, one still waiting for an answer goes on to the state machine.
+ * Other duplicates need no answer and are discarded.
  */
 void session::process(dispatcher *d, event *evt) 
 {
+	msg_event *e = dynamic_cast<msg_event *>(evt);
+	msg::ntlp_msg *msg = ( e != NULL ) ? e->get_ntlp_msg() : NULL;
+
+	if ( duplicate_filter::is_filtered(msg) ) {
+		msg::content_digest digest = msg->get_anslp_msg()->get_digest();
+		const msg::ntlp_msg *reply = NULL;
+
+		if ( ! duplicates.lookup(msg, digest, reply) ) {
+			duplicates.record(msg, digest);
+		}
+		else if ( reply != NULL ) {
+			LogDebug("answering retransmitted message from cache");
+			d->send_message( reply->copy() );
+			return;
+		}
+		else if ( e->get_create() == NULL ) {
+			LogDebug("discarding duplicate message");
+			return;
+		}
+	}
 
+	d->set_reply_filter(&duplicates);
 
-	process_event(d, evt);	// implemented by child classes
+	try {
+		process_event(d, evt);	// implemented by child classes
+	}
+	catch ( ... ) {
+		d->set_reply_filter(NULL);
+		throw;
+	}
 
+	d->set_reply_filter(NULL);
 }
 
 
@@ -278,3 +320,434 @@ session::release()
 { 
 	return lock_->release(); 
 } 
+
+
+int 
+session::acquire_shared()
+{ 
+	return lock_->acquire_shared(); 
+}
+	
+int 
+session::release_shared() 
+{ 
+	return lock_->release_shared(); 
+} 
+
+
+bool 
+session::is_outdated_timer(const event *evt) const
+{
+	return false;
+}
+
+
+const ntlp::mri *
+session::get_refresh_mri() const
+{
+	return NULL;
+}
+
+
+/*
+ * Saved states are read after a restart, so points in time are stored
+ * as wall-clock milliseconds. The parts which are IEs are prefixed with
+ * their length, so each can be read from a NetMsg of its own.
+ */
+namespace {
+
+uint64 wall_ms() 
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+
+	return (uint64) tv.tv_sec * 1000 + tv.tv_usec / 1000;
+}
+
+void encode64(NetMsg &msg, uint64 value) 
+{
+	msg.encode32((uint32) (value >> 32));
+	msg.encode32((uint32) value);
+}
+
+uint64 decode64(NetMsg &msg) 
+{
+	uint64 value = msg.decode32();
+	return (value << 32) | msg.decode32();
+}
+
+template <class T> void save_part(NetMsg &msg, const T *ie) 
+{
+	uint32 start_pos = msg.get_pos();
+	uint32 bytes_written;
+
+	msg.encode32(0);
+	ie->serialize(msg, IE::protocol_v1, bytes_written);
+
+	uint32 end_pos = msg.get_pos();
+	msg.set_pos(start_pos);
+	msg.encode32(end_pos - start_pos - 4);
+	msg.set_pos(end_pos);
+}
+
+/**
+ * Return a copy of the next length prefixed part, NULL if it is damaged.
+ */
+NetMsg *take_part(NetMsg &msg) 
+{
+	uint32 length = msg.decode32();
+
+	if ( length == 0 || length > msg.get_bytes_left() )
+		return NULL;
+
+	uint32 start_pos = msg.get_pos();
+	msg.set_pos(start_pos + length);
+
+	return new NetMsg(msg.get_buffer() + start_pos, length); // copies
+}
+
+IE *restore_part(NetMsg &msg, uint16 category) 
+{
+	NetMsg *part = take_part(msg);
+
+	if ( part == NULL )
+		return NULL;
+
+	IEErrorList errlist;
+	uint32 bytes_read;
+
+	IE *ie = ANSLP_IEManager::instance()->deserialize(*part, category, 
+				IE::protocol_v1, errlist, bytes_read, false);
+	delete part;
+
+	return ie;
+}
+
+bool save_objects(NetMsg &msg, const objectList_t *objects) 
+{
+	msg.encode32(objects->size());
+
+	for ( objectListConstIter_t i = objects->begin(); 
+			i != objects->end(); i++ ) {
+		uint32 pos = msg.get_pos();
+
+		msg.copy_from(i->first.get_bytes(), pos, mspec_rule_key::SIZE);
+		msg.set_pos(pos + mspec_rule_key::SIZE);
+
+		save_part(msg, i->second);
+	}
+
+	return true;
+}
+
+bool restore_objects(NetMsg &msg, auction_rule *r, bool responses) 
+{
+	uint32 num = msg.decode32();
+
+	for ( uint32 i = 0; i < num; i++ ) {
+		if ( msg.get_bytes_left() < mspec_rule_key::SIZE )
+			return false;
+
+		mspec_rule_key key(msg.get_buffer() + msg.get_pos());
+		msg.set_pos(msg.get_pos() + mspec_rule_key::SIZE);
+
+		IE *ie = restore_part(msg, cat_anslp_object);
+		anslp_mspec_object *obj = dynamic_cast<anslp_mspec_object *>(ie);
+
+		if ( obj == NULL ) {
+			delete ie;
+			return false;
+		}
+
+		if ( responses )
+			r->set_response_object(key, obj);
+		else
+			r->set_request_object(key, obj);
+	}
+
+	return true;
+}
+
+} // anonymous namespace
+
+
+bool 
+session::save_state(NetMsg &msg) const
+{
+	msg.encode32(msn);
+	msg.encode32(msg_hop_count);
+
+	save_rule(msg, rule);
+
+	return true;
+}
+
+
+bool 
+session::restore_state(dispatcher *d, NetMsg &msg)
+{
+	msn = msg.decode32();
+	msg_hop_count = msg.decode32();
+
+	auction_rule *r = restore_rule(msg);
+	
+	if ( r == NULL )
+		return false;
+
+	delete rule;
+	rule = r;
+
+	return true;
+}
+
+
+void 
+session::get_state_mark(state_mark &mark) const
+{
+	mark.add(msn);
+	mark.add(msg_hop_count);
+	mark.add(rule);
+}
+
+
+/**
+ * Check whether the session changed since the session manager saved it.
+ *
+ * The caller has to hold the session's lock.
+ */
+bool 
+session::has_unsaved_changes() const
+{
+	if ( ! saved )
+		return true;
+
+	state_mark mark;
+	get_state_mark(mark);
+
+	return mark != saved_mark;
+}
+
+
+/**
+ * Remember the current state as saved, or forget the last save.
+ *
+ * The caller has to hold the session's lock.
+ */
+void 
+session::set_saved(bool value) const
+{
+	saved = value;
+
+	if ( saved ) {
+		saved_mark = state_mark();
+		get_state_mark(saved_mark);
+	}
+}
+
+
+void 
+state_mark::add(const timer &t)
+{
+	add(t.get_id());
+	add(t.get_expires_ms());
+}
+
+
+bool 
+state_mark::operator==(const state_mark &other) const
+{
+	if ( num_values != other.num_values )
+		return false;
+
+	for ( int i = 0; i < num_values; i++ )
+		if ( values[i] != other.values[i] )
+			return false;
+
+	return true;
+}
+
+
+/**
+ * Save when the timer goes off, or that it is stopped.
+ */
+void 
+session::save_timer(NetMsg &msg, const timer &t) 
+{
+	uint32 remaining = t.get_remaining_ms();
+
+	encode64(msg, ( remaining > 0 ) ? wall_ms() + remaining : 0);
+}
+
+
+/**
+ * Start the timer for the time left, an overdue timer goes off at once.
+ */
+void 
+session::restore_timer(dispatcher *d, NetMsg &msg, timer &t) 
+{
+	uint64 expires = decode64(msg);
+
+	if ( expires == 0 ) {
+		t.stop();
+		return;
+	}
+
+	uint64 now = wall_ms();
+
+	t.start_ms(d, ( expires > now ) ? (uint32) (expires - now) : 1);
+}
+
+
+/**
+ * Save a point in time given as refresh_scheduler::now_ms() timestamp.
+ */
+void 
+session::save_time(NetMsg &msg, uint64 ms) 
+{
+	uint64 now = refresh_scheduler::now_ms();
+
+	encode64(msg, wall_ms() + ( ms > now ? ms - now : 0 ));
+}
+
+
+/**
+ * Read a point in time, past ones are returned as the current time.
+ */
+uint64 
+session::restore_time(NetMsg &msg) 
+{
+	uint64 wall = decode64(msg);
+	uint64 now = wall_ms();
+
+	return refresh_scheduler::now_ms() + ( wall > now ? wall - now : 0 );
+}
+
+
+/**
+ * Save the MRI, only path-coupled MRIs are supported.
+ */
+bool 
+session::save_mri(NetMsg &msg, const ntlp::mri *m) 
+{
+	const ntlp::mri_pathcoupled *pc 
+		= dynamic_cast<const ntlp::mri_pathcoupled *>(m);
+
+	if ( pc == NULL )
+		return false;
+
+	save_part(msg, pc);
+
+	return true;
+}
+
+
+ntlp::mri_pathcoupled *
+session::restore_mri(NetMsg &msg) 
+{
+	NetMsg *part = take_part(msg);
+
+	if ( part == NULL )
+		return NULL;
+
+	ntlp::mri_pathcoupled *m = new ntlp::mri_pathcoupled();
+
+	IEErrorList errlist;
+	uint32 bytes_read;
+
+	if ( m->deserialize(*part, IE::protocol_v1, errlist, bytes_read, 
+						false) == NULL ) {
+		delete m;
+		m = NULL;
+	}
+
+	delete part;
+
+	return m;
+}
+
+
+/**
+ * Save the objects of the rule together with their keys, which are 
+ * shared with the auction application.
+ */
+void 
+session::save_rule(NetMsg &msg, const auction_rule *r) 
+{
+	save_objects(msg, r->get_request_objects());
+	save_objects(msg, r->get_response_objects());
+}
+
+
+auction_rule *
+session::restore_rule(NetMsg &msg) 
+{
+	auction_rule *r = new auction_rule();
+
+	if ( ! restore_objects(msg, r, false) || ! restore_objects(msg, r, true) ) {
+		delete r;
+		return NULL;
+	}
+
+	return r;
+}
+
+
+/**
+ * Save a message, which may be NULL.
+ */
+bool 
+session::save_message(NetMsg &msg, const msg::ntlp_msg *m) 
+{
+	msg.encode32( m != NULL );
+
+	if ( m == NULL )
+		return true;
+
+	protlib::uint128 sid = m->get_session_id().get_id();
+	msg.encode32(sid.w1);
+	msg.encode32(sid.w2);
+	msg.encode32(sid.w3);
+	msg.encode32(sid.w4);
+	msg.encode32(m->get_sii_handle());
+
+	if ( ! save_mri(msg, m->get_mri()) )
+		return false;
+
+	save_part(msg, m->get_anslp_msg());
+
+	return true;
+}
+
+
+bool 
+session::restore_message(NetMsg &msg, msg::ntlp_msg *&m) 
+{
+	m = NULL;
+
+	if ( msg.decode32() == 0 )
+		return true;
+
+	protlib::uint128 sid;
+	sid.w1 = msg.decode32();
+	sid.w2 = msg.decode32();
+	sid.w3 = msg.decode32();
+	sid.w4 = msg.decode32();
+	uint32 sii_handle = msg.decode32();
+
+	ntlp::mri_pathcoupled *routing_info = restore_mri(msg);
+	if ( routing_info == NULL )
+		return false;
+
+	IE *ie = restore_part(msg, cat_anslp_msg);
+	msg::anslp_msg *body = dynamic_cast<msg::anslp_msg *>(ie);
+
+	if ( body == NULL ) {
+		delete ie;
+		delete routing_info;
+		return false;
+	}
+
+	m = new msg::ntlp_msg(session_id(sid), body, routing_info, sii_handle);
+
+	return true;
+}
@@ -27,11 +27,11 @@
 //
 // ===========================================================
 #include <assert.h>
-#include <openssl/rand.h>
 #include <iostream>
 #include "logfile.h"
 
 #include "session.h"
+#include "id_generator.h"
 // #include "dispatcher.h"
 
 
@@ -43,14 +43,12 @@ using namespace protlib::log;
  * Constructor.
  *
  * Initializes this object with a random 128 Bit session ID. The random
- * numbers used are cryptographically strong (according to OpenSSL's docs).
+ * numbers used are cryptographically strong (according to OpenSSL's docs),
+ * they are taken from the per-thread pool kept by id_generator.
  */
 session_id::session_id() 
 {
-	// Use OpenSSL's cryptographically strong random numbers.
-	int ret = RAND_bytes((unsigned char *) &id, sizeof(id));
-
-	assert( ret == 1 );
+	id_generator::generate(id);
 }
 
 session_id::session_id(string sessionId)
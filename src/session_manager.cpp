@@ -33,6 +33,10 @@
 
 #include "session.h"
 #include "session_manager.h"
+#include "netmsg_pool.h"
+#include "profiled_mutex_lockable.h"
+#include "spin_park_lockable.h"
+#include "rw_lockable.h"
 
 
 #include <pthread.h>
@@ -58,9 +62,18 @@ using protlib::uint32;
 
 /**
  * Contructor.
+ *
+ * New sessions get the configured lock strategy. If lock profiling is 
+ * configured, the session table lock and the locks of the sessions 
+ * created record their wait and hold times instead.
  */
-session_manager::session_manager(anslp_config *conf)
-		: config(conf), session_table(SESSION_TABLE_SIZE) 
+session_manager::session_manager(anslp_config *conf, session_store *store)
+		: config(conf), store(store), session_table(SESSION_TABLE_SIZE),
+		  lock_type(lt_mutex), lock_spins(spin_park_lockable::DEFAULT_MAX_SPINS),
+		  profiling(conf != NULL && conf->get_lock_profiling()),
+		  table_profile("session_table"), ni_profile("ni_session"),
+		  nf_profile("nf_session"), nr_profile("nr_session"),
+		  table_locked_ns(0)
 {
 
 	pthread_mutexattr_t mutex_attr;
@@ -76,6 +89,19 @@ session_manager::session_manager(anslp_config *conf)
 	pthread_mutex_init(&mutex, &mutex_attr);
 
 	pthread_mutexattr_destroy(&mutex_attr); // valid, doesn't affect mutex
+
+	if ( conf != NULL ) {
+		std::string type = conf->get_session_lock();
+
+		if ( type == "spin" )
+			lock_type = lt_spin;
+		else if ( type == "rwlock" )
+			lock_type = lt_rwlock;
+		else if ( type != "mutex" )
+			LogWarn("unknown session lock " << type << ", using a mutex");
+
+		lock_spins = conf->get_session_lock_spins();
+	}
 }
 
 
@@ -118,9 +144,10 @@ ni_session *session_manager::create_ni_session()
 	ni_session *s;
 
 	install_cleanup_handler(&mutex);
-	pthread_mutex_lock(&mutex);
+	lock_table();
 
-	s = new ni_session(create_unique_id(), config);
+	s = new ni_session(create_unique_id(), config, 
+					   create_lock(ni_profile));
 	session_table[s->get_id()] = s;
 
 	LogInfo("created new NI session " << s->get_id().to_string());
@@ -130,7 +157,7 @@ ni_session *session_manager::create_ni_session()
             " tid:" <<  syscall(SYS_gettid) );
 
 
-	pthread_mutex_unlock(&mutex);
+	unlock_table();
 	uninstall_cleanup_handler();
 
 	return s;
@@ -145,14 +172,15 @@ nf_session *session_manager::create_nf_session(const session_id &sid)
 	nf_session *s;
 
 	install_cleanup_handler(&mutex);
-	pthread_mutex_lock(&mutex);
+	lock_table();
 
-	s = new nf_session(sid, config);
+	s = new nf_session(sid, config, 
+					   create_lock(nf_profile));
 	session_table[s->get_id()] = s;
 
 	LogInfo("created new NF session " << s->get_id());
 
-	pthread_mutex_unlock(&mutex);
+	unlock_table();
 	uninstall_cleanup_handler();
 
 	return s;
@@ -167,14 +195,15 @@ nr_session *session_manager::create_nr_session(const session_id &sid)
 	nr_session *s;
 
 	install_cleanup_handler(&mutex);
-	pthread_mutex_lock(&mutex);
+	lock_table();
 
-	s = new nr_session(sid, config);
+	s = new nr_session(sid, config, 
+					   create_lock(nr_profile));
 	session_table[s->get_id()] = s;
 
 	LogInfo("created new NR session " << s->get_id());
 
-	pthread_mutex_unlock(&mutex);
+	unlock_table();
 	uninstall_cleanup_handler();
 
 	return s;
@@ -203,14 +232,14 @@ session *session_manager::get_session(const session_id &sid)
 	session *s = NULL;
 
 	install_cleanup_handler(&mutex);
-	pthread_mutex_lock(&mutex);
+	lock_table();
 
 	c_iter i = session_table.find(sid);
 		
 	if ( i != session_table.end() )
 		s = i->second;
 
-	pthread_mutex_unlock(&mutex);
+	unlock_table();
 	uninstall_cleanup_handler();
 
 	return s;
@@ -223,44 +252,239 @@ session *session_manager::get_session(const session_id &sid)
  * Remove the session with the given session ID from the session table. If
  * there is no session with this ID, NULL is returned.
  *
- * The returned session itself is *not* deleted.
+ * The returned session is retired: it is deleted as soon as no thread
+ * can observe it anymore, so callers may only use it inside their current
+ * critical section.
  *
  * @param sid a session ID
  * @return the session, or NULL if it isn't found
  */
 session *session_manager::remove_session(const session_id &sid) 
 {
-	session *s;
+	session *s = NULL;
 
 	install_cleanup_handler(&mutex);
-	pthread_mutex_lock(&mutex);
+	lock_table();
 
-	s = session_table[sid];
+	hash_map<session_id, session *>::iterator i = session_table.find(sid);
 
-	// Note: session_table[sid] creates a session if none existed before
-	session_table.erase(sid);
+	if ( i != session_table.end() ) {
+		s = i->second;
+		session_table.erase(i);
 
-	LogInfo("removed session " << s->get_id());
-	
-	store_session_asdone(s);
+		LogInfo("removed session " << s->get_id());
+	}
 	
-	pthread_mutex_unlock(&mutex);
+	unlock_table();
 	uninstall_cleanup_handler();
 
+	if ( s != NULL && has_store() )
+		store->erase(sid);
+
+	epochs.retire(s);
+
 	return s; // either the session or NULL
 }
 
 
-/* -------------------- storeBidAsDone -------------------- */
+/**
+ * Write the state of a session to the session store, if there is one.
+ *
+ * The caller has to hold the session's lock. A session that doesn't save
+ * its state, for example because it is still being set up, is removed 
+ * from the store. Sessions the last event didn't change aren't serialized
+ * again, see session::get_state_mark().
+ */
+void session_manager::save_session(const session *s) 
+{
+	assert( s != NULL );
+
+	if ( ! has_store() || ! s->has_unsaved_changes() )
+		return;
+
+	NetMsg *msg = netmsg_pool::acquire(session_store::MAX_RECORD_SIZE);
+	bool saved = false;
+	bool too_large = false;
+
+	try {
+		msg->encode32(s->get_session_type());
+		saved = s->save_state(*msg);
+	}
+	catch ( ... ) {
+		too_large = true;
+	}
+
+	if ( too_large ) {
+		LogWarn("state of session " << s->get_id() << " exceeds " 
+			<< session_store::MAX_RECORD_SIZE << " bytes, not saved");
+		store->reject(s->get_id());
+		s->set_saved(true); // the same state won't fit next time either
+	}
+	else if ( ! saved ) {
+		store->erase(s->get_id());
+		s->set_saved(true);
+	}
+	else if ( store->put(s->get_id(), msg->get_buffer(), msg->get_pos()) )
+		s->set_saved(true);
+	else {
+		LogWarn("unable to save session " << s->get_id());
+		s->set_saved(false); // try again after the next event
+	}
+
+	netmsg_pool::release(msg);
+}
 
-void session_manager::store_session_asdone(session *s)
+
+/**
+ * Restore the sessions saved in the session store.
+ *
+ * This has to be called before the dispatchers start. The timers of the
+ * sessions are started using the given dispatcher, so they go off when
+ * they would have without the restart. Saved states that can't be used 
+ * are removed from the store.
+ *
+ * @param d a dispatcher for starting the timers
+ * @return the number of sessions restored
+ */
+uint32 session_manager::restore_sessions(dispatcher *d) 
+{
+	if ( ! has_store() )
+		return 0;
+
+	session_store::record_list_t records;
+	store->get_records(records);
+
+	uint32 num_restored = 0;
+
+	for ( session_store::record_list_t::iterator i = records.begin();
+			i != records.end(); i++ ) {
+
+		NetMsg msg((uchar *) i->second.data(), i->second.size());
+		session *s = NULL;
+		bool restored = false;
+
+		try {
+			switch ( msg.decode32() ) {
+				case session::st_initiator:
+					s = new ni_session(i->first, config,
+										   create_lock(ni_profile));
+					break;
+				case session::st_forwarder:
+					s = new nf_session(i->first, config,
+										   create_lock(nf_profile));
+					break;
+				case session::st_receiver:
+					s = new nr_session(i->first, config,
+										   create_lock(nr_profile));
+					break;
+			}
+
+			if ( s != NULL )
+				restored = s->restore_state(d, msg);
+		}
+		catch ( ... ) {
+			// the saved state is truncated
+		}
+
+		if ( ! restored ) {
+			LogWarn("unable to restore session " << i->first);
+			store->erase(i->first);
+			delete s;
+			continue;
+		}
+
+		install_cleanup_handler(&mutex);
+		lock_table();
+
+		session_table[s->get_id()] = s;
+
+		unlock_table();
+		uninstall_cleanup_handler();
+
+		LogInfo("restored session " << s->get_id());
+		num_restored++;
+	}
+
+	return num_restored;
+}
+
+
+/**
+ * Return the lock profiles, empty if lock profiling isn't configured.
+ */
+std::vector<lock_profile_stats> session_manager::get_lock_profiles() const
+{
+	std::vector<lock_profile_stats> profiles;
+
+	if ( profiling ) {
+		profiles.push_back(table_profile.get_stats());
+		profiles.push_back(ni_profile.get_stats());
+		profiles.push_back(nf_profile.get_stats());
+		profiles.push_back(nr_profile.get_stats());
+	}
+
+	return profiles;
+}
+
+
+/**
+ * Lock the session table, recording the wait if profiling is configured.
+ */
+void session_manager::lock_table()
+{
+	if ( ! profiling ) {
+		pthread_mutex_lock(&mutex);
+		return;
+	}
+
+	if ( pthread_mutex_trylock(&mutex) == 0 ) {
+		table_locked_ns = lock_profile::now_ns();
+		table_profile.record_acquire(0, false);
+		return;
+	}
+
+	uint64_t start = lock_profile::now_ns();
+	pthread_mutex_lock(&mutex);
+
+	table_locked_ns = lock_profile::now_ns();
+	table_profile.record_acquire(table_locked_ns - start, true);
+}
+
+
+/**
+ * Unlock the session table, recording the hold time if profiling is
+ * configured.
+ */
+void session_manager::unlock_table()
+{
+	if ( ! profiling ) {
+		pthread_mutex_unlock(&mutex);
+		return;
+	}
+
+	uint64_t held = lock_profile::now_ns() - table_locked_ns;
+	pthread_mutex_unlock(&mutex);
+
+	table_profile.record_release(held);
+}
+
+
+/**
+ * Create the lock of a new session.
+ *
+ * @return the configured lock or NULL for the session's default mutex
+ */
+lock *session_manager::create_lock(lock_profile &profile)
 {
-    
-    sessionDone.push_back(s);
-
-    if (sessionDone.size() > DONE_SESSION_LIST_SIZE) {
-        // remove session
-        saveDelete(sessionDone.front());
-        sessionDone.pop_front();
-    }
+	if ( profiling )
+		return new lock(new profiled_mutex_lockable(&profile));
+
+	switch ( lock_type ) {
+		case lt_spin:
+			return new lock(new spin_park_lockable(lock_spins));
+		case lt_rwlock:
+			return new lock(new rw_lockable());
+		default:
+			return NULL;
+	}
 }
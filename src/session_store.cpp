@@ -0,0 +1,500 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file session_store.cpp
+/// Memory-mapped store of session snapshots.
+/// ----------------------------------------------------------
+/// $Id: session_store.cpp 2558 2016-04-15 09:40:00 amarentes $
+/// $HeadURL: https://./src/session_store.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "session_store.h"
+
+
+using namespace anslp;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * The store is closed until open() is called.
+ */
+session_store::session_store()
+		: fd(-1), base(NULL), mapped_size(0), num_slots(0), sequence(0) 
+{
+	assert( sizeof(slot_header_t) + MAX_RECORD_SIZE == SLOT_SIZE );
+
+	pthread_mutex_init(&mutex, NULL);
+
+	stats.writes = 0;
+	stats.unchanged = 0;
+	stats.erased = 0;
+	stats.rejected = 0;
+}
+
+
+/**
+ * Destructor.
+ */
+session_store::~session_store() 
+{
+	close();
+
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Open the given file and map it into memory.
+ *
+ * A file with a different layout is reinitialized, the snapshots it 
+ * contains are lost. On failure, errno tells why and the store stays
+ * closed.
+ *
+ * @param filename the path of the file, it is created if necessary
+ * @param num_slots the maximum number of sessions stored
+ * @return true if the store could be opened
+ */
+bool session_store::open(const std::string &filename, uint32 num_slots) 
+{
+	assert( ! is_open() );
+	assert( num_slots > 0 );
+
+	size_t size = sizeof(file_header_t) + (size_t) num_slots * SLOT_SIZE;
+	bool reinitialize = false;
+
+	fd = ::open(filename.c_str(), O_RDWR | O_CREAT, 0600);
+	if ( fd < 0 )
+		return false;
+
+	struct stat st;
+	if ( fstat(fd, &st) != 0 )
+		goto fail;
+
+	{
+		file_header_t header;
+		memset(&header, 0, sizeof(header));
+
+		if ( (size_t) st.st_size == size )
+			if ( pread(fd, &header, sizeof(header), 0) != sizeof(header) )
+				goto fail;
+
+		reinitialize = header.magic != FILE_MAGIC 
+			|| header.version != VERSION || header.slot_size != SLOT_SIZE 
+			|| header.num_slots != num_slots;
+	}
+
+	// Slots are allocated lazily, the file is sparse.
+	if ( reinitialize )
+		if ( ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0 )
+			goto fail;
+
+	base = (uchar *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, 
+						  fd, 0);
+	if ( base == MAP_FAILED ) {
+		base = NULL;
+		goto fail;
+	}
+
+	mapped_size = size;
+	this->num_slots = num_slots;
+
+	if ( reinitialize ) {
+		file_header_t *header = (file_header_t *) base;
+
+		header->magic = FILE_MAGIC;
+		header->version = VERSION;
+		header->slot_size = SLOT_SIZE;
+		header->num_slots = num_slots;
+	}
+
+	recover();
+
+	return true;
+
+  fail:
+	int saved_errno = errno;
+	::close(fd);
+	fd = -1;
+	errno = saved_errno;
+
+	return false;
+}
+
+
+/**
+ * Write all snapshots back to the file and unmap it.
+ */
+void session_store::close() 
+{
+	if ( ! is_open() )
+		return;
+
+	msync(base, mapped_size, MS_SYNC);
+	munmap(base, mapped_size);
+	::close(fd);
+
+	base = NULL;
+	fd = -1;
+	mapped_size = 0;
+	num_slots = 0;
+
+	slots.clear();
+	free_slots.clear();
+}
+
+
+/**
+ * Store the snapshot of a session, replacing the previous one.
+ *
+ * @param sid the session the snapshot belongs to
+ * @param data the snapshot
+ * @param length the length of the snapshot in bytes
+ * @return false if the snapshot is too large or the store is full
+ */
+bool session_store::put(const session_id &sid, const uchar *data, 
+						uint32 length) 
+{
+	assert( is_open() );
+	assert( data != NULL || length == 0 );
+
+	bool ret = true;
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	hash_map<session_id, uint32>::iterator i = slots.find(sid);
+	slot_header_t *old_slot = NULL;
+
+	if ( i != slots.end() ) {
+		old_slot = get_slot(i->second);
+
+		// Most events don't change a session's snapshot.
+		if ( old_slot->length == length 
+				&& memcmp(old_slot + 1, data, length) == 0 ) {
+			stats.unchanged++;
+			goto out;
+		}
+	}
+
+	/*
+	 * Drop the old snapshot if the new one is too large, the session 
+	 * must not be resumed from an outdated state.
+	 */
+	if ( length > MAX_RECORD_SIZE 
+			|| ( free_slots.empty() && old_slot == NULL ) ) {
+		if ( old_slot != NULL ) {
+			old_slot->magic = 0;
+			free_slots.push_back(i->second);
+			slots.erase(i);
+		}
+
+		stats.rejected++;
+		ret = false;
+		goto out;
+	}
+
+	{
+		/*
+		 * If the store is full, the old slot is overwritten. It is 
+		 * invalid while being written.
+		 */
+		uint32 slot;
+
+		if ( ! free_slots.empty() ) {
+			slot = free_slots.back();
+			free_slots.pop_back();
+		}
+		else {
+			slot = i->second;
+			old_slot->magic = 0;
+			old_slot = NULL;
+			__sync_synchronize();
+		}
+
+		slot_header_t *h = get_slot(slot);
+		protlib::uint128 id = sid.get_id();
+
+		memcpy(h + 1, data, length);
+		h->length = length;
+		h->sequence = ++sequence;
+		h->sid[0] = id.w1;
+		h->sid[1] = id.w2;
+		h->sid[2] = id.w3;
+		h->sid[3] = id.w4;
+		h->checksum = checksum(h, data);
+
+		// The slot becomes valid only after everything else is written.
+		__sync_synchronize();
+		h->magic = SLOT_MAGIC;
+
+		if ( old_slot != NULL ) {
+			__sync_synchronize();
+			old_slot->magic = 0;
+			free_slots.push_back(i->second);
+			i->second = slot;
+		}
+		else if ( i == slots.end() )
+			slots[sid] = slot;
+
+		stats.writes++;
+	}
+
+  out:
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+
+	return ret;
+}
+
+
+/**
+ * Count a snapshot that couldn't be created because it is too large.
+ *
+ * The previous snapshot of the session is dropped like in put(), the 
+ * session must not be resumed from an outdated state.
+ */
+void session_store::reject(const session_id &sid) 
+{
+	assert( is_open() );
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	hash_map<session_id, uint32>::iterator i = slots.find(sid);
+
+	if ( i != slots.end() ) {
+		get_slot(i->second)->magic = 0;
+		free_slots.push_back(i->second);
+		slots.erase(i);
+	}
+
+	stats.rejected++;
+
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+}
+
+
+/**
+ * Remove the snapshot of a session.
+ *
+ * @return true if there was a snapshot
+ */
+bool session_store::erase(const session_id &sid) 
+{
+	assert( is_open() );
+
+	bool found = false;
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	hash_map<session_id, uint32>::iterator i = slots.find(sid);
+
+	if ( i != slots.end() ) {
+		get_slot(i->second)->magic = 0;
+		free_slots.push_back(i->second);
+		slots.erase(i);
+
+		stats.erased++;
+		found = true;
+	}
+
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+
+	return found;
+}
+
+
+/**
+ * Append a copy of every stored snapshot to records.
+ */
+void session_store::get_records(record_list_t &records) const 
+{
+	assert( is_open() );
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	for ( hash_map<session_id, uint32>::const_iterator i = slots.begin();
+			i != slots.end(); i++ ) {
+		const slot_header_t *h = get_slot(i->second);
+
+		records.push_back(std::make_pair(i->first, 
+			std::string((const char *) (h + 1), h->length)));
+	}
+
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+}
+
+
+/**
+ * Return the number of sessions stored.
+ */
+uint32 session_store::size() const 
+{
+	uint32 ret;
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	ret = slots.size();
+
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+
+	return ret;
+}
+
+
+session_store_stats session_store::get_stats() const 
+{
+	session_store_stats ret;
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	ret = stats;
+
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+
+	return ret;
+}
+
+
+session_store::slot_header_t *session_store::get_slot(uint32 slot) const 
+{
+	assert( slot < num_slots );
+
+	return (slot_header_t *) 
+		(base + sizeof(file_header_t) + (size_t) slot * SLOT_SIZE);
+}
+
+
+bool session_store::is_valid(const slot_header_t *h) const 
+{
+	return h->magic == SLOT_MAGIC && h->length <= MAX_RECORD_SIZE 
+		&& h->checksum == checksum(h, (const uchar *) (h + 1));
+}
+
+
+/**
+ * Rebuild the slot index from the file.
+ *
+ * Damaged slots are released. If a session has two slots because the
+ * daemon died while replacing its snapshot, the newer one is kept.
+ */
+void session_store::recover() 
+{
+	slots.clear();
+	free_slots.clear();
+	sequence = 0;
+
+	for ( uint32 slot = num_slots; slot-- > 0; ) {
+		slot_header_t *h = get_slot(slot);
+
+		if ( ! is_valid(h) ) {
+			// Writing to a slot never used would allocate its page.
+			if ( h->magic != 0 )
+				h->magic = 0;
+			free_slots.push_back(slot);
+			continue;
+		}
+
+		protlib::uint128 id;
+		id.w1 = h->sid[0];
+		id.w2 = h->sid[1];
+		id.w3 = h->sid[2];
+		id.w4 = h->sid[3];
+		session_id sid(id);
+
+		if ( (int32_t) (h->sequence - sequence) > 0 )
+			sequence = h->sequence;
+
+		hash_map<session_id, uint32>::iterator i = slots.find(sid);
+
+		if ( i == slots.end() ) {
+			slots[sid] = slot;
+			continue;
+		}
+
+		// Keep the newer of the two snapshots.
+		slot_header_t *other = get_slot(i->second);
+
+		if ( (int32_t) (h->sequence - other->sequence) > 0 ) {
+			other->magic = 0;
+			free_slots.push_back(i->second);
+			i->second = slot;
+		}
+		else {
+			h->magic = 0;
+			free_slots.push_back(slot);
+		}
+	}
+}
+
+
+/**
+ * Return a checksum (FNV-1a) of a slot's header fields and its data.
+ */
+uint32 session_store::checksum(const slot_header_t *h, const uchar *data) 
+{
+	uint32 hash = 2166136261u;
+	uint32 fields[6] = { h->length, h->sequence, 
+						 h->sid[0], h->sid[1], h->sid[2], h->sid[3] };
+
+	const uchar *p = (const uchar *) fields;
+	for ( uint32 i = 0; i < sizeof(fields); i++ )
+		hash = (hash ^ p[i]) * 16777619u;
+
+	for ( uint32 i = 0; i < h->length; i++ )
+		hash = (hash ^ data[i]) * 16777619u;
+
+	return hash;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, 
+								const session_store_stats &s) 
+{
+	return out << "writes=" << s.writes << ", unchanged=" << s.unchanged
+		<< ", erased=" << s.erased << ", rejected=" << s.rejected;
+}
+
+// EOF
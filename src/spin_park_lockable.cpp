@@ -0,0 +1,115 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file spin_park_lockable.cpp
+/// A lockable that spins briefly before it blocks.
+/// ----------------------------------------------------------
+/// $Id: spin_park_lockable.cpp 2558 2016-04-20 11:00:00 amarentes $
+/// $HeadURL: https://./src/spin_park_lockable.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+
+#include <errno.h>
+#include <stdint.h>
+
+#include "spin_park_lockable.h"
+
+using namespace anslp;
+
+
+// Tell the CPU we are spinning, so it doesn't starve its sibling thread.
+static inline void cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__ ("pause" ::: "memory");
+#else
+	__sync_synchronize();
+#endif
+}
+
+
+spin_park_lockable::spin_park_lockable (uint32 max_spins)
+		: max_spins(max_spins), spin_estimate(0)
+{
+
+	pthread_mutexattr_t mutex_attr;
+
+	pthread_mutexattr_init(&mutex_attr);
+
+#ifdef _DEBUG
+	pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_ERRORCHECK);
+#else
+	pthread_mutexattr_settype(&mutex_attr, PTHREAD_MUTEX_NORMAL);
+#endif
+
+	pthread_mutex_init(&mutex, &mutex_attr);
+
+	pthread_mutexattr_destroy(&mutex_attr); // valid, doesn't affect mutex
+
+}
+
+spin_park_lockable::~spin_park_lockable()
+{
+	pthread_mutex_destroy(&mutex);
+}
+
+
+int spin_park_lockable::acquire(void)
+{
+	if ( pthread_mutex_trylock(&mutex) == 0 )
+		return 0;
+
+	// Spin a little longer than recently needed, the estimate may be stale.
+	uint32 limit = 2 * spin_estimate + 10;
+	if ( limit > max_spins )
+		limit = max_spins;
+
+	uint32 spins = 0;
+	int ret = EBUSY;
+
+	while ( spins < limit && ret != 0 ) {
+		cpu_relax();
+		spins++;
+		ret = pthread_mutex_trylock(&mutex);
+	}
+
+	if ( ret != 0 ) {
+		ret = pthread_mutex_lock(&mutex);
+		assert( ret == 0 );
+	}
+
+	// We hold the lock, so nobody else writes the estimate.
+	int32_t delta = (int32_t) spins - (int32_t) spin_estimate;
+	spin_estimate = (uint32) ( (int32_t) spin_estimate + delta / 8 );
+	
+	return ret;
+}
+
+
+int spin_park_lockable::release(void)
+{
+	int ret;
+
+	ret = pthread_mutex_unlock(&mutex);
+	assert( ret == 0 );
+	
+	return ret;
+}
@@ -0,0 +1,282 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file summary_refresh_collector.cpp
+/// The summary_refresh_collector class.
+/// ----------------------------------------------------------
+/// $Id: summary_refresh_collector.cpp 2558 2016-03-17 15:20:00 amarentes $
+/// $HeadURL: https://./src/summary_refresh_collector.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <assert.h>
+#include <sstream>
+
+#include "logfile.h"
+#include "mri_pc.h"	// from NTLP
+
+#include "summary_refresh_collector.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+using namespace protlib::log;
+
+
+#define LogError(msg) ERRLog("summary_refresh_collector", msg)
+#define LogWarn(msg) WLog("summary_refresh_collector", msg)
+#define LogInfo(msg) ILog("summary_refresh_collector", msg)
+#define LogDebug(msg) DLog("summary_refresh_collector", msg)
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * Constructor.
+ *
+ * @param max_sessions maximum number of sessions in one summary refresh
+ * @param max_delay_ms maximum time a refresh waits for others (in ms)
+ */
+summary_refresh_collector::summary_refresh_collector(uint32 max_sessions, 
+													 uint32 max_delay_ms)
+		: max_sessions(max_sessions), max_delay_ms(max_delay_ms) 
+{
+	if ( this->max_sessions > session_refresh_list::MAX_ENTRIES )
+		this->max_sessions = session_refresh_list::MAX_ENTRIES;
+	
+	pthread_mutex_init(&mutex, NULL);
+}
+
+
+/**
+ * Destructor.
+ *
+ * Deletes all pending refreshes without sending them.
+ */
+summary_refresh_collector::~summary_refresh_collector() 
+{
+	for ( batch_map_t::iterator i = batches.begin(); i != batches.end(); i++ ) {
+		delete i->second.first;
+		delete i->second.summary;
+	}
+
+	pthread_mutex_destroy(&mutex);
+}
+
+
+/**
+ * Compute the key of the peer a message is sent to.
+ *
+ * @return false if the peer can't be determined
+ */
+bool summary_refresh_collector::get_peer_key(const ntlp_msg *msg, 
+											 std::string &key)
+{
+	return get_peer_key(msg->get_mri(), msg->get_sii_handle(), key);
+}
+
+
+/**
+ * Compute the key of the peer reached using the given MRI and SII handle.
+ *
+ * @param mri the MRI of the session
+ * @param sii_handle the SII handle or 0 if GIST didn't tell us one
+ * @param key the resulting key
+ * @return false if the peer can't be determined
+ */
+bool summary_refresh_collector::get_peer_key(const ntlp::mri *mri, 
+							uint32 sii_handle, std::string &key)
+{
+	std::ostringstream o;
+	
+	if ( sii_handle != 0 ) {
+		o << "sii:" << sii_handle;
+	} else {
+		const ntlp::mri_pathcoupled *pc_mri 
+			= dynamic_cast<const ntlp::mri_pathcoupled *>(mri);
+
+		if ( pc_mri == NULL )
+			return false;
+		
+		o << "pc:" << pc_mri->get_destaddress() 
+		  << ":" << pc_mri->get_downstream();
+	}
+	
+	key = o.str();
+	return true;
+}
+
+
+/**
+ * Turn a batch into the message to send.
+ */
+ntlp_msg *summary_refresh_collector::release(batch_t &batch) 
+{
+	// Nothing was merged, send the original REFRESH.
+	if ( batch.summary == NULL )
+		return batch.first;
+
+	ntlp_msg *msg = new ntlp_msg(batch.first->get_session_id(), 
+		batch.summary, batch.first->get_mri()->copy(), 
+		batch.first->get_sii_handle());
+
+	delete batch.first;
+	
+	return msg;
+}
+
+
+/**
+ * Check whether add() would take the given message.
+ *
+ * Callers that hold a serialized form of the message use this to copy
+ * the message only if it goes into a batch.
+ */
+bool summary_refresh_collector::collects(const ntlp_msg *msg) const 
+{
+	std::string key;
+
+	return msg->get_anslp_refresh() != NULL && max_sessions >= 2 
+		&& get_peer_key(msg, key);
+}
+
+
+/**
+ * Add a message to the batch of its peer.
+ *
+ * Only REFRESH messages are collected. If the message is taken, the 
+ * collector becomes its owner. Batches that became full are appended to
+ * ready and have to be sent by the caller.
+ *
+ * @param msg the message to send
+ * @param ready returns the messages to send right away
+ * @return true if the message was taken, false if the caller sends it
+ */
+bool summary_refresh_collector::add(ntlp_msg *msg, 
+									std::vector<ntlp_msg *> &ready) 
+{
+	assert( msg != NULL );
+
+	anslp_refresh *refresh = msg->get_anslp_refresh();
+	std::string key;
+	
+	if ( refresh == NULL || max_sessions < 2 || ! get_peer_key(msg, key) )
+		return false;
+	
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	batch_map_t::iterator i = batches.find(key);
+
+	if ( i == batches.end() ) {
+		batch_t batch;
+		batch.first = msg;
+		batch.summary = NULL;
+		clock_gettime(CLOCK_MONOTONIC, &batch.started);
+		batches[key] = batch;
+	} 
+	else {
+		batch_t &batch = i->second;
+		
+		if ( batch.summary == NULL ) {
+			anslp_refresh *first = batch.first->get_anslp_refresh();
+			
+			batch.summary = new anslp_summary_refresh();
+			batch.summary->add_session(
+				batch.first->get_session_id().get_id(), 
+				first->get_msg_sequence_number(), 
+				first->get_session_lifetime());
+		}
+		
+		batch.summary->add_session(msg->get_session_id().get_id(),
+			refresh->get_msg_sequence_number(), 
+			refresh->get_session_lifetime());
+
+		delete msg;
+
+		if ( batch.summary->get_num_sessions() >= max_sessions ) {
+			LogDebug("summary refresh for " << key << " is full");
+			ready.push_back(release(batch));
+			batches.erase(i);
+		}
+	}
+	
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+
+	return true;
+}
+
+
+/**
+ * Release batches that waited long enough.
+ *
+ * @param all release all batches, no matter how long they waited
+ * @param ready returns the messages to send
+ */
+void summary_refresh_collector::flush(bool all, 
+									  std::vector<ntlp_msg *> &ready) 
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	install_cleanup_handler(&mutex);
+	pthread_mutex_lock(&mutex);
+
+	batch_map_t::iterator i = batches.begin();
+	while ( i != batches.end() ) {
+		
+		batch_t &batch = i->second;
+		
+		long waited_ms = (now.tv_sec - batch.started.tv_sec) * 1000 
+			+ (now.tv_nsec - batch.started.tv_nsec) / 1000000;
+
+		if ( all || waited_ms >= (long) max_delay_ms ) {
+			ready.push_back(release(batch));
+			batches.erase(i++);
+		} else {
+			i++;
+		}
+	}
+	
+	pthread_mutex_unlock(&mutex);
+	uninstall_cleanup_handler();
+}
+
+
+/**
+ * Return the number of peers with refreshes waiting.
+ */
+size_t summary_refresh_collector::get_num_pending() const 
+{
+	size_t ret;
+	
+	pthread_mutex_lock(&mutex);
+	ret = batches.size();
+	pthread_mutex_unlock(&mutex);
+
+	return ret;
+}
+
+// EOF
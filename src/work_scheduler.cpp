@@ -0,0 +1,429 @@
+/// ----------------------------------------*- mode: C++; -*--
+/// @file work_scheduler.cpp
+/// Per-worker deques of session batches with work stealing.
+/// ----------------------------------------------------------
+/// $Id: work_scheduler.cpp 2558 2016-04-23 10:00:00 amarentes $
+/// $HeadURL: https://./src/work_scheduler.cpp $
+// ===========================================================
+//                      
+// Copyright (C) 2012-2014, all rights reserved by
+// - System and Computing Engineering, Universidad de los Andes
+//
+// More information and contact:
+// https://www.uniandes.edu.co/
+//                      
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; version 2 of the License
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License along
+// with this program; if not, write to the Free Software Foundation, Inc.,
+// 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+//
+// ===========================================================
+#include <time.h>
+#include <errno.h>
+#include <assert.h>
+
+#include "events.h"
+#include "work_scheduler.h"
+
+
+using namespace anslp;
+
+
+#define install_cleanup_handler(m) \
+    pthread_cleanup_push((void (*)(void *)) pthread_mutex_unlock, (void *) m)
+
+#define uninstall_cleanup_handler()	pthread_cleanup_pop(0);
+
+
+/**
+ * The queued events of one session, or one event without a session.
+ */
+struct work_scheduler::batch {
+	batch(const session_id *s) : sid(s != NULL ? new session_id(*s) : NULL) { }
+	~batch() { delete sid; }
+
+	session_id *sid;
+	std::deque<event *> events;
+};
+
+
+/**
+ * Constructor.
+ *
+ * @param num_workers the number of dispatcher threads
+ */
+work_scheduler::work_scheduler(uint32 num_workers)
+		: num_workers(num_workers), num_registered(0), next_worker(0),
+		  num_queued(0), num_waiting(0), ingress_running(0)
+{
+	if ( this->num_workers == 0 )
+		this->num_workers = 1;
+
+	stats.pushed = 0;
+	stats.batches = 0;
+	stats.stolen = 0;
+
+	shards = new shard_t[NUM_SHARDS];
+
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ )
+		pthread_mutex_init(&shards[i].mutex, NULL);
+
+	workers = new worker_t[this->num_workers];
+
+	for ( uint32 i = 0; i < this->num_workers; i++ ) {
+		pthread_mutex_init(&workers[i].mutex, NULL);
+		workers[i].size = 0;
+	}
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+
+	pthread_mutex_init(&wait_mutex, NULL);
+	pthread_cond_init(&wakeup, &attr);
+
+	pthread_condattr_destroy(&attr);
+}
+
+
+/**
+ * Destructor.
+ *
+ * Deletes all queued events. No batch may be processed anymore.
+ */
+work_scheduler::~work_scheduler() 
+{
+	for ( uint32 i = 0; i < num_workers; i++ ) {
+		std::deque<batch *> &batches = workers[i].batches;
+
+		for ( std::deque<batch *>::iterator b = batches.begin(); 
+				b != batches.end(); b++ ) {
+			for ( std::deque<event *>::iterator e = (*b)->events.begin();
+					e != (*b)->events.end(); e++ )
+				delete *e;
+
+			delete *b;
+		}
+
+		pthread_mutex_destroy(&workers[i].mutex);
+	}
+
+	for ( uint32 i = 0; i < NUM_SHARDS; i++ )
+		pthread_mutex_destroy(&shards[i].mutex);
+
+	pthread_cond_destroy(&wakeup);
+	pthread_mutex_destroy(&wait_mutex);
+
+	delete[] workers;
+	delete[] shards;
+}
+
+
+/**
+ * Return the number of the calling dispatcher thread.
+ *
+ * Each thread calls this once, before using pop() or done().
+ */
+uint32 work_scheduler::register_worker() 
+{
+	return __sync_fetch_and_add(&num_registered, 1) % num_workers;
+}
+
+
+work_scheduler::shard_t &work_scheduler::get_shard(const session_id &sid) const
+{
+	return shards[__gnu_cxx::hash<session_id>()(sid) % NUM_SHARDS];
+}
+
+
+/**
+ * Queue an event.
+ *
+ * @param evt the event, it is owned by this object
+ */
+void work_scheduler::push(event *evt) 
+{
+	assert( evt != NULL );
+
+	const session_id *sid = evt->get_session_id();
+	batch *b = NULL;
+	uint32 worker;
+
+	__sync_fetch_and_add(&num_queued, 1);
+	__sync_fetch_and_add(&stats.pushed, 1);
+
+	if ( sid == NULL ) {
+		b = new batch(NULL);
+		b->events.push_back(evt);
+		worker = __sync_fetch_and_add(&next_worker, 1) % num_workers;
+	}
+	else {
+		size_t hash = __gnu_cxx::hash<session_id>()(*sid);
+		shard_t &shard = shards[hash % NUM_SHARDS];
+
+		pthread_mutex_lock(&shard.mutex);
+		install_cleanup_handler(&shard.mutex);
+
+		batch_table_t::iterator i = shard.batches.find(*sid);
+
+		if ( i != shard.batches.end() )
+			i->second->events.push_back(evt); // queued or processed
+		else {
+			b = new batch(sid);
+			b->events.push_back(evt);
+			shard.batches[*sid] = b;
+		}
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shard.mutex);
+
+		// The home thread of the session.
+		worker = ( hash / NUM_SHARDS ) % num_workers;
+	}
+
+	if ( b != NULL )
+		enqueue(worker, b);
+
+	if ( num_waiting > 0 ) {
+		pthread_mutex_lock(&wait_mutex);
+		pthread_cond_signal(&wakeup);
+		pthread_mutex_unlock(&wait_mutex);
+	}
+}
+
+
+/**
+ * Put a batch on the deque of a thread.
+ */
+void work_scheduler::enqueue(uint32 worker, batch *b) 
+{
+	worker_t &w = workers[worker];
+
+	pthread_mutex_lock(&w.mutex);
+	install_cleanup_handler(&w.mutex);
+
+	w.batches.push_back(b);
+	w.size = w.batches.size();
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&w.mutex);
+}
+
+
+/**
+ * Take the oldest batch from the deque of a thread.
+ *
+ * When stealing, a deque that another thread holds is skipped.
+ */
+work_scheduler::batch *work_scheduler::dequeue(uint32 worker, bool steal) 
+{
+	worker_t &w = workers[worker];
+	batch *b = NULL;
+
+	if ( w.size == 0 )
+		return NULL;
+
+	if ( steal ) {
+		if ( pthread_mutex_trylock(&w.mutex) != 0 )
+			return NULL;
+	}
+	else
+		pthread_mutex_lock(&w.mutex);
+
+	install_cleanup_handler(&w.mutex);
+
+	if ( ! w.batches.empty() ) {
+		b = w.batches.front();
+		w.batches.pop_front();
+		w.size = w.batches.size();
+	}
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&w.mutex);
+
+	return b;
+}
+
+
+/**
+ * Take a batch to process.
+ *
+ * The batch has to be passed to done() after its events are processed.
+ * Until then, no other thread gets events of the same session.
+ *
+ * @param worker the number of the calling thread
+ * @param events receives the events, the caller has to delete them
+ * @return the batch or NULL if there is no work
+ */
+work_scheduler::batch *work_scheduler::pop(uint32 worker, 
+		std::vector<event *> &events) 
+{
+	batch *b = dequeue(worker, false);
+
+	for ( uint32 i = 1; b == NULL && i < num_workers; i++ ) {
+		b = dequeue((worker + i) % num_workers, true);
+
+		if ( b != NULL )
+			__sync_fetch_and_add(&stats.stolen, 1);
+	}
+
+	if ( b == NULL )
+		return NULL;
+
+	__sync_fetch_and_add(&stats.batches, 1);
+
+	if ( b->sid == NULL ) {
+		events.assign(b->events.begin(), b->events.end());
+		b->events.clear();
+	}
+	else {
+		shard_t &shard = get_shard(*b->sid);
+
+		// Events may be appended until the lock is held.
+		pthread_mutex_lock(&shard.mutex);
+		install_cleanup_handler(&shard.mutex);
+
+		events.assign(b->events.begin(), b->events.end());
+		b->events.clear();
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shard.mutex);
+	}
+
+	__sync_fetch_and_sub(&num_queued, events.size());
+
+	return b;
+}
+
+
+/**
+ * Finish a batch returned by pop().
+ *
+ * If events of the session arrived meanwhile, the batch is put on the
+ * deque of the calling thread again.
+ *
+ * @param worker the number of the calling thread
+ * @param b the batch
+ */
+void work_scheduler::done(uint32 worker, batch *b) 
+{
+	assert( b != NULL );
+
+	bool requeue = false;
+
+	if ( b->sid != NULL ) {
+		shard_t &shard = get_shard(*b->sid);
+
+		pthread_mutex_lock(&shard.mutex);
+		install_cleanup_handler(&shard.mutex);
+
+		if ( b->events.empty() )
+			shard.batches.erase(*b->sid);
+		else
+			requeue = true;
+
+		uninstall_cleanup_handler();
+		pthread_mutex_unlock(&shard.mutex);
+	}
+
+	if ( requeue )
+		enqueue(worker % num_workers, b);
+	else
+		delete b;
+}
+
+
+/**
+ * Wait until an event is queued.
+ *
+ * @param timeout_ms the maximum time to wait
+ * @return true if there are queued events
+ */
+bool work_scheduler::wait(uint32 timeout_ms) 
+{
+	struct timespec deadline;
+	clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+	deadline.tv_sec += timeout_ms / 1000;
+	deadline.tv_nsec += (long) ( timeout_ms % 1000 ) * 1000000;
+
+	if ( deadline.tv_nsec >= 1000000000 ) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock(&wait_mutex);
+	install_cleanup_handler(&wait_mutex);
+
+	// Announce the wait before checking, push() signals after queueing.
+	__sync_fetch_and_add(&num_waiting, 1);
+
+	int err = 0;
+
+	while ( num_queued == 0 && err != ETIMEDOUT )
+		err = pthread_cond_timedwait(&wakeup, &wait_mutex, &deadline);
+
+	__sync_fetch_and_sub(&num_waiting, 1);
+
+	uninstall_cleanup_handler();
+	pthread_mutex_unlock(&wait_mutex);
+
+	return num_queued > 0;
+}
+
+
+/**
+ * Start moving events from the input queue to the scheduler.
+ *
+ * Only one dispatcher thread reads the input queue at a time, the others
+ * keep processing batches meanwhile.
+ *
+ * @return false if another thread does it already
+ */
+bool work_scheduler::begin_ingress() 
+{
+	return __sync_bool_compare_and_swap(&ingress_running, 0, 1);
+}
+
+
+/**
+ * End a run started using begin_ingress().
+ */
+void work_scheduler::end_ingress() 
+{
+	__sync_lock_release(&ingress_running);
+}
+
+
+/**
+ * Return a copy of the current counters.
+ */
+work_scheduler_stats work_scheduler::get_stats() const
+{
+	work_scheduler_stats s;
+
+	s.pushed = __sync_fetch_and_add(&stats.pushed, 0);
+	s.batches = __sync_fetch_and_add(&stats.batches, 0);
+	s.stolen = __sync_fetch_and_add(&stats.stolen, 0);
+
+	return s;
+}
+
+
+std::ostream &anslp::operator<<(std::ostream &out, 
+		const work_scheduler_stats &s)
+{
+	return out << "pushed=" << s.pushed << " batches=" << s.batches
+		<< " stolen=" << s.stolen;
+}
+
+
+// EOF
@@ -0,0 +1,185 @@
+/*
+ * Test the admission_control class.
+ *
+ * $Id: admission_control_test.cpp 2016-03-23 16:05:00 amarentes $
+ * $HeadURL: https://./test/admission_control_test.cpp $
+ */
+#include <vector>
+#include <unistd.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "events.h"
+#include "admission_control.h"
+
+using namespace anslp;
+
+
+/*
+ * An event that counts how often events are deleted.
+ */
+class counting_event : public event {
+  public:
+	counting_event(int *deleted) : event(), deleted(deleted) { }
+	
+	virtual ~counting_event() { (*deleted)++; }
+	
+  private:
+	int *deleted;
+};
+
+
+class AdmissionControlTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( AdmissionControlTest );
+
+	CPPUNIT_TEST( testAdmit );
+	CPPUNIT_TEST( testDeferAndResume );
+	CPPUNIT_TEST( testMaxDeferred );
+	CPPUNIT_TEST( testExpired );
+	CPPUNIT_TEST( testServiceTime );
+	CPPUNIT_TEST( testTriage );
+	CPPUNIT_TEST( testDestructor );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testAdmit();
+	void testDeferAndResume();
+	void testMaxDeferred();
+	void testExpired();
+	void testServiceTime();
+	void testTriage();
+	void testDestructor();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AdmissionControlTest );
+
+
+void AdmissionControlTest::testAdmit() {
+	admission_control ac(10, 100, 0, 0, 1);
+
+	CPPUNIT_ASSERT( ! ac.is_overloaded(5) );
+	CPPUNIT_ASSERT( ac.admit(5) == admission_control::ADMIT );
+	
+	CPPUNIT_ASSERT( ac.is_overloaded(10) );
+	CPPUNIT_ASSERT( ac.admit(10) == admission_control::DEFER );
+	CPPUNIT_ASSERT( ac.admit(100) == admission_control::SHED );
+
+	admission_stats stats = ac.get_stats();
+	CPPUNIT_ASSERT( stats.admitted == 1 );
+	CPPUNIT_ASSERT( stats.shed == 1 );
+}
+
+
+void AdmissionControlTest::testDeferAndResume() {
+	admission_control ac(10, 0, 0, 0, 1);
+	int deleted = 0;
+	std::vector<event *> expired;
+
+	event *e1 = new counting_event(&deleted);
+	event *e2 = new counting_event(&deleted);
+
+	CPPUNIT_ASSERT( ac.defer(e1) );
+	CPPUNIT_ASSERT( ac.defer(e2) );
+	CPPUNIT_ASSERT( ac.has_deferred() );
+	CPPUNIT_ASSERT( ac.get_num_deferred() == 2 );
+
+	// New session setups queue up behind the deferred ones.
+	CPPUNIT_ASSERT( ac.admit(0) == admission_control::DEFER );
+
+	CPPUNIT_ASSERT( ac.resume(20, expired) == NULL );
+	CPPUNIT_ASSERT( ac.resume(5, expired) == e1 );
+	CPPUNIT_ASSERT( ac.resume(5, expired) == e2 );
+	CPPUNIT_ASSERT( ac.resume(5, expired) == NULL );
+	CPPUNIT_ASSERT( expired.empty() );
+	CPPUNIT_ASSERT( ! ac.has_deferred() );
+
+	CPPUNIT_ASSERT( ac.admit(0) == admission_control::ADMIT );
+	CPPUNIT_ASSERT( ac.get_stats().resumed == 2 );
+
+	delete e1;
+	delete e2;
+	CPPUNIT_ASSERT( deleted == 2 );
+}
+
+
+void AdmissionControlTest::testMaxDeferred() {
+	admission_control ac(10, 0, 0, 2, 1);
+	int deleted = 0;
+	counting_event e1(&deleted), e2(&deleted), e3(&deleted);
+	std::vector<event *> expired;
+
+	CPPUNIT_ASSERT( ac.defer(&e1) );
+	CPPUNIT_ASSERT( ac.defer(&e2) );
+	CPPUNIT_ASSERT( ! ac.defer(&e3) );
+	CPPUNIT_ASSERT( ac.get_stats().shed == 1 );
+
+	CPPUNIT_ASSERT( ac.resume(0, expired) == &e1 );
+	CPPUNIT_ASSERT( ac.resume(0, expired) == &e2 );
+}
+
+
+void AdmissionControlTest::testExpired() {
+	admission_control ac(10, 0, 50, 0, 1);
+	int deleted = 0;
+	std::vector<event *> expired;
+
+	event *e1 = new counting_event(&deleted);
+	CPPUNIT_ASSERT( ac.defer(e1) );
+	
+	usleep(60 * 1000);
+
+	CPPUNIT_ASSERT( ac.resume(0, expired) == NULL );
+	CPPUNIT_ASSERT( expired.size() == 1 );
+	CPPUNIT_ASSERT( expired[0] == e1 );
+	CPPUNIT_ASSERT( ac.get_stats().expired == 1 );
+
+	delete e1;
+}
+
+
+/*
+ * The queueing delay estimated from the service time triggers deferring
+ * and shedding even if the queue depth thresholds are not reached.
+ */
+void AdmissionControlTest::testServiceTime() {
+	admission_control ac(0, 0, 1000, 0, 2);
+
+	for ( int i = 0; i < 100; i++ )
+		ac.record_service(10000);
+
+	// 100 events at 10 ms each, served by two threads.
+	CPPUNIT_ASSERT( ac.get_estimated_delay(100) == 500 );
+
+	CPPUNIT_ASSERT( ac.admit(50) == admission_control::ADMIT );
+	CPPUNIT_ASSERT( ac.admit(100) == admission_control::DEFER );
+	CPPUNIT_ASSERT( ac.admit(200) == admission_control::SHED );
+}
+
+
+void AdmissionControlTest::testTriage() {
+	admission_control ac(10, 0, 0, 0, 1);
+
+	CPPUNIT_ASSERT( ac.begin_triage() );
+	CPPUNIT_ASSERT( ! ac.begin_triage() );
+	ac.end_triage();
+	CPPUNIT_ASSERT( ac.begin_triage() );
+	ac.end_triage();
+}
+
+
+void AdmissionControlTest::testDestructor() {
+	int deleted = 0;
+
+	{
+		admission_control ac(10, 0, 0, 0, 1);
+		ac.defer(new counting_event(&deleted));
+		ac.defer(new counting_event(&deleted));
+	}
+
+	CPPUNIT_ASSERT( deleted == 2 );
+}
+
+// EOF
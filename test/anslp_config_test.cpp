@@ -0,0 +1,127 @@
+/*
+ * Test the configuration snapshots of the anslp_config class.
+ *
+ * $Id: anslp_config_test.cpp 2016-04-14 11:05:00 amarentes $
+ * $HeadURL: https://./test/anslp_config_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "anslp_config.h"
+
+#include "utils.h"
+
+using namespace anslp;
+
+
+class AnslpConfigTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( AnslpConfigTest );
+
+	CPPUNIT_TEST( testSnapshot );
+	CPPUNIT_TEST( testPublish );
+	CPPUNIT_TEST( testInstances );
+	CPPUNIT_TEST( testReloadRequest );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+
+	void testSnapshot();
+	void testPublish();
+	void testInstances();
+	void testReloadRequest();
+
+  private:
+	mock_anslp_config *conf;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AnslpConfigTest );
+
+
+void AnslpConfigTest::setUp() {
+	conf = new mock_anslp_config();
+}
+
+
+void AnslpConfigTest::tearDown() {
+	delete conf;
+}
+
+
+void AnslpConfigTest::testSnapshot() {
+	CPPUNIT_ASSERT( conf->get_snapshot() != NULL );
+
+	CPPUNIT_ASSERT( conf->get_nr_max_retries() 
+			== conf->getpar<uint32>(anslpconf_nr_max_retries) );
+	CPPUNIT_ASSERT( conf->get_auctioneer_server() 
+			== conf->getpar<string>(anslpconf_auctioneer_server) );
+	CPPUNIT_ASSERT( conf->get_install_auction_rules() 
+			== conf->getpar<bool>(anslpconf_install_auction_rules) );
+}
+
+
+/*
+ * Changing a parameter publishes a new snapshot.
+ */
+void AnslpConfigTest::testPublish() {
+	const anslp_config_snapshot *old = conf->get_snapshot();
+	const string old_server = conf->get_auctioneer_server();
+	uint32 retries = conf->get_nr_max_retries();
+
+	conf->setpar<string>(anslpconf_auctioneer_server, "192.168.0.10");
+	conf->setpar<uint32>(anslpconf_nr_max_retries, retries + 1);
+
+	CPPUNIT_ASSERT( conf->get_snapshot() != old );
+	CPPUNIT_ASSERT( conf->get_auctioneer_server() == "192.168.0.10" );
+	CPPUNIT_ASSERT( conf->get_nr_max_retries() == retries + 1 );
+
+	conf->setpar<string>(anslpconf_auctioneer_server, old_server);
+	conf->setpar<uint32>(anslpconf_nr_max_retries, retries);
+}
+
+
+/*
+ * Every instance has a snapshot of its own, only a few replaced ones
+ * are kept.
+ */
+void AnslpConfigTest::testInstances() {
+	anslp_config copy(*conf);
+	uint32 retries = conf->get_nr_max_retries();
+
+	CPPUNIT_ASSERT( copy.get_snapshot() != NULL );
+	CPPUNIT_ASSERT( copy.get_snapshot() != conf->get_snapshot() );
+	CPPUNIT_ASSERT( copy.get_nr_max_retries() == retries );
+
+	// The repository is shared, but only conf publishes the change.
+	conf->setpar<uint32>(anslpconf_nr_max_retries, retries + 1);
+	CPPUNIT_ASSERT( conf->get_nr_max_retries() == retries + 1 );
+	CPPUNIT_ASSERT( copy.get_nr_max_retries() == retries );
+
+	copy.publish_snapshot();
+	CPPUNIT_ASSERT( copy.get_nr_max_retries() == retries + 1 );
+
+	for ( size_t i = 0; i < 2 * anslp_config::MAX_RETIRED_SNAPSHOTS; i++ )
+		conf->publish_snapshot();
+
+	CPPUNIT_ASSERT( conf->get_num_retired_snapshots() 
+					== anslp_config::MAX_RETIRED_SNAPSHOTS );
+	CPPUNIT_ASSERT( copy.get_num_retired_snapshots() == 1 );
+
+	conf->setpar<uint32>(anslpconf_nr_max_retries, retries);
+}
+
+
+void AnslpConfigTest::testReloadRequest() {
+	CPPUNIT_ASSERT( ! anslp_config::claim_reload() );
+
+	anslp_config::request_reload();
+	anslp_config::request_reload();
+
+	CPPUNIT_ASSERT( anslp_config::claim_reload() );
+	CPPUNIT_ASSERT( ! anslp_config::claim_reload() );
+}
+
+// EOF
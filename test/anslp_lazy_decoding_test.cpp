@@ -0,0 +1,168 @@
+/*
+ * Test the lazy decoding of anslp_msg objects.
+ *
+ * $Id: anslp_lazy_decoding_test.cpp 2016-04-04 16:40:00 amarentes $
+ * $HeadURL: https://./test/anslp_lazy_decoding_test.cpp $
+ */
+#include <cstring>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "network_message.h"
+
+#include "msg/anslp_create.h"
+#include "msg/anslp_ie.h"
+#include "msg/anslp_msg.h"
+#include "msg/anslp_ipap_message.h"
+#include "IpAp_field.h"
+#include "IpAp_data_record.h"
+
+
+using namespace anslp::msg;
+
+
+class AnslpLazyDecodingTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( AnslpLazyDecodingTest );
+
+	CPPUNIT_TEST( testForwardUndecoded );
+	CPPUNIT_TEST( testDecodeOnAccess );
+	CPPUNIT_TEST( testCopyUndecoded );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+
+	void testForwardUndecoded();
+	void testDecodeOnAccess();
+	void testCopyUndecoded();
+
+  private:
+	anslp_create *build_create();
+	anslp_create *parse(NetMsg &msg);
+
+	anslp_create *original;
+	NetMsg *wire;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AnslpLazyDecodingTest );
+
+
+void AnslpLazyDecodingTest::setUp() {
+	ANSLP_IEManager::register_known_ies();
+	ANSLP_IEManager::set_lazy_decoding(true);
+
+	original = build_create();
+
+	uint32 bytes_written;
+	wire = new NetMsg( original->get_serialized_size(IE::protocol_v1) );
+	original->serialize(*wire, IE::protocol_v1, bytes_written);
+}
+
+
+void AnslpLazyDecodingTest::tearDown() {
+	delete wire;
+	delete original;
+
+	ANSLP_IEManager::set_lazy_decoding(false);
+	ANSLP_IEManager::clear();
+}
+
+
+anslp_create *AnslpLazyDecodingTest::build_create() {
+	uint64_t starttime = 100;
+	uint64_t endtime = 200;
+
+	anslp_ipap_message *mess = new anslp_ipap_message(IPAP_VERSION);
+
+	uint16_t templatedataid = (mess->ip_message).new_data_template( 2, 
+									IPAP_SETID_AUCTION_TEMPLATE );
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_STARTSECONDS);
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_ENDSECONDS);
+
+	ipap_field field1 = (mess->ip_message).get_field_definition( 0, IPAP_FT_STARTSECONDS );
+	ipap_field field2 = (mess->ip_message).get_field_definition( 0, IPAP_FT_ENDSECONDS );
+
+	ipap_data_record data(templatedataid);
+	data.insert_field(0, IPAP_FT_STARTSECONDS, field1.get_ipap_value_field( starttime ));
+	data.insert_field(0, IPAP_FT_ENDSECONDS, field2.get_ipap_value_field( endtime ));
+	(mess->ip_message).include_data(templatedataid, data);
+	(mess->ip_message).output();
+
+	anslp_create *c = new anslp_create();
+	c->set_session_lifetime(30);
+	c->set_msg_sequence_number(47);
+	c->set_selection_auctioning_entities(selection_auctioning_entities::sme_any);
+	c->set_message_hop_count(20);
+	c->set_mspec_object(mess);
+
+	return c;
+}
+
+
+anslp_create *AnslpLazyDecodingTest::parse(NetMsg &msg) {
+	IEErrorList errlist;
+	uint32 num_read;
+
+	msg.set_pos(0);
+	IE *ie = ANSLP_IEManager::instance()->deserialize(msg, cat_anslp_msg, 
+				IE::protocol_v1, errlist, num_read, false);
+
+	CPPUNIT_ASSERT( ie != NULL );
+	CPPUNIT_ASSERT( errlist.is_empty() );
+	CPPUNIT_ASSERT( num_read == msg.get_size() );
+
+	return dynamic_cast<anslp_create *>(ie);
+}
+
+
+void AnslpLazyDecodingTest::testForwardUndecoded() {
+	anslp_create *m = parse(*wire);
+
+	// Scalar objects are available right away.
+	CPPUNIT_ASSERT( m->get_msg_sequence_number() == 47 );
+	CPPUNIT_ASSERT( m->get_session_lifetime() == 30 );
+
+	// Written back without decoding, the bytes are the same.
+	uint32 bytes_written;
+	NetMsg out( m->get_serialized_size(IE::protocol_v1) );
+	m->serialize(out, IE::protocol_v1, bytes_written);
+
+	CPPUNIT_ASSERT( out.get_size() == wire->get_size() );
+	CPPUNIT_ASSERT( memcmp(out.get_buffer(), wire->get_buffer(), 
+						   wire->get_size()) == 0 );
+	delete m;
+}
+
+
+void AnslpLazyDecodingTest::testDecodeOnAccess() {
+	anslp_create *m = parse(*wire);
+
+	std::vector<anslp_mspec_object *> objects;
+	m->get_mspec_objects(objects);
+
+	CPPUNIT_ASSERT( objects.size() == 1 );
+	CPPUNIT_ASSERT( dynamic_cast<anslp_ipap_message *>(objects[0]) != NULL );
+	delete objects[0];
+
+	CPPUNIT_ASSERT( *m == *original );
+	delete m;
+}
+
+
+void AnslpLazyDecodingTest::testCopyUndecoded() {
+	anslp_create *m = parse(*wire);
+	anslp_create *c = m->copy();
+
+	// Comparing decodes both sides.
+	CPPUNIT_ASSERT( *c == *m );
+	CPPUNIT_ASSERT( *c == *original );
+
+	delete c;
+	delete m;
+}
+
+// EOF
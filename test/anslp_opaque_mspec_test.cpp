@@ -0,0 +1,173 @@
+/*
+ * Test the anslp_opaque_mspec class.
+ *
+ * $Id: anslp_opaque_mspec_test.cpp 2016-04-01 10:15:00 amarentes $
+ * $HeadURL: https://./test/anslp_opaque_mspec_test.cpp $
+ */
+#include <cstring>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "network_message.h"
+
+#include "msg/anslp_create.h"
+#include "msg/anslp_ie.h"
+#include "msg/anslp_msg.h"
+#include "msg/anslp_ipap_message.h"
+#include "msg/anslp_opaque_mspec.h"
+#include "IpAp_field.h"
+#include "IpAp_data_record.h"
+
+
+using namespace anslp::msg;
+
+
+class AnslpOpaqueMspecTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( AnslpOpaqueMspecTest );
+
+	CPPUNIT_TEST( testBasics );
+	CPPUNIT_TEST( testSharedCopy );
+	CPPUNIT_TEST( testCutThrough );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+
+	void testBasics();
+	void testSharedCopy();
+	void testCutThrough();
+
+  private:
+	anslp_create *build_create();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AnslpOpaqueMspecTest );
+
+
+void AnslpOpaqueMspecTest::setUp() {
+	ANSLP_IEManager::register_known_ies(true);
+}
+
+
+void AnslpOpaqueMspecTest::tearDown() {
+	ANSLP_IEManager::clear();
+}
+
+
+anslp_create *AnslpOpaqueMspecTest::build_create() {
+	uint64_t starttime = 100;
+	uint64_t endtime = 200;
+
+	anslp_ipap_message *mess = new anslp_ipap_message(IPAP_VERSION);
+
+	uint16_t templatedataid = (mess->ip_message).new_data_template( 2, 
+									IPAP_SETID_AUCTION_TEMPLATE );
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_STARTSECONDS);
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_ENDSECONDS);
+
+	ipap_field field1 = (mess->ip_message).get_field_definition( 0, IPAP_FT_STARTSECONDS );
+	ipap_field field2 = (mess->ip_message).get_field_definition( 0, IPAP_FT_ENDSECONDS );
+
+	ipap_data_record data(templatedataid);
+	data.insert_field(0, IPAP_FT_STARTSECONDS, field1.get_ipap_value_field( starttime ));
+	data.insert_field(0, IPAP_FT_ENDSECONDS, field2.get_ipap_value_field( endtime ));
+	(mess->ip_message).include_data(templatedataid, data);
+	(mess->ip_message).output();
+
+	anslp_create *c = new anslp_create();
+	c->set_session_lifetime(30);
+	c->set_msg_sequence_number(47);
+	c->set_selection_auctioning_entities(selection_auctioning_entities::sme_any);
+	c->set_message_hop_count(20);
+	c->set_mspec_object(mess);
+
+	return c;
+}
+
+
+void AnslpOpaqueMspecTest::testBasics() {
+	uchar body[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+	anslp_opaque_mspec o1(body, sizeof(body));
+	anslp_opaque_mspec o2(body, 4);
+	anslp_opaque_mspec o3;
+
+	CPPUNIT_ASSERT( o1.check_body() );
+	CPPUNIT_ASSERT( ! o3.check_body() );
+	CPPUNIT_ASSERT( o1.get_body_length() == 8 );
+	CPPUNIT_ASSERT( o1.get_serialized_size(IE::protocol_v1) == 12 );
+	CPPUNIT_ASSERT( o1.get_object_type() == anslp_ipap_message::OBJECT_TYPE );
+
+	CPPUNIT_ASSERT( o1.isEqual(o1) );
+	CPPUNIT_ASSERT( o1.notEqual(o2) );
+	CPPUNIT_ASSERT( o3.get_body() == NULL );
+}
+
+
+void AnslpOpaqueMspecTest::testSharedCopy() {
+	uchar body[4] = { 9, 8, 7, 6 };
+
+	anslp_opaque_mspec *o1 = new anslp_opaque_mspec(body, sizeof(body));
+	anslp_opaque_mspec *o2 = o1->copy();
+
+	CPPUNIT_ASSERT( o1->get_body() == o2->get_body() );
+	CPPUNIT_ASSERT( o1->isEqual(*o2) );
+
+	// The copy keeps the bytes alive on its own.
+	delete o1;
+	CPPUNIT_ASSERT( memcmp(o2->get_body(), body, sizeof(body)) == 0 );
+
+	delete o2;
+}
+
+
+void AnslpOpaqueMspecTest::testCutThrough() {
+	ANSLP_IEManager *mgr = ANSLP_IEManager::instance();
+
+	anslp_create *m1 = build_create();
+
+	NetMsg msg( m1->get_serialized_size(IE::protocol_v1) );
+	uint32 bytes_written;
+	m1->serialize(msg, IE::protocol_v1, bytes_written);
+
+	msg.set_pos(0);
+	IEErrorList errlist;
+	uint32 num_read;
+
+	IE *ie = mgr->deserialize(msg, cat_anslp_msg, IE::protocol_v1, errlist,
+			num_read, false);
+
+	CPPUNIT_ASSERT( ie != NULL );
+	CPPUNIT_ASSERT( errlist.is_empty() );
+	CPPUNIT_ASSERT( num_read == bytes_written );
+
+	anslp_create *m2 = dynamic_cast<anslp_create *>(ie);
+	CPPUNIT_ASSERT( m2 != NULL );
+	CPPUNIT_ASSERT( m2->get_msg_sequence_number() == 47 );
+	CPPUNIT_ASSERT( m2->get_message_hop_count() == 20 );
+
+	std::vector<anslp_mspec_object *> objects;
+	m2->get_mspec_objects(objects);
+	CPPUNIT_ASSERT( objects.size() == 1 );
+	CPPUNIT_ASSERT( dynamic_cast<anslp_opaque_mspec *>(objects[0]) != NULL );
+	delete objects[0];
+
+	// Forwarded as received: the bytes on the wire do not change.
+	anslp_create *m3 = m2->copy();
+
+	NetMsg out( m3->get_serialized_size(IE::protocol_v1) );
+	m3->serialize(out, IE::protocol_v1, bytes_written);
+
+	CPPUNIT_ASSERT( out.get_size() == msg.get_size() );
+	CPPUNIT_ASSERT( memcmp(out.get_buffer(), msg.get_buffer(), msg.get_size()) == 0 );
+
+	delete m3;
+	delete m2;
+	delete m1;
+}
+
+// EOF
@@ -0,0 +1,243 @@
+/*
+ * Test the anslp_summary_refresh class and the summary refresh collector.
+ *
+ * $Id: anslp_summary_refresh_test.cpp 2016-03-17 16:02:00 amarentes $
+ * $HeadURL: https://./test/anslp_summary_refresh_test.cpp $
+ */
+#include <unistd.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "network_message.h"
+#include "mri_pc.h"
+
+#include "msg/anslp_ie.h"
+#include "msg/anslp_msg.h"
+#include "msg/anslp_summary_refresh.h"
+#include "msg/ntlp_msg.h"
+#include "session_id.h"
+#include "summary_refresh_collector.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+class AnslpSummaryRefreshTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( AnslpSummaryRefreshTest );
+
+	CPPUNIT_TEST( testBasics );
+	CPPUNIT_TEST( testCopying );
+	CPPUNIT_TEST( testManager );
+	CPPUNIT_TEST( testCachedSize );
+	CPPUNIT_TEST( testCollector );
+	CPPUNIT_TEST( testCollectorFull );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testBasics();
+	void testCopying();
+	void testManager();
+	void testCachedSize();
+	void testCollector();
+	void testCollectorFull();
+	
+  private:
+	ntlp_msg *create_refresh(const char *dest, uint32 msn) const;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( AnslpSummaryRefreshTest );
+
+
+ntlp_msg *AnslpSummaryRefreshTest::create_refresh(const char *dest, 
+												  uint32 msn) const
+{
+	anslp_refresh *refresh = new anslp_refresh();
+	refresh->set_msg_sequence_number(msn);
+	refresh->set_session_lifetime(30);
+	
+	ntlp::mri *ntlp_mri = new ntlp::mri_pathcoupled(
+		hostaddress("192.168.0.4"), 32, 0,
+		hostaddress(dest), 32, 0,
+		"tcp", 0, 0, 0, true
+	);
+
+	return new ntlp_msg(session_id(), refresh, ntlp_mri, 0);
+}
+
+
+void AnslpSummaryRefreshTest::testBasics() {
+	anslp_summary_refresh s1;
+	session_id sid1, sid2;
+
+	CPPUNIT_ASSERT( s1.get_num_sessions() == 0 );
+	CPPUNIT_ASSERT( ! s1.check() );
+	
+	s1.add_session(sid1.get_id(), 4, 100);
+	s1.add_session(sid2.get_id(), 7, 30);
+	
+	CPPUNIT_ASSERT( s1.check() );
+	CPPUNIT_ASSERT( s1.get_num_sessions() == 2 );
+	CPPUNIT_ASSERT( session_id(s1.get_session(0).sid) == sid1 );
+	CPPUNIT_ASSERT( s1.get_session(0).msn == 4 );
+	CPPUNIT_ASSERT( s1.get_session(0).lifetime == 100 );
+	CPPUNIT_ASSERT( session_id(s1.get_session(1).sid) == sid2 );
+	CPPUNIT_ASSERT( s1.get_session(1).msn == 7 );
+}
+
+
+void AnslpSummaryRefreshTest::testCopying() {
+	session_id sid;
+	
+	anslp_summary_refresh *s1 = new anslp_summary_refresh();
+	s1->add_session(sid.get_id(), 4, 100);
+
+	anslp_summary_refresh *s2 = s1->copy();
+	CPPUNIT_ASSERT( s1 != s2 );
+	CPPUNIT_ASSERT( *s1 == *s2 );
+	
+	s2->add_session(sid.get_id(), 5, 100);
+	CPPUNIT_ASSERT( *s1 != *s2 );
+
+	delete s2;
+	delete s1;
+}
+
+
+void AnslpSummaryRefreshTest::testManager() {
+
+	ANSLP_IEManager::clear();
+	ANSLP_IEManager::register_known_ies();
+	ANSLP_IEManager *mgr = ANSLP_IEManager::instance();
+
+	anslp_summary_refresh *m1 = new anslp_summary_refresh();
+	for ( uint32 i = 0; i < 10; i++ ) {
+		session_id sid;
+		m1->add_session(sid.get_id(), i, 30);
+	}
+       
+	NetMsg msg( m1->get_serialized_size(IE::protocol_v1) );
+	uint32 bytes_written;
+	m1->serialize(msg, IE::protocol_v1, bytes_written);
+	
+	CPPUNIT_ASSERT( bytes_written == m1->get_serialized_size(IE::protocol_v1) );
+
+	msg.set_pos(0);
+	IEErrorList errlist;
+	uint32 num_read;
+
+	IE *ie = mgr->deserialize(msg, cat_anslp_msg, IE::protocol_v1, errlist,
+			num_read, false);
+			
+	CPPUNIT_ASSERT( ie != NULL );
+	CPPUNIT_ASSERT( errlist.is_empty() );
+	CPPUNIT_ASSERT( num_read == ie->get_serialized_size(IE::protocol_v1) );
+	CPPUNIT_ASSERT( *m1 == *ie );
+	
+	delete ie;
+	delete m1;
+	mgr->clear();
+}
+
+
+/*
+ * The cached object size follows changes of the object.
+ */
+void AnslpSummaryRefreshTest::testCachedSize() {
+	anslp_summary_refresh *m1 = new anslp_summary_refresh();
+	session_id sid;
+	
+	m1->add_session(sid.get_id(), 1, 30);
+	size_t size1 = m1->get_serialized_size(IE::protocol_v1);
+	CPPUNIT_ASSERT( size1 == m1->get_serialized_size(IE::protocol_v1) );
+	
+	m1->add_session(sid.get_id(), 2, 30);
+	size_t size2 = m1->get_serialized_size(IE::protocol_v1);
+	CPPUNIT_ASSERT( size2 == size1 + session_refresh_list::ENTRY_LENGTH );
+
+	NetMsg msg( size2 );
+	uint32 bytes_written;
+	m1->serialize(msg, IE::protocol_v1, bytes_written);
+	CPPUNIT_ASSERT( bytes_written == size2 );
+
+	delete m1;
+}
+
+
+void AnslpSummaryRefreshTest::testCollector() {
+	
+	summary_refresh_collector collector(256, 0);
+	std::vector<ntlp_msg *> ready;
+	
+	// Only refreshes are collected.
+	ntlp_msg *other = create_refresh("192.168.0.5", 1);
+	anslp_create *create = new anslp_create();
+	ntlp_msg *create_msg = new ntlp_msg(other->get_session_id(), create, 
+										other->get_mri()->copy(), 0);
+	CPPUNIT_ASSERT( ! collector.collects(create_msg) );
+	CPPUNIT_ASSERT( ! collector.add(create_msg, ready) );
+	delete create_msg;
+
+	CPPUNIT_ASSERT( collector.collects(other) );
+	CPPUNIT_ASSERT( ! summary_refresh_collector(1, 0).collects(other) );
+	delete other;
+
+	CPPUNIT_ASSERT( collector.add(create_refresh("192.168.0.5", 1), ready) );
+	CPPUNIT_ASSERT( collector.add(create_refresh("192.168.0.5", 2), ready) );
+	CPPUNIT_ASSERT( collector.add(create_refresh("192.168.0.5", 3), ready) );
+	CPPUNIT_ASSERT( collector.add(create_refresh("192.168.0.9", 4), ready) );
+	
+	CPPUNIT_ASSERT( ready.empty() );
+	CPPUNIT_ASSERT( collector.get_num_pending() == 2 );
+	
+	collector.flush(true, ready);
+	
+	CPPUNIT_ASSERT( ready.size() == 2 );
+	CPPUNIT_ASSERT( collector.get_num_pending() == 0 );
+
+	size_t summaries = 0, refreshes = 0;
+	for ( size_t i = 0; i < ready.size(); i++ ) {
+		anslp_summary_refresh *s = dynamic_cast<anslp_summary_refresh *>(
+				ready[i]->get_anslp_msg());
+		
+		if ( s != NULL ) {
+			CPPUNIT_ASSERT( s->get_num_sessions() == 3 );
+			CPPUNIT_ASSERT( s->get_session(2).msn == 3 );
+			summaries++;
+		}
+		
+		// A single refresh is sent unchanged.
+		if ( ready[i]->get_anslp_refresh() != NULL ) 
+			refreshes++;
+
+		delete ready[i];
+	}
+	
+	CPPUNIT_ASSERT( summaries == 1 && refreshes == 1 );
+}
+
+
+void AnslpSummaryRefreshTest::testCollectorFull() {
+	
+	summary_refresh_collector collector(3, 60000);
+	std::vector<ntlp_msg *> ready;
+	
+	collector.add(create_refresh("192.168.0.5", 1), ready);
+	collector.add(create_refresh("192.168.0.5", 2), ready);
+	
+	// Not due yet.
+	collector.flush(false, ready);
+	CPPUNIT_ASSERT( ready.empty() );
+
+	collector.add(create_refresh("192.168.0.5", 3), ready);
+	
+	CPPUNIT_ASSERT( ready.size() == 1 );
+	CPPUNIT_ASSERT( collector.get_num_pending() == 0 );
+
+	delete ready[0];
+}
+
+// EOF
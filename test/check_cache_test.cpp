@@ -0,0 +1,191 @@
+/*
+ * Test the check_cache class.
+ *
+ * $Id: check_cache_test.cpp 2016-04-13 10:20:00 amarentes $
+ * $HeadURL: https://./test/check_cache_test.cpp $
+ */
+#include <vector>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "check_cache.h"
+#include "msg/anslp_opaque_mspec.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+class CheckCacheTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( CheckCacheTest );
+
+	CPPUNIT_TEST( testLookup );
+	CPPUNIT_TEST( testExpiry );
+	CPPUNIT_TEST( testInvalidate );
+	CPPUNIT_TEST( testUnexpected );
+	CPPUNIT_TEST( testDisabled );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void tearDown();
+	
+	void testLookup();
+	void testExpiry();
+	void testInvalidate();
+	void testUnexpected();
+	void testDisabled();
+
+  private:
+	std::vector<objectList_t *> lists;
+
+	objectList_t *request(uchar first, uchar last);
+	objectList_t *answer(const objectList_t *request, uchar value);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CheckCacheTest );
+
+
+void CheckCacheTest::tearDown() {
+	for ( size_t i = 0; i < lists.size(); i++ ) {
+		objectListIter_t it;
+		for ( it = lists[i]->begin(); it != lists[i]->end(); it++ )
+			delete it->second;
+
+		delete lists[i];
+	}
+	
+	lists.clear();
+}
+
+
+/*
+ * Build a request with one object per value, each with new keys.
+ */
+objectList_t *CheckCacheTest::request(uchar first, uchar last) {
+	objectList_t *objects = new objectList_t();
+	lists.push_back(objects);
+
+	for ( uchar value = first; value <= last; value++ ) {
+		uchar body[4] = { value, value, value, value };
+		(*objects)[mspec_rule_key()] = new anslp_opaque_mspec(body, 4);
+	}
+
+	return objects;
+}
+
+
+/*
+ * Build the application's answer, which keeps all objects but one.
+ */
+objectList_t *CheckCacheTest::answer(const objectList_t *request, 
+									 uchar value) {
+	objectList_t *objects = new objectList_t();
+	lists.push_back(objects);
+
+	uchar body[4] = { value, value, value, value };
+	anslp_opaque_mspec rejected(body, 4);
+
+	objectListConstIter_t it;
+	for ( it = request->begin(); it != request->end(); it++ ) {
+		if ( ! it->second->isEqual(rejected) )
+			(*objects)[it->first] = it->second->copy();
+	}
+
+	return objects;
+}
+
+
+void CheckCacheTest::testLookup() {
+	check_cache cache(1000, 64);
+	std::vector<bool> applicable;
+
+	objectList_t *first = request(1, 3);
+	CPPUNIT_ASSERT( ! cache.lookup(first, applicable, 0) );
+
+	cache.expect("session-1", first, 0);
+	CPPUNIT_ASSERT( cache.learn("session-1", answer(first, 2), 10) );
+
+	// Other sessions have other keys, but ask the same.
+	objectList_t *second = request(1, 3);
+	CPPUNIT_ASSERT( cache.lookup(second, applicable, 20) );
+	CPPUNIT_ASSERT( applicable.size() == 3 );
+	CPPUNIT_ASSERT( applicable[0] && ! applicable[1] && applicable[2] );
+
+	// Different objects, or the same in another order, are unknown.
+	CPPUNIT_ASSERT( ! cache.lookup(request(1, 4), applicable, 20) );
+	CPPUNIT_ASSERT( ! cache.lookup(request(2, 3), applicable, 20) );
+
+	check_cache_stats s = cache.get_stats();
+	CPPUNIT_ASSERT( s.hits == 1 );
+	CPPUNIT_ASSERT( s.misses == 3 );
+	CPPUNIT_ASSERT( s.stored == 1 );
+}
+
+
+void CheckCacheTest::testExpiry() {
+	check_cache cache(1000, 64);
+	std::vector<bool> applicable;
+
+	objectList_t *objects = request(1, 2);
+	cache.expect("session-1", objects, 0);
+	cache.learn("session-1", answer(objects, 0), 500);
+
+	CPPUNIT_ASSERT( cache.lookup(objects, applicable, 1499) );
+	CPPUNIT_ASSERT( ! cache.lookup(objects, applicable, 1500) );
+	CPPUNIT_ASSERT( cache.get_stats().expired == 1 );
+}
+
+
+void CheckCacheTest::testInvalidate() {
+	check_cache cache(1000, 64);
+	std::vector<bool> applicable;
+
+	objectList_t *objects = request(1, 2);
+	cache.expect("session-1", objects, 0);
+	cache.learn("session-1", answer(objects, 0), 0);
+	CPPUNIT_ASSERT( cache.lookup(objects, applicable, 0) );
+
+	cache.invalidate();
+	CPPUNIT_ASSERT( ! cache.lookup(objects, applicable, 0) );
+
+	// An answer to a request sent before the change is not stored.
+	cache.expect("session-2", objects, 0);
+	cache.invalidate();
+	CPPUNIT_ASSERT( ! cache.learn("session-2", answer(objects, 0), 0) );
+	CPPUNIT_ASSERT( ! cache.lookup(objects, applicable, 0) );
+
+	CPPUNIT_ASSERT( cache.get_stats().invalidations == 2 );
+}
+
+
+void CheckCacheTest::testUnexpected() {
+	check_cache cache(1000, 64);
+	std::vector<bool> applicable;
+
+	objectList_t *objects = request(1, 2);
+	
+	// Answers given from the cache are not learned again.
+	CPPUNIT_ASSERT( ! cache.learn("session-1", answer(objects, 0), 0) );
+
+	cache.expect("session-1", objects, 0);
+	CPPUNIT_ASSERT( cache.learn("session-1", answer(objects, 0), 0) );
+	CPPUNIT_ASSERT( ! cache.learn("session-1", answer(objects, 0), 0) );
+}
+
+
+void CheckCacheTest::testDisabled() {
+	check_cache cache(0, 64);
+	std::vector<bool> applicable;
+
+	CPPUNIT_ASSERT( ! cache.is_enabled() );
+
+	objectList_t *objects = request(1, 2);
+	cache.expect("session-1", objects, 0);
+	CPPUNIT_ASSERT( ! cache.learn("session-1", answer(objects, 0), 0) );
+	CPPUNIT_ASSERT( ! cache.lookup(objects, applicable, 0) );
+}
+
+// EOF
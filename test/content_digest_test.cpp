@@ -0,0 +1,174 @@
+/*
+ * Test the content_digest class and the digests of objects and messages.
+ *
+ * $Id: content_digest_test.cpp 2016-04-11 09:30:00 amarentes $
+ * $HeadURL: https://./test/content_digest_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "network_message.h"
+
+#include "msg/anslp_create.h"
+#include "msg/anslp_ie.h"
+#include "msg/anslp_msg.h"
+#include "msg/anslp_ipap_message.h"
+#include "msg/anslp_opaque_mspec.h"
+#include "msg/content_digest.h"
+#include "IpAp_field.h"
+#include "IpAp_data_record.h"
+
+
+using namespace anslp::msg;
+
+
+class ContentDigestTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( ContentDigestTest );
+
+	CPPUNIT_TEST( testBuilder );
+	CPPUNIT_TEST( testObjects );
+	CPPUNIT_TEST( testMessages );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void tearDown();
+
+	void testBuilder();
+	void testObjects();
+	void testMessages();
+
+  private:
+	anslp_ipap_message *build_mspec(uint64_t starttime);
+	anslp_create *roundtrip(const anslp_create *c, bool opaque);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ContentDigestTest );
+
+
+void ContentDigestTest::tearDown() {
+	ANSLP_IEManager::clear();
+}
+
+
+anslp_ipap_message *ContentDigestTest::build_mspec(uint64_t starttime) {
+	uint64_t endtime = starttime + 100;
+
+	anslp_ipap_message *mess = new anslp_ipap_message(IPAP_VERSION);
+
+	uint16_t templatedataid = (mess->ip_message).new_data_template( 2, 
+									IPAP_SETID_AUCTION_TEMPLATE );
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_STARTSECONDS);
+	(mess->ip_message).add_field(templatedataid, 0, IPAP_FT_ENDSECONDS);
+
+	ipap_field field1 = (mess->ip_message).get_field_definition( 0, IPAP_FT_STARTSECONDS );
+	ipap_field field2 = (mess->ip_message).get_field_definition( 0, IPAP_FT_ENDSECONDS );
+
+	ipap_data_record data(templatedataid);
+	data.insert_field(0, IPAP_FT_STARTSECONDS, field1.get_ipap_value_field( starttime ));
+	data.insert_field(0, IPAP_FT_ENDSECONDS, field2.get_ipap_value_field( endtime ));
+	(mess->ip_message).include_data(templatedataid, data);
+	(mess->ip_message).output();
+
+	return mess;
+}
+
+
+/*
+ * Serialize the message and read it back, with the mspec objects decoded
+ * as IPAP messages or kept opaque.
+ */
+anslp_create *ContentDigestTest::roundtrip(const anslp_create *c, bool opaque) {
+	ANSLP_IEManager::clear();
+	ANSLP_IEManager::register_known_ies(opaque);
+
+	NetMsg msg( c->get_serialized_size(IE::protocol_v1) );
+	uint32 bytes_written;
+	c->serialize(msg, IE::protocol_v1, bytes_written);
+
+	msg.set_pos(0);
+	IEErrorList errlist;
+	uint32 num_read;
+
+	IE *ie = ANSLP_IEManager::instance()->deserialize(msg, cat_anslp_msg, 
+			IE::protocol_v1, errlist, num_read, false);
+
+	CPPUNIT_ASSERT( ie != NULL );
+	return dynamic_cast<anslp_create *>(ie);
+}
+
+
+void ContentDigestTest::testBuilder() {
+	uchar data[40];
+	for ( size_t i = 0; i < sizeof(data); i++ )
+		data[i] = uchar(i * 7);
+
+	content_digest null;
+	CPPUNIT_ASSERT( null.is_null() );
+
+	content_digest d1 = content_digest::compute(data, sizeof(data));
+	CPPUNIT_ASSERT( ! d1.is_null() );
+
+	// The result doesn't depend on how the bytes are split.
+	digest_builder builder;
+	builder.update(data, 3);
+	builder.update(data + 3, 20);
+	builder.update(data + 23, sizeof(data) - 23);
+	CPPUNIT_ASSERT( builder.finish() == d1 );
+
+	data[17] ^= 1;
+	CPPUNIT_ASSERT( content_digest::compute(data, sizeof(data)) != d1 );
+
+	CPPUNIT_ASSERT( ! content_digest::compute(data, 0).is_null() );
+}
+
+
+void ContentDigestTest::testObjects() {
+	anslp_ipap_message *mess = build_mspec(100);
+	anslp_ipap_message *copy = mess->copy();
+	anslp_ipap_message *other = build_mspec(300);
+
+	CPPUNIT_ASSERT( ! mess->get_digest().is_null() );
+	CPPUNIT_ASSERT( mess->get_digest() == copy->get_digest() );
+	CPPUNIT_ASSERT( mess->get_digest() != other->get_digest() );
+	CPPUNIT_ASSERT( mess->isEqual(*copy) );
+	CPPUNIT_ASSERT( mess->notEqual(*other) );
+
+	// The same body kept as received has the same digest.
+	NetMsg msg( mess->get_serialized_size(IE::protocol_v1) );
+	uint32 bytes_written;
+	mess->serialize(msg, IE::protocol_v1, bytes_written);
+
+	anslp_opaque_mspec opaque(msg.get_buffer() + 4, bytes_written - 4);
+	CPPUNIT_ASSERT( opaque.get_digest() == mess->get_digest() );
+
+	delete other;
+	delete copy;
+	delete mess;
+}
+
+
+void ContentDigestTest::testMessages() {
+	anslp_create *c = new anslp_create();
+	c->set_session_lifetime(30);
+	c->set_msg_sequence_number(47);
+	c->set_selection_auctioning_entities(selection_auctioning_entities::sme_any);
+	c->set_mspec_object(build_mspec(100));
+
+	anslp_create *decoded = roundtrip(c, false);
+	anslp_create *opaque = roundtrip(c, true);
+
+	CPPUNIT_ASSERT( c->get_digest() == decoded->get_digest() );
+	CPPUNIT_ASSERT( c->get_digest() == opaque->get_digest() );
+
+	// Any object counts, not only the mspec objects.
+	decoded->set_session_lifetime(31);
+	CPPUNIT_ASSERT( c->get_digest() != decoded->get_digest() );
+
+	delete opaque;
+	delete decoded;
+	delete c;
+}
+
+// EOF
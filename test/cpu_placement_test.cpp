@@ -0,0 +1,98 @@
+/*
+ * Test the cpu_placement class.
+ *
+ * $Id: cpu_placement_test.cpp 2016-04-21 10:00:00 amarentes $
+ * $HeadURL: https://./test/cpu_placement_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "cpu_placement.h"
+
+
+using namespace anslp;
+
+
+class CpuPlacementTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( CpuPlacementTest );
+
+	CPPUNIT_TEST( testParse );
+	CPPUNIT_TEST( testMalformed );
+	CPPUNIT_TEST( testSelect );
+	CPPUNIT_TEST( testAffinity );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testParse();
+	void testMalformed();
+	void testSelect();
+	void testAffinity();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CpuPlacementTest );
+
+
+void CpuPlacementTest::testParse() {
+	cpu_set_t set;
+
+	CPPUNIT_ASSERT( cpu_placement::parse("0-3, 8,10-11", set) );
+	CPPUNIT_ASSERT_EQUAL( 7, CPU_COUNT(&set) );
+	CPPUNIT_ASSERT( CPU_ISSET(2, &set) );
+	CPPUNIT_ASSERT( ! CPU_ISSET(9, &set) );
+	CPPUNIT_ASSERT_EQUAL( std::string("0-3,8,10-11"), 
+						  cpu_placement::to_string(set) );
+
+	CPPUNIT_ASSERT( cpu_placement::parse("5", set) );
+	CPPUNIT_ASSERT_EQUAL( std::string("5"), cpu_placement::to_string(set) );
+}
+
+
+void CpuPlacementTest::testMalformed() {
+	cpu_set_t set;
+
+	CPPUNIT_ASSERT( ! cpu_placement::parse("", set) );
+	CPPUNIT_ASSERT( ! cpu_placement::parse("a", set) );
+	CPPUNIT_ASSERT( ! cpu_placement::parse("3-1", set) );
+	CPPUNIT_ASSERT( ! cpu_placement::parse("1;2", set) );
+	CPPUNIT_ASSERT( ! cpu_placement::parse("-1", set) );
+	CPPUNIT_ASSERT( ! cpu_placement::parse("100000", set) );
+}
+
+
+void CpuPlacementTest::testSelect() {
+	cpu_set_t set, cpu;
+
+	CPPUNIT_ASSERT( cpu_placement::parse("2,4,6", set) );
+
+	CPPUNIT_ASSERT( cpu_placement::select(set, 0, cpu) );
+	CPPUNIT_ASSERT_EQUAL( std::string("2"), cpu_placement::to_string(cpu) );
+
+	CPPUNIT_ASSERT( cpu_placement::select(set, 2, cpu) );
+	CPPUNIT_ASSERT_EQUAL( std::string("6"), cpu_placement::to_string(cpu) );
+
+	// wraps around
+	CPPUNIT_ASSERT( cpu_placement::select(set, 4, cpu) );
+	CPPUNIT_ASSERT_EQUAL( std::string("4"), cpu_placement::to_string(cpu) );
+
+	CPU_ZERO(&set);
+	CPPUNIT_ASSERT( ! cpu_placement::select(set, 0, cpu) );
+}
+
+
+void CpuPlacementTest::testAffinity() {
+	cpu_set_t original, cpu;
+	CPPUNIT_ASSERT( cpu_placement::get_affinity(original) );
+
+	CPPUNIT_ASSERT( cpu_placement::select(original, 0, cpu) );
+	CPPUNIT_ASSERT( cpu_placement::set_affinity(cpu) );
+
+	cpu_set_t now;
+	CPPUNIT_ASSERT( cpu_placement::get_affinity(now) );
+	CPPUNIT_ASSERT_EQUAL( 1, CPU_COUNT(&now) );
+
+	CPPUNIT_ASSERT( cpu_placement::set_affinity(original) );
+}
+
+// EOF
@@ -0,0 +1,233 @@
+/*
+ * Test the create_filter class.
+ *
+ * $Id: create_filter_test.cpp 2016-04-18 10:10:00 amarentes $
+ * $HeadURL: https://./test/create_filter_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "mri.h"	// from NTLP
+
+#include "create_filter.h"
+#include "session_manager.h"
+#include "events.h"
+#include "msg/anslp_create.h"
+#include "msg/anslp_response.h"
+#include "msg/selection_auctioning_entities.h"
+
+#include "utils.h" // mock_dispatcher
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+class CreateFilterTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( CreateFilterTest );
+
+	CPPUNIT_TEST( testValues );
+	CPPUNIT_TEST( testRate );
+	CPPUNIT_TEST( testQuota );
+	CPPUNIT_TEST( testOverflow );
+	CPPUNIT_TEST( testRejectWithoutMsn );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testValues();
+	void testRate();
+	void testQuota();
+	void testOverflow();
+	void testRejectWithoutMsn();
+
+  private:
+	create_request request(uint64_t source);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( CreateFilterTest );
+
+
+/*
+ * Build the values of a CREATE that passes all checks.
+ */
+create_request CreateFilterTest::request(uint64_t source) {
+	create_request r;
+	r.source = source;
+	r.well_formed = true;
+	r.path_coupled = true;
+	r.lifetime = 30000;
+	r.hop_count = 20;
+	r.sme = selection_auctioning_entities::sme_any;
+	
+	return r;
+}
+
+
+void CreateFilterTest::testValues() {
+	create_filter filter(32, 0, 0, 0, 64);
+
+	create_request r = request(1);
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::PASS );
+
+	r = request(1);
+	r.well_formed = false;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::MALFORMED );
+
+	r = request(1);
+	r.path_coupled = false;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::BAD_MRI );
+
+	r = request(1);
+	r.lifetime = 0;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::BAD_LIFETIME );
+
+	r = request(1);
+	r.hop_count = 0;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::HOP_LIMIT );
+	
+	r.hop_count = 33;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::HOP_LIMIT );
+
+	r = request(1);
+	r.sme = 6;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::BAD_SME );
+
+	r.sme = selection_auctioning_entities::sme_enterprise_specific;
+	CPPUNIT_ASSERT( filter.check(r, 0) == create_filter::PASS );
+
+	create_filter_stats s = filter.get_stats();
+	CPPUNIT_ASSERT_EQUAL( 2, (int) s.passed );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.malformed );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.bad_mri );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.bad_lifetime );
+	CPPUNIT_ASSERT_EQUAL( 2, (int) s.hop_limit );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.bad_sme );
+}
+
+
+void CreateFilterTest::testRate() {
+	// 10 sessions per second, 3 at once
+	create_filter filter(0, 10, 3, 0, 64);
+
+	for ( int i = 0; i < 3; i++ )
+		CPPUNIT_ASSERT( filter.check(request(1), 1000) 
+						== create_filter::PASS );
+
+	CPPUNIT_ASSERT( filter.check(request(1), 1000) 
+					== create_filter::RATE_LIMITED );
+
+	// other sources have their own bucket
+	CPPUNIT_ASSERT( filter.check(request(2), 1000) == create_filter::PASS );
+
+	// a token every 100 ms
+	CPPUNIT_ASSERT( filter.check(request(1), 1050) 
+					== create_filter::RATE_LIMITED );
+	CPPUNIT_ASSERT( filter.check(request(1), 1100) == create_filter::PASS );
+
+	// invalid CREATEs don't take tokens
+	create_request r = request(1);
+	r.lifetime = 0;
+	CPPUNIT_ASSERT( filter.check(r, 1200) == create_filter::BAD_LIFETIME );
+	CPPUNIT_ASSERT( filter.check(request(1), 1200) == create_filter::PASS );
+
+	CPPUNIT_ASSERT_EQUAL( 2, (int) filter.get_stats().rate_limited );
+}
+
+
+void CreateFilterTest::testQuota() {
+	create_filter filter(0, 0, 0, 2, 64);
+
+	session_id sid1, sid2, sid3;
+
+	CPPUNIT_ASSERT( filter.check(request(1), 0) == create_filter::PASS );
+	filter.add_session(sid1, 1, 0);
+	CPPUNIT_ASSERT( filter.check(request(1), 0) == create_filter::PASS );
+	filter.add_session(sid2, 1, 0);
+	
+	CPPUNIT_ASSERT_EQUAL( 2, (int) filter.get_num_sessions(1) );
+	CPPUNIT_ASSERT( filter.check(request(1), 0) 
+					== create_filter::OVER_QUOTA );
+	CPPUNIT_ASSERT( filter.check(request(2), 0) == create_filter::PASS );
+
+	// unknown sessions are ignored
+	filter.remove_session(sid3);
+	CPPUNIT_ASSERT_EQUAL( 2, (int) filter.get_num_sessions(1) );
+
+	filter.remove_session(sid1);
+	CPPUNIT_ASSERT_EQUAL( 1, (int) filter.get_num_sessions(1) );
+	CPPUNIT_ASSERT( filter.check(request(1), 0) == create_filter::PASS );
+
+	// removing twice doesn't count twice
+	filter.remove_session(sid1);
+	CPPUNIT_ASSERT_EQUAL( 1, (int) filter.get_num_sessions(1) );
+}
+
+
+void CreateFilterTest::testOverflow() {
+	// room for one source per shard
+	create_filter filter(0, 0, 0, 1, create_filter::NUM_SHARDS);
+
+	uint64_t a = 1;
+	uint64_t b = 1 + create_filter::NUM_SHARDS; // same shard as a
+
+	session_id sid1, sid2;
+
+	CPPUNIT_ASSERT( filter.check(request(a), 0) == create_filter::PASS );
+	filter.add_session(sid1, a, 0);
+
+	// b doesn't fit, it uses the overflow entry
+	CPPUNIT_ASSERT( filter.check(request(b), 0) == create_filter::PASS );
+	filter.add_session(sid2, b, 0);
+	
+	CPPUNIT_ASSERT_EQUAL( 1, (int) filter.get_num_sessions(
+		create_filter::OVERFLOW_SOURCE) );
+	CPPUNIT_ASSERT( filter.get_stats().overflowed > 0 );
+
+	// a's entry is kept while it holds a session, idle ones are dropped
+	filter.remove_session(sid1);
+	CPPUNIT_ASSERT( filter.check(request(b), 0) == create_filter::PASS );
+	CPPUNIT_ASSERT_EQUAL( 0, (int) filter.get_num_sessions(a) );
+}
+
+
+/*
+ * A malformed CREATE may lack the MSN, the dispatcher answers it with MSN 0.
+ */
+void CreateFilterTest::testRejectWithoutMsn() {
+	mock_anslp_config *conf = new mock_anslp_config();
+	session_manager *mgr = new session_manager(conf);
+	create_filter filter(32, 0, 0, 0, 64);
+	mock_dispatcher *d = new mock_dispatcher(mgr, NULL, conf, &filter);
+
+	anslp_create *create = new anslp_create();
+	create->set_session_lifetime(30);
+	create->set_selection_auctioning_entities(
+		selection_auctioning_entities::sme_any);
+
+	ntlp::mri *mri = new ntlp::mri_pathcoupled(
+		hostaddress("192.168.0.4"), 32, 0,
+		hostaddress("192.168.0.5"), 32, 0,
+		"tcp", 0, 0, 0, true
+	);
+
+	session_id sid;
+	msg_event *e = new msg_event(new session_id(sid), 
+		new ntlp_msg(sid, create, mri, 0));
+
+	d->process(e);
+	delete e;
+
+	ASSERT_RESPONSE_MESSAGE_SENT(d, information_code::sc_protocol_error);
+	CPPUNIT_ASSERT_EQUAL( 0, 
+		(int) d->get_message()->get_anslp_msg()->get_msg_sequence_number() );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) filter.get_stats().malformed );
+	CPPUNIT_ASSERT( mgr->get_session(sid) == NULL );
+
+	delete d;
+	delete mgr;
+	delete conf;
+}
+
+// EOF
@@ -0,0 +1,143 @@
+/*
+ * Test the dispatcher class.
+ *
+ * $Id: dispatcher_test.cpp 2016-05-02 11:20:00 amarentes $
+ * $HeadURL: https://./test/dispatcher_test.cpp $
+ */
+#include <vector>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "mri.h"	// from NTLP
+
+#include "events.h"
+#include "session_manager.h"
+#include "nr_session.h"
+#include "msg/anslp_summary_refresh.h"
+
+#include "utils.h" // mock_dispatcher
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+/*
+ * A dispatcher that records the REFRESH messages a summary is split into.
+ */
+class recording_dispatcher : public mock_dispatcher {
+  public:
+	recording_dispatcher(session_manager *m, anslp_config *conf)
+		: mock_dispatcher(m, NULL, conf) { }
+	~recording_dispatcher();
+
+	void process(event *evt) throw ();
+
+	std::vector<ntlp_msg *> refreshes;
+};
+
+
+recording_dispatcher::~recording_dispatcher() {
+	for ( size_t i = 0; i < refreshes.size(); i++ )
+		delete refreshes[i];
+}
+
+
+void recording_dispatcher::process(event *evt) throw () {
+	msg_event *e = dynamic_cast<msg_event *>(evt);
+
+	if ( e != NULL && e->get_ntlp_msg() != NULL
+			&& e->get_ntlp_msg()->get_anslp_refresh() != NULL )
+		refreshes.push_back(e->get_ntlp_msg()->copy());
+	else
+		mock_dispatcher::process(evt);
+}
+
+
+class DispatcherTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( DispatcherTest );
+
+	CPPUNIT_TEST( testSummaryRefreshMri );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testSummaryRefreshMri();
+
+  private:
+	ntlp::mri_pathcoupled *create_mri(const char *source) const;
+	hostaddress get_source(const ntlp_msg *msg) const;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DispatcherTest );
+
+
+ntlp::mri_pathcoupled *DispatcherTest::create_mri(const char *source) const {
+	return new ntlp::mri_pathcoupled(
+		hostaddress(source), 32, 0,
+		hostaddress("192.168.0.5"), 32, 0,
+		"tcp", 0, 0, 0, true
+	);
+}
+
+
+hostaddress DispatcherTest::get_source(const ntlp_msg *msg) const {
+	const ntlp::mri_pathcoupled *mri =
+		dynamic_cast<const ntlp::mri_pathcoupled *>(msg->get_mri());
+
+	CPPUNIT_ASSERT( mri != NULL );
+
+	return mri->get_sourceaddress();
+}
+
+
+/*
+ * Each REFRESH split from a summary carries the MRI of its own session.
+ */
+void DispatcherTest::testSummaryRefreshMri() {
+	mock_anslp_config *conf = new mock_anslp_config();
+	session_manager *mgr = new session_manager(conf);
+	recording_dispatcher *d = new recording_dispatcher(mgr, conf);
+
+	session_id sid1, sid2, sid3;
+
+	mgr->create_nr_session(sid1)->set_mri(create_mri("192.168.0.1"));
+	mgr->create_nr_session(sid2)->set_mri(create_mri("192.168.0.2"));
+
+	anslp_summary_refresh *summary = new anslp_summary_refresh();
+	summary->add_session(sid1.get_id(), 4, 30);
+	summary->add_session(sid2.get_id(), 7, 30);
+	summary->add_session(sid3.get_id(), 9, 30); // unknown
+
+	// The summary itself carries the MRI of the first session only.
+	msg_event *e = new msg_event(new session_id(sid1),
+		new ntlp_msg(sid1, summary, create_mri("192.168.0.1"), 0));
+
+	d->process(e);
+	delete e;
+
+	CPPUNIT_ASSERT_EQUAL( 3, (int) d->refreshes.size() );
+
+	CPPUNIT_ASSERT( d->refreshes[0]->get_session_id() == sid1 );
+	CPPUNIT_ASSERT( get_source(d->refreshes[0])
+					== hostaddress("192.168.0.1") );
+	CPPUNIT_ASSERT( d->refreshes[0]->get_anslp_msg()
+						->get_msg_sequence_number() == 4 );
+
+	CPPUNIT_ASSERT( d->refreshes[1]->get_session_id() == sid2 );
+	CPPUNIT_ASSERT( get_source(d->refreshes[1])
+					== hostaddress("192.168.0.2") );
+
+	// no session to ask, the summary's MRI is used
+	CPPUNIT_ASSERT( d->refreshes[2]->get_session_id() == sid3 );
+	CPPUNIT_ASSERT( get_source(d->refreshes[2])
+					== hostaddress("192.168.0.1") );
+
+	delete d;
+	delete mgr;
+	delete conf;
+}
+
+// EOF
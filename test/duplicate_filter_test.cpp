@@ -0,0 +1,150 @@
+/*
+ * Test the duplicate_filter class.
+ *
+ * $Id: duplicate_filter_test.cpp 2016-04-11 09:30:00 amarentes $
+ * $HeadURL: https://./test/duplicate_filter_test.cpp $
+ */
+#include <vector>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "duplicate_filter.h"
+#include "msg/ntlp_msg.h"
+#include "msg/anslp_msg.h"
+#include "msg/information_code.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+class DuplicateFilterTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( DuplicateFilterTest );
+
+	CPPUNIT_TEST( testLookup );
+	CPPUNIT_TEST( testReply );
+	CPPUNIT_TEST( testCapacity );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testLookup();
+	void testReply();
+	void testCapacity();
+
+  private:
+	ntlp_msg *create_msg(uint32 msn, uint32 lifetime) const;
+	ntlp_msg *refresh_msg(uint32 msn) const;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( DuplicateFilterTest );
+
+
+ntlp_msg *DuplicateFilterTest::create_msg(uint32 msn, uint32 lifetime) const {
+	anslp_create *create = new anslp_create();
+	create->set_msg_sequence_number(msn);
+	create->set_session_lifetime(lifetime);
+
+	ntlp::mri *mri = new ntlp::mri_pathcoupled(
+		hostaddress("192.168.0.4"), 32, 0,
+		hostaddress("192.168.0.5"), 32, 0,
+		"tcp", 0, 0, 0, true
+	);
+
+	return new ntlp_msg(session_id(), create, mri, 0);
+}
+
+
+ntlp_msg *DuplicateFilterTest::refresh_msg(uint32 msn) const {
+	anslp_refresh *refresh = new anslp_refresh();
+	refresh->set_msg_sequence_number(msn);
+	refresh->set_session_lifetime(10);
+
+	return new ntlp_msg(session_id(), refresh, 
+						new ntlp::mri_pathcoupled(), 0);
+}
+
+
+void DuplicateFilterTest::testLookup() {
+	duplicate_filter filter;
+	ntlp_msg *c1 = create_msg(47, 10);
+	ntlp_msg *c2 = create_msg(47, 20);	// same MSN, other contents
+	ntlp_msg *r1 = refresh_msg(48);
+	const ntlp_msg *reply;
+
+	CPPUNIT_ASSERT( duplicate_filter::is_filtered(c1) );
+	CPPUNIT_ASSERT( ! duplicate_filter::is_filtered(r1) );
+	CPPUNIT_ASSERT( ! duplicate_filter::is_filtered(NULL) );
+
+	content_digest d1 = c1->get_anslp_msg()->get_digest();
+	content_digest d2 = c2->get_anslp_msg()->get_digest();
+	CPPUNIT_ASSERT( d1 != d2 );
+
+	CPPUNIT_ASSERT( ! filter.lookup(c1, d1, reply) );
+	filter.record(c1, d1);
+	CPPUNIT_ASSERT( filter.lookup(c1, d1, reply) );
+	CPPUNIT_ASSERT( reply == NULL );
+	CPPUNIT_ASSERT( ! filter.lookup(c2, d2, reply) );
+
+	delete r1;
+	delete c2;
+	delete c1;
+}
+
+
+void DuplicateFilterTest::testReply() {
+	duplicate_filter filter;
+	ntlp_msg *c1 = create_msg(47, 10);
+	content_digest d1 = c1->get_anslp_msg()->get_digest();
+	const ntlp_msg *reply;
+
+	filter.record(c1, d1);
+
+	// A response to some other MSN is not kept.
+	ntlp_msg *r1 = refresh_msg(48);
+	ntlp_msg *other = r1->create_success_response(10);
+	filter.record_reply(other);
+	CPPUNIT_ASSERT( filter.lookup(c1, d1, reply) && reply == NULL );
+
+	ntlp_msg *resp = c1->create_success_response(10);
+	filter.record_reply(resp);
+	CPPUNIT_ASSERT( filter.lookup(c1, d1, reply) );
+	CPPUNIT_ASSERT( reply != NULL && reply != resp );
+	CPPUNIT_ASSERT( reply->get_anslp_response() != NULL );
+	CPPUNIT_ASSERT( reply->get_anslp_response()->get_msg_sequence_number() == 47 );
+
+	filter.clear();
+	CPPUNIT_ASSERT( ! filter.lookup(c1, d1, reply) );
+
+	delete resp;
+	delete other;
+	delete r1;
+	delete c1;
+}
+
+
+void DuplicateFilterTest::testCapacity() {
+	duplicate_filter filter;
+	std::vector<ntlp_msg *> msgs;
+	const ntlp_msg *reply;
+
+	for ( uint32 i = 0; i <= duplicate_filter::CAPACITY; i++ ) {
+		msgs.push_back(create_msg(i, 10));
+		filter.record(msgs[i], msgs[i]->get_anslp_msg()->get_digest());
+	}
+
+	// The oldest entry made room for the last one.
+	CPPUNIT_ASSERT( ! filter.lookup(msgs[0], 
+			msgs[0]->get_anslp_msg()->get_digest(), reply) );
+
+	for ( uint32 i = 1; i < msgs.size(); i++ )
+		CPPUNIT_ASSERT( filter.lookup(msgs[i], 
+				msgs[i]->get_anslp_msg()->get_digest(), reply) );
+
+	for ( uint32 i = 0; i < msgs.size(); i++ )
+		delete msgs[i];
+}
+
+// EOF
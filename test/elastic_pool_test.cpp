@@ -0,0 +1,117 @@
+/*
+ * Test the elastic_pool class.
+ *
+ * $Id: elastic_pool_test.cpp 2016-04-22 10:00:00 amarentes $
+ * $HeadURL: https://./test/elastic_pool_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "elastic_pool.h"
+
+
+using namespace anslp;
+
+
+class ElasticPoolTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( ElasticPoolTest );
+
+	CPPUNIT_TEST( testFixed );
+	CPPUNIT_TEST( testGrow );
+	CPPUNIT_TEST( testShrink );
+	CPPUNIT_TEST( testPark );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testFixed();
+	void testGrow();
+	void testShrink();
+	void testPark();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( ElasticPoolTest );
+
+
+void ElasticPoolTest::testFixed() {
+	elastic_pool pool(2, 1, 10, 100);
+
+	CPPUNIT_ASSERT( ! pool.is_elastic() );
+	CPPUNIT_ASSERT( pool.start_worker() );
+	CPPUNIT_ASSERT( pool.start_worker() );
+	CPPUNIT_ASSERT( ! pool.start_worker() );
+
+	CPPUNIT_ASSERT( ! pool.report_delay(1000, 1000) );
+	CPPUNIT_ASSERT( ! pool.retire(0, 1000) );
+	CPPUNIT_ASSERT_EQUAL( 2u, pool.get_size() );
+
+	// A target of 0 turns the pool into a fixed one, too.
+	elastic_pool pool2(1, 4, 0, 100);
+	CPPUNIT_ASSERT( ! pool2.is_elastic() );
+}
+
+
+void ElasticPoolTest::testGrow() {
+	elastic_pool pool(1, 3, 10, 100);
+
+	CPPUNIT_ASSERT( pool.start_worker() );
+	CPPUNIT_ASSERT( ! pool.start_worker() );
+	CPPUNIT_ASSERT( ! pool.start_worker() );
+	CPPUNIT_ASSERT_EQUAL( 1u, pool.get_size() );
+
+	// Delays up to the target keep the pool as it is.
+	CPPUNIT_ASSERT( ! pool.report_delay(10, 1000) );
+
+	CPPUNIT_ASSERT( pool.report_delay(11, 1000) );
+	CPPUNIT_ASSERT_EQUAL( 2u, pool.get_size() );
+
+	// At most one thread per target delay.
+	CPPUNIT_ASSERT( ! pool.report_delay(50, 1005) );
+	CPPUNIT_ASSERT( pool.report_delay(50, 1010) );
+	CPPUNIT_ASSERT_EQUAL( 3u, pool.get_size() );
+
+	// Never more than max_workers.
+	CPPUNIT_ASSERT( ! pool.report_delay(50, 2000) );
+
+	elastic_pool_stats s = pool.get_stats();
+	CPPUNIT_ASSERT_EQUAL( 3u, s.size );
+	CPPUNIT_ASSERT_EQUAL( 50u, s.queue_delay_ms );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) 2, s.grown );
+}
+
+
+void ElasticPoolTest::testShrink() {
+	elastic_pool pool(1, 2, 10, 100);
+
+	CPPUNIT_ASSERT( pool.start_worker() );
+	CPPUNIT_ASSERT( ! pool.start_worker() );
+	CPPUNIT_ASSERT( pool.report_delay(20, 1000) );
+	CPPUNIT_ASSERT_EQUAL( 2u, pool.get_size() );
+
+	CPPUNIT_ASSERT( ! pool.retire(1000, 1099) );
+	CPPUNIT_ASSERT( pool.retire(1000, 1100) );
+	CPPUNIT_ASSERT_EQUAL( 1u, pool.get_size() );
+
+	// The last min_workers threads keep working.
+	CPPUNIT_ASSERT( ! pool.retire(1000, 5000) );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) 1, pool.get_stats().shrunk );
+}
+
+
+void ElasticPoolTest::testPark() {
+	elastic_pool pool(1, 2, 10, 100);
+
+	CPPUNIT_ASSERT( pool.start_worker() );
+	CPPUNIT_ASSERT( ! pool.start_worker() );
+
+	// Nobody wakes a parked thread, it times out.
+	CPPUNIT_ASSERT( ! pool.park(10) );
+
+	// A wakeup is kept until a thread parks.
+	CPPUNIT_ASSERT( pool.report_delay(20, 1000) );
+	CPPUNIT_ASSERT( pool.park(10) );
+	CPPUNIT_ASSERT( ! pool.park(10) );
+}
+
+// EOF
@@ -0,0 +1,165 @@
+/*
+ * Test the epoch_manager class.
+ *
+ * $Id: epoch_manager_test.cpp 2016-03-15 09:40:00 amarentes $
+ * $HeadURL: https://./test/epoch_manager_test.cpp $
+ */
+#include <pthread.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "session.h"
+#include "epoch_manager.h"
+
+using namespace anslp;
+
+
+/*
+ * A minimal session that counts how often sessions are deleted.
+ */
+class counting_session : public session {
+  public:
+	counting_session(int *deleted) : session(), deleted(deleted) { }
+	
+	virtual ~counting_session() { (*deleted)++; }
+	
+	virtual bool is_final() const { return true; }
+	
+  protected:
+	virtual void process_event(dispatcher *d, event *evt) { }
+	
+  private:
+	int *deleted;
+};
+
+
+struct reader_param {
+	epoch_manager *mgr;
+	volatile int entered;
+	volatile int release;
+};
+
+static void *reader(void *arg)
+{
+	reader_param *p = reinterpret_cast<reader_param *>(arg);
+
+	p->mgr->enter();
+	p->entered = 1;
+	
+	while ( ! p->release )
+		sched_yield();
+
+	p->mgr->leave();
+	p->mgr->unregister_thread();
+
+	return NULL;
+}
+
+
+class EpochManagerTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( EpochManagerTest );
+
+	CPPUNIT_TEST( testNoReaders );
+	CPPUNIT_TEST( testNested );
+	CPPUNIT_TEST( testBlockingReader );
+	CPPUNIT_TEST( testDestructor );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testNoReaders();
+	void testNested();
+	void testBlockingReader();
+	void testDestructor();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( EpochManagerTest );
+
+
+void EpochManagerTest::testNoReaders() 
+{
+	int deleted = 0;
+	epoch_manager mgr;
+	
+	// Nobody can observe the session, it is deleted right away.
+	mgr.retire(new counting_session(&deleted));
+	
+	CPPUNIT_ASSERT( deleted == 1 );
+	CPPUNIT_ASSERT( mgr.get_num_retired() == 0 );
+
+	mgr.retire(NULL);
+	CPPUNIT_ASSERT( mgr.get_num_retired() == 0 );
+}
+
+void EpochManagerTest::testNested() 
+{
+	int deleted = 0;
+	epoch_manager mgr;
+	
+	mgr.enter();
+	mgr.enter();
+	
+	mgr.retire(new counting_session(&deleted));
+	mgr.leave();
+
+	// Still inside the outer critical section.
+	CPPUNIT_ASSERT( deleted == 0 );
+	
+	mgr.leave();
+
+	CPPUNIT_ASSERT( deleted == 1 );
+	
+	mgr.unregister_thread();
+}
+
+void EpochManagerTest::testBlockingReader() 
+{
+	int deleted = 0;
+	epoch_manager mgr;
+	reader_param param = { &mgr, 0, 0 };
+	
+	pthread_t t;
+	pthread_create(&t, NULL, reader, &param);
+	
+	while ( ! param.entered )
+		sched_yield();
+
+	// The reader may have looked up the session before it was removed.
+	mgr.retire(new counting_session(&deleted));
+	mgr.retire(new counting_session(&deleted));
+	
+	CPPUNIT_ASSERT( deleted == 0 );
+	CPPUNIT_ASSERT( mgr.get_num_retired() == 2 );
+
+	param.release = 1;
+	pthread_join(t, NULL);
+	
+	// The reader collected the sessions on leaving.
+	CPPUNIT_ASSERT( deleted == 2 );
+	CPPUNIT_ASSERT( mgr.get_num_retired() == 0 );
+}
+
+void EpochManagerTest::testDestructor() 
+{
+	int deleted = 0;
+	
+	{
+		epoch_manager mgr;
+		
+		mgr.enter();
+		mgr.retire(new counting_session(&deleted));
+		mgr.leave();
+		mgr.enter();
+		mgr.retire(new counting_session(&deleted));
+		
+		CPPUNIT_ASSERT( mgr.get_num_retired() > 0 );
+		
+		// The manager goes away with the thread still inside.
+	}
+
+	CPPUNIT_ASSERT( deleted == 2 );
+}
+
+// EOF
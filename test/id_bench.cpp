@@ -0,0 +1,57 @@
+/*
+ * Compare the pooled id generator against the former per-call generation
+ * of session ids (RAND_bytes) and rule keys (uuid_generate_time_safe).
+ *
+ * usage: id_bench [ids]
+ *
+ * $Id: id_bench.cpp 2016-03-14 10:12:00 amarentes $
+ * $HeadURL: https://./test/id_bench.cpp $
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <iostream>
+#include <openssl/rand.h>
+#include <uuid/uuid.h>
+
+#include "id_generator.h"
+
+
+using namespace anslp;
+
+
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+int main(int argc, char *argv[]) {
+	unsigned long num_ids = ( argc > 1 ) ? atol(argv[1]) : 100000;
+
+	uint128 id;
+	uuid_t uuid;
+
+	double start = now();
+	for ( unsigned long i = 0; i < num_ids; i++ )
+		RAND_bytes((unsigned char *) &id, sizeof(id));
+	double t_rand = now() - start;
+
+	start = now();
+	for ( unsigned long i = 0; i < num_ids; i++ )
+		uuid_generate_time_safe(uuid);
+	double t_uuid = now() - start;
+
+	start = now();
+	for ( unsigned long i = 0; i < num_ids; i++ )
+		id_generator::generate(id);
+	double t_pool = now() - start;
+
+	std::cout << "ids generated: " << num_ids << std::endl
+			  << "RAND_bytes per id:         " << t_rand << " s" << std::endl
+			  << "uuid_generate_time_safe:   " << t_uuid << " s" << std::endl
+			  << "id_generator:              " << t_pool << " s" << std::endl;
+
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * Test the id_generator class.
+ *
+ * $Id: id_generator_test.cpp 2016-03-14 10:12:00 amarentes $
+ * $HeadURL: https://./test/id_generator_test.cpp $
+ */
+#include <set>
+#include <pthread.h>
+#include <uuid/uuid.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "id_generator.h"
+#include "session_id.h"
+#include "mspec_rule_key.h"
+
+using namespace anslp;
+
+
+static void *generate_ids(void *arg)
+{
+	std::vector<session_id> *ids = 
+		reinterpret_cast<std::vector<session_id> *>(arg);
+	
+	for ( unsigned i = 0; i < ids->capacity(); i++ )
+		ids->push_back(session_id());
+	
+	return NULL;
+}
+
+
+class Id_Generator_Test : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( Id_Generator_Test );
+
+	CPPUNIT_TEST( testUnique );
+	CPPUNIT_TEST( testRefill );
+	CPPUNIT_TEST( testThreads );
+	CPPUNIT_TEST( testRuleKey );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+	void testUnique();
+	void testRefill();
+	void testThreads();
+	void testRuleKey();
+
+  private:
+  
+	static const unsigned NUM_IDS = 100000;
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( Id_Generator_Test );
+
+
+void Id_Generator_Test::setUp() 
+{
+
+}
+
+void Id_Generator_Test::tearDown() 
+{
+
+}
+
+void Id_Generator_Test::testUnique()
+{
+	std::set<std::string> seen;
+	
+	for ( unsigned i = 0; i < NUM_IDS; i++ ){
+		session_id id;
+		CPPUNIT_ASSERT( seen.insert(id.to_string()).second );
+	}
+}
+
+void Id_Generator_Test::testRefill()
+{
+	unsigned long before = id_generator::get_refill_count();
+	
+	uint128 id;
+	unsigned ids_per_pool = id_generator::POOL_SIZE / sizeof(id);
+	
+	for ( unsigned i = 0; i < 2 * ids_per_pool; i++ )
+		id_generator::generate(id);
+	
+	unsigned long refills = id_generator::get_refill_count() - before;
+	
+	// One refill per pool worth of ids, the first one may be partial.
+	CPPUNIT_ASSERT( refills >= 2 && refills <= 3 );
+	
+	// Requests larger than the pool are served as well.
+	unsigned char big[id_generator::POOL_SIZE + 100];
+	id_generator::generate(big, sizeof(big));
+}
+
+void Id_Generator_Test::testThreads()
+{
+	std::vector<session_id> ids1, ids2;
+	ids1.reserve(NUM_IDS / 10);
+	ids2.reserve(NUM_IDS / 10);
+	
+	pthread_t t1, t2;
+	pthread_create(&t1, NULL, generate_ids, &ids1);
+	pthread_create(&t2, NULL, generate_ids, &ids2);
+	pthread_join(t1, NULL);
+	pthread_join(t2, NULL);
+	
+	std::set<std::string> seen;
+	for ( unsigned i = 0; i < ids1.size(); i++ )
+		CPPUNIT_ASSERT( seen.insert(ids1[i].to_string()).second );
+
+	for ( unsigned i = 0; i < ids2.size(); i++ )
+		CPPUNIT_ASSERT( seen.insert(ids2[i].to_string()).second );
+}
+
+void Id_Generator_Test::testRuleKey()
+{
+	mspec_rule_key key1;
+	mspec_rule_key key2;
+	
+	CPPUNIT_ASSERT( key1 != key2 );
+	
+	// Keys are valid random (version 4) uuids.
+	std::string str = key1.to_string();
+	CPPUNIT_ASSERT( str.size() == 36 );
+	CPPUNIT_ASSERT( str[14] == '4' );
+	
+	uuid_t parsed;
+	CPPUNIT_ASSERT( uuid_parse(str.c_str(), parsed) == 0 );
+}
+
+// EOF
@@ -0,0 +1,118 @@
+/*
+ * Test the ie_store class.
+ *
+ * $Id: ie_store_test.cpp 2016-04-06 11:05:00 amarentes $
+ * $HeadURL: https://./test/ie_store_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "msg/ie_store.h"
+#include "msg/msg_sequence_number.h"
+
+
+using namespace anslp::msg;
+
+
+class IeStoreTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( IeStoreTest );
+
+	CPPUNIT_TEST( testBasics );
+	CPPUNIT_TEST( testOrder );
+	CPPUNIT_TEST( testMaxSequence );
+	CPPUNIT_TEST( testCopying );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testBasics();
+	void testOrder();
+	void testMaxSequence();
+	void testCopying();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( IeStoreTest );
+
+
+void IeStoreTest::testBasics() {
+	ie_store store;
+	ie_object_key k1(0xF7, 1);
+	ie_object_key k2(0xF9, 1);
+
+	CPPUNIT_ASSERT( store.size() == 0 );
+	CPPUNIT_ASSERT( store.get(k1) == NULL );
+
+	store.set(k1, new msg_sequence_number(1));
+	store.set(k2, new msg_sequence_number(2));
+	CPPUNIT_ASSERT( store.size() == 2 );
+
+	// Replacing deletes the old entry.
+	store.set(k1, new msg_sequence_number(3));
+	CPPUNIT_ASSERT( store.size() == 2 );
+	CPPUNIT_ASSERT( *store.get(k1) == msg_sequence_number(3) );
+
+	IE *ie = store.remove(k2);
+	CPPUNIT_ASSERT( ie != NULL );
+	CPPUNIT_ASSERT( store.remove(k2) == NULL );
+	CPPUNIT_ASSERT( store.size() == 1 );
+	delete ie;
+}
+
+
+/*
+ * Keys whose type and sequence number add up to the same value are still
+ * different keys.
+ */
+void IeStoreTest::testOrder() {
+	ie_store store;
+
+	store.set(ie_object_key(0xFA, 1), new msg_sequence_number(1));
+	store.set(ie_object_key(0xF9, 2), new msg_sequence_number(2));
+	store.set(ie_object_key(0xF9, 1), new msg_sequence_number(3));
+
+	CPPUNIT_ASSERT( store.size() == 3 );
+	CPPUNIT_ASSERT( *store.get(ie_object_key(0xFA, 1)) == msg_sequence_number(1) );
+	CPPUNIT_ASSERT( *store.get(ie_object_key(0xF9, 2)) == msg_sequence_number(2) );
+
+	ie_store::const_iterator i = store.begin();
+	CPPUNIT_ASSERT( i->first == ie_object_key(0xF9, 1) );
+	i++;
+	CPPUNIT_ASSERT( i->first == ie_object_key(0xF9, 2) );
+	i++;
+	CPPUNIT_ASSERT( i->first == ie_object_key(0xFA, 1) );
+}
+
+
+void IeStoreTest::testMaxSequence() {
+	ie_store store;
+
+	CPPUNIT_ASSERT( store.getMaxSequence(0xF9) == 0 );
+
+	store.set(ie_object_key(0xF7, 1), new msg_sequence_number(1));
+	store.set(ie_object_key(0xF9, 1), new msg_sequence_number(2));
+	store.set(ie_object_key(0xF9, 2), new msg_sequence_number(3));
+	store.set(ie_object_key(0xFA, 1), new msg_sequence_number(4));
+
+	CPPUNIT_ASSERT( store.getMaxSequence(0xF9) == 2 );
+	CPPUNIT_ASSERT( store.getMaxSequence(0xF7) == 1 );
+	CPPUNIT_ASSERT( store.getMaxSequence(0xF8) == 0 );
+}
+
+
+void IeStoreTest::testCopying() {
+	ie_store store;
+
+	store.set(ie_object_key(0xF7, 1), new msg_sequence_number(1));
+	store.set(ie_object_key(0xF9, 1), new msg_sequence_number(2));
+
+	ie_store copy(store);
+	CPPUNIT_ASSERT( copy == store );
+	CPPUNIT_ASSERT( copy.get(ie_object_key(0xF7, 1)) 
+						!= store.get(ie_object_key(0xF7, 1)) );
+
+	copy.set(ie_object_key(0xF9, 1), new msg_sequence_number(5));
+	CPPUNIT_ASSERT( ! (copy == store) );
+}
+
+// EOF
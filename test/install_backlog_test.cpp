@@ -0,0 +1,95 @@
+/*
+ * Test the install_backlog class.
+ *
+ * $Id: install_backlog_test.cpp 2016-04-24 10:00:00 amarentes $
+ * $HeadURL: https://./test/install_backlog_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "install_backlog.h"
+
+
+using namespace anslp;
+
+
+class InstallBacklogTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( InstallBacklogTest );
+
+	CPPUNIT_TEST( testWatermarks );
+	CPPUNIT_TEST( testCapacity );
+	CPPUNIT_TEST( testDisabled );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testWatermarks();
+	void testCapacity();
+	void testDisabled();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( InstallBacklogTest );
+
+
+void InstallBacklogTest::testWatermarks() {
+	install_backlog backlog(0, 100, 50);
+
+	CPPUNIT_ASSERT( ! backlog.update(99) );
+	CPPUNIT_ASSERT( ! backlog.is_full() );
+
+	// Full at the high watermark, reported once.
+	CPPUNIT_ASSERT( backlog.update(100) );
+	CPPUNIT_ASSERT( backlog.is_full() );
+	CPPUNIT_ASSERT( ! backlog.update(120) );
+
+	// Still full between the watermarks.
+	CPPUNIT_ASSERT( ! backlog.update(51) );
+	CPPUNIT_ASSERT( backlog.is_full() );
+
+	CPPUNIT_ASSERT( backlog.update(50) );
+	CPPUNIT_ASSERT( ! backlog.is_full() );
+	CPPUNIT_ASSERT( ! backlog.update(80) );
+
+	backlog.count_throttled();
+
+	install_backlog_stats s = backlog.get_stats();
+	CPPUNIT_ASSERT_EQUAL( 80u, s.occupancy );
+	CPPUNIT_ASSERT_EQUAL( 120u, s.max_occupancy );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) 1, s.filled );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) 1, s.throttled );
+}
+
+
+void InstallBacklogTest::testCapacity() {
+	install_backlog backlog(10, 8, 4);
+
+	CPPUNIT_ASSERT( backlog.admit(9, false) );
+	CPPUNIT_ASSERT( ! backlog.is_full() );
+
+	CPPUNIT_ASSERT( ! backlog.admit(10, false) );
+	CPPUNIT_ASSERT( ! backlog.admit(11, false) );
+
+	// Session removals are always queued.
+	CPPUNIT_ASSERT( backlog.admit(12, true) );
+
+	install_backlog_stats s = backlog.get_stats();
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) 2, s.refused );
+	CPPUNIT_ASSERT_EQUAL( 12u, s.max_occupancy );
+}
+
+
+void InstallBacklogTest::testDisabled() {
+	install_backlog backlog(0, 0, 0);
+
+	CPPUNIT_ASSERT( ! backlog.update(1000000) );
+	CPPUNIT_ASSERT( ! backlog.is_full() );
+	CPPUNIT_ASSERT( backlog.admit(1000000, false) );
+
+	// The low watermark can't be above the high one.
+	install_backlog backlog2(0, 10, 20);
+	CPPUNIT_ASSERT( backlog2.update(10) );
+	CPPUNIT_ASSERT( backlog2.update(10) );
+}
+
+// EOF
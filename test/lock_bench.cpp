@@ -0,0 +1,137 @@
+/*
+ * Compare the session lock strategies under contention.
+ *
+ * Every thread repeatedly acquires one shared lock, does some work 
+ * inside and outside of the critical section, and releases it. The work
+ * inside is about as long as a session's state machine step, so the 
+ * results show which strategy suits the session locks.
+ *
+ * usage: lock_bench [threads] [iterations] [work]
+ *
+ * $Id: lock_bench.cpp 2016-04-20 11:00:00 amarentes $
+ * $HeadURL: https://./test/lock_bench.cpp $
+ */
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <iostream>
+#include <iomanip>
+
+#include "thread_mutex_lockable.h"
+#include "spin_park_lockable.h"
+#include "rw_lockable.h"
+#include "profiled_mutex_lockable.h"
+
+
+using namespace anslp;
+
+
+struct bench_param {
+	lockable *l;
+	unsigned long iterations;
+	unsigned long work;
+	unsigned int shared_percent;
+	volatile unsigned long counter;
+};
+
+
+static inline void do_work(unsigned long work) {
+	for ( volatile unsigned long i = 0; i < work; i++ )
+		;
+}
+
+
+static void *bench_thread(void *arg) {
+	bench_param *p = (bench_param *) arg;
+	unsigned int seed = (unsigned int) (size_t) pthread_self();
+
+	for ( unsigned long i = 0; i < p->iterations; i++ ) {
+		if ( p->shared_percent > 0 
+				&& (unsigned int) rand_r(&seed) % 100 < p->shared_percent ) {
+			p->l->acquire_shared();
+			do_work(p->work);
+			p->l->release_shared();
+		}
+		else {
+			p->l->acquire();
+			do_work(p->work);
+			p->counter++;
+			p->l->release();
+		}
+
+		// the rest of the event's processing, outside of the lock
+		do_work(p->work);
+	}
+
+	return NULL;
+}
+
+
+static double now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void run(const char *name, lockable *l, unsigned int threads, 
+				unsigned long iterations, unsigned long work,
+				unsigned int shared_percent = 0) {
+
+	bench_param p;
+	p.l = l;
+	p.iterations = iterations;
+	p.work = work;
+	p.shared_percent = shared_percent;
+	p.counter = 0;
+
+	pthread_t *ids = new pthread_t[threads];
+
+	double start = now();
+
+	for ( unsigned int i = 0; i < threads; i++ )
+		pthread_create(&ids[i], NULL, bench_thread, &p);
+
+	for ( unsigned int i = 0; i < threads; i++ )
+		pthread_join(ids[i], NULL);
+
+	double elapsed = now() - start;
+
+	delete[] ids;
+
+	std::cout << std::setw(24) << std::left << name 
+			  << std::setw(12) << std::right 
+			  << (unsigned long) ( threads * iterations / elapsed )
+			  << " ops/s" << std::endl;
+}
+
+
+int main(int argc, char *argv[]) {
+	unsigned int threads = ( argc > 1 ) ? atoi(argv[1]) : 4;
+	unsigned long iterations = ( argc > 2 ) ? atol(argv[2]) : 1000000;
+	unsigned long work = ( argc > 3 ) ? atol(argv[3]) : 100;
+
+	std::cout << threads << " threads, " << iterations 
+			  << " iterations each, work " << work << std::endl;
+
+	thread_mutex_lockable mutex;
+	run("mutex", &mutex, threads, iterations, work);
+
+	spin_park_lockable spin;
+	run("spin", &spin, threads, iterations, work);
+
+	rw_lockable rwlock;
+	run("rwlock", &rwlock, threads, iterations, work);
+
+	rw_lockable rwlock_shared;
+	run("rwlock 50% shared", &rwlock_shared, threads, iterations, work, 50);
+
+	lock_profile profile("bench");
+	profiled_mutex_lockable profiled(&profile);
+	run("profiled mutex", &profiled, threads, iterations, work);
+
+	std::cout << profile.get_stats() << std::endl;
+
+	return 0;
+}
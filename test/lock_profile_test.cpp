@@ -0,0 +1,142 @@
+/*
+ * Test the lock_profile and profiled_mutex_lockable classes.
+ *
+ * $Id: lock_profile_test.cpp 2016-04-19 09:30:00 amarentes $
+ * $HeadURL: https://./test/lock_profile_test.cpp $
+ */
+#include <unistd.h>
+#include <pthread.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "lock_profile.h"
+#include "profiled_mutex_lockable.h"
+
+
+using namespace anslp;
+
+
+class LockProfileTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( LockProfileTest );
+
+	CPPUNIT_TEST( testBuckets );
+	CPPUNIT_TEST( testRecord );
+	CPPUNIT_TEST( testUncontended );
+	CPPUNIT_TEST( testContended );
+	CPPUNIT_TEST( testDump );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testBuckets();
+	void testRecord();
+	void testUncontended();
+	void testContended();
+	void testDump();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LockProfileTest );
+
+
+void LockProfileTest::testBuckets() {
+	CPPUNIT_ASSERT_EQUAL( 0, (int) lock_profile::get_bucket(0) );
+	CPPUNIT_ASSERT_EQUAL( 0, (int) lock_profile::get_bucket(1) );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) lock_profile::get_bucket(2) );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) lock_profile::get_bucket(3) );
+	CPPUNIT_ASSERT_EQUAL( 10, (int) lock_profile::get_bucket(1024) );
+	CPPUNIT_ASSERT_EQUAL( (int) lock_profile_stats::NUM_BUCKETS - 1,
+		(int) lock_profile::get_bucket((uint64_t) -1) );
+}
+
+
+void LockProfileTest::testRecord() {
+	lock_profile profile("test");
+
+	for ( int i = 0; i < 98; i++ ) {
+		profile.record_acquire(0, false);
+		profile.record_release(100);
+	}
+
+	profile.record_acquire(5000, true);
+	profile.record_release(100000);
+	profile.record_acquire(3000, true);
+	profile.record_release(100);
+
+	lock_profile_stats s = profile.get_stats();
+	CPPUNIT_ASSERT( s.name == "test" );
+	CPPUNIT_ASSERT_EQUAL( 100, (int) s.acquisitions );
+	CPPUNIT_ASSERT_EQUAL( 2, (int) s.contended );
+	CPPUNIT_ASSERT_EQUAL( 8000, (int) s.total_wait_ns );
+	CPPUNIT_ASSERT_EQUAL( 5000, (int) s.max_wait_ns );
+	CPPUNIT_ASSERT_EQUAL( 100000, (int) s.max_hold_ns );
+
+	// 100 ns fall into [64, 128)
+	CPPUNIT_ASSERT_EQUAL( 127, (int) s.get_percentile(s.hold, 50) );
+	CPPUNIT_ASSERT_EQUAL( 127, (int) s.get_percentile(s.hold, 99) );
+	CPPUNIT_ASSERT_EQUAL( 131071, (int) s.get_percentile(s.hold, 100) );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.get_percentile(s.wait, 98) );
+	CPPUNIT_ASSERT_EQUAL( 4095, (int) s.get_percentile(s.wait, 99) );
+}
+
+
+void LockProfileTest::testUncontended() {
+	lock_profile profile("test");
+	profiled_mutex_lockable l(&profile);
+
+	for ( int i = 0; i < 10; i++ ) {
+		l.acquire();
+		l.release();
+	}
+
+	lock_profile_stats s = profile.get_stats();
+	CPPUNIT_ASSERT_EQUAL( 10, (int) s.acquisitions );
+	CPPUNIT_ASSERT_EQUAL( 0, (int) s.contended );
+	CPPUNIT_ASSERT_EQUAL( 10, (int) s.wait[0] );
+}
+
+
+static void *hold_lock(void *arg) {
+	lockable *l = (lockable *) arg;
+
+	l->acquire();
+	usleep(50000);
+	l->release();
+
+	return NULL;
+}
+
+
+void LockProfileTest::testContended() {
+	lock_profile profile("test");
+	profiled_mutex_lockable l(&profile);
+
+	l.acquire();
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, hold_lock, &l);
+	
+	// let the thread block on the lock
+	usleep(20000);
+	l.release();
+
+	pthread_join(thread, NULL);
+
+	lock_profile_stats s = profile.get_stats();
+	CPPUNIT_ASSERT_EQUAL( 2, (int) s.acquisitions );
+	CPPUNIT_ASSERT_EQUAL( 1, (int) s.contended );
+	CPPUNIT_ASSERT( s.max_wait_ns >= 10000000 );
+	CPPUNIT_ASSERT( s.max_hold_ns >= 40000000 );
+}
+
+
+void LockProfileTest::testDump() {
+	CPPUNIT_ASSERT( ! lock_profile::claim_dump() );
+
+	lock_profile::request_dump();
+	CPPUNIT_ASSERT( lock_profile::claim_dump() );
+	CPPUNIT_ASSERT( ! lock_profile::claim_dump() );
+}
+
+// EOF
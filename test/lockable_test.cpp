@@ -0,0 +1,165 @@
+/*
+ * Test the spin_park_lockable and rw_lockable classes.
+ *
+ * $Id: lockable_test.cpp 2016-04-20 11:00:00 amarentes $
+ * $HeadURL: https://./test/lockable_test.cpp $
+ */
+#include <unistd.h>
+#include <pthread.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "spin_park_lockable.h"
+#include "rw_lockable.h"
+
+
+using namespace anslp;
+
+
+class LockableTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( LockableTest );
+
+	CPPUNIT_TEST( testSpinExclusion );
+	CPPUNIT_TEST( testSpinPark );
+	CPPUNIT_TEST( testRwExclusion );
+	CPPUNIT_TEST( testRwShared );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testSpinExclusion();
+	void testSpinPark();
+	void testRwExclusion();
+	void testRwShared();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( LockableTest );
+
+
+struct counter_param {
+	lockable *l;
+	int iterations;
+	int counter;
+};
+
+
+static void *count_up(void *arg) {
+	counter_param *p = (counter_param *) arg;
+
+	for ( int i = 0; i < p->iterations; i++ ) {
+		p->l->acquire();
+		int c = p->counter;
+		sched_yield();
+		p->counter = c + 1;
+		p->l->release();
+	}
+
+	return NULL;
+}
+
+
+/*
+ * Let a few threads increment a counter non-atomically under the lock.
+ */
+static int count(lockable *l) {
+	counter_param p;
+	p.l = l;
+	p.iterations = 1000;
+	p.counter = 0;
+
+	pthread_t threads[4];
+	for ( int i = 0; i < 4; i++ )
+		pthread_create(&threads[i], NULL, count_up, &p);
+
+	for ( int i = 0; i < 4; i++ )
+		pthread_join(threads[i], NULL);
+
+	return p.counter;
+}
+
+
+void LockableTest::testSpinExclusion() {
+	spin_park_lockable l;
+	CPPUNIT_ASSERT_EQUAL( 4000, count(&l) );
+}
+
+
+static void *hold(void *arg) {
+	lockable *l = (lockable *) arg;
+
+	l->acquire();
+	usleep(20000);
+	l->release();
+
+	return NULL;
+}
+
+
+void LockableTest::testSpinPark() {
+	// no spinning at all, a waiting thread blocks right away
+	spin_park_lockable l(0);
+
+	pthread_t thread;
+	pthread_create(&thread, NULL, hold, &l);
+	usleep(5000);
+
+	l.acquire();
+	l.release();
+
+	pthread_join(thread, NULL);
+}
+
+
+void LockableTest::testRwExclusion() {
+	rw_lockable l;
+	CPPUNIT_ASSERT_EQUAL( 4000, count(&l) );
+}
+
+
+struct reader_param {
+	lockable *l;
+	volatile int inside;
+	volatile int max_inside;
+};
+
+
+static void *read_shared(void *arg) {
+	reader_param *p = (reader_param *) arg;
+
+	p->l->acquire_shared();
+	
+	int inside = __sync_add_and_fetch(&p->inside, 1);
+	if ( inside > p->max_inside )
+		p->max_inside = inside;
+
+	usleep(20000);
+	__sync_sub_and_fetch(&p->inside, 1);
+
+	p->l->release_shared();
+
+	return NULL;
+}
+
+
+void LockableTest::testRwShared() {
+	rw_lockable l;
+
+	reader_param p;
+	p.l = &l;
+	p.inside = 0;
+	p.max_inside = 0;
+
+	pthread_t threads[2];
+	for ( int i = 0; i < 2; i++ )
+		pthread_create(&threads[i], NULL, read_shared, &p);
+
+	for ( int i = 0; i < 2; i++ )
+		pthread_join(threads[i], NULL);
+
+	// both readers held the lock at the same time
+	CPPUNIT_ASSERT_EQUAL( 2, (int) p.max_inside );
+}
+
+// EOF
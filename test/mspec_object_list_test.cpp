@@ -0,0 +1,182 @@
+/*
+ * Test the mspec_object_list class.
+ *
+ * $Id: mspec_object_list_test.cpp 2016-04-08 10:20:00 amarentes $
+ * $HeadURL: https://./test/mspec_object_list_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <vector>
+
+#include "mspec_object_list.h"
+#include "msg/anslp_opaque_mspec.h"
+
+
+using namespace anslp;
+using namespace anslp::msg;
+
+
+class MspecObjectListTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( MspecObjectListTest );
+
+	CPPUNIT_TEST( testBasics );
+	CPPUNIT_TEST( testExchange );
+	CPPUNIT_TEST( testErase );
+	CPPUNIT_TEST( testIndex );
+	CPPUNIT_TEST( testCopying );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testBasics();
+	void testExchange();
+	void testErase();
+	void testIndex();
+	void testCopying();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( MspecObjectListTest );
+
+
+void MspecObjectListTest::testBasics() {
+	mspec_object_list list;
+	mspec_rule_key k1, k2;
+	anslp_opaque_mspec o1;
+
+	CPPUNIT_ASSERT( list.empty() );
+	CPPUNIT_ASSERT( list.find(k1) == list.end() );
+
+	list[k1] = &o1;
+	CPPUNIT_ASSERT( list.size() == 1 );
+	CPPUNIT_ASSERT( list.find(k1) != list.end() );
+	CPPUNIT_ASSERT( list.find(k1)->second == &o1 );
+	CPPUNIT_ASSERT( list.find(k2) == list.end() );
+
+	// Like std::map, operator[] inserts a NULL object for unknown keys.
+	CPPUNIT_ASSERT( list[k2] == NULL );
+	CPPUNIT_ASSERT( list.size() == 2 );
+
+	// Entries are kept in insertion order.
+	CPPUNIT_ASSERT( list.begin()->first == k1 );
+	CPPUNIT_ASSERT( list.rbegin()->first == k2 );
+
+	list.clear();
+	CPPUNIT_ASSERT( list.empty() );
+	CPPUNIT_ASSERT( list.find(k1) == list.end() );
+}
+
+
+void MspecObjectListTest::testExchange() {
+	mspec_object_list list;
+	mspec_rule_key k1;
+	anslp_opaque_mspec o1, o2;
+
+	CPPUNIT_ASSERT( list.exchange(k1, &o1) == NULL );
+	CPPUNIT_ASSERT( list.exchange(k1, &o2) == &o1 );
+	CPPUNIT_ASSERT( list.size() == 1 );
+	CPPUNIT_ASSERT( list.find(k1)->second == &o2 );
+}
+
+
+void MspecObjectListTest::testErase() {
+	mspec_object_list list;
+	std::vector<mspec_rule_key> keys;
+
+	for ( size_t i = 0; i < 5; i++ )
+		keys.push_back(mspec_rule_key());
+
+	for ( size_t i = 0; i < keys.size(); i++ )
+		list[keys[i]] = NULL;
+
+	CPPUNIT_ASSERT( list.erase(keys[1]) == 1 );
+	CPPUNIT_ASSERT( list.erase(keys[1]) == 0 );
+	CPPUNIT_ASSERT( list.size() == 4 );
+	CPPUNIT_ASSERT( list.find(keys[1]) == list.end() );
+
+	// Erase every other entry while iterating.
+	mspec_object_list::iterator it = list.begin();
+	bool drop = true;
+	while ( it != list.end() )
+	{
+		if ( drop )
+			it = list.erase(it);
+		else
+			it++;
+		drop = ! drop;
+	}
+
+	CPPUNIT_ASSERT( list.size() == 2 );
+	CPPUNIT_ASSERT( list.find(keys[2]) != list.end() );
+	CPPUNIT_ASSERT( list.find(keys[4]) != list.end() );
+	CPPUNIT_ASSERT( list.find(keys[0]) == list.end() );
+	CPPUNIT_ASSERT( list.find(keys[3]) == list.end() );
+}
+
+
+void MspecObjectListTest::testIndex() {
+	mspec_object_list list;
+	std::vector<mspec_rule_key> keys;
+	std::vector<anslp_opaque_mspec *> objects;
+
+	for ( size_t i = 0; i < 100; i++ )
+	{
+		keys.push_back(mspec_rule_key());
+		objects.push_back(new anslp_opaque_mspec());
+		list[keys[i]] = objects[i];
+		CPPUNIT_ASSERT( list.is_indexed() 
+						== (list.size() > mspec_object_list::INDEX_THRESHOLD) );
+	}
+
+	for ( size_t i = 0; i < keys.size(); i++ )
+		CPPUNIT_ASSERT( list.find(keys[i])->second == objects[i] );
+
+	mspec_rule_key unknown;
+	CPPUNIT_ASSERT( list.find(unknown) == list.end() );
+
+	// Erasing moves entries, lookups have to follow them.
+	for ( size_t i = 0; i < keys.size(); i += 3 )
+		CPPUNIT_ASSERT( list.erase(keys[i]) == 1 );
+
+	for ( size_t i = 0; i < keys.size(); i++ )
+	{
+		if ( i % 3 == 0 )
+			CPPUNIT_ASSERT( list.find(keys[i]) == list.end() );
+		else
+			CPPUNIT_ASSERT( list.find(keys[i])->second == objects[i] );
+	}
+
+	// Shrinking below the threshold drops the index.
+	while ( list.size() > mspec_object_list::INDEX_THRESHOLD )
+		list.erase(list.begin());
+	CPPUNIT_ASSERT( ! list.is_indexed() );
+
+	for ( size_t i = 0; i < objects.size(); i++ )
+		delete objects[i];
+}
+
+
+void MspecObjectListTest::testCopying() {
+	mspec_object_list list1;
+	std::vector<mspec_rule_key> keys;
+
+	for ( size_t i = 0; i < 20; i++ )
+	{
+		keys.push_back(mspec_rule_key());
+		list1[keys[i]] = NULL;
+	}
+
+	mspec_object_list list2(list1);
+	CPPUNIT_ASSERT( list2.size() == list1.size() );
+	CPPUNIT_ASSERT( list2.find(keys[7]) != list2.end() );
+
+	mspec_object_list list3;
+	list3 = list1;
+	list1.clear();
+	CPPUNIT_ASSERT( list3.size() == keys.size() );
+	CPPUNIT_ASSERT( list3.find(keys[19]) != list3.end() );
+	CPPUNIT_ASSERT( list1.find(keys[19]) == list1.end() );
+}
+
+// EOF
@@ -0,0 +1,104 @@
+/*
+ * Test the netmsg_pool class.
+ *
+ * $Id: netmsg_pool_test.cpp 2016-03-28 11:30:00 amarentes $
+ * $HeadURL: https://./test/netmsg_pool_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "netmsg_pool.h"
+
+using namespace anslp;
+
+
+class NetMsgPoolTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( NetMsgPoolTest );
+
+	CPPUNIT_TEST( testSizeClasses );
+	CPPUNIT_TEST( testReuse );
+	CPPUNIT_TEST( testLarge );
+	CPPUNIT_TEST( testMaxIdle );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void tearDown() { netmsg_pool::clear(); }
+	
+	void testSizeClasses();
+	void testReuse();
+	void testLarge();
+	void testMaxIdle();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( NetMsgPoolTest );
+
+
+void NetMsgPoolTest::testSizeClasses() {
+	NetMsg *m1 = netmsg_pool::acquire(1);
+	NetMsg *m2 = netmsg_pool::acquire(256);
+	NetMsg *m3 = netmsg_pool::acquire(257);
+
+	CPPUNIT_ASSERT( m1->get_size() == 256 );
+	CPPUNIT_ASSERT( m2->get_size() == 256 );
+	CPPUNIT_ASSERT( m3->get_size() == 1024 );
+
+	netmsg_pool::release(m1);
+	netmsg_pool::release(m2);
+	netmsg_pool::release(m3);
+}
+
+
+void NetMsgPoolTest::testReuse() {
+	netmsg_pool::clear();
+	
+	NetMsg *m1 = netmsg_pool::acquire(100);
+	m1->encode32(42);
+	netmsg_pool::release(m1);
+
+	uint32 allocated = netmsg_pool::get_num_allocated();
+
+	for ( int i = 0; i < 100; i++ ) {
+		NetMsg *m2 = netmsg_pool::acquire(200);
+		CPPUNIT_ASSERT( m2 == m1 );
+		CPPUNIT_ASSERT( m2->get_pos() == 0 );
+		netmsg_pool::release(m2);
+	}
+
+	CPPUNIT_ASSERT( netmsg_pool::get_num_allocated() == allocated );
+}
+
+
+void NetMsgPoolTest::testLarge() {
+	uint32 size = 256 * 1024 + 1;
+	
+	NetMsg *m1 = netmsg_pool::acquire(size);
+	CPPUNIT_ASSERT( m1->get_size() == size );
+	
+	// Not kept, deleted right away.
+	netmsg_pool::release(m1);
+}
+
+
+void NetMsgPoolTest::testMaxIdle() {
+	NetMsg *msgs[netmsg_pool::MAX_IDLE + 2];
+	
+	for ( uint32 i = 0; i < netmsg_pool::MAX_IDLE + 2; i++ )
+		msgs[i] = netmsg_pool::acquire(1000);
+
+	for ( uint32 i = 0; i < netmsg_pool::MAX_IDLE + 2; i++ )
+		netmsg_pool::release(msgs[i]);
+
+	uint32 allocated = netmsg_pool::get_num_allocated();
+
+	for ( uint32 i = 0; i < netmsg_pool::MAX_IDLE + 2; i++ )
+		msgs[i] = netmsg_pool::acquire(1000);
+
+	CPPUNIT_ASSERT( netmsg_pool::get_num_allocated() == allocated + 2 );
+
+	for ( uint32 i = 0; i < netmsg_pool::MAX_IDLE + 2; i++ )
+		netmsg_pool::release(msgs[i]);
+}
+
+// EOF
@@ -73,7 +73,7 @@ class InitiatorTest : public CppUnit::TestCase {
 
 	msg::ntlp_msg *create_anslp_response(
 		uint8 severity, uint8 response_code, uint16 msg_type,
-		uint32 msn=START_MSN) const;
+		uint32 msn=START_MSN, uint32 sii_handle=0) const;
 
 	anslp_response *create_anslp_response_with_objects(
 		uint8 severity, uint8 response_code, uint16 msg_type,
@@ -223,7 +223,8 @@ msg::ntlp_msg *InitiatorTest::create_anslp_create() const {
 
 
 msg::ntlp_msg *InitiatorTest::create_anslp_response(uint8 severity,
-		uint8 response_code, uint16 msg_type, uint32 msn) const {
+		uint8 response_code, uint16 msg_type, uint32 msn, 
+		uint32 sii_handle) const {
 
 	anslp_response *resp = new anslp_response();
 	resp->set_information_code(severity, response_code, 
@@ -236,7 +237,7 @@ msg::ntlp_msg *InitiatorTest::create_anslp_response(uint8 severity,
 		"tcp", 0, 0, 0, true
 	);
 
-	return new msg::ntlp_msg(session_id(), resp, ntlp_mri, 0);
+	return new msg::ntlp_msg(session_id(), resp, ntlp_mri, sii_handle);
 }
 
 anslp_response *InitiatorTest::create_anslp_response_with_objects(uint8 severity,
@@ -363,7 +364,7 @@ void InitiatorTest::testPending()
 
 	ntlp_msg *resp1 = create_anslp_response(information_code::sc_success,
 		information_code::suc_successfully_processed,
-		information_code::obj_none);
+		information_code::obj_none, START_MSN, 42);
 
 	event *e1 = new msg_event(NULL, resp1);
 
@@ -371,6 +372,7 @@ void InitiatorTest::testPending()
 	ASSERT_STATE(s1, ni_session::STATE_ANSLP_PENDING_INSTALLING);
 	ASSERT_NO_MESSAGE(d);
 	ASSERT_TIMER_STARTED(d, s1.get_response_timer());
+	CPPUNIT_ASSERT( s1.get_peer_sii_handle() == 42 );
 
 
 	/*
@@ -743,6 +745,54 @@ void InitiatorTest::testAuctioning()
 	ASSERT_REFRESH_MESSAGE_SENT(d);
 	ASSERT_TIMER_STARTED(d, s6.get_response_timer());
 
+	// The next refresh goes out with the MSN patched into the cached image.
+	uint32 msn6 = d->get_message()->get_anslp_msg()->get_msg_sequence_number();
+	s6.get_refresh_timer().set_id(0xABCE);
+
+	process(s6, new timer_event(NULL, 0xABCE));
+	ASSERT_STATE(s6, ni_session::STATE_ANSLP_AUCTIONING);
+	ASSERT_REFRESH_MESSAGE_SENT(d);
+	CPPUNIT_ASSERT( d->get_message()->get_anslp_msg()->get_msg_sequence_number()
+					== msn6 + 1 );
+
+	// After a route change, the next refresh is built for the new MRI.
+	s6.set_mri(new ntlp::mri_pathcoupled(
+		hostaddress("192.168.1.4"), 32, 0,
+		hostaddress("192.168.1.9"), 32, 0,
+		"tcp", 0, 0, 0, true));
+	s6.get_refresh_timer().set_id(0xABD0);
+
+	process(s6, new timer_event(NULL, 0xABD0));
+	ASSERT_REFRESH_MESSAGE_SENT(d);
+	const ntlp::mri_pathcoupled *mri6 = 
+		dynamic_cast<const ntlp::mri_pathcoupled *>(d->get_message()->get_mri());
+	CPPUNIT_ASSERT( mri6 != NULL 
+		&& mri6->get_destaddress() == hostaddress("192.168.1.9") );
+
+	// The same holds for a changed lifetime.
+	s6.set_lifetime(60);
+	s6.get_refresh_timer().set_id(0xABD1);
+
+	process(s6, new timer_event(NULL, 0xABD1));
+	ASSERT_REFRESH_MESSAGE_SENT(d);
+	CPPUNIT_ASSERT( d->get_message()->get_anslp_refresh()
+						->get_session_lifetime() == 60 );
+
+	// Once a peer confirmed a REFRESH, the next ones are sent to it.
+	ni_session_test s6b(ni_session::STATE_ANSLP_AUCTIONING);
+	s6b.set_last_refresh_message(create_anslp_refresh());
+
+	process(s6b, new msg_event(NULL, 
+		create_anslp_response(information_code::sc_success,
+			information_code::suc_successfully_processed,
+			information_code::obj_none, START_MSN, 42)));
+	CPPUNIT_ASSERT( s6b.get_peer_sii_handle() == 42 );
+
+	s6b.get_refresh_timer().set_id(0xABCF);
+	process(s6b, new timer_event(NULL, 0xABCF));
+	ASSERT_REFRESH_MESSAGE_SENT(d);
+	CPPUNIT_ASSERT( d->get_message()->get_sii_handle() == 42 );
+
 
 	/*
 	 * STATE_ANSLP_AUCTIONING ---[tg_BIDDING]---> STATE_ANSLP_AUCTIONING
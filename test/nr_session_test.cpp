@@ -47,6 +47,7 @@ class ResponderTest : public CppUnit::TestCase {
 	CPPUNIT_TEST( testAuctioning );
 	CPPUNIT_TEST( testPendingTeardown );
 	CPPUNIT_TEST( testIntegratedStateMachine );
+	CPPUNIT_TEST( testStateMark );
 
 	CPPUNIT_TEST_SUITE_END();
 
@@ -60,6 +61,7 @@ class ResponderTest : public CppUnit::TestCase {
 	void testAuctioning();
 	void testPendingTeardown();
 	void testIntegratedStateMachine();
+	void testStateMark();
 
   private:
 	static const uint32 START_MSN = 77;
@@ -532,6 +534,33 @@ ResponderTest::testAuctioning() {
 }
 
 
+/*
+ * Only events that change the session leave changes to be saved.
+ */
+void 
+ResponderTest::testStateMark() 
+{
+	nr_session_test s1(nr_session::STATE_ANSLP_AUCTIONING, conf, START_MSN);
+	CPPUNIT_ASSERT( s1.has_unsaved_changes() );
+
+	s1.set_saved(true);
+	CPPUNIT_ASSERT( ! s1.has_unsaved_changes() );
+
+	// MSN too low, the REFRESH is discarded
+	process(s1, new msg_event(NULL, create_anslp_refresh(10, 20), true));
+	ASSERT_NO_MESSAGE(d);
+	CPPUNIT_ASSERT( ! s1.has_unsaved_changes() );
+
+	process(s1, new msg_event(NULL, 
+		create_anslp_refresh(START_MSN+1, 10), true));
+	ASSERT_RESPONSE_MESSAGE_SENT(d, information_code::sc_success);
+	CPPUNIT_ASSERT( s1.has_unsaved_changes() );
+
+	s1.set_saved(false);
+	CPPUNIT_ASSERT( s1.has_unsaved_changes() );
+}
+
+
 void 
 ResponderTest::testPendingTeardown() 
 {
@@ -0,0 +1,187 @@
+/*
+ * Test the refresh_scheduler class.
+ *
+ * $Id: refresh_scheduler_test.cpp 2016-03-21 10:15:00 amarentes $
+ * $HeadURL: https://./test/refresh_scheduler_test.cpp $
+ */
+#include <algorithm>
+#include <map>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "refresh_scheduler.h"
+
+using namespace anslp;
+
+
+class RefreshSchedulerTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( RefreshSchedulerTest );
+
+	CPPUNIT_TEST( testWindow );
+	CPPUNIT_TEST( testSpreading );
+	CPPUNIT_TEST( testWideWindow );
+	CPPUNIT_TEST( testNoJitter );
+	CPPUNIT_TEST( testDeadline );
+	CPPUNIT_TEST( testQueueDepth );
+	CPPUNIT_TEST( testPeerRate );
+	CPPUNIT_TEST( testLate );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testWindow();
+	void testSpreading();
+	void testWideWindow();
+	void testNoJitter();
+	void testDeadline();
+	void testQueueDepth();
+	void testPeerRate();
+	void testLate();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( RefreshSchedulerTest );
+
+
+void RefreshSchedulerTest::testWindow() {
+	refresh_scheduler s(25, 0, 1, 0);
+
+	for ( int i = 0; i < 100; i++ ) {
+		uint32 delay = s.schedule(20000, 30000);
+		
+		CPPUNIT_ASSERT( delay >= 15000 );
+		CPPUNIT_ASSERT( delay <= 20000 );
+	}
+
+	CPPUNIT_ASSERT( s.get_stats().scheduled == 100 );
+}
+
+
+/*
+ * A burst of refreshes is spread evenly over the jitter window.
+ */
+void RefreshSchedulerTest::testSpreading() {
+	refresh_scheduler s(50, 0, 1, 0);
+	std::map<uint64_t, int> per_slot;
+	
+	for ( int i = 0; i < 200; i++ ) {
+		uint32 delay = s.schedule(4000, 10000);
+		
+		CPPUNIT_ASSERT( delay >= 2000 && delay <= 4000 );
+		per_slot[(refresh_scheduler::now_ms() + delay) 
+					/ refresh_scheduler::SLOT_MS]++;
+	}
+
+	CPPUNIT_ASSERT( per_slot.size() >= 20 );
+
+	// Slots at the window borders may be cut by the current time.
+	std::map<uint64_t, int>::iterator i = ++per_slot.begin();
+	std::map<uint64_t, int>::iterator last = --per_slot.end();
+	
+	for ( ; i != last; i++ ) {
+		CPPUNIT_ASSERT( i->second >= 8 );
+		CPPUNIT_ASSERT( i->second <= 12 );
+	}
+}
+
+
+/*
+ * Candidates cover a window wider than MAX_CANDIDATES slots. A window
+ * beyond the ring's horizon is cut.
+ */
+void RefreshSchedulerTest::testWideWindow() {
+	refresh_scheduler s(25, 0, 1, 0);
+	uint32 max_delay = 0;
+
+	// 300 slots
+	for ( int i = 0; i < 200; i++ ) {
+		uint32 delay = s.schedule(120000, 120000);
+
+		CPPUNIT_ASSERT( delay >= 90000 && delay <= 120000 );
+		max_delay = std::max(max_delay, delay);
+	}
+
+	CPPUNIT_ASSERT( max_delay >= 110000 );
+
+	// 10000 slots
+	const uint32 horizon = 
+		refresh_scheduler::NUM_SLOTS * refresh_scheduler::SLOT_MS;
+
+	for ( int i = 0; i < 100; i++ ) {
+		uint32 delay = s.schedule(4000000, 4000000);
+
+		CPPUNIT_ASSERT( delay >= 3000000 && delay <= 3000000 + horizon );
+	}
+}
+
+void RefreshSchedulerTest::testNoJitter() {
+	refresh_scheduler s(0, 0, 1, 0);
+
+	for ( int i = 0; i < 10; i++ ) 
+		CPPUNIT_ASSERT( s.schedule(5000, 8000) == 5000 );
+}
+
+
+void RefreshSchedulerTest::testDeadline() {
+	refresh_scheduler s(25, 0, 1, 0);
+
+	for ( int i = 0; i < 10; i++ ) 
+		CPPUNIT_ASSERT( s.schedule(20000, 3000) <= 3000 );
+}
+
+
+void RefreshSchedulerTest::testQueueDepth() {
+	refresh_scheduler s(25, 0, 1, 100);
+	uint64_t now = refresh_scheduler::now_ms();
+
+	s.set_queue_depth(50);
+	CPPUNIT_ASSERT( s.admit("peer", now, now + 10000) == 0 );
+
+	s.set_queue_depth(500);
+	uint32 defer = s.admit("peer", now, now + 10000);
+	CPPUNIT_ASSERT( defer > 0 );
+	CPPUNIT_ASSERT( defer <= refresh_scheduler::MAX_DEFER_MS );
+	
+	// Too little slack left, the refresh is sent anyway.
+	CPPUNIT_ASSERT( s.admit("peer", now, now + 50) == 0 );
+
+	refresh_scheduler_stats stats = s.get_stats();
+	CPPUNIT_ASSERT( stats.sent == 2 );
+	CPPUNIT_ASSERT( stats.deferred_queue == 1 );
+}
+
+
+void RefreshSchedulerTest::testPeerRate() {
+	refresh_scheduler s(25, 10, 5, 0);
+	uint64_t now = refresh_scheduler::now_ms();
+
+	for ( int i = 0; i < 5; i++ )
+		CPPUNIT_ASSERT( s.admit("a", now, now + 10000) == 0 );
+
+	// The bucket of peer "a" is empty, but "b" has its own.
+	uint32 defer = s.admit("a", now, now + 10000);
+	CPPUNIT_ASSERT( defer > 0 );
+	CPPUNIT_ASSERT( defer <= 101 );
+	CPPUNIT_ASSERT( s.admit("b", now, now + 10000) == 0 );
+
+	// The deadline wins over the peer's rate.
+	CPPUNIT_ASSERT( s.admit("a", now, now + 10) == 0 );
+	
+	CPPUNIT_ASSERT( s.get_stats().deferred_peer == 1 );
+}
+
+
+void RefreshSchedulerTest::testLate() {
+	refresh_scheduler s(25, 0, 1, 0);
+	uint64_t now = refresh_scheduler::now_ms();
+
+	CPPUNIT_ASSERT( s.admit("a", now - 3000, now - 1000) == 0 );
+
+	refresh_scheduler_stats stats = s.get_stats();
+	CPPUNIT_ASSERT( stats.late == 1 );
+	CPPUNIT_ASSERT( stats.max_delay_ms >= 3000 );
+	CPPUNIT_ASSERT( stats.min_margin_ms == 0 );
+}
+
+// EOF
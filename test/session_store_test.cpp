@@ -0,0 +1,219 @@
+/*
+ * Test the session_store class.
+ *
+ * $Id: session_store_test.cpp 2016-04-15 09:40:00 amarentes $
+ * $HeadURL: https://./test/session_store_test.cpp $
+ */
+#include <string>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "session_store.h"
+
+
+using namespace anslp;
+
+
+class SessionStoreTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( SessionStoreTest );
+
+	CPPUNIT_TEST( testPut );
+	CPPUNIT_TEST( testReopen );
+	CPPUNIT_TEST( testDamagedSlot );
+	CPPUNIT_TEST( testLimits );
+	CPPUNIT_TEST( testLayoutChange );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+
+	void testPut();
+	void testReopen();
+	void testDamagedSlot();
+	void testLimits();
+	void testLayoutChange();
+
+  private:
+	std::string filename;
+
+	bool put(session_store &store, const session_id &sid, 
+			 const std::string &data);
+
+	std::string get(const session_store &store, const session_id &sid);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( SessionStoreTest );
+
+
+void SessionStoreTest::setUp() {
+	char name[] = "/tmp/session_store_test.XXXXXX";
+	int fd = mkstemp(name);
+
+	CPPUNIT_ASSERT( fd >= 0 );
+	close(fd);
+
+	filename = name;
+}
+
+
+void SessionStoreTest::tearDown() {
+	unlink(filename.c_str());
+}
+
+
+bool SessionStoreTest::put(session_store &store, const session_id &sid,
+		const std::string &data) {
+
+	return store.put(sid, (const uchar *) data.data(), data.size());
+}
+
+
+/*
+ * Return the data stored for the session, "-" if there is none.
+ */
+std::string SessionStoreTest::get(const session_store &store, 
+		const session_id &sid) {
+
+	session_store::record_list_t records;
+	store.get_records(records);
+
+	for ( size_t i = 0; i < records.size(); i++ )
+		if ( records[i].first == sid )
+			return records[i].second;
+
+	return "-";
+}
+
+
+void SessionStoreTest::testPut() {
+	session_store store;
+	session_id s1, s2;
+
+	CPPUNIT_ASSERT( store.open(filename, 4) );
+	CPPUNIT_ASSERT( store.is_open() );
+	CPPUNIT_ASSERT( store.size() == 0 );
+
+	CPPUNIT_ASSERT( put(store, s1, "first") );
+	CPPUNIT_ASSERT( put(store, s2, "second") );
+	CPPUNIT_ASSERT( store.size() == 2 );
+	CPPUNIT_ASSERT_EQUAL( std::string("first"), get(store, s1) );
+
+	// Unchanged snapshots aren't written again.
+	CPPUNIT_ASSERT( put(store, s1, "first") );
+	CPPUNIT_ASSERT( store.get_stats().writes == 2 );
+	CPPUNIT_ASSERT( store.get_stats().unchanged == 1 );
+
+	CPPUNIT_ASSERT( put(store, s1, "changed") );
+	CPPUNIT_ASSERT( store.size() == 2 );
+	CPPUNIT_ASSERT_EQUAL( std::string("changed"), get(store, s1) );
+
+	CPPUNIT_ASSERT( store.erase(s2) );
+	CPPUNIT_ASSERT( ! store.erase(s2) );
+	CPPUNIT_ASSERT( store.size() == 1 );
+	CPPUNIT_ASSERT_EQUAL( std::string("-"), get(store, s2) );
+}
+
+
+void SessionStoreTest::testReopen() {
+	session_id s1, s2;
+
+	{
+		session_store store;
+		CPPUNIT_ASSERT( store.open(filename, 4) );
+
+		CPPUNIT_ASSERT( put(store, s1, "old") );
+		CPPUNIT_ASSERT( put(store, s1, "new") );
+		CPPUNIT_ASSERT( put(store, s2, "other") );
+		CPPUNIT_ASSERT( store.erase(s2) );
+	}
+
+	session_store store;
+	CPPUNIT_ASSERT( store.open(filename, 4) );
+
+	CPPUNIT_ASSERT( store.size() == 1 );
+	CPPUNIT_ASSERT_EQUAL( std::string("new"), get(store, s1) );
+
+	// All other slots are free again.
+	session_id s3, s4, s5;
+	CPPUNIT_ASSERT( put(store, s3, "3") );
+	CPPUNIT_ASSERT( put(store, s4, "4") );
+	CPPUNIT_ASSERT( put(store, s5, "5") );
+}
+
+
+void SessionStoreTest::testDamagedSlot() {
+	session_id s1;
+
+	{
+		session_store store;
+		CPPUNIT_ASSERT( store.open(filename, 2) );
+		CPPUNIT_ASSERT( put(store, s1, "snapshot") );
+	}
+
+	// The snapshot is in the first slot, change one of its bytes.
+	int fd = open(filename.c_str(), O_RDWR);
+	CPPUNIT_ASSERT( fd >= 0 );
+
+	off_t pos = 16 + 32;
+	CPPUNIT_ASSERT( pwrite(fd, "S", 1, pos) == 1 );
+	close(fd);
+
+	session_store store;
+	CPPUNIT_ASSERT( store.open(filename, 2) );
+	CPPUNIT_ASSERT( store.size() == 0 );
+}
+
+
+void SessionStoreTest::testLimits() {
+	session_store store;
+	session_id s1, s2, s3;
+
+	CPPUNIT_ASSERT( store.open(filename, 2) );
+
+	std::string large(session_store::MAX_RECORD_SIZE + 1, 'x');
+	CPPUNIT_ASSERT( ! put(store, s1, large) );
+
+	large.resize(session_store::MAX_RECORD_SIZE);
+	CPPUNIT_ASSERT( put(store, s1, large) );
+
+	CPPUNIT_ASSERT( put(store, s2, "2") );
+	CPPUNIT_ASSERT( ! put(store, s3, "3") );
+
+	// A full store still takes changed snapshots.
+	CPPUNIT_ASSERT( put(store, s2, "changed") );
+	CPPUNIT_ASSERT_EQUAL( std::string("changed"), get(store, s2) );
+
+	// A snapshot growing too large replaces the old one by nothing.
+	CPPUNIT_ASSERT( ! put(store, s2, large + "x") );
+	CPPUNIT_ASSERT_EQUAL( std::string("-"), get(store, s2) );
+	CPPUNIT_ASSERT( store.get_stats().rejected == 3 );
+
+	// A session whose state didn't even fit into the buffer.
+	store.reject(s1);
+	CPPUNIT_ASSERT_EQUAL( std::string("-"), get(store, s1) );
+	CPPUNIT_ASSERT( store.get_stats().rejected == 4 );
+}
+
+
+void SessionStoreTest::testLayoutChange() {
+	session_id s1;
+
+	{
+		session_store store;
+		CPPUNIT_ASSERT( store.open(filename, 2) );
+		CPPUNIT_ASSERT( put(store, s1, "snapshot") );
+	}
+
+	session_store store;
+	CPPUNIT_ASSERT( store.open(filename, 8) );
+	CPPUNIT_ASSERT( store.size() == 0 );
+}
+
+// EOF
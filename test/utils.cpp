@@ -4,11 +4,15 @@
  * $Id: utils.cpp 4118 2015-09-04 7:43:00Z amarentes $
  * $HeadURL: https://./test/utils.cpp $
  */
+#include <assert.h>
+
 #include <cppunit/TestAssert.h>
 #include <cppunit/SourceLine.h>
 
 #include "utils.h"
 #include "msg/anslp_msg.h"
+#include "msg/anslp_ie.h"
+#include "msg/wire_image.h"
 
 
 using namespace CppUnit;
@@ -49,6 +53,36 @@ void mock_dispatcher::send_message(msg::ntlp_msg *msg) throw () {
 }
 
 
+/**
+ * For testing: Store the message decoded from the image instead of sending it.
+ *
+ * Like the real dispatcher, the image is built from the message if it is
+ * empty. Decoding it makes in-place patches (like a new MSN) visible.
+ */
+void mock_dispatcher::send_wire_message(const msg::ntlp_msg *msg,
+		msg::wire_image &image) throw () {
+
+	assert( msg != NULL );
+
+	if ( image.is_empty() )
+		image.assign(msg->get_anslp_msg());
+
+	NetMsg buf(image.get_buffer(), image.get_size());
+	IEErrorList errlist;
+	uint32 num_read;
+
+	IE *ie = ANSLP_IEManager::instance()->deserialize(buf, cat_anslp_msg,
+				IE::protocol_v1, errlist, num_read, false);
+
+	anslp_msg *body = dynamic_cast<anslp_msg *>(ie);
+	assert( body != NULL && errlist.is_empty() );
+
+	send_message(new ntlp_msg(msg->get_session_id(), body,
+		( msg->get_mri() != NULL ) ? msg->get_mri()->copy() : NULL,
+		msg->get_sii_handle()));
+}
+
+
 /**
  * For testing: Store the timer instead of sending it.
  */
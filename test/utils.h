@@ -13,6 +13,7 @@
 #include "protlib_types.h"
 #include "dispatcher.h"
 #include "gist_conf.h"
+#include "msg/anslp_ie.h"
 
 class mock_anslp_config;
 class mock_dispatcher;
@@ -84,15 +85,23 @@ class mock_dispatcher : public dispatcher {
   public:
 	mock_dispatcher(session_manager *m=NULL, 
 					auction_rule_installer *p=NULL, 
-					anslp_config *conf=NULL)
-		: dispatcher(m, p, conf ? conf : new mock_anslp_config()),
-		  message(NULL), timer(0), next_timer_id(1) { }
+					anslp_config *conf=NULL,
+					create_filter *f=NULL)
+		: dispatcher(m, p, conf ? conf : new mock_anslp_config(),
+					 NULL, NULL, NULL, f),
+		  message(NULL), timer(0), next_timer_id(1) {
+
+		// send_wire_message() decodes the images it receives
+		msg::ANSLP_IEManager::register_known_ies();
+	}
 	~mock_dispatcher() { clear(); }
 
 	/*
 	 * Inherited from parent:
 	 */
 	virtual void send_message(msg::ntlp_msg *msg) throw ();
+	virtual void send_wire_message(const msg::ntlp_msg *msg,
+		msg::wire_image &image) throw ();
 	virtual id_t start_timer(const session *s, int secs) throw ();
 
 	/*
@@ -0,0 +1,126 @@
+/*
+ * Test the wire_image class.
+ *
+ * $Id: wire_image_test.cpp 2016-03-30 09:20:00 amarentes $
+ * $HeadURL: https://./test/wire_image_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include "network_message.h"
+
+#include "msg/anslp_ie.h"
+#include "msg/anslp_msg.h"
+#include "msg/anslp_refresh.h"
+#include "msg/wire_image.h"
+
+
+using namespace anslp::msg;
+
+
+class WireImageTest : public CppUnit::TestCase {
+
+	CPPUNIT_TEST_SUITE( WireImageTest );
+
+	CPPUNIT_TEST( testEmpty );
+	CPPUNIT_TEST( testAssign );
+	CPPUNIT_TEST( testPatchMsn );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void setUp();
+	void tearDown();
+	
+	void testEmpty();
+	void testAssign();
+	void testPatchMsn();
+
+  private:
+	anslp_msg *parse(const wire_image &image);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( WireImageTest );
+
+
+void WireImageTest::setUp() {
+	ANSLP_IEManager::clear();
+	ANSLP_IEManager::register_known_ies();
+}
+
+
+void WireImageTest::tearDown() {
+	ANSLP_IEManager::clear();
+}
+
+
+anslp_msg *WireImageTest::parse(const wire_image &image) {
+	NetMsg msg(image.get_buffer(), image.get_size());
+	IEErrorList errlist;
+	uint32 num_read;
+
+	IE *ie = ANSLP_IEManager::instance()->deserialize(msg, cat_anslp_msg, 
+				IE::protocol_v1, errlist, num_read, false);
+
+	CPPUNIT_ASSERT( ie != NULL );
+	CPPUNIT_ASSERT( errlist.is_empty() );
+	CPPUNIT_ASSERT( num_read == image.get_size() );
+
+	return dynamic_cast<anslp_msg *>(ie);
+}
+
+
+void WireImageTest::testEmpty() {
+	wire_image image;
+
+	CPPUNIT_ASSERT( image.is_empty() );
+	CPPUNIT_ASSERT( ! image.set_msg_sequence_number(1) );
+}
+
+
+void WireImageTest::testAssign() {
+	anslp_refresh *r1 = new anslp_refresh();
+	r1->set_msg_sequence_number(5);
+	r1->set_session_lifetime(30);
+
+	wire_image image;
+	image.assign(r1);
+
+	CPPUNIT_ASSERT( ! image.is_empty() );
+	CPPUNIT_ASSERT( image.get_size() == r1->get_serialized_size(IE::protocol_v1) );
+
+	anslp_msg *m = parse(image);
+	CPPUNIT_ASSERT( *m == *r1 );
+
+	image.clear();
+	CPPUNIT_ASSERT( image.is_empty() );
+
+	delete m;
+	delete r1;
+}
+
+
+void WireImageTest::testPatchMsn() {
+	anslp_refresh *r1 = new anslp_refresh();
+	r1->set_msg_sequence_number(5);
+	r1->set_session_lifetime(30);
+
+	wire_image image;
+	image.assign(r1);
+
+	CPPUNIT_ASSERT( image.set_msg_sequence_number(6) );
+
+	anslp_refresh *r2 = dynamic_cast<anslp_refresh *>(parse(image));
+	CPPUNIT_ASSERT( r2 != NULL );
+	CPPUNIT_ASSERT( r2->get_msg_sequence_number() == 6 );
+	CPPUNIT_ASSERT( r2->get_session_lifetime() == 30 );
+
+	// The image now matches a message carrying the new MSN.
+	r1->set_msg_sequence_number(6);
+	CPPUNIT_ASSERT( *r1 == *r2 );
+
+	delete r2;
+	delete r1;
+}
+
+// EOF
@@ -0,0 +1,270 @@
+/*
+ * Test the work_scheduler class.
+ *
+ * $Id: work_scheduler_test.cpp 2016-04-23 10:00:00 amarentes $
+ * $HeadURL: https://./test/work_scheduler_test.cpp $
+ */
+#include <cppunit/TestCase.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <pthread.h>
+
+#include "events.h"
+#include "work_scheduler.h"
+
+
+using namespace anslp;
+
+
+class WorkSchedulerTest : public CppUnit::TestFixture {
+
+	CPPUNIT_TEST_SUITE( WorkSchedulerTest );
+
+	CPPUNIT_TEST( testBatches );
+	CPPUNIT_TEST( testInProgress );
+	CPPUNIT_TEST( testSteal );
+	CPPUNIT_TEST( testNoSession );
+	CPPUNIT_TEST( testWait );
+	CPPUNIT_TEST( testConcurrent );
+
+	CPPUNIT_TEST_SUITE_END();
+
+  public:
+	void testBatches();
+	void testInProgress();
+	void testSteal();
+	void testNoSession();
+	void testWait();
+	void testConcurrent();
+
+  private:
+	static uint32 get_id(event *evt);
+	static void *work(void *arg);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION( WorkSchedulerTest );
+
+
+uint32 WorkSchedulerTest::get_id(event *evt) {
+	timer_event *e = dynamic_cast<timer_event *>(evt);
+	CPPUNIT_ASSERT( e != NULL );
+
+	return e->get_id();
+}
+
+
+void WorkSchedulerTest::testBatches() {
+	work_scheduler sched(1);
+	session_id sid1, sid2;
+
+	sched.push(new timer_event(&sid1, 1));
+	sched.push(new timer_event(&sid2, 2));
+	sched.push(new timer_event(&sid1, 3));
+	CPPUNIT_ASSERT_EQUAL( (size_t) 3, sched.size() );
+
+	// The events of sid1 come in one batch, in order.
+	std::vector<event *> events;
+	work_scheduler::batch *b = sched.pop(0, events);
+	CPPUNIT_ASSERT( b != NULL );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 2, events.size() );
+	CPPUNIT_ASSERT_EQUAL( 1u, get_id(events[0]) );
+	CPPUNIT_ASSERT_EQUAL( 3u, get_id(events[1]) );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 1, sched.size() );
+
+	delete events[0];
+	delete events[1];
+	sched.done(0, b);
+
+	events.clear();
+	b = sched.pop(0, events);
+	CPPUNIT_ASSERT( b != NULL );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 1, events.size() );
+	CPPUNIT_ASSERT_EQUAL( 2u, get_id(events[0]) );
+
+	delete events[0];
+	sched.done(0, b);
+
+	events.clear();
+	CPPUNIT_ASSERT( sched.pop(0, events) == NULL );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 0, sched.size() );
+}
+
+
+void WorkSchedulerTest::testInProgress() {
+	work_scheduler sched(2);
+	session_id sid;
+
+	sched.push(new timer_event(&sid, 1));
+
+	std::vector<event *> events;
+	work_scheduler::batch *b = sched.pop(0, events);
+	CPPUNIT_ASSERT( b != NULL );
+	delete events[0];
+
+	uint64_t stolen = sched.get_stats().stolen;
+
+	// The session is processed, nobody else gets its events.
+	sched.push(new timer_event(&sid, 2));
+
+	std::vector<event *> other;
+	CPPUNIT_ASSERT( sched.pop(1, other) == NULL );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 1, sched.size() );
+
+	// Afterwards, they are queued for the thread that processed it.
+	sched.done(0, b);
+
+	events.clear();
+	b = sched.pop(0, events);
+	CPPUNIT_ASSERT( b != NULL );
+	CPPUNIT_ASSERT_EQUAL( 2u, get_id(events[0]) );
+	CPPUNIT_ASSERT_EQUAL( stolen, sched.get_stats().stolen );
+
+	delete events[0];
+	sched.done(0, b);
+}
+
+
+void WorkSchedulerTest::testSteal() {
+	const uint32 num = 64;
+	work_scheduler sched(2);
+	session_id sids[num];
+
+	for ( uint32 i = 0; i < num; i++ )
+		sched.push(new timer_event(&sids[i], i));
+
+	// One thread takes all batches, some of them from the other deque.
+	std::vector<event *> events;
+	work_scheduler::batch *b;
+	uint32 found = 0;
+
+	while ( ( b = sched.pop(0, events) ) != NULL ) {
+		for ( size_t i = 0; i < events.size(); i++ )
+			delete events[i];
+
+		found += events.size();
+		events.clear();
+		sched.done(0, b);
+	}
+
+	work_scheduler_stats s = sched.get_stats();
+	CPPUNIT_ASSERT_EQUAL( num, found );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) num, s.pushed );
+	CPPUNIT_ASSERT_EQUAL( (uint64_t) num, s.batches );
+	CPPUNIT_ASSERT( s.stolen > 0 && s.stolen < num );
+}
+
+
+void WorkSchedulerTest::testNoSession() {
+	work_scheduler sched(1);
+
+	sched.push(new timer_event(NULL, 1));
+	sched.push(new timer_event(NULL, 2));
+
+	// Events without a session are never batched.
+	std::vector<event *> events1, events2;
+	work_scheduler::batch *b1 = sched.pop(0, events1);
+	work_scheduler::batch *b2 = sched.pop(0, events2);
+	CPPUNIT_ASSERT( b1 != NULL && b2 != NULL );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 1, events1.size() );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 1, events2.size() );
+	CPPUNIT_ASSERT_EQUAL( 1u, get_id(events1[0]) );
+	CPPUNIT_ASSERT_EQUAL( 2u, get_id(events2[0]) );
+
+	delete events1[0];
+	delete events2[0];
+	sched.done(0, b1);
+	sched.done(0, b2);
+}
+
+
+void WorkSchedulerTest::testWait() {
+	work_scheduler sched(1);
+	session_id sid;
+
+	CPPUNIT_ASSERT( ! sched.wait(10) );
+
+	// Queued events are deleted with the scheduler.
+	sched.push(new timer_event(&sid, 1));
+	CPPUNIT_ASSERT( sched.wait(10) );
+}
+
+
+namespace {
+	const uint32 NUM_THREADS = 4;
+	const uint32 NUM_SESSIONS = 32;
+	const uint32 NUM_EVENTS = 20000;
+
+	struct shared_t {
+		work_scheduler *sched;
+		volatile uint32 processed;
+		volatile uint32 last[NUM_SESSIONS];
+		volatile uint32 misordered;
+	};
+}
+
+
+/*
+ * Process batches until all events are done, checking that the events
+ * of each session arrive in order.
+ */
+void *WorkSchedulerTest::work(void *arg) {
+	shared_t *shared = reinterpret_cast<shared_t *>(arg);
+	uint32 worker = shared->sched->register_worker();
+
+	while ( shared->processed < NUM_EVENTS ) {
+		std::vector<event *> events;
+		work_scheduler::batch *b = shared->sched->pop(worker, events);
+
+		if ( b == NULL ) {
+			shared->sched->wait(1);
+			continue;
+		}
+
+		for ( size_t i = 0; i < events.size(); i++ ) {
+			uint32 id = get_id(events[i]);
+			uint32 s = id % NUM_SESSIONS;
+
+			if ( id < shared->last[s] )
+				__sync_fetch_and_add(&shared->misordered, 1);
+
+			shared->last[s] = id;
+			delete events[i];
+		}
+
+		__sync_fetch_and_add(&shared->processed, events.size());
+		shared->sched->done(worker, b);
+	}
+
+	return NULL;
+}
+
+
+void WorkSchedulerTest::testConcurrent() {
+	work_scheduler sched(NUM_THREADS);
+	session_id sids[NUM_SESSIONS];
+
+	shared_t shared;
+	shared.sched = &sched;
+	shared.processed = 0;
+	shared.misordered = 0;
+
+	for ( uint32 i = 0; i < NUM_SESSIONS; i++ )
+		shared.last[i] = 0;
+
+	pthread_t threads[NUM_THREADS];
+
+	for ( uint32 i = 0; i < NUM_THREADS; i++ )
+		pthread_create(&threads[i], NULL, work, &shared);
+
+	for ( uint32 i = 0; i < NUM_EVENTS; i++ )
+		sched.push(new timer_event(&sids[i % NUM_SESSIONS], i));
+
+	for ( uint32 i = 0; i < NUM_THREADS; i++ )
+		pthread_join(threads[i], NULL);
+
+	CPPUNIT_ASSERT_EQUAL( NUM_EVENTS, (uint32) shared.processed );
+	CPPUNIT_ASSERT_EQUAL( 0u, (uint32) shared.misordered );
+	CPPUNIT_ASSERT_EQUAL( (size_t) 0, sched.size() );
+}
+
+// EOF